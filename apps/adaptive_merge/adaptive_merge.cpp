@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "taco.h"
+#include "taco/index_notation/kernel.h"
+
+using namespace taco;
+
+// Compares merging the rows of two sparse matrices with two fingers, by
+// galloping and adaptively (choosing between the two for every row from the
+// ratio of the row lengths) on the row-wise inner products
+// y(i) = A(i,j) * B(i,j), for matrices whose row lengths follow a power law
+// and for matrices whose rows all have the same length.
+
+static double milliseconds(std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+// Returns a CSR matrix whose row lengths follow a power law, with a few long
+// rows and many short ones.
+static Tensor<double> powerLawMatrix(const std::string& name, int rows,
+                                     int cols, std::mt19937& gen) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> column(0, cols - 1);
+  Tensor<double> A(name, {rows, cols}, CSR);
+  for (int i = 0; i < rows; ++i) {
+    const int length = std::min(cols, (int)(2.0 / std::pow(uniform(gen), 1.5)));
+    for (int k = 0; k < length; ++k) {
+      A.insert({i, column(gen)}, 1.0 + k % 5);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+// Returns a CSR matrix whose rows all have `length` random entries.
+static Tensor<double> regularMatrix(const std::string& name, int rows,
+                                    int cols, int length, std::mt19937& gen) {
+  std::uniform_int_distribution<int> column(0, cols - 1);
+  Tensor<double> A(name, {rows, cols}, CSR);
+  for (int i = 0; i < rows; ++i) {
+    for (int k = 0; k < length; ++k) {
+      A.insert({i, column(gen)}, 1.0 + k % 5);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+static double benchmark(MergeStrategy strategy, const Tensor<double>& A,
+                        const Tensor<double>& B, int repetitions,
+                        Tensor<double>* y) {
+  IndexVar i("i"), j("j");
+  (*y)(i) = A(i,j) * B(i,j);
+  IndexStmt stmt = y->getAssignment().concretize().mergeby(j, strategy);
+
+  std::vector<TensorStorage> arguments = {y->getStorage(), A.getStorage(),
+                                          B.getStorage()};
+  Kernel kernel = compile(stmt);
+  kernel.assemble(arguments);
+  kernel.compute(arguments);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int r = 0; r < repetitions; ++r) {
+    kernel.compute(arguments);
+  }
+  return milliseconds(begin) / repetitions;
+}
+
+int main(int argc, char* argv[]) {
+  const int repetitions = (argc > 1) ? atoi(argv[1]) : 10;
+  const int rows = 100000;
+  const int cols = 1000000;
+  std::mt19937 gen(0);
+
+  std::vector<std::pair<std::string,std::pair<Tensor<double>,Tensor<double>>>>
+      matrices;
+  matrices.push_back({"power-law", {powerLawMatrix("A", rows, cols, gen),
+                                    powerLawMatrix("B", rows, cols, gen)}});
+  matrices.push_back({"regular", {regularMatrix("A", rows, cols, 32, gen),
+                                  regularMatrix("B", rows, cols, 32, gen)}});
+
+  std::cout << "matrix\tstrategy\ttime (ms)\tcorrect" << std::endl;
+  for (auto& matrix : matrices) {
+    const Tensor<double>& A = matrix.second.first;
+    const Tensor<double>& B = matrix.second.second;
+
+    Tensor<double> expected("expected", {rows}, Dense);
+    double time = benchmark(MergeStrategy::TwoFinger, A, B, repetitions,
+                            &expected);
+    std::cout << matrix.first << "\tTwoFinger\t" << time << "\tyes"
+              << std::endl;
+
+    auto report = [&](const std::string& name, MergeStrategy strategy) {
+      Tensor<double> y("y", {rows}, Dense);
+      const double time = benchmark(strategy, A, B, repetitions, &y);
+      std::cout << matrix.first << "\t" << name << "\t" << time << "\t"
+                << (equals(y, expected) ? "yes" : "no") << std::endl;
+    };
+    report("Gallop", MergeStrategy::Gallop);
+    for (int threshold : {2, 8, 32, 128}) {
+      taco_set_adaptive_merge_threshold(threshold);
+      report("Adaptive-" + std::to_string(threshold), MergeStrategy::Adaptive);
+    }
+  }
+  return 0;
+}
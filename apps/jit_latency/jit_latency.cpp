@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "taco.h"
+#include "taco/codegen/module.h"
+#include "taco/lower/lower.h"
+
+using namespace taco;
+
+// Measures how long it takes to turn lowered kernels into callable code with
+// the system C compiler (C99 target) and with the in-process LLVM backend
+// (X86 target), with and without tiered compilation. With tiered compilation
+// this is the time to the first result, since the module can be called as soon
+// as the baseline tier is ready.
+
+static double compileMilliseconds(ir::Stmt func, Target target) {
+  auto begin = std::chrono::steady_clock::now();
+  ir::Module module(target);
+  module.addFunction(func);
+  module.compile();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+int main(int argc, char* argv[]) {
+  int repetitions = (argc > 1) ? std::atoi(argv[1]) : 5;
+
+  // The disk cache would hide the cost of the system compiler
+  unsetenv("TACO_CACHE_DIR");
+
+  Format csr({Dense,Sparse});
+  Format csf({Sparse,Sparse,Sparse});
+  IndexVar i("i"), j("j"), k("k");
+
+  TensorVar y("y", Type(Float64, {1000}), dense);
+  TensorVar A("A", Type(Float64, {1000,1000}), csr);
+  TensorVar x("x", Type(Float64, {1000}), dense);
+  TensorVar B("B", Type(Float64, {1000,1000}), csr);
+  TensorVar C("C", Type(Float64, {1000,1000}), csr);
+  TensorVar D("D", Type(Float64, {100,100,100}), csf);
+  TensorVar E("E", Type(Float64, {100,100}), csr);
+  TensorVar z("z", Type(Float64, {100}), dense);
+
+  std::vector<std::pair<std::string, IndexStmt>> kernels = {
+    {"spmv",   y(i) = A(i,j) * x(j)},
+    {"add",    C(i,j) = A(i,j) + B(i,j)},
+    {"ttv",    E(i,j) = D(i,j,k) * z(k)}
+  };
+
+  const Target c99(Target::C99, Target::Linux);
+  const Target x86(Target::X86, Target::Linux);
+  std::cout << "kernel\tC99 (ms)\tX86 (ms)\ttiered C99 (ms)\ttiered X86 (ms)"
+            << std::endl;
+  for (auto& kernel : kernels) {
+    IndexStmt stmt = makeConcreteNotation(makeReductionNotation(kernel.second));
+    ir::Stmt func = lower(stmt, "compute", true, true);
+    std::vector<double> times(4, 0.0);
+    for (int r = 0; r < repetitions; r++) {
+      unsetenv("TACO_TIERED_COMPILATION");
+      times[0] += compileMilliseconds(func, c99);
+      times[1] += compileMilliseconds(func, x86);
+      setenv("TACO_TIERED_COMPILATION", "1", 1);
+      times[2] += compileMilliseconds(func, c99);
+      times[3] += compileMilliseconds(func, x86);
+    }
+    std::cout << kernel.first;
+    for (double time : times) {
+      std::cout << "\t" << time / repetitions;
+    }
+    std::cout << std::endl;
+  }
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "taco.h"
+#include "taco/index_notation/kernel.h"
+
+using namespace taco;
+
+// Compares the strategies that intersections of sparse vectors can be merged
+// with (two-finger merging, galloping and merging by blocks of coordinates)
+// on the inner product of two sparse vectors, whose numbers of nonzeros range
+// from balanced to highly skewed.
+
+static double milliseconds(std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+// Returns a sparse vector with `nnz` nonzeros at uniformly random coordinates.
+static Tensor<double> randomVector(const std::string& name, int dimension,
+                                   int nnz, std::mt19937& gen) {
+  std::vector<int> coordinates(dimension);
+  for (int i = 0; i < dimension; ++i) {
+    coordinates[i] = i;
+  }
+  for (int k = 0; k < nnz; ++k) {
+    std::uniform_int_distribution<int> other(k, dimension - 1);
+    std::swap(coordinates[k], coordinates[other(gen)]);
+  }
+  Tensor<double> a(name, {dimension}, Sparse);
+  for (int k = 0; k < nnz; ++k) {
+    a.insert({coordinates[k]}, 1.0 + coordinates[k] % 3);
+  }
+  a.pack();
+  return a;
+}
+
+static double benchmark(MergeStrategy strategy, const Tensor<double>& a,
+                        const Tensor<double>& b, int repetitions,
+                        double* result) {
+  IndexVar i("i");
+  Tensor<double> c("c");
+  c() = a(i) * b(i);
+  IndexStmt stmt = c.getAssignment().concretize().mergeby(i, strategy);
+
+  std::vector<TensorStorage> arguments = {c.getStorage(), a.getStorage(),
+                                          b.getStorage()};
+  Kernel kernel = compile(stmt);
+  kernel.assemble(arguments);
+  kernel.compute(arguments);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int r = 0; r < repetitions; ++r) {
+    kernel.compute(arguments);
+  }
+  const double time = milliseconds(begin) / repetitions;
+  *result = ((double*)c.getStorage().getValues().getData())[0];
+  return time;
+}
+
+int main(int argc, char* argv[]) {
+  const int repetitions = (argc > 1) ? atoi(argv[1]) : 20;
+  const int dimension = 10000000;
+  const int nnz = 1000000;
+  std::mt19937 gen(0);
+
+  const std::vector<std::pair<std::string,MergeStrategy>> strategies = {
+    {"TwoFinger", MergeStrategy::TwoFinger},
+    {"Gallop", MergeStrategy::Gallop},
+    {"SIMDBlock", MergeStrategy::SIMDBlock}
+  };
+
+  std::cout << "nnz(a)\tnnz(b)";
+  for (const auto& strategy : strategies) {
+    std::cout << "\t" << strategy.first << " (ms)";
+  }
+  std::cout << "\tcorrect" << std::endl;
+
+  Tensor<double> b = randomVector("b", dimension, nnz, gen);
+  for (int ratio : {1, 4, 16, 64, 256, 1024}) {
+    Tensor<double> a = randomVector("a", dimension, nnz / ratio, gen);
+    std::cout << nnz / ratio << "\t" << nnz;
+
+    bool correct = true;
+    double expected = 0.0;
+    for (size_t s = 0; s < strategies.size(); ++s) {
+      double result;
+      const double time = benchmark(strategies[s].second, a, b, repetitions,
+                                    &result);
+      if (s == 0) {
+        expected = result;
+      }
+      correct = correct && (result == expected);
+      std::cout << "\t" << time;
+    }
+    std::cout << "\t" << (correct ? "yes" : "no") << std::endl;
+  }
+  return 0;
+}
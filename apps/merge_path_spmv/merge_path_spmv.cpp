@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "taco.h"
+#include "taco/index_notation/kernel.h"
+
+using namespace taco;
+
+// Compares parallelizing sparse matrix-vector multiplication y(i) = A(i,j) *
+// x(j) over the rows of A (ParallelUnit::CPUThread, with chunks of rows that
+// threads take dynamically) with splitting the rows and nonzeros of A evenly
+// across threads (ParallelUnit::CPUMergePath), for matrices whose row lengths
+// follow a power law and for matrices whose rows all have the same length.
+
+static double milliseconds(std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+// Returns a CSR matrix whose row lengths follow a power law, with a few rows
+// that are orders of magnitude longer than the rest.
+static Tensor<double> powerLawMatrix(int rows, int cols, std::mt19937& gen) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> column(0, cols - 1);
+  Tensor<double> A("A", {rows, cols}, CSR);
+  for (int i = 0; i < rows; ++i) {
+    const int length = std::min(cols, (int)(2.0 / std::pow(uniform(gen), 1.5)));
+    for (int k = 0; k < length; ++k) {
+      A.insert({i, column(gen)}, 1.0 + k % 5);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+// Returns a CSR matrix whose rows all have `length` random entries.
+static Tensor<double> regularMatrix(int rows, int cols, int length,
+                                    std::mt19937& gen) {
+  std::uniform_int_distribution<int> column(0, cols - 1);
+  Tensor<double> A("A", {rows, cols}, CSR);
+  for (int i = 0; i < rows; ++i) {
+    for (int k = 0; k < length; ++k) {
+      A.insert({i, column(gen)}, 1.0 + k % 5);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+static double benchmark(IndexStmt stmt, const Tensor<double>& A,
+                        const Tensor<double>& x, int repetitions,
+                        Tensor<double>* y) {
+  std::vector<TensorStorage> arguments = {y->getStorage(), A.getStorage(),
+                                          x.getStorage()};
+  Kernel kernel = compile(stmt);
+  kernel.assemble(arguments);
+  kernel.compute(arguments);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int r = 0; r < repetitions; ++r) {
+    kernel.compute(arguments);
+  }
+  return milliseconds(begin) / repetitions;
+}
+
+int main(int argc, char* argv[]) {
+  const int repetitions = (argc > 1) ? atoi(argv[1]) : 20;
+  const int rows = 100000;
+  const int cols = 100000;
+  std::mt19937 gen(0);
+
+  std::vector<std::pair<std::string,Tensor<double>>> matrices;
+  matrices.push_back({"power-law", powerLawMatrix(rows, cols, gen)});
+  matrices.push_back({"regular", regularMatrix(rows, cols, 16, gen)});
+
+  Tensor<double> x("x", {cols}, Dense);
+  for (int j = 0; j < cols; ++j) {
+    x.insert({j}, 1.0 + j % 7);
+  }
+  x.pack();
+
+  std::cout << "matrix\tthreads\tloops\ttime (ms)\tcorrect" << std::endl;
+  for (auto& matrix : matrices) {
+    const Tensor<double>& A = matrix.second;
+
+    IndexVar i("i"), j("j"), i0("i0"), i1("i1");
+    Tensor<double> expected("expected", {rows}, Dense);
+    expected(i) = A(i,j) * x(j);
+    benchmark(expected.getAssignment().concretize(), A, x, 1, &expected);
+
+    for (int threads : {1, 2, 4, 8}) {
+      taco_set_num_threads(threads);
+
+      Tensor<double> y("y", {rows}, Dense);
+      y(i) = A(i,j) * x(j);
+      IndexStmt rowsStmt = y.getAssignment().concretize()
+          .split(i, i0, i1, 16)
+          .parallelize(i0, ParallelUnit::CPUThread, OutputRaceStrategy::NoRaces);
+      double time = benchmark(rowsStmt, A, x, repetitions, &y);
+      std::cout << matrix.first << "\t" << threads << "\tCPUThread\t" << time
+                << "\t" << (equals(y, expected) ? "yes" : "no") << std::endl;
+
+      Tensor<double> z("z", {rows}, Dense);
+      z(i) = A(i,j) * x(j);
+      IndexStmt mergePathStmt = z.getAssignment().concretize()
+          .parallelize(i, ParallelUnit::CPUMergePath, OutputRaceStrategy::NoRaces);
+      time = benchmark(mergePathStmt, A, x, repetitions, &z);
+      std::cout << matrix.first << "\t" << threads << "\tCPUMergePath\t"
+                << time << "\t" << (equals(z, expected) ? "yes" : "no")
+                << std::endl;
+    }
+  }
+  taco_set_num_threads(1);
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "taco.h"
+#include "taco/util/radix_sort.h"
+
+using namespace taco;
+
+// Measures how fast a tensor is read from a .tns or .mtx file, how long it
+// takes to pack it, how long it takes to read it straight into its format,
+// and how much the peak memory use of the process grows while packing. It
+// also compares the radix sort that pack uses to order the coordinates with the
+// qsort-based sort that pack used before, on the same shuffled coordinates.
+
+static double milliseconds(std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static double peakMegabytes() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+static size_t numIntegersToCompare = 0;
+static int lexicographicalCmp(const void* a, const void* b) {
+  for (size_t i = 0; i < numIntegersToCompare; i++) {
+    int diff = ((int*)a)[i] - ((int*)b)[i];
+    if (diff != 0) {
+      return diff;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <tensor.tns|matrix.mtx> [mode formats]"
+              << std::endl;
+    return 1;
+  }
+  const std::string filename = argv[1];
+  const std::string modes = (argc > 2) ? argv[2] : "";
+
+  std::vector<ModeFormatPack> modeFormats;
+  for (char mode : modes) {
+    modeFormats.push_back(mode == 'd' ? Dense : Sparse);
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  TensorBase tensor = modes.empty() ? read(filename, Sparse, false)
+                                    : read(filename, Format(modeFormats), false);
+  const double readTime = milliseconds(begin);
+  struct stat fileStat;
+  stat(filename.c_str(), &fileStat);
+  const double readThroughput = fileStat.st_size / 1e6 / (readTime / 1e3);
+
+  const double peakBefore = peakMegabytes();
+  begin = std::chrono::steady_clock::now();
+  tensor.pack();
+  const double packTime = milliseconds(begin);
+  const double packMemory = peakMegabytes() - peakBefore;
+
+  begin = std::chrono::steady_clock::now();
+  TensorBase packed = modes.empty() ? read(filename, Sparse)
+                                    : read(filename, Format(modeFormats));
+  const double readPackedTime = milliseconds(begin);
+
+  // Shuffled coordinate records laid out like pack's coordinate buffer
+  const int order = tensor.getOrder();
+  const size_t recordSize = order * sizeof(int) + sizeof(double);
+  std::vector<char> records;
+  for (auto& value : iterate<double>(tensor)) {
+    records.resize(records.size() + recordSize);
+    char* record = &records[records.size() - recordSize];
+    for (int i = 0; i < order; ++i) {
+      ((int*)record)[i] = value.first[i];
+    }
+    memcpy(record + order * sizeof(int), &value.second, sizeof(double));
+  }
+  const size_t nnz = records.size() / recordSize;
+  srand(0);
+  for (size_t i = nnz; i > 1; --i) {
+    const size_t j = rand() % i;
+    std::swap_ranges(&records[(i-1) * recordSize], &records[i * recordSize],
+                     &records[j * recordSize]);
+  }
+
+  std::vector<char> qsortRecords = records;
+  begin = std::chrono::steady_clock::now();
+  numIntegersToCompare = order;
+  qsort(qsortRecords.data(), nnz, recordSize, lexicographicalCmp);
+  const double qsortTime = milliseconds(begin);
+
+  std::vector<const void*> fields;
+  for (int i = 0; i < order; ++i) {
+    fields.push_back(records.data() + i * sizeof(int));
+  }
+  begin = std::chrono::steady_clock::now();
+  util::radixSortPermutation(fields, recordSize, nnz);
+  const double radixTime = milliseconds(begin);
+
+  std::cout << "nnz\tread (ms)\tread (MB/s)\tpack (ms)\t"
+            << "pack peak memory growth (MB)\tread packed (ms)\t"
+            << "qsort (ms)\tradix sort (ms)" << std::endl;
+  std::cout << nnz << "\t" << readTime << "\t" << readThroughput << "\t"
+            << packTime << "\t" << packMemory << "\t" << readPackedTime
+            << "\t" << qsortTime << "\t" << radixTime << std::endl;
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "taco.h"
+
+using namespace taco;
+
+// Compares sparse matrix-vector multiplication with a matrix stored as CSR and
+// as sliced ELLPACK (SELL-C-σ) with several chunk sizes and sort windows.
+
+static double milliseconds(std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static size_t storedBytes(const TensorBase& tensor) {
+  const Index& index = tensor.getStorage().getIndex();
+  size_t bytes = tensor.getStorage().getValues().getSize() * sizeof(double);
+  for (int i = 0; i < index.numModeIndices(); ++i) {
+    const ModeIndex modeIndex = index.getModeIndex(i);
+    for (int j = 0; j < modeIndex.numIndexArrays(); ++j) {
+      const Array array = modeIndex.getIndexArray(j);
+      bytes += array.getSize() * array.getType().getNumBytes();
+    }
+  }
+  return bytes;
+}
+
+// Returns a CSR matrix whose row lengths follow a power law, with a few long
+// rows and many short ones.
+static TensorBase powerLawMatrix(int n) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> column(0, n - 1);
+  Tensor<double> A("A", {n, n}, CSR);
+  for (int i = 0; i < n; ++i) {
+    const int length = std::min(n, (int)(2.0 / std::pow(uniform(gen), 0.7)));
+    for (int k = 0; k < length; ++k) {
+      A.insert({i, column(gen)}, 1.0 + k % 5);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+// Returns a CSR matrix whose rows all have `length` entries.
+static TensorBase regularMatrix(int n, int length) {
+  Tensor<double> A("A", {n, n}, CSR);
+  for (int i = 0; i < n; ++i) {
+    for (int k = 0; k < length; ++k) {
+      A.insert({i, (i + k * 97) % n}, 1.0 + k % 5);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+static void benchmark(const std::string& name, const TensorBase& A,
+                      const std::string& matrix, int repetitions) {
+  const int rows = A.getDimension(0);
+  const int cols = A.getDimension(1);
+
+  Tensor<double> x("x", {cols}, Dense);
+  for (int j = 0; j < cols; ++j) {
+    x.insert({j}, 1.0 + j % 7);
+  }
+  x.pack();
+
+  IndexVar i, j;
+  Tensor<double> y("y", {rows}, Dense);
+  y(i) = A(i,j) * x(j);
+  y.compile();
+  y.assemble();
+  y.compute();
+
+  // Restating the assignment reuses the compiled kernel but marks the result
+  // as stale, so that it is computed again
+  auto begin = std::chrono::steady_clock::now();
+  for (int r = 0; r < repetitions; ++r) {
+    y(i) = A(i,j) * x(j);
+    y.compute();
+  }
+  const double time = milliseconds(begin) / repetitions;
+
+  std::cout << matrix << "\t" << name << "\t"
+            << A.getStorage().getValues().getSize() << "\t" << storedBytes(A)
+            << "\t" << time << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  const int repetitions = (argc > 2) ? atoi(argv[2]) : 10;
+
+  std::vector<std::pair<std::string, TensorBase>> matrices;
+  if (argc > 1) {
+    matrices.push_back({argv[1], read(argv[1], CSR)});
+  } else {
+    matrices.push_back({"power-law", powerLawMatrix(200000)});
+    matrices.push_back({"regular", regularMatrix(200000, 16)});
+  }
+
+  std::cout << "matrix\tformat\tentries\tbytes\tspmv (ms)" << std::endl;
+  for (const auto& matrix : matrices) {
+    const TensorBase& csr = matrix.second;
+    benchmark("CSR", csr, matrix.first, repetitions);
+    for (int chunkSize : {4, 8, 16}) {
+      for (int sortWindow : {1, 32 * chunkSize}) {
+        const std::string name = "SELL-" + std::to_string(chunkSize) + "-" +
+                                 std::to_string(sortWindow);
+        benchmark(name, makeSELL("S", csr, chunkSize, sortWindow),
+                  matrix.first, repetitions);
+      }
+    }
+  }
+  return 0;
+}
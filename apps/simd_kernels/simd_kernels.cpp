@@ -0,0 +1,164 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "taco.h"
+#include "taco/index_notation/kernel.h"
+
+using namespace taco;
+
+// Compares kernels whose innermost loops are vectorized (parallelized over
+// ParallelUnit::CPUVector) with the same kernels scheduled without
+// vectorization: sparse matrix-vector multiplication, sampled dense-dense
+// matrix multiplication and sparse matrix times dense matrix multiplication.
+
+static double milliseconds(std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static Tensor<double> randomSparse(const std::string& name, int rows, int cols,
+                                   int rowLength, std::mt19937& gen) {
+  std::uniform_int_distribution<int> column(0, cols - 1);
+  Tensor<double> A(name, {rows, cols}, CSR);
+  for (int i = 0; i < rows; ++i) {
+    for (int k = 0; k < rowLength; ++k) {
+      A.insert({i, column(gen)}, 1.0 + k % 3);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+static Tensor<double> randomDense(const std::string& name, int rows, int cols,
+                                  std::mt19937& gen) {
+  std::uniform_real_distribution<double> value(-1.0, 1.0);
+  Tensor<double> A(name, {rows, cols}, Format({Dense, Dense}));
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      A.insert({i, j}, value(gen));
+    }
+  }
+  A.pack();
+  return A;
+}
+
+// Times `stmt` and reports it along with whether the result matches that of
+// the scalar kernel, which is computed first into `expected`.
+static void benchmark(const std::string& name, const std::string& variant,
+                      IndexStmt stmt, TensorBase result,
+                      std::vector<TensorBase> operands,
+                      const TensorBase* expected, int repetitions) {
+  std::vector<TensorStorage> arguments = {result.getStorage()};
+  for (const auto& operand : operands) {
+    arguments.push_back(operand.getStorage());
+  }
+  Kernel kernel = compile(stmt);
+  kernel.assemble(arguments);
+  kernel.compute(arguments);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int r = 0; r < repetitions; ++r) {
+    kernel.compute(arguments);
+  }
+  const double time = milliseconds(begin) / repetitions;
+
+  const bool correct = (expected == nullptr) || equals(result, *expected);
+  std::cout << name << "\t" << variant << "\t" << time << "\t"
+            << (correct ? "yes" : "no") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  const int repetitions = (argc > 1) ? atoi(argv[1]) : 10;
+  std::mt19937 gen(0);
+
+  std::cout << "kernel\tloops\ttime (ms)\tcorrect" << std::endl;
+
+  // y(i) = A(i,j) * x(j), with the positions of every row split into
+  // blocks of 8 that are reduced in SIMD lanes
+  {
+    const int n = 100000;
+    Tensor<double> A = randomSparse("A", n, n, 32, gen);
+    Tensor<double> xv("xv", {n}, Dense);
+    for (int j = 0; j < n; ++j) {
+      xv.insert({j}, 1.0 + j % 7);
+    }
+    xv.pack();
+
+    IndexVar i("i"), j("j"), jpos("jpos"), jpos0("jpos0"), jpos1("jpos1");
+    Tensor<double> y("y", {n}, Dense);
+    Tensor<double> expected("expected", {n}, Dense);
+    y(i) = A(i,j) * xv(j);
+    expected(i) = A(i,j) * xv(j);
+    auto schedule = [&](IndexStmt stmt) {
+      return stmt.pos(j, jpos, A(i,j))
+                 .split(jpos, jpos0, jpos1, 8);
+    };
+    IndexStmt scalar = schedule(expected.getAssignment().concretize());
+    IndexStmt vector = schedule(y.getAssignment().concretize())
+        .parallelize(jpos1, ParallelUnit::CPUVector,
+                     OutputRaceStrategy::ParallelReduction);
+    benchmark("SpMV", "scalar", scalar, expected, {A, xv}, nullptr,
+              repetitions);
+    benchmark("SpMV", "vector", vector, y, {A, xv}, &expected, repetitions);
+  }
+
+  // E(i,k) = B(i,k) * sum(j, C(i,j) * D(k,j)), where the dense inner
+  // products over j are split into blocks of 16 that are reduced in SIMD lanes
+  {
+    const int n = 4000;
+    const int rank = 128;
+    Tensor<double> B = randomSparse("B", n, n, 32, gen);
+    Tensor<double> C = randomDense("C", n, rank, gen);
+    Tensor<double> D = randomDense("D", n, rank, gen);
+
+    IndexVar i("i"), j("j"), k("k"), j0("j0"), j1("j1");
+    Tensor<double> E("E", {n, n}, Format({Dense, Dense}));
+    Tensor<double> expected("expected", {n, n}, Format({Dense, Dense}));
+    E(i,k) = B(i,k) * C(i,j) * D(k,j);
+    expected(i,k) = B(i,k) * C(i,j) * D(k,j);
+    auto schedule = [&](IndexStmt stmt) {
+      return stmt.reorder({i, k, j})
+                 .split(j, j0, j1, 16);
+    };
+    IndexStmt scalar = schedule(expected.getAssignment().concretize());
+    IndexStmt vector = schedule(E.getAssignment().concretize())
+        .parallelize(j1, ParallelUnit::CPUVector,
+                     OutputRaceStrategy::ParallelReduction);
+    benchmark("SDDMM", "scalar", scalar, expected, {B, C, D}, nullptr,
+              repetitions);
+    benchmark("SDDMM", "vector", vector, E, {B, C, D}, &expected, repetitions);
+  }
+
+  // C(i,k) = A(i,j) * B(j,k), where the dense rows of B and C are
+  // vectorized over k
+  {
+    const int n = 20000;
+    const int cols = 64;
+    Tensor<double> A = randomSparse("A", n, n, 16, gen);
+    Tensor<double> B = randomDense("B", n, cols, gen);
+
+    IndexVar i("i"), j("j"), k("k"), i0("i0"), i1("i1"), jpos("jpos"),
+             jpos0("jpos0"), jpos1("jpos1");
+    Tensor<double> C("C", {n, cols}, Format({Dense, Dense}));
+    Tensor<double> expected("expected", {n, cols}, Format({Dense, Dense}));
+    C(i,k) = A(i,j) * B(j,k);
+    expected(i,k) = A(i,j) * B(j,k);
+    auto schedule = [&](IndexStmt stmt) {
+      return stmt.split(i, i0, i1, 16)
+                 .pos(j, jpos, A(i,j))
+                 .split(jpos, jpos0, jpos1, 8)
+                 .reorder({i0, i1, jpos0, k, jpos1});
+    };
+    IndexStmt scalar = schedule(expected.getAssignment().concretize());
+    IndexStmt vector = schedule(C.getAssignment().concretize())
+        .parallelize(k, ParallelUnit::CPUVector,
+                     OutputRaceStrategy::IgnoreRaces);
+    benchmark("SpMM", "scalar", scalar, expected, {A, B}, nullptr,
+              repetitions);
+    benchmark("SpMM", "vector", vector, C, {A, B}, &expected, repetitions);
+  }
+  return 0;
+}
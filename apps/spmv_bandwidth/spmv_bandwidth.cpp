@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "taco.h"
+#include "taco/index_notation/kernel.h"
+
+using namespace taco;
+
+// Compares the bandwidth of sparse matrix-vector multiplication with a matrix
+// whose column coordinates are stored compressed and bit-packed.
+
+static double milliseconds(std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static size_t storedBytes(const TensorBase& tensor) {
+  const Index& index = tensor.getStorage().getIndex();
+  size_t bytes = tensor.getStorage().getValues().getSize() * sizeof(double);
+  for (int i = 0; i < index.numModeIndices(); ++i) {
+    const ModeIndex modeIndex = index.getModeIndex(i);
+    for (int j = 0; j < modeIndex.numIndexArrays(); ++j) {
+      const Array array = modeIndex.getIndexArray(j);
+      bytes += array.getSize() * array.getType().getNumBytes();
+    }
+  }
+  return bytes;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <matrix.mtx> [repetitions]"
+              << std::endl;
+    return 1;
+  }
+  const std::string filename = argv[1];
+  const int repetitions = (argc > 2) ? atoi(argv[2]) : 10;
+
+  std::cout << "format\tnnz\tbytes\tspmv (ms)\tbandwidth (GB/s)" << std::endl;
+  for (ModeFormat modeFormat : {Compressed, BitPacked}) {
+    TensorBase A = read(filename, Format({Dense, modeFormat}));
+    const int rows = A.getDimension(0);
+    const int cols = A.getDimension(1);
+
+    Tensor<double> x("x", {cols}, Dense);
+    for (int j = 0; j < cols; ++j) {
+      x.insert({j}, 1.0 + j % 7);
+    }
+    x.pack();
+
+    IndexVar i, j;
+    Tensor<double> y("y", {rows}, Dense);
+    y(i) = A(i,j) * x(j);
+    y.evaluate();
+    Kernel spmv = compile(makeConcreteNotation(y.getAssignment()));
+    spmv.compute(y.getStorage(), A.getStorage(), x.getStorage());
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+      spmv.compute(y.getStorage(), A.getStorage(), x.getStorage());
+    }
+    const double time = milliseconds(begin) / repetitions;
+
+    const size_t nnz = A.getStorage().getValues().getSize();
+    const size_t bytes = storedBytes(A) + (size_t)(rows + cols) * sizeof(double);
+    std::cout << modeFormat << "\t" << nnz << "\t" << storedBytes(A) << "\t"
+              << time << "\t" << bytes / 1e6 / time << std::endl;
+  }
+  return 0;
+}
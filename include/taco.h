@@ -5,5 +5,6 @@
 #include "taco/format.h"
 #include "taco/index_notation/tensor_operator.h"
 #include "taco/index_notation/index_notation.h"
+#include "taco/parallel_runtime.h"
 
 #endif
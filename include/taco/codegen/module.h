@@ -1,9 +1,12 @@
 #ifndef TACO_MODULE_H
 #define TACO_MODULE_H
 
+#include <functional>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
+#include <thread>
 #include <utility>
 #include <random>
 
@@ -13,17 +16,73 @@
 namespace taco {
 namespace ir {
 
+class CodeGen_LLVM;
+class Module;
+
+/// The optimization tiers that a module can be compiled at.
+enum class CompilationTier {
+  /// Compiled quickly at a low optimization level, to answer the first calls
+  Baseline,
+  /// Compiled at full optimization
+  Optimized
+};
+
+/// Describes a module that has started to run code compiled at a new tier.
+struct TierTransition {
+  const Module* module;
+  CompilationTier tier;
+
+  /// How long it took to compile the module at this tier, in milliseconds
+  double compileTime;
+};
+
+/// Set a function to be called whenever a module starts running code compiled
+/// at a new tier. Optimized tiers are installed on a background thread, so the
+/// hook must be thread safe. Passing an empty function removes the hook.
+void setTierTransitionHook(std::function<void(const TierTransition&)> hook);
+
 class Module {
 public:
   /// Create a module for some target
   Module(Target target=getTargetFromEnvironment())
-    : lib_handle(nullptr), moduleFromUserSource(false), target(target) {
+    : moduleFromUserSource(false), target(target) {
     setJITLibname();
     setJITTmpdir();
   }
 
-  /// Compile the source into a library, returning its full path
+  /// Unload the compiled library, if any, waiting for background compilation
+  /// to finish first
+  ~Module();
+
+  /// Compile the source into a library, returning its full path. If the
+  /// target is compiled in memory (see Target), this returns the empty string.
+  ///
+  /// If tiered compilation is enabled by setting the TACO_TIERED_COMPILATION
+  /// environment variable to 1, the module is first compiled quickly at a low
+  /// optimization level and then recompiled at full optimization on a
+  /// background thread. Calls switch over to the optimized code once it is
+  /// ready, and the returned path is that of the baseline library. Baseline
+  /// C code is compiled with TACO_BASELINE_CFLAGS (-O0 by default).
   std::string compile();
+
+  /// Compile several modules at once. The source code of the modules is
+  /// generated on the calling thread, after which the modules are built in
+  /// parallel, on up to as many threads as there are hardware threads.
+  static void compile(const std::vector<std::shared_ptr<Module>>& modules);
+
+  /// Create a module that shares the compiled code of `module`, but exposes
+  /// function `functionNames.at(name)` of `module` as function `name`. This
+  /// lets functions that were compiled together be handed out separately.
+  static std::shared_ptr<Module>
+  alias(std::shared_ptr<Module> module,
+        std::map<std::string,std::string> functionNames);
+
+  /// Returns the tier of the code that calls into this module currently run.
+  CompilationTier getTier() const;
+
+  /// Block until the module has been recompiled at full optimization, if it
+  /// is being recompiled in the background.
+  void waitForOptimization();
   
   /// Compile the module into a source file located at the specified location
   /// path and prefix.  The generated source will be path/prefix.{.c|.bc, .h}
@@ -71,8 +130,22 @@ private:
   std::stringstream header;
   std::string libname;
   std::string tmpdir;
-  void* lib_handle;
   std::vector<Stmt> funcs;
+
+  // The library that calls are dispatched to, which is replaced atomically
+  // when an optimized library is installed. The library it replaces is kept
+  // in retiredLibrary, since callers may still run its functions.
+  struct Library;
+  std::shared_ptr<Library> library;
+  std::shared_ptr<Library> retiredLibrary;
+
+  // recompiles the module at full optimization when compiled in tiers
+  std::thread optimizer;
+
+  // the module whose functions this module exposes under other names, if the
+  // module was created by alias()
+  std::shared_ptr<Module> aliased;
+  std::map<std::string,std::string> aliasedNames;
   
   // true iff the module was created from user-provided source
   bool moduleFromUserSource;
@@ -81,6 +154,12 @@ private:
   
   void setJITLibname();
   void setJITTmpdir();
+  void generateSource();
+  std::function<std::string()> prepareCompile();
+  void installLibrary(std::shared_ptr<Library> library, double compileTime);
+
+  // true iff the parallel loops of the library run on the work-stealing runtime
+  bool usesParallelRuntime();
 
   static std::string chars;
   static std::default_random_engine gen;
@@ -67,10 +67,86 @@ public:
   /// Sets the types of the coordinate arrays for each level
   void setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTypes);
 
+  /// Sets the types of the position and coordinate arrays of every level.
+  /// The position type bounds the number of components that a level can
+  /// store and the coordinate type bounds its dimension, so 64-bit positions
+  /// are needed for tensors with more than 2^31 components, and narrow types
+  /// save memory bandwidth for small tensors. The coordinates of bit-packed
+  /// and bitmap levels are always stored in 32-bit words, and those of hashed
+  /// levels in signed integers.
+  void setIndexTypes(Datatype posType, Datatype crdType);
+
+  /// Sets the block size of every mode, which stores the tensor as a tensor of
+  /// fixed-size dense blocks (e.g. BCSR). The modes of the format then store
+  /// the blocks, and every block stores its components densely in the same
+  /// mode ordering. The dimensions of blocked tensors must be multiples of the
+  /// block sizes.
+  void setBlockSizes(const std::vector<int>& blockSizes);
+
+  /// Gets the block size of every mode, which is empty if the format is not
+  /// blocked.
+  const std::vector<int>& getBlockSizes() const;
+
+  /// True if the format stores the tensor as a tensor of dense blocks.
+  bool isBlocked() const;
+
+  /// Gets the format of the levels that a blocked format is stored in. Modes
+  /// `0..n-1` of the returned format index the blocks and modes `n..2n-1`
+  /// index the components in a block, where `n` is the order of the format.
+  Format getBlockLevelFormat() const;
+
+  /// Gets the dimensions of the levels that a tensor with dimensions
+  /// `dimensions` is stored in, in the mode order of `getBlockLevelFormat()`.
+  std::vector<int>
+  getBlockLevelDimensions(const std::vector<int>& dimensions) const;
+
+  /// Sets the chunk size `C` and the sorting window `σ` of a matrix format,
+  /// which stores the matrix in the sliced ELLPACK format SELL-C-σ. The rows
+  /// in every window of `σ` rows are sorted by decreasing length, and every
+  /// chunk of `C` consecutive sorted rows is padded to the length of its
+  /// longest row and stored column-major, so that a kernel can process the
+  /// rows of a chunk in lockstep. The sorting window must be 1 (no sorting)
+  /// or a multiple of the chunk size.
+  void setSlicing(int chunkSize, int sortWindow);
+
+  /// Gets the chunk size of a sliced format, which is 0 if the format is not
+  /// sliced.
+  int getChunkSize() const;
+
+  /// Gets the sorting window of a sliced format.
+  int getSortWindow() const;
+
+  /// True if the format stores the matrix in the sliced ELLPACK format.
+  bool isSliced() const;
+
+  /// Gets the format of the levels that a sliced format is stored in. Mode 0
+  /// of the returned format indexes the chunks, mode 1 the columns of the
+  /// padded rows of a chunk, mode 2 the rows of the matrix and mode 3 the
+  /// columns of the matrix.
+  Format getSlicedLevelFormat() const;
+
+  /// Gets the dimensions of the levels that a matrix with dimensions
+  /// `dimensions` is stored in, in the mode order of
+  /// `getSlicedLevelFormat()`.
+  std::vector<int>
+  getSlicedLevelDimensions(const std::vector<int>& dimensions) const;
+
+  /// Gets the format of the levels that tensors of the format are stored in,
+  /// which is the format itself unless it is blocked or sliced.
+  Format getLevelFormat() const;
+
+  /// Gets the dimensions of the levels that a tensor with dimensions
+  /// `dimensions` is stored in, in the mode order of `getLevelFormat()`.
+  std::vector<int>
+  getLevelDimensions(const std::vector<int>& dimensions) const;
+
 private:
   std::vector<ModeFormatPack> modeFormatPacks;
   std::vector<int> modeOrdering;
   std::vector<std::vector<Datatype>> levelArrayTypes;
+  std::vector<int> blockSizes;
+  int chunkSize = 0;
+  int sortWindow = 0;
 };
 
 bool operator==(const Format&, const Format&);
@@ -87,12 +163,20 @@ public:
   static ModeFormat dense;       /// e.g., first mode in CSR
   static ModeFormat compressed;  /// e.g., second mode in CSR
   static ModeFormat singleton;   /// e.g., second mode in COO
+  static ModeFormat bitpacked;   /// compressed with bit-packed coordinates
+  static ModeFormat hashed;      /// hash table per parent position
+  static ModeFormat bitmap;      /// bitmap per parent position
+  static ModeFormat sliced;      /// rows of the chunks of a SELL-C-σ matrix
 
   static ModeFormat sparse;      /// alias for compressed
   static ModeFormat Dense;       /// alias for dense
   static ModeFormat Compressed;  /// alias for compressed
   static ModeFormat Sparse;      /// alias for compressed
   static ModeFormat Singleton;   /// alias for singleton
+  static ModeFormat BitPacked;   /// alias for bitpacked
+  static ModeFormat Hashed;      /// alias for hashed
+  static ModeFormat Bitmap;      /// alias for bitmap
+  static ModeFormat Sliced;      /// alias for sliced
 
   /// Properties of a mode format
   enum Property {
@@ -190,11 +274,19 @@ extern const ModeFormat Dense;
 extern const ModeFormat Compressed;
 extern const ModeFormat Sparse;
 extern const ModeFormat Singleton;
+extern const ModeFormat BitPacked;
+extern const ModeFormat Hashed;
+extern const ModeFormat Bitmap;
+extern const ModeFormat Sliced;
 
 extern const ModeFormat dense;
 extern const ModeFormat compressed;
 extern const ModeFormat sparse;
 extern const ModeFormat singleton;
+extern const ModeFormat bitpacked;
+extern const ModeFormat hashed;
+extern const ModeFormat bitmap;
+extern const ModeFormat sliced;
 
 extern const Format CSR;
 extern const Format CSC;
@@ -203,6 +295,17 @@ extern const Format DCSC;
 
 const Format COO(int order, bool isUnique = true, bool isOrdered = true, 
                  bool isAoS = false, const std::vector<int>& modeOrdering = {});
+
+/// Blocked CSR, with dense blocks of `rowBlockSize` x `columnBlockSize`
+/// components.
+const Format BCSR(int rowBlockSize, int columnBlockSize);
+
+/// Blocked CSF, with dense blocks whose dimensions are given by `blockSizes`.
+const Format BCSF(const std::vector<int>& blockSizes);
+
+/// Sliced ELLPACK (SELL-C-σ), with chunks of `chunkSize` rows that are sorted
+/// by length within windows of `sortWindow` rows.
+const Format SELL(int chunkSize, int sortWindow = 1);
 /// @}
 
 /// True if all modes are dense.
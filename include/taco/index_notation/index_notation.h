@@ -723,6 +723,14 @@ public:
   /// assume that no data races will occur. For all other strategies other than Atomics,
   /// there is the precondition
   /// that the racing reduction must be over the index variable being parallelized.
+  ///
+  /// ParallelUnit::CPUMergePath splits the rows of a sparse matrix across CPU
+  /// threads by the number of rows plus nonzeros that every thread computes, so
+  /// that matrices with a few very long rows are balanced. It has the
+  /// precondition that `i` iterates over the dense rows of a matrix, and
+  /// directly contains a serial loop over the nonzeros of a compressed row that
+  /// sums into a dense vector indexed by `i` (e.g. SpMV). Rows split across
+  /// threads are summed in a serial pass after the parallel loop.
   IndexStmt parallelize(IndexVar i, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy) const;
 
   /// pos and coord create
@@ -819,6 +827,11 @@ public:
 /// Check if two index statements are isomorphic.
 bool isomorphic(IndexStmt, IndexStmt);
 
+/// Compute a structural hash of an index statement. The hash does not depend
+/// on the identity of the tensor and index variables, so isomorphic statements
+/// always hash to the same value.
+size_t structuralHash(IndexStmt);
+
 /// Compare two index statments by value.
 bool equals(IndexStmt, IndexStmt);
 
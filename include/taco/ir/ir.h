@@ -33,6 +33,8 @@ enum class IRNodeType {
   Max,
   BitAnd,
   BitOr,
+  Shl,
+  Shr,
   Not,
   Eq,
   Neq,
@@ -392,6 +394,26 @@ struct BitOr : public ExprNode<BitOr> {
   static const IRNodeType _type_info = IRNodeType::BitOr;
 };
 
+/** Left shift: a << b */
+struct Shl : public ExprNode<Shl> {
+  Expr a;
+  Expr b;
+
+  static Expr make(Expr a, Expr b);
+
+  static const IRNodeType _type_info = IRNodeType::Shl;
+};
+
+/** Right shift: a >> b, which is logical if a is unsigned */
+struct Shr : public ExprNode<Shr> {
+  Expr a;
+  Expr b;
+
+  static Expr make(Expr a, Expr b);
+
+  static const IRNodeType _type_info = IRNodeType::Shr;
+};
+
 /** Equality: a==b. */
 struct Eq : public ExprNode<Eq> {
   Expr a;
@@ -792,6 +814,10 @@ struct GetProperty : public ExprNode<GetProperty> {
   static Expr make(Expr tensor, TensorProperty property, int mode=0);
   static Expr make(Expr tensor, TensorProperty property, int mode,
                    int index, std::string name);
+
+  /// Make an `Indices` property whose array elements have the given type.
+  static Expr make(Expr tensor, TensorProperty property, int mode,
+                   int index, std::string name, Datatype type);
   
   static const IRNodeType _type_info = IRNodeType::GetProperty;
 };
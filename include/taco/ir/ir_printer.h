@@ -36,6 +36,8 @@ protected:
   virtual void visit(const Max*);
   virtual void visit(const BitAnd*);
   virtual void visit(const BitOr*);
+  virtual void visit(const Shl*);
+  virtual void visit(const Shr*);
   virtual void visit(const Eq*);
   virtual void visit(const Neq*);
   virtual void visit(const Gt*);
@@ -88,6 +90,8 @@ protected:
     REM = 5,
     ADD = 6,
     SUB = 6,
+    SHL = 7,
+    SHR = 7,
     EQ = 10,
     GT = 9,
     LT = 9,
@@ -16,6 +16,8 @@ struct Min;
 struct Max;
 struct BitAnd;
 struct BitOr;
+struct Shl;
+struct Shr;
 struct Eq;
 struct Neq;
 struct Gt;
@@ -69,6 +71,8 @@ public:
   virtual void visit(const Max*) = 0;
   virtual void visit(const BitAnd*) = 0;
   virtual void visit(const BitOr*) = 0;
+  virtual void visit(const Shl*) = 0;
+  virtual void visit(const Shr*) = 0;
   virtual void visit(const Eq*) = 0;
   virtual void visit(const Neq*) = 0;
   virtual void visit(const Gt*) = 0;
@@ -125,6 +129,8 @@ public:
   virtual void visit(const Max* op);
   virtual void visit(const BitAnd* op);
   virtual void visit(const BitOr* op);
+  virtual void visit(const Shl* op);
+  virtual void visit(const Shr* op);
   virtual void visit(const Eq* op);
   virtual void visit(const Neq* op);
   virtual void visit(const Gt* op);
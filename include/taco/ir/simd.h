@@ -0,0 +1,38 @@
+#ifndef TACO_IR_SIMD_H
+#define TACO_IR_SIMD_H
+
+#include <vector>
+
+#include "taco/ir/ir.h"
+
+namespace taco {
+namespace ir {
+
+/// The properties of a vectorized loop that decide whether its iterations can
+/// be executed in SIMD lanes.
+struct SimdLoop {
+  /// Whether no iteration of the loop depends on another, other than through
+  /// the reductions. Every element that the loop stores is then stored by
+  /// at most one iteration, and read by no other.
+  bool isIndependent = false;
+
+  /// The scalar variables, declared outside the loop, that every iteration
+  /// adds to and that are read nowhere else in the loop.
+  std::vector<Expr> reductions;
+};
+
+/// Determines whether the iterations of `loop` are independent of each other,
+/// and which scalars they sum into. Loops with other loop-carried dependences,
+/// or with statements that cannot be executed in SIMD lanes (e.g. while loops,
+/// breaks and allocations), are not independent.
+SimdLoop analyzeSimdLoop(const For* loop);
+
+/// Rewrites the vectorized loops of a statement that accumulate into an array
+/// element that does not depend on the loop (e.g. `y[i] = y[i] + A[p]*x[j]`)
+/// to accumulate into a scalar instead, which is added to the element after
+/// the loop. This turns the dependence through memory into a scalar reduction
+/// that the loop can be vectorized with.
+Stmt promoteSimdReductions(const Stmt& stmt);
+
+}}
+#endif
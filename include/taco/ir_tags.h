@@ -8,8 +8,9 @@ namespace taco {
 /// ParallelUnit::GPUBlock must be used with GPUThread to create blocks of GPU threads
 /// ParallelUnit::GPUWarp can be optionally used to allow for GPU warp-level primitives
 /// ParallelUnit::GPUThread causes for every iteration to be executed on a separate GPU thread
+/// ParallelUnit::CPUMergePath splits the rows and nonzeros of a sparse matrix evenly across CPU threads
 enum class ParallelUnit {
-  NotParallel, DefaultUnit, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, CPUThreadGroupReduction, GPUBlockReduction, GPUWarpReduction
+  NotParallel, DefaultUnit, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, CPUThreadGroupReduction, GPUBlockReduction, GPUWarpReduction, CPUMergePath
 };
 extern const char *ParallelUnit_NAMES[];
 
@@ -35,11 +36,24 @@ extern const char *AssembleStrategy_NAMES[];
 
 /// MergeStrategy::TwoFinger merges iterators by incrementing one at a time
 /// MergeStrategy::Galloping merges iterators by exponential search (galloping)
+/// MergeStrategy::SIMDBlock merges iterators by comparing blocks of
+/// coordinates with the coordinate they advance to at once
+/// MergeStrategy::Adaptive merges the iterators of every segment by galloping
+/// if the numbers of positions they iterate over are far apart, and with two
+/// fingers otherwise
 enum class MergeStrategy {
-  TwoFinger, Gallop
+  TwoFinger, Gallop, SIMDBlock, Adaptive
 };
 extern const char *MergeStrategy_NAMES[];
 
+/// Set the ratio between the numbers of positions that the longest and the
+/// shortest merged iterators of a segment must exceed for MergeStrategy::Adaptive
+/// to merge the segment by galloping. Applies to kernels lowered afterwards.
+void taco_set_adaptive_merge_threshold(int threshold);
+
+/// Get the ratio above which MergeStrategy::Adaptive merges by galloping.
+int taco_get_adaptive_merge_threshold();
+
 }
 
 #endif //TACO_IR_TAGS_H
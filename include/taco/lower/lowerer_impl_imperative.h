@@ -84,6 +84,18 @@ protected:
                                         std::set<Access> reducedAccesses,
                                         ir::Stmt recoveryStmt);
 
+  /// Lower a forall over the rows of a CSR matrix that is parallelized over
+  /// ParallelUnit::CPUMergePath. Every thread iterates over an equal share of
+  /// the rows and nonzeros, and the sums of the rows that threads share are
+  /// added to the result after the parallel loop.
+  virtual ir::Stmt lowerForallMergePath(Forall forall,
+                                        std::vector<Iterator> locaters,
+                                        std::vector<Iterator> inserters,
+                                        std::vector<Iterator> appenders,
+                                        MergeLattice caseLattice,
+                                        std::set<Access> reducedAccesses,
+                                        ir::Stmt recoveryStmt);
+
   /// Lower a forall that iterates over all the coordinates in the forall index
   /// var's dimension, and locates tensor positions from the locate iterators.
   virtual ir::Stmt lowerForallDenseAcceleration(Forall forall,
@@ -116,6 +128,18 @@ protected:
                                        std::set<Access> reducedAccesses,
                                        ir::Stmt recoveryStmt);
 
+  /// Lower a forall that iterates over the positions of a bitmap iterator and
+  /// locates into other bitmap iterators, by intersecting the bitmaps a word
+  /// at a time.
+  virtual ir::Stmt lowerForallBitmapIntersection(Forall forall,
+                                                 Iterator iterator,
+                                                 std::vector<Iterator> locaters,
+                                                 std::vector<Iterator> inserters,
+                                                 std::vector<Iterator> appenders,
+                                                 MergeLattice caseLattice,
+                                                 std::set<Access> reducedAccesses,
+                                                 ir::Stmt recoveryStmt);
+
   virtual ir::Stmt lowerForallFusedPosition(Forall forall, Iterator iterator,
                                        std::vector<Iterator> locaters,
                                        std::vector<Iterator> inserters,
@@ -147,7 +171,9 @@ protected:
      *      A concrete index notation statement to compute at the points in the
      *      sparse iteration space described by the merge lattice.
      * \param mergeStrategy
-     *      A strategy for merging iterators. One of TwoFinger or Gallop.
+     *      A strategy for merging iterators. One of TwoFinger, Gallop or
+     *      SIMDBlock (lowerMergeLattice resolves Adaptive to one of the first
+     *      two).
      *
      * \return
      *       IR code to compute the forall loop.
@@ -174,7 +200,8 @@ protected:
      *      sparse iteration space region described by the merge point.
      * \param mergeWithMax
      *      A boolean indicating whether coordinates should be combined with MAX instead of MIN.
-     *      MAX is needed when the iterators are merged with the Gallop strategy.
+     *      MAX is needed when the iterators are merged with the Gallop or
+     *      SIMDBlock strategies.
      */
   virtual ir::Stmt lowerMergePoint(MergeLattice pointLattice,
                                    ir::Expr coordinate, IndexVar coordinateVar, IndexStmt statement,
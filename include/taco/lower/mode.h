@@ -73,12 +73,18 @@ std::ostream& operator<<(std::ostream&, const Mode&);
 class ModePack {
 public:
   ModePack();
+  /// Create the arrays of a mode pack. Index arrays, whose elements are
+  /// 32-bit integers by default, are given the types in `arrayTypes` (the
+  /// type of array i of the pack is `arrayTypes[i]`).
   ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor, int mode, 
-           int level);
+           int level, std::vector<Datatype> arrayTypes = {});
 
   /// Returns number of tensor modes belonging to mode pack.
   size_t getNumModes() const;
 
+  /// Returns the number of arrays shared by tensor modes.
+  size_t getNumArrays() const;
+
   /// Returns arrays shared by tensor modes.
   ir::Expr getArray(size_t i) const;
 
@@ -0,0 +1,120 @@
+#ifndef TACO_MODE_FORMAT_BITMAP_H
+#define TACO_MODE_FORMAT_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "taco/lower/mode_format_compressed.h"
+
+namespace taco {
+
+/// A mode whose coordinates below every parent position are stored as a
+/// bitmap, for levels that are too sparse to store densely but too dense for
+/// a coordinate list to pay off. The positions of the level are packed, as
+/// those of a compressed mode, and the pos array is the same as that of a
+/// compressed mode.
+///
+/// The bitmap of parent position `p` is `nw = ceil(dim/32)` 32-bit words, and
+/// word `w` of the level is word `w - p*nw` of the bitmap of parent `p`. The
+/// crd array stores two entries per word of the level: the word itself,
+/// followed by the position of the first coordinate in the word. Locating a
+/// coordinate thus takes a bit test and a popcount of the bits before it.
+/// Loops over the positions of the level find the coordinates by scanning the
+/// words with count-trailing-zeros, and a loop that iterates over a bitmap
+/// level and locates into other bitmap levels ANDs the bitmaps a word at a
+/// time instead.
+///
+/// Results are assembled by appending ordered coordinates to the crd array,
+/// as for compressed modes, and building the bitmaps when the level is
+/// finalized. Since the coordinate of a position follows from the scan of the
+/// positions before it, bitmap levels must be ordered and unique, and they
+/// cannot be iterated with the schedules that skip or split positions
+/// (parallel or vectorized position loops, galloping, windows, index sets and
+/// position splits).
+class BitmapModeFormat : public CompressedModeFormat {
+public:
+  using ModeFormatImpl::getInsertCoord;
+
+  /// The number of coordinates in a word of the bitmaps.
+  static const int WORD_SIZE = 32;
+
+  BitmapModeFormat();
+  BitmapModeFormat(bool isZeroless, long long allocSize = DEFAULT_ALLOC_SIZE);
+
+  ~BitmapModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  ModeFunction coordBounds(ir::Expr parentPos, Mode mode) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Stmt getAppendCoord(ir::Expr pos, ir::Expr coord,
+                          Mode mode) const override;
+  ir::Stmt getAppendFinalizeLevel(ir::Expr parentSize, ir::Expr size,
+                                  Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the number of words in the bitmap of every parent position.
+  static ir::Expr getNumWords(Mode mode);
+
+  /// Returns the bits of word `word` of the level.
+  static ir::Expr loadWord(ir::Expr word, Mode mode);
+
+  /// Returns the position of the first coordinate in word `word` of the level.
+  static ir::Expr loadWordPos(ir::Expr word, Mode mode);
+
+  /// Returns the number of bits of `bits` below bit `bit`.
+  static ir::Expr countBitsBelow(ir::Expr bits, ir::Expr bit);
+
+  /// Returns the number of words in the bitmap of a mode of dimension
+  /// `dimension`.
+  static size_t getNumWords(size_t dimension);
+
+  /// Store the bitmaps of the `pos[numParents]` ordered coordinates in `crd`
+  /// below `numParents` parent positions into `words`, which must hold
+  /// `2*numParents*getNumWords(dimension)` entries.
+  template <typename P>
+  static void pack(const P* pos, const int32_t* crd, size_t numParents,
+                   size_t dimension, int32_t* words) {
+    const size_t numWords = getNumWords(dimension);
+    for (size_t p = 0; p < numParents; ++p) {
+      for (size_t w = p * numWords; w < (p + 1) * numWords; ++w) {
+        words[2 * w] = 0;
+      }
+      for (size_t q = pos[p]; q < (size_t)pos[p+1]; ++q) {
+        const size_t w = p * numWords + crd[q] / WORD_SIZE;
+        words[2 * w] |= (int32_t)((uint32_t)1 << (crd[q] % WORD_SIZE));
+      }
+      size_t q = pos[p];
+      for (size_t w = p * numWords; w < (p + 1) * numWords; ++w) {
+        words[2 * w + 1] = (int32_t)q;
+        q += countBits((uint32_t)words[2 * w]);
+      }
+    }
+  }
+
+  /// Returns the number of set bits in `bits`.
+  static int countBits(uint32_t bits);
+
+  /// Store the coordinates of the bitmaps of `numParents` parent positions in
+  /// `words` into `crd`, which must hold a coordinate for every set bit.
+  static void unpack(const int32_t* words, size_t numParents,
+                     size_t dimension, int32_t* crd);
+
+protected:
+  /// Returns the variable `name` of the scan over the words of the parent
+  /// position that the level is iterated below.
+  ir::Expr getScanVar(Mode mode, std::string name, Datatype type) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef TACO_MODE_FORMAT_BITPACKED_H
+#define TACO_MODE_FORMAT_BITPACKED_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "taco/lower/mode_format_compressed.h"
+
+namespace taco {
+
+/// A compressed mode whose coordinates are bit-packed to save memory
+/// bandwidth. The pos array is the same as that of a compressed mode, while
+/// the crd array holds 32-bit words. The positions of the level are split into
+/// fixed-size blocks of 32 positions, and the coordinates of each block are
+/// stored as deltas from the smallest coordinate in the block, packed into as
+/// few bits as the largest delta needs. Every coordinate can thus be decoded
+/// on its own, without the coordinates before it. Loops over the positions of
+/// the level decode the coordinates in-loop without a loop-carried dependence,
+/// so they can still be vectorized.
+///
+/// For a level with `n` positions and `nb = ceil(n/32)` blocks, the crd array
+/// starts with a header of two words per block, the smallest coordinate in
+/// the block followed by the word where the block's deltas start, and two more
+/// words that mark where the deltas of the last block end. A block of deltas
+/// of `w` bits takes exactly `w` words, so `w` is the difference between the
+/// start of the block and of the next block. The deltas are followed by two
+/// padding words.
+///
+/// Results are assembled by appending plain coordinates to the crd array, as
+/// for compressed modes, and packing them when the level is finalized. Bit-packed levels must be ordered and
+/// unique, and cannot be iterated with the schedules that search the crd array
+/// (galloping, windows, index sets and position splits).
+class BitPackedModeFormat : public CompressedModeFormat {
+public:
+  using ModeFormatImpl::getInsertCoord;
+
+  /// The number of positions in a block.
+  static const int BLOCK_SIZE = 32;
+
+  BitPackedModeFormat();
+  BitPackedModeFormat(bool isFull, bool isZeroless,
+                      long long allocSize = DEFAULT_ALLOC_SIZE);
+
+  ~BitPackedModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  ModeFunction coordBounds(ir::Expr parentPos, Mode mode) const override;
+
+  ir::Stmt getAppendCoord(ir::Expr pos, ir::Expr coord,
+                          Mode mode) const override;
+  ir::Stmt getAppendInitLevel(ir::Expr parentSize, ir::Expr size,
+                              Mode mode) const override;
+  ir::Stmt getAppendFinalizeLevel(ir::Expr parentSize, ir::Expr size,
+                                  Mode mode) const override;
+
+  /// Returns an upper bound on the number of words it takes to pack `n`
+  /// coordinates.
+  static size_t getMaxPackedSize(size_t n);
+
+  /// Pack the `n` coordinates in `crd` into `packed`, which must hold at least
+  /// `getMaxPackedSize(n)` words. Returns the number of words used.
+  static size_t pack(const int32_t* crd, size_t n, int32_t* packed);
+
+  /// Returns the number of words used to pack `n` coordinates.
+  static size_t getPackedSize(const int32_t* packed, size_t n);
+
+  /// Returns the coordinate at position `p` of the packed coordinates.
+  static int32_t unpack(const int32_t* packed, size_t p);
+
+protected:
+  ir::Expr getCoordBuffer(Mode mode) const;
+
+  /// Returns an expression that decodes the coordinate at position `pos`.
+  ir::Expr decode(ir::Expr pos, Mode mode) const;
+};
+
+}
+
+#endif
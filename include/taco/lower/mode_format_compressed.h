@@ -64,6 +64,12 @@ public:
   ir::Expr getWidth(Mode mode) const override;
 
 protected:
+  /// Create a variant of the compressed mode format with the given name.
+  CompressedModeFormat(std::string name, bool isFull, bool isOrdered,
+                       bool isUnique, bool isZeroless, bool hasSeqInsertEdge,
+                       bool hasInsertCoord, bool hasLocate,
+                       long long allocSize);
+
   ir::Expr getPosArray(ModePack pack) const;
   ir::Expr getCoordArray(ModePack pack) const;
 
@@ -0,0 +1,76 @@
+#ifndef TACO_MODE_FORMAT_HASHED_H
+#define TACO_MODE_FORMAT_HASHED_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A mode whose coordinates are stored in an open-addressing hash table per
+/// parent position, so that coordinates can be located in constant expected
+/// time. The table of parent position `p` is `[pos[p], pos[p+1])` in the crd
+/// array. Each slot of a table is a position of the level, where empty slots
+/// hold the coordinate -1 and have the fill value. A coordinate is hashed by
+/// multiplying it with a 32-bit constant modulo the capacity of the table, and
+/// collisions are resolved by linear probing.
+///
+/// Locating a coordinate that is not stored yields the empty slot where it
+/// would be inserted, whose value is the fill value. Operands packed from
+/// components get tables with `2n+1` slots for the `n` coordinates below every
+/// parent. Results are assembled by inserting coordinates in any order into
+/// tables that can hold every coordinate of the mode, so hashed result levels
+/// are meant to be used below few parents.
+class HashedModeFormat : public ModeFormatImpl {
+public:
+  using ModeFormatImpl::getInsertCoord;
+
+  HashedModeFormat();
+  HashedModeFormat(bool isZeroless);
+
+  ~HashedModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Stmt getInsertCoord(ir::Expr p, const std::vector<ir::Expr>& i,
+                          Mode mode) const override;
+  ir::Expr getWidth(Mode mode) const override;
+  ir::Stmt getInsertInitCoords(ir::Expr pBegin, ir::Expr pEnd,
+                               Mode mode) const override;
+  ir::Stmt getInsertInitLevel(ir::Expr szPrev, ir::Expr sz,
+                              Mode mode) const override;
+  ir::Stmt getInsertFinalizeLevel(ir::Expr szPrev, ir::Expr sz,
+                                  Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the capacity of the table that holds `n` coordinates.
+  static size_t getCapacity(size_t n);
+
+  /// Returns the slot where the probe sequence of `coord` starts in a table
+  /// of capacity `capacity`.
+  static size_t hash(int64_t coord, size_t capacity) {
+    return (uint32_t)((uint32_t)coord * 2654435761u) % capacity;
+  }
+
+protected:
+  ir::Expr getPosArray(ModePack pack) const;
+  ir::Expr getCoordArray(ModePack pack) const;
+  ir::Expr getSizeArray(ModePack pack) const;
+
+  ir::Expr getPosCapacity(Mode mode) const;
+  ir::Expr getCoordCapacity(Mode mode) const;
+};
+
+}
+
+#endif
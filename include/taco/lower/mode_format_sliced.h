@@ -0,0 +1,54 @@
+#ifndef TACO_MODE_FORMAT_SLICED_H
+#define TACO_MODE_FORMAT_SLICED_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// The level of the rows of a matrix in the sliced ELLPACK format SELL-C-σ,
+/// which is stored in the levels `{Dense, Compressed, Sliced, Singleton}`.
+/// The dense level indexes the chunks of `C` rows and the compressed level
+/// the columns of the padded rows of a chunk. Below every column `k` of a
+/// chunk, this level has one position per row of the chunk, so the positions
+/// of the rows are `k*C` to `k*C + C-1` and the rows of a chunk are stored
+/// column-major. Loops over the level are thus loops over the `C` lanes of a
+/// chunk with a constant trip count.
+///
+/// The rows of the matrix are sorted by length within windows of `σ` rows,
+/// so the rows array maps slot `c*C + lane` of chunk `c` to the row that it
+/// stores, or to -1 if the slot pads the last chunk. Slots past the end of a
+/// row are padded with explicit zeros. Sliced levels can only be iterated, so
+/// sliced matrices cannot be results.
+class SlicedModeFormat : public ModeFormatImpl {
+public:
+  /// The chunk size of the mode format `Sliced`.
+  static const int DEFAULT_CHUNK_SIZE = 8;
+
+  SlicedModeFormat();
+  SlicedModeFormat(int chunkSize);
+
+  ~SlicedModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the number of rows in a chunk.
+  int getChunkSize() const;
+
+protected:
+  ir::Expr getRowsArray(ModePack pack) const;
+
+  bool equals(const ModeFormatImpl& other) const override;
+
+  const int chunkSize;
+};
+
+}
+
+#endif
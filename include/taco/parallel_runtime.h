@@ -0,0 +1,79 @@
+/// This file declares the work-stealing runtime that the parallel loops of
+/// generated C code can run on instead of OpenMP, and the C ABI that generated
+/// code calls it through.
+/// The runtime struct *must* be kept in sync with the version emitted in
+/// codegen_c.cpp.
+
+#ifndef TACO_PARALLEL_RUNTIME_H
+#define TACO_PARALLEL_RUNTIME_H
+
+#include <stdint.h>
+
+namespace taco {
+
+/// The runtimes that the parallel loops of generated C code can run on.
+/// ParallelRuntime::OpenMP emits OpenMP pragmas, which run in parallel when
+/// taco is built with OpenMP. ParallelRuntime::WorkStealing emits the bodies
+/// of parallel loops as functions that are run by taco_parallel_for on a pool
+/// of threads that is shared by all kernels, whether or not taco is built with
+/// OpenMP.
+enum class ParallelRuntime {
+  OpenMP, WorkStealing
+};
+
+/// Set the runtime that the parallel loops of kernels that are compiled from
+/// now on run on.
+void taco_set_parallel_runtime(ParallelRuntime runtime);
+
+/// Get the runtime that the parallel loops of kernels that are compiled from
+/// now on run on.
+ParallelRuntime taco_get_parallel_runtime();
+
+}
+
+extern "C" {
+
+/// The body of a parallel loop, which runs iterations [begin,end) with the
+/// variables that it captures from the enclosing kernel in `ctx`.
+typedef void (*taco_parallel_body_t)(void* ctx, int64_t begin, int64_t end);
+
+/// The functions of the runtime that a compiled library calls, which are
+/// filled in by the module that loads it.
+typedef struct taco_parallel_runtime_t {
+  void (*parallel_for)(int64_t, int64_t, int64_t, taco_parallel_body_t, void*);
+  int  (*thread_num)(void);
+  int  (*max_threads)(void);
+} taco_parallel_runtime_t;
+
+/// Run the iterations [begin,end) of a loop in parallel and return when all of
+/// them have run. The range is split in halves down to ranges of `grain`
+/// iterations (or a range chosen by the runtime if `grain` is not positive),
+/// which idle threads steal. Loops may be nested, in which case the threads
+/// that wait for an inner loop help to run its iterations.
+void taco_parallel_for(int64_t begin, int64_t end, int64_t grain,
+                       taco_parallel_body_t body, void* ctx);
+
+/// Get the index of the calling thread among the threads that run the
+/// innermost parallel loop that it is in, which is less than the value of
+/// taco_parallel_max_threads() when the loop started. Returns 0 outside of
+/// parallel loops.
+int taco_parallel_thread_num(void);
+
+/// Get the number of threads that parallel loops started by the calling thread
+/// may run on. Loops inherit the limit of the loop they are nested in.
+int taco_parallel_max_threads(void);
+
+/// Set the number of threads that parallel loops started by the calling
+/// thread may run on, and return the previous limit. The limit only applies
+/// to the calling thread, so threads that call kernels concurrently can use
+/// different limits. A limit that is not positive means that kernels run on
+/// taco_get_num_threads() threads, and that loops called directly run on one
+/// thread per hardware thread.
+int taco_parallel_set_thread_limit(int limit);
+
+/// Get the limit that was set by the calling thread, or 0 if none was set.
+int taco_parallel_get_thread_limit(void);
+
+}
+
+#endif
@@ -24,6 +24,11 @@ public:
   /// Construct an array of elements of the given type.
   Array(Datatype type, void* data, size_t size, Policy policy=Free);
 
+  /// Construct an array of elements of the given type that are owned by
+  /// another object, such as a memory-mapped file. The owner is kept alive for
+  /// as long as the array is.
+  Array(Datatype type, void* data, size_t size, std::shared_ptr<void> owner);
+
   /// Returns the type of the array elements
   const Datatype& getType() const;
 
@@ -0,0 +1,83 @@
+#ifndef TACO_STORAGE_COORDINATE_BUFFER_H
+#define TACO_STORAGE_COORDINATE_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "taco/type.h"
+#include "taco/error.h"
+#include "taco/util/uncopyable.h"
+
+namespace taco {
+
+/// A buffer of the components that have been inserted into a tensor but not
+/// yet packed. The coordinates of every mode are stored in their own column,
+/// and the values in a column of the tensor's component type, so that pack
+/// can sort the components and hand the columns to the packer without first
+/// separating the coordinates from each other and from the values.
+///
+/// The columns grow geometrically, with `realloc`, so large buffers usually
+/// grow in place instead of being copied. `reserve` sets the capacity up
+/// front if the number of components is known.
+class CoordinateBuffer : util::Uncopyable {
+public:
+  /// Create an empty buffer of components of a tensor of the given order and
+  /// component type.
+  CoordinateBuffer(int order, Datatype type);
+  ~CoordinateBuffer();
+
+  /// Returns the number of buffered components.
+  size_t size() const {
+    return numComponents;
+  }
+
+  /// Make room for at least `capacity` components.
+  void reserve(size_t capacity);
+
+  /// Append a component, whose value must have the component type.
+  template <typename CType>
+  void push(const int* coordinate, CType value) {
+    taco_iassert(sizeof(CType) == type.getNumBytes());
+    if (numComponents == capacity) {
+      reserve(capacity == 0 ? 16 : 2 * capacity);
+    }
+    for (int i = 0; i < order; ++i) {
+      columns[i][numComponents] = coordinate[i];
+    }
+    ((CType*)values)[numComponents] = value;
+    numComponents++;
+  }
+
+  /// Append `numComponents` components, whose coordinates are stored next to
+  /// each other in `coordinates`.
+  void push(const int* coordinates, const void* values, size_t numComponents);
+
+  /// Append `numComponents` components, where `coordinates[i]` holds the
+  /// coordinates of the i-th mode.
+  void push(const std::vector<const int*>& coordinates, const void* values,
+            size_t numComponents);
+
+  /// Returns the coordinates of a mode.
+  const int* getCoordinates(int mode) const {
+    return columns[mode];
+  }
+
+  /// Returns the values.
+  const void* getValues() const {
+    return values;
+  }
+
+  /// Remove all components and release the memory of the buffer.
+  void clear();
+
+private:
+  int order;
+  Datatype type;
+  size_t numComponents;
+  size_t capacity;
+  std::vector<int*> columns;
+  char* values;
+};
+
+}
+#endif
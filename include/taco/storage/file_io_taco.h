@@ -0,0 +1,60 @@
+/// Read and write the taco binary tensor format, which stores a packed tensor
+/// as-is so that it can be used without parsing or packing it again.
+
+#ifndef TACO_FILE_IO_TACO_H
+#define TACO_FILE_IO_TACO_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "taco/format.h"
+
+namespace taco {
+class TensorBase;
+class Format;
+
+/// Read a taco tensor from a file in the format it was written in. The file
+/// is memory-mapped and the tensor's index arrays and values refer directly
+/// to the mapped file, so nothing is copied or packed. Writes to the arrays
+/// are private to the process.
+TensorBase readTACO(std::string filename);
+
+/// Read a taco tensor from a file. If the tensor was written in a different
+/// format, it is converted to the given format.
+TensorBase readTACO(std::string filename, const ModeFormat& modetype,
+                    bool pack=true);
+
+/// Read a taco tensor from a file. If the tensor was written in a different
+/// format, it is converted to the given format.
+TensorBase readTACO(std::string filename, const Format& format,
+                    bool pack=true);
+
+/// Read a taco tensor from a stream.
+TensorBase readTACO(std::istream& stream, const ModeFormat& modetype,
+                    bool pack=true);
+
+/// Read a taco tensor from a stream.
+TensorBase readTACO(std::istream& stream, const Format& format,
+                    bool pack=true);
+
+/// Write a taco tensor to a file.
+void writeTACO(std::string filename, const TensorBase& tensor);
+
+/// Write a taco tensor to a stream.
+void writeTACO(std::ostream& stream, const TensorBase& tensor);
+
+/// Convert a tensor in a .tns or coordinate .mtx file, which may be larger
+/// than memory, to a .taco file in the given format of dense, compressed and
+/// singleton modes. The components are read in batches of about a quarter of
+/// `memoryLimit` bytes of text, which are sorted and spilled to temporary
+/// files next to the output file. The sorted runs are then merged while the
+/// index arrays of the format are written out, so the components are never
+/// all held in memory. Duplicate coordinates are summed. The result can be
+/// loaded with `readTACO`, which memory-maps it.
+void convertToTACO(std::string inputFilename, std::string outputFilename,
+                   const Format& format, size_t memoryLimit=(size_t)1 << 30);
+
+}
+#endif
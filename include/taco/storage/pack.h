@@ -30,6 +30,44 @@ TensorStorage pack(Datatype                             datatype,
                    const void*                          values,
                    const Literal&                       fill);
 
+/// Returns true if `packSorted` can pack into the format, which is the case
+/// for chains of dense, compressed and singleton modes with integer position
+/// and coordinate arrays of any width (e.g., dense arrays, CSR, CSC, DCSR,
+/// CSF and COO, in any mode ordering).
+bool canPackSorted(const Format& format);
+
+/// Pack coordinates into the storage's format without generating code. The
+/// coordinates must be stored as a structure of arrays, with
+/// `coordinates[i]` holding the coordinates of the i-th mode in storage
+/// order, and must be sorted lexicographically in that order. Duplicate
+/// coordinates are summed. Index arrays are built from prefix sums over the
+/// coordinates, in parallel for large inputs, and have the types of the
+/// format's level arrays. Positions or coordinates that do not fit in those
+/// types are reported as errors.
+void packSorted(TensorStorage storage,
+                const std::vector<const int*>& coordinates,
+                const void* values, size_t numCoordinates);
+
+/// Returns true if `mergeSorted` can add coordinates to the storage, which is
+/// the case if it has been packed into an ordered format that `canPackSorted`
+/// accepts.
+bool canMergeSorted(const TensorStorage& storage);
+
+/// Add coordinates, which must be sorted as for `packSorted`, to a storage
+/// that has already been packed. The stored components are merged with the
+/// new ones and the result is packed again, so only the new coordinates need
+/// to be sorted and the time is linear in the size of the result. Duplicate
+/// coordinates are summed.
+void mergeSorted(TensorStorage storage,
+                 const std::vector<const int*>& coordinates,
+                 const void* values, size_t numCoordinates);
+
+/// Pack the components of the CSR matrix `csr` into the storage of a sliced
+/// matrix (see `Format::setSlicing`). The rows in every sorting window are
+/// sorted by decreasing length, with ties kept in row order, and the slots
+/// past the end of a row hold the fill value at the row's last column.
+void packSliced(TensorStorage storage, const TensorStorage& csr);
+
 template<typename V, size_t O, typename C>
 TensorStorage pack(std::vector<int> dimensions, Format format,
                    const std::vector<std::pair<Coordinates<O,C>,V>>& components,
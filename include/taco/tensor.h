@@ -21,6 +21,7 @@
 #include "taco/storage/array.h"
 #include "taco/storage/typed_vector.h"
 #include "taco/storage/typed_index.h"
+#include "taco/storage/coordinate_buffer.h"
 
 #include "taco/error.h"
 #include "taco/error/error_messages.h"
@@ -127,7 +128,8 @@ public:
   /// Get the expression to be evaluated when calling compute or assemble.
   Assignment getAssignment() const;
 
-  /// Reserve space for `numCoordinates` additional coordinates.
+  /// Reserve space for `numCoordinates` additional coordinates, so that
+  /// inserting them does not grow the insert buffer.
   void reserve(size_t numCoordinates);
 
   /* --- Write Methods       --- */
@@ -142,6 +144,19 @@ public:
   template <typename CType>
   void insert(const std::vector<int>& coordinate, CType value);
 
+  /// Insert `numValues` values into the tensor. The coordinates of the i-th
+  /// value are `coordinates[i*order]` through `coordinates[(i+1)*order-1]`.
+  /// Large insertions are split across threads.
+  template <typename CType>
+  void insert(const int* coordinates, const CType* values, size_t numValues);
+
+  /// Insert `numValues` values into the tensor. The coordinates of the i-th
+  /// value are `coordinates[0][i]` through `coordinates[order-1][i]`, so each
+  /// mode's coordinates are copied into the insert buffer in one block.
+  template <typename CType>
+  void insert(const std::vector<const int*>& coordinates, const CType* values,
+              size_t numValues);
+
   /// Fill the tensor with the list of components defined by the iterator range (begin, end).
   ///
   /// The input list of triplets does not have to be sorted, and can contains duplicated elements.
@@ -294,16 +309,21 @@ public:
         tensor(tensor),
         tensorStorage(tensor->getStorage()),
         tensorOrder(tensor->getOrder()),
+        levelOrder(tensor->getFormat().getLevelFormat().getOrder()),
+        blockSizes(tensor->getFormat().getBlockSizes()),
         bufferCapacity(100),
         bufferSize(0),
         bufferPos(bufferSize),
         chunksIterated(-1),
-        ctx(isEnd ? nullptr : makeContext(tensorOrder, bufferCapacity)), 
+        ctx(isEnd ? nullptr : makeContext(levelOrder, bufferCapacity)), 
         valBuffer(ctx ? ctx->valBuffer : nullptr),
         curVal(Coordinates(tensorOrder), (CType)0) {
       if (!isEnd) {
-        const auto helperFuncs = tensor->getHelperFunctions(tensor->getFormat(), 
-            tensor->getComponentType(), tensor->getDimensions());
+        // Hold on to the helper module so that it stays loaded even if it is
+        // evicted from the cache while the tensor is being iterated.
+        const Format& format = tensor->getFormat();
+        helperFuncs = tensor->getHelperFunctions(format.getLevelFormat(),
+                                                 tensor->getComponentType());
         *reinterpret_cast<void**>(&iterFunc) = 
             helperFuncs->getFuncPtr("_shim_iterate");
         ++(*this);
@@ -324,6 +344,28 @@ public:
                                   (void*)valBuffer, (void*)&bufferCapacity, 
                                   (void*)tensorStorage};
       bufferSize = iterFunc(args.data());
+
+      // Combine the coordinates of the blocks and of the components in the
+      // blocks of blocked tensors, in place. The coordinates of sliced
+      // matrices are those of their last levels.
+      if (!blockSizes.empty()) {
+        for (int i = 0; i < bufferSize; ++i) {
+          const T* levelCoords = &ctx->coordBuffer[i * levelOrder];
+          for (int mode = 0; mode < tensorOrder; ++mode) {
+            ctx->coordBuffer[i * tensorOrder + mode] =
+                levelCoords[mode] * blockSizes[mode] +
+                levelCoords[tensorOrder + mode];
+          }
+        }
+      } else if (levelOrder != tensorOrder) {
+        for (int i = 0; i < bufferSize; ++i) {
+          const T* levelCoords = &ctx->coordBuffer[i * levelOrder];
+          for (int mode = 0; mode < tensorOrder; ++mode) {
+            ctx->coordBuffer[i * tensorOrder + mode] =
+                levelCoords[levelOrder - tensorOrder + mode];
+          }
+        }
+      }
     }
 
     typedef int (*fnptr_t)(void**);
@@ -331,10 +373,13 @@ public:
     const TensorBase*              tensor;
     const taco_tensor_t*           tensorStorage;
     const int                      tensorOrder;
+    const int                      levelOrder;
+    const std::vector<int>         blockSizes;
     const int                      bufferCapacity;
     int                            bufferSize;
     int                            bufferPos;
     int64_t                        chunksIterated;
+    std::shared_ptr<ir::Module>    helperFuncs;
     fnptr_t                        iterFunc;
     const std::shared_ptr<Context> ctx;
     const CType*                   valBuffer;
@@ -424,6 +469,12 @@ public:
 
   void compile(IndexStmt stmt, bool assembleWhileCompute=false);
 
+  /// Compile the expressions of several tensors at once. The kernels are
+  /// lowered one tensor at a time, but are then grouped into a few modules
+  /// that are compiled in parallel (see ir::Module::compile), which is much
+  /// faster than compiling the tensors one by one.
+  static void compile(std::vector<TensorBase> tensors);
+
   /// Assemble the tensor storage, including index and value arrays.
   void assemble();
 
@@ -500,13 +551,14 @@ public:
   friend struct AccessTensorNode;
   std::vector<TensorBase> getDependentTensors();
 private:
-  static std::shared_ptr<ir::Module> getHelperFunctions(
-      const Format& format, Datatype ctype, const std::vector<int>& dimensions);
+  static std::shared_ptr<ir::Module> getHelperFunctions(const Format& format,
+                                                        Datatype ctype);
   static std::shared_ptr<ir::Module> getComputeKernel(const IndexStmt stmt);
   static void cacheComputeKernel(const IndexStmt stmt, 
                                  const std::shared_ptr<ir::Module> kernel);
 
   /* --- Compiler Methods --- */
+  IndexStmt getConcreteAssignment();
   bool neverPacked();
 
   void unsetNeverPacked();
@@ -537,20 +589,35 @@ private:
   template <typename CType>
   void reinsertPackedComponents();
 
+  /// Pack the buffered components of a blocked tensor.
+  void packBlocked();
+
+  /// Pack the buffered components of a sliced matrix.
+  void packSliced();
+
+  /// Compile the assignment of a tensor whose assignment accesses blocked or
+  /// sliced tensors, as described at `compileViews` in tensor.cpp.
+  void compileViews();
+
+  /// Share the arrays of the tensors of a kernel that is compiled for views
+  /// with their views.
+  void refreshViews();
+
+  /// Take the arrays that a kernel compiled for views computed from the view
+  /// of the result.
+  void unpackViewResult();
+
   struct Content;
   std::shared_ptr<Content> content;
 
-  typedef std::vector<std::tuple<Format,
-                                 Datatype,
-                                 std::vector<int>,
-                                 std::shared_ptr<ir::Module>>> HelperFuncsCache;
+  template <typename Key>
+  class ModuleCache;
+
+  typedef ModuleCache<std::pair<Format,Datatype>> HelperFuncsCache;
   static HelperFuncsCache helperFunctions;
-  static std::mutex helperFunctionsMutex;
 
-  typedef std::vector<std::pair<IndexStmt, 
-                                std::shared_ptr<ir::Module>>> KernelsCache;
+  typedef ModuleCache<IndexStmt> KernelsCache;
   static KernelsCache computeKernels;
-  static std::mutex computeKernelsMutex;
 };
 
 /// A reference to a tensor. Tensor object copies copies the reference, and
@@ -727,7 +794,12 @@ enum class FileType {
   ttx,
 
   /// .rb  - The rutherford-boeing sparse matrix format.
-  rb
+  rb,
+
+  /// .taco - The taco binary tensor format.  It stores the format, dimensions
+  ///         and fill value of a packed tensor followed by its index arrays
+  ///         and values, so it is loaded by memory-mapping the file.
+  taco
 };
 
 /// Read a tensor from a file. The file format is inferred from the filename
@@ -818,6 +890,11 @@ void getCSRArrays(const TensorBase& tensor,
   *vals   = static_cast<T*>(storage.getValues().getData());
 }
 
+/// Convert a CSR matrix to the sliced ELLPACK format
+/// `SELL(chunkSize, sortWindow)`. The result has its own arrays.
+TensorBase makeSELL(const std::string& name, const TensorBase& csr,
+                    int chunkSize, int sortWindow = 1);
+
 /// Factory function to construct a compressed sparse columns (CSC) matrix. The
 /// arrays remain owned by the user and will not be freed by taco.
 template<typename T>
@@ -905,9 +982,12 @@ struct TensorBase::Content {
   bool               assembleWhileCompute;
   std::shared_ptr<ir::Module> module;
 
-  size_t             coordinateBufferUsed;
-  size_t             coordinateSize;
-  std::shared_ptr<std::vector<char>> coordinateBuffer;
+  std::shared_ptr<CoordinateBuffer> coordinateBuffer;
+
+  // Views of the result and operands of an assignment that accesses blocked
+  // or sliced tensors, which the kernel is compiled for
+  std::shared_ptr<TensorBase> viewResult;
+  std::vector<std::pair<TensorBase,TensorBase>> viewOperands;
 
   bool               neverPacked;
   bool               needsPack;
@@ -944,16 +1024,7 @@ void TensorBase::insert(const std::initializer_list<int>& coordinate, CType valu
   "Cannot insert a value of type '" << type<CType>() << "' " <<
   "into a tensor with component type " << getComponentType();
   syncDependentTensors();
-  if ((content->coordinateBuffer->size() - content->coordinateBufferUsed) < content->coordinateSize) {
-    content->coordinateBuffer->resize(content->coordinateBuffer->size() + content->coordinateSize);
-  }
-  int* coordLoc = (int*)&content->coordinateBuffer->data()[content->coordinateBufferUsed];
-  for (int idx : coordinate) {
-    *(coordLoc++) = idx;
-  }
-  TypedComponentPtr valLoc(getComponentType(), coordLoc);
-  *valLoc = TypedComponentVal(getComponentType(), &value);
-  content->coordinateBufferUsed += content->coordinateSize;
+  content->coordinateBuffer->push(coordinate.begin(), value);
   setNeedsPack(true);
 }
 
@@ -964,6 +1035,30 @@ void TensorBase::insert(const std::vector<int>& coordinate, CType value) {
   setNeedsPack(true);
 }
 
+template <typename CType>
+void TensorBase::insert(const int* coordinates, const CType* values,
+                        size_t numValues) {
+  taco_uassert(getComponentType() == type<CType>()) <<
+    "Cannot insert a value of type '" << type<CType>() << "' " <<
+    "into a tensor with component type " << getComponentType();
+  syncDependentTensors();
+  content->coordinateBuffer->push(coordinates, values, numValues);
+  setNeedsPack(true);
+}
+
+template <typename CType>
+void TensorBase::insert(const std::vector<const int*>& coordinates,
+                        const CType* values, size_t numValues) {
+  taco_uassert(coordinates.size() == (size_t)getOrder()) <<
+    "Wrong number of coordinate arrays";
+  taco_uassert(getComponentType() == type<CType>()) <<
+    "Cannot insert a value of type '" << type<CType>() << "' " <<
+    "into a tensor with component type " << getComponentType();
+  syncDependentTensors();
+  content->coordinateBuffer->push(coordinates, values, numValues);
+  setNeedsPack(true);
+}
+
 template <typename CType>
 void TensorBase::insertUnsynced(const std::vector<int>& coordinate, CType value) {
   taco_uassert(coordinate.size() == (size_t)getOrder()) <<
@@ -971,32 +1066,14 @@ void TensorBase::insertUnsynced(const std::vector<int>& coordinate, CType value)
   taco_uassert(getComponentType() == type<CType>()) <<
     "Cannot insert a value of type '" << type<CType>() << "' " <<
     "into a tensor with component type " << getComponentType();
-  if ((content->coordinateBuffer->size() - content->coordinateBufferUsed) < content->coordinateSize) {
-    content->coordinateBuffer->resize(content->coordinateBuffer->size() + content->coordinateSize);
-  }
-  int* coordLoc = (int*)&content->coordinateBuffer->data()[content->coordinateBufferUsed];
-  for (int idx : coordinate) {
-    *(coordLoc++) = idx;
-  }
-  TypedComponentPtr valLoc(getComponentType(), coordLoc);
-  *valLoc = TypedComponentVal(getComponentType(), &value);
-  content->coordinateBufferUsed += content->coordinateSize;
+  content->coordinateBuffer->push(coordinate.data(), value);
 }
   
 template <typename T, typename CType>
 void TensorBase::insertUnchecked(
     const typename TensorBase::const_iterator<T,CType>::Coordinates& coordinate, 
     CType value) {
-  if ((content->coordinateBuffer->size() - content->coordinateBufferUsed) < content->coordinateSize) {
-    content->coordinateBuffer->resize(content->coordinateBuffer->size() + content->coordinateSize);
-  }
-  int* coordLoc = (int*)&content->coordinateBuffer->data()[content->coordinateBufferUsed];
-  for (size_t i = 0; i < coordinate.getOrder(); ++i) {
-    *(coordLoc++) = coordinate[i];
-  }
-  TypedComponentPtr valLoc(getComponentType(), coordLoc);
-  *valLoc = TypedComponentVal(getComponentType(), &value);
-  content->coordinateBufferUsed += content->coordinateSize;
+  content->coordinateBuffer->push(&coordinate[0], value);
 }
 
 template <typename CType>
@@ -4,6 +4,8 @@
 #include <string>
 #include <fstream>
 
+#include "taco/util/uncopyable.h"
+
 namespace taco {
 namespace util {
 
@@ -11,5 +13,26 @@ std::string sanitizePath(std::string path);
 
 void openStream(std::fstream& stream, std::string path, std::fstream::openmode mode);
 
+/// A read-only memory map of a file, which lets readers parse a file in place
+/// and in parallel without first copying it into memory.
+class MappedFile : Uncopyable {
+public:
+  /// Map the file at the given path into memory. If `copyOnWrite` is true the
+  /// mapped memory may be written to, and the writes are private to the
+  /// process and never reach the file.
+  MappedFile(std::string path, bool copyOnWrite=false);
+  ~MappedFile();
+
+  /// Returns the contents of the file.
+  const char* getData() const;
+
+  /// Returns the size of the file in bytes.
+  size_t getSize() const;
+
+private:
+  const char* data;
+  size_t size;
+};
+
 }}
 #endif
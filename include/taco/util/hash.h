@@ -0,0 +1,47 @@
+#ifndef TACO_UTIL_HASH_H
+#define TACO_UTIL_HASH_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace taco {
+namespace util {
+
+/// Hash a byte range using 64-bit FNV-1a. Unlike std::hash, the result is
+/// stable across processes, platforms and standard library implementations,
+/// so it may be used to name persistent files.
+inline uint64_t fnv1a(const void* data, size_t size,
+                      uint64_t hash=0xcbf29ce484222325ull) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+/// Hash a string using 64-bit FNV-1a.
+inline uint64_t fnv1a(const std::string& str,
+                      uint64_t hash=0xcbf29ce484222325ull) {
+  return fnv1a(str.data(), str.size(), hash);
+}
+
+/// Mix the hash `value` into `seed`.
+inline void hashCombine(size_t& seed, size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+/// Format a 64-bit hash as a fixed-width hexadecimal string.
+inline std::string toHexString(uint64_t hash) {
+  static const char digits[] = "0123456789abcdef";
+  std::string str(16, '0');
+  for (int i = 15; i >= 0; --i) {
+    str[i] = digits[hash & 0xf];
+    hash >>= 4;
+  }
+  return str;
+}
+
+}}
+#endif
@@ -0,0 +1,23 @@
+#ifndef TACO_UTIL_PARALLEL_H
+#define TACO_UTIL_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace taco {
+namespace util {
+
+/// Returns the number of threads to use for `n` units of work if every thread
+/// should get at least `grain` units. A `maxThreads` of 0 means one thread per
+/// hardware thread.
+size_t getNumWorkers(size_t n, size_t grain, size_t maxThreads=0);
+
+/// Splits [0,n) into `numWorkers` contiguous ranges and calls
+/// `f(worker, begin, end)` for each of them on its own thread. The calling
+/// thread runs the first range. If any call throws, the first exception is
+/// rethrown after all threads have finished.
+void parallelFor(size_t n, size_t numWorkers,
+                 const std::function<void(size_t,size_t,size_t)>& f);
+
+}}
+#endif
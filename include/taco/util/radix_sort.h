@@ -0,0 +1,26 @@
+#ifndef TACO_UTIL_RADIX_SORT_H
+#define TACO_UTIL_RADIX_SORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace taco {
+namespace util {
+
+/// Returns the permutation that stably sorts `n` records lexicographically by
+/// their integer key fields, so that record `perm[0]` comes first. Field `j`
+/// of record `i` is the int at `(const char*)fields[j] + i*stride` and
+/// `fields[0]` is the most significant field. Keys are compared as unsigned
+/// integers.
+///
+/// The fields are packed into 64-bit keys that use only as many bits as the
+/// largest value of each field needs, and the keys are sorted with a
+/// least-significant-digit radix sort. Every pass is split across up to
+/// `maxThreads` threads (0 means one per hardware thread).
+std::vector<uint32_t> radixSortPermutation(const std::vector<const void*>& fields,
+                                           size_t stride, size_t n,
+                                           size_t maxThreads=0);
+
+}}
+#endif
@@ -29,6 +29,7 @@ protected:
 
   static std::string printCType(Datatype type, bool is_ptr);
   static std::string printCUDAType(Datatype type, bool is_ptr);
+  static std::string printIndexType(Datatype type);
 
   static std::string printCAlloc(std::string pointer, std::string size);
   static std::string printCUDAAlloc(std::string pointer, std::string size);
@@ -6,6 +6,10 @@
 #include <taco.h>
 
 #include "taco/ir/ir_visitor.h"
+#include "taco/ir/ir_rewriter.h"
+#include "taco/ir/simd.h"
+#include "taco/ir/simplify.h"
+#include "taco/parallel_runtime.h"
 #include "codegen_c.h"
 #include "taco/error.h"
 #include "taco/util/strings.h"
@@ -39,6 +43,8 @@ const string cHeaders =
   "#endif\n"
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
+  "#define taco_ctz(_w) __builtin_ctz(_w)\n"
+  "#define taco_popcount(_w) __builtin_popcount(_w)\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
@@ -84,6 +90,42 @@ const string cHeaders =
   "  }\n"
   "  return curr+1;\n"
   "}\n"
+  // Increment arrayStart until array[arrayStart] >= target or arrayStart >= arrayEnd
+  // by comparing blocks of TACO_SIMD_BLOCK coordinates with the target at once.
+  // Since the array is sorted, the number of coordinates of a block that are
+  // less than the target is the number of positions to advance by.
+  "#ifndef TACO_SIMD_BLOCK\n"
+  "#define TACO_SIMD_BLOCK 8\n"
+  "#endif\n"
+  "#if defined(__GNUC__)\n"
+  "typedef int taco_simd_block __attribute__((vector_size(TACO_SIMD_BLOCK * sizeof(int))));\n"
+  "#endif\n"
+  "int taco_simdAdvance(int *array, int arrayStart, int arrayEnd, int target) {\n"
+  "  int curr = arrayStart;\n"
+  "  if (curr >= arrayEnd || array[curr] >= target) {\n"
+  "    return curr;\n"
+  "  }\n"
+  "#if defined(__GNUC__)\n"
+  "  taco_simd_block targets = (taco_simd_block){0} + target;\n"
+  "  while (curr + TACO_SIMD_BLOCK <= arrayEnd) {\n"
+  "    taco_simd_block block;\n"
+  "    memcpy(&block, &array[curr], sizeof(block));\n"
+  "    taco_simd_block less = block < targets;\n"
+  "    int count = 0;\n"
+  "    for (int lane = 0; lane < TACO_SIMD_BLOCK; lane++) {\n"
+  "      count -= less[lane];\n"
+  "    }\n"
+  "    curr += count;\n"
+  "    if (count < TACO_SIMD_BLOCK) {\n"
+  "      return curr;\n"
+  "    }\n"
+  "  }\n"
+  "#endif\n"
+  "  while (curr < arrayEnd && array[curr] < target) {\n"
+  "    curr++;\n"
+  "  }\n"
+  "  return curr;\n"
+  "}\n"
   "int taco_binarySearchAfter(int *array, int arrayStart, int arrayEnd, int target) {\n"
   "  if (array[arrayStart] >= target) {\n"
   "    return arrayStart;\n"
@@ -126,6 +168,146 @@ const string cHeaders =
   "  }\n"
   "  return lowerBound;\n"
   "}\n"
+  // Return the number of rows that the first `diagonal` items of the merge path
+  // of a CSR matrix consume, where the merge path merges the row ends pos[1..]
+  // with the nonzeros 0..nnz-1 and every row ends before the nonzeros at its end.
+  "int taco_mergePathSearch(int *pos, int numRows, int nnz, int diagonal) {\n"
+  "  int lowerBound = TACO_MAX(diagonal - nnz, 0);\n"
+  "  int upperBound = TACO_MIN(diagonal, numRows);\n"
+  "  while (lowerBound < upperBound) {\n"
+  "    int mid = (lowerBound + upperBound) / 2;\n"
+  "    if (pos[mid + 1] <= diagonal - mid - 1) {\n"
+  "      lowerBound = mid + 1;\n"
+  "    }\n"
+  "    else {\n"
+  "      upperBound = mid;\n"
+  "    }\n"
+  "  }\n"
+  "  return lowerBound;\n"
+  "}\n"
+  // Versions of the search functions for index arrays of other types than
+  // int, which take and return 64-bit positions
+  "#if defined(__GNUC__)\n"
+  "#define TACO_SIMD_ADVANCE(T) \\\n"
+  "typedef T taco_simd_block_##T __attribute__((vector_size(TACO_SIMD_BLOCK * sizeof(T)))); \\\n"
+  "int64_t taco_simdAdvance_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  int64_t curr = arrayStart; \\\n"
+  "  if (curr >= arrayEnd || array[curr] >= target) { \\\n"
+  "    return curr; \\\n"
+  "  } \\\n"
+  "  taco_simd_block_##T targets = (taco_simd_block_##T){0} + (T)target; \\\n"
+  "  while (curr + TACO_SIMD_BLOCK <= arrayEnd) { \\\n"
+  "    taco_simd_block_##T block; \\\n"
+  "    memcpy(&block, &array[curr], sizeof(block)); \\\n"
+  "    int64_t count = 0; \\\n"
+  "    for (int lane = 0; lane < TACO_SIMD_BLOCK; lane++) { \\\n"
+  "      count -= (block < targets)[lane]; \\\n"
+  "    } \\\n"
+  "    curr += count; \\\n"
+  "    if (count < TACO_SIMD_BLOCK) { \\\n"
+  "      return curr; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  while (curr < arrayEnd && array[curr] < target) { \\\n"
+  "    curr++; \\\n"
+  "  } \\\n"
+  "  return curr; \\\n"
+  "}\n"
+  "#else\n"
+  "#define TACO_SIMD_ADVANCE(T) \\\n"
+  "int64_t taco_simdAdvance_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  int64_t curr = arrayStart; \\\n"
+  "  while (curr < arrayEnd && array[curr] < target) { \\\n"
+  "    curr++; \\\n"
+  "  } \\\n"
+  "  return curr; \\\n"
+  "}\n"
+  "#endif\n"
+  "#define TACO_SEARCH_FUNCTIONS(T) \\\n"
+  "int64_t taco_gallop_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayStart] >= target || arrayStart >= arrayEnd) { \\\n"
+  "    return arrayStart; \\\n"
+  "  } \\\n"
+  "  int64_t step = 1; \\\n"
+  "  int64_t curr = arrayStart; \\\n"
+  "  while (curr + step < arrayEnd && array[curr + step] < target) { \\\n"
+  "    curr += step; \\\n"
+  "    step = step * 2; \\\n"
+  "  } \\\n"
+  "  step = step / 2; \\\n"
+  "  while (step > 0) { \\\n"
+  "    if (curr + step < arrayEnd && array[curr + step] < target) { \\\n"
+  "      curr += step; \\\n"
+  "    } \\\n"
+  "    step = step / 2; \\\n"
+  "  } \\\n"
+  "  return curr+1; \\\n"
+  "} \\\n"
+  "TACO_SIMD_ADVANCE(T) \\\n"
+  "int64_t taco_binarySearchAfter_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayStart] >= target) { \\\n"
+  "    return arrayStart; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; \\\n"
+  "  int64_t upperBound = arrayEnd; \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    int64_t midValue = array[mid]; \\\n"
+  "    if (midValue < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } \\\n"
+  "    else if (midValue > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } \\\n"
+  "    else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return upperBound; \\\n"
+  "} \\\n"
+  "int64_t taco_binarySearchBefore_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayEnd] <= target) { \\\n"
+  "    return arrayEnd; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; \\\n"
+  "  int64_t upperBound = arrayEnd; \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    int64_t midValue = array[mid]; \\\n"
+  "    if (midValue < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } \\\n"
+  "    else if (midValue > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } \\\n"
+  "    else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return lowerBound; \\\n"
+  "} \\\n"
+  "int64_t taco_mergePathSearch_##T(T *pos, int64_t numRows, int64_t nnz, int64_t diagonal) { \\\n"
+  "  int64_t lowerBound = TACO_MAX(diagonal - nnz, 0); \\\n"
+  "  int64_t upperBound = TACO_MIN(diagonal, numRows); \\\n"
+  "  while (lowerBound < upperBound) { \\\n"
+  "    int64_t mid = (lowerBound + upperBound) / 2; \\\n"
+  "    if ((int64_t)pos[mid + 1] <= diagonal - mid - 1) { \\\n"
+  "      lowerBound = mid + 1; \\\n"
+  "    } \\\n"
+  "    else { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return lowerBound; \\\n"
+  "}\n"
+  "TACO_SEARCH_FUNCTIONS(int8_t)\n"
+  "TACO_SEARCH_FUNCTIONS(int16_t)\n"
+  "TACO_SEARCH_FUNCTIONS(int32_t)\n"
+  "TACO_SEARCH_FUNCTIONS(int64_t)\n"
+  "TACO_SEARCH_FUNCTIONS(uint8_t)\n"
+  "TACO_SEARCH_FUNCTIONS(uint16_t)\n"
+  "TACO_SEARCH_FUNCTIONS(uint32_t)\n"
+  "TACO_SEARCH_FUNCTIONS(uint64_t)\n"
   "taco_tensor_t* init_taco_tensor_t(int32_t order, int32_t csize,\n"
   "                                  int32_t* dimensions, int32_t* mode_ordering,\n"
   "                                  taco_mode_t* mode_types) {\n"
@@ -162,6 +344,201 @@ const string cHeaders =
   "  free(t);\n"
   "}\n"
   "#endif\n";
+
+// The functions that the parallel loops of kernels that run on the
+// work-stealing runtime call, through a table that the module that loads the
+// library binds to the runtime of libtaco. Loops run serially if it is unbound.
+// This *must* be kept in sync with parallel_runtime.h
+const string parallelRuntimeHeaders =
+  "#ifndef TACO_PARALLEL_RUNTIME_DEFINED\n"
+  "#define TACO_PARALLEL_RUNTIME_DEFINED\n"
+  "typedef void (*taco_parallel_body_t)(void*, int64_t, int64_t);\n"
+  "typedef struct taco_parallel_runtime_t {\n"
+  "  void (*parallel_for)(int64_t, int64_t, int64_t, taco_parallel_body_t, void*);\n"
+  "  int  (*thread_num)(void);\n"
+  "  int  (*max_threads)(void);\n"
+  "} taco_parallel_runtime_t;\n"
+  "taco_parallel_runtime_t taco_parallel_runtime;\n"
+  "static inline void taco_parallel_for(int64_t begin, int64_t end, int64_t grain,\n"
+  "                                     taco_parallel_body_t body, void* ctx) {\n"
+  "  if (taco_parallel_runtime.parallel_for) {\n"
+  "    taco_parallel_runtime.parallel_for(begin, end, grain, body, ctx);\n"
+  "  }\n"
+  "  else if (begin < end) {\n"
+  "    body(ctx, begin, end);\n"
+  "  }\n"
+  "}\n"
+  "static inline int taco_parallel_thread_num(void) {\n"
+  "  return taco_parallel_runtime.thread_num ? taco_parallel_runtime.thread_num() : 0;\n"
+  "}\n"
+  "static inline int taco_parallel_max_threads(void) {\n"
+  "  return taco_parallel_runtime.max_threads ? taco_parallel_runtime.max_threads() : 1;\n"
+  "}\n"
+  "#endif\n";
+
+bool isParallelLoop(const For* op) {
+  switch (op->kind) {
+    case LoopKind::Static:
+    case LoopKind::Dynamic:
+    case LoopKind::Runtime:
+    case LoopKind::Static_Chunked:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Atomic updates in loops that run on the work-stealing runtime are emitted as
+// compare-and-swap loops, which are only lock-free for scalars of up to 8 bytes
+bool isLockFreeAtomic(Datatype type) {
+  return !type.isComplex() && type.getNumBits() <= 64;
+}
+
+// Collects the parallel loops that can run on the work-stealing runtime,
+// with inner loops before the loops that they are nested in
+struct FindOutlinableLoops : public IRVisitor {
+  using IRVisitor::visit;
+
+  vector<const For*> loops;
+  vector<bool> lockFree;
+
+  void visit(const For* op) {
+    const bool parallel = isParallelLoop(op);
+    if (parallel) {
+      lockFree.push_back(true);
+    }
+    IRVisitor::visit(op);
+    if (parallel) {
+      auto lit = op->increment.as<Literal>();
+      if (lockFree.back() && lit != nullptr && lit->equalsScalar(1)) {
+        loops.push_back(op);
+      }
+      lockFree.pop_back();
+    }
+  }
+
+  void visit(const Assign* op) {
+    updateLockFree(op->use_atomics, op->lhs.type());
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Store* op) {
+    updateLockFree(op->use_atomics, op->data.type());
+    IRVisitor::visit(op);
+  }
+
+  // An update that is not lock-free keeps the loops that it is in on OpenMP
+  void updateLockFree(bool atomic, Datatype type) {
+    if (atomic && !isLockFreeAtomic(type)) {
+      for (size_t i = 0; i < lockFree.size(); ++i) {
+        lockFree[i] = false;
+      }
+    }
+  }
+};
+
+// Finds the variables and tensor properties that the body of a loop uses but
+// does not declare, which the function that it is outlined into captures, and
+// those that it assigns, which are captured by address so that assignments
+// are seen outside of the loop
+struct FindCaptures : public IRVisitor {
+  using IRVisitor::visit;
+
+  const map<Expr, string, ExprCompare>& varMap;
+  set<Expr, ExprCompare> declared;
+  vector<Expr> captures;
+  vector<string> names;
+  set<string> assigned;
+
+  FindCaptures(const map<Expr, string, ExprCompare>& varMap)
+      : varMap(varMap) {
+  }
+
+  void capture(Expr expr) {
+    taco_iassert(varMap.count(expr) > 0) << expr << " not found in varMap";
+    const string& name = varMap.at(expr);
+    if (!util::contains(names, name)) {
+      captures.push_back(expr);
+      names.push_back(name);
+    }
+  }
+
+  void assign(Expr expr) {
+    if (!declared.count(expr) && varMap.count(expr) > 0) {
+      assigned.insert(varMap.at(expr));
+    }
+  }
+
+  void visit(const Var* op) {
+    if (!declared.count(op)) {
+      capture(op);
+    }
+  }
+
+  void visit(const GetProperty* op) {
+    capture(op);
+  }
+
+  void visit(const VarDecl* op) {
+    declared.insert(op->var);
+    op->rhs.accept(this);
+  }
+
+  void visit(const For* op) {
+    declared.insert(op->var);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Assign* op) {
+    assign(op->lhs);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Allocate* op) {
+    assign(op->var);
+    IRVisitor::visit(op);
+  }
+};
+
+// Replaces the variable or array element that an atomic update writes to, in
+// the value that it writes, with the value that it had before the update
+struct ReplaceUpdated : public IRRewriter {
+  using IRRewriter::visit;
+
+  Expr updated;
+  Expr replacement;
+
+  ReplaceUpdated(Expr updated, Expr replacement)
+      : updated(updated), replacement(replacement) {
+  }
+
+  void visit(const Var* op) {
+    expr = (Expr(op) == updated) ? replacement : Expr(op);
+  }
+
+  void visit(const Load* op) {
+    if (updated.as<Load>() &&
+        util::toString(Expr(op)) == util::toString(updated)) {
+      expr = replacement;
+    }
+    else {
+      IRRewriter::visit(op);
+    }
+  }
+};
+
+Stmt simplifyFully(Stmt stmt) {
+  if (isa<Scope>(stmt)) {
+    stmt = to<Scope>(stmt)->scopedStmt;
+  }
+  Stmt oldStmt;
+  do {
+    oldStmt = stmt;
+    stmt = ir::simplify(stmt);
+  } while (stmt != oldStmt);
+  return stmt;
+}
+
 } // anonymous namespace
 
 // find variables for generating declarations
@@ -263,7 +640,8 @@ protected:
 };
 
 CodeGen_C::CodeGen_C(std::ostream &dest, OutputKind outputKind, bool simplify)
-    : CodeGen(dest, false, simplify, C), out(dest), outputKind(outputKind) {}
+    : CodeGen(dest, false, simplify, C), out(dest), outputKind(outputKind),
+      emittingCoroutine(false), outlineParallelLoops(false) {}
 
 CodeGen_C::~CodeGen_C() {}
 
@@ -291,6 +669,9 @@ void CodeGen_C::visit(const Function* func) {
   emittingCoroutine = (numYields > 0);
   funcName = func->name;
   labelCount = 0;
+  outlineParallelLoops = outputKind == ImplementationGen && !emittingCoroutine &&
+      taco_get_parallel_runtime() == ParallelRuntime::WorkStealing;
+  outlinedLoops.clear();
 
   resetUniqueNameCounters();
   FindVars inputVarFinder(func->inputs, {}, this);
@@ -298,6 +679,23 @@ void CodeGen_C::visit(const Function* func) {
   FindVars outputVarFinder({}, func->outputs, this);
   func->body.accept(&outputVarFinder);
 
+  // find all the vars that are not inputs or outputs
+  resetUniqueNameCounters();
+  FindVars varFinder(func->inputs, func->outputs, this);
+  func->body.accept(&varFinder);
+  varMap = varFinder.varMap;
+  localVars = varFinder.localVars;
+
+  // emit the bodies of parallel loops that run on the work-stealing runtime
+  // as functions ahead of the function that runs them, which means that the
+  // body has to be simplified up front for loops to be found when printing it
+  Stmt body = func->body;
+  if (outlineParallelLoops) {
+    body = simplifyFully(body);
+    out << parallelRuntimeHeaders;
+    outlineLoops(body);
+  }
+
   // output function declaration
   doIndent();
   out << printFuncName(func, inputVarFinder.varDecls, outputVarFinder.varDecls);
@@ -313,13 +711,6 @@ void CodeGen_C::visit(const Function* func) {
 
   indent++;
 
-  // find all the vars that are not inputs or outputs and declare them
-  resetUniqueNameCounters();
-  FindVars varFinder(func->inputs, func->outputs, this);
-  func->body.accept(&varFinder);
-  varMap = varFinder.varMap;
-  localVars = varFinder.localVars;
-
   // Print variable declarations
   out << printDecls(varFinder.varDecls, func->inputs, func->outputs) << endl;
 
@@ -329,7 +720,12 @@ void CodeGen_C::visit(const Function* func) {
   }
 
   // output body
-  print(func->body);
+  if (outlineParallelLoops) {
+    body.accept(this);
+  }
+  else {
+    print(body);
+  }
 
   // output repack only if we allocated memory
   if (checkForAlloc(func))
@@ -347,6 +743,181 @@ void CodeGen_C::visit(const Function* func) {
   out << "}\n";
 }
 
+void CodeGen_C::outlineLoops(Stmt stmt) {
+  FindOutlinableLoops finder;
+  stmt.accept(&finder);
+  for (const For* loop : finder.loops) {
+    outlineLoop(loop);
+  }
+}
+
+// The body of a parallel loop is emitted as a function that runs a range of
+// its iterations, and that reads the variables that the loop captures from a
+// struct that the kernel fills in before it calls taco_parallel_for
+void CodeGen_C::outlineLoop(const For* op) {
+  OutlinedLoop loop;
+  loop.name = funcName + "_parallel" + to_string(outlinedLoops.size());
+
+  FindCaptures finder(varMap);
+  finder.declared.insert(op->var);
+  op->contents.accept(&finder);
+  loop.captures = finder.captures;
+  loop.fields = finder.names;
+  for (const string& field : loop.fields) {
+    loop.capturedByAddress.push_back(finder.assigned.count(field) > 0);
+  }
+
+  const string ctx = "taco_captures";
+  vector<string> types;
+  for (const Expr& capture : loop.captures) {
+    if (auto var = capture.as<Var>()) {
+      types.push_back(var->is_tensor ? "taco_tensor_t*"
+                                     : printType(var->type, var->is_ptr));
+      continue;
+    }
+    auto prop = capture.as<GetProperty>();
+    auto tensor = prop->tensor.as<Var>();
+    switch (prop->property) {
+      case TensorProperty::Values:
+        types.push_back(printType(tensor->type, true));
+        break;
+      case TensorProperty::FillValue:
+        types.push_back(printType(tensor->type, false));
+        break;
+      case TensorProperty::Indices:
+        types.push_back(printIndexType(prop->type) + "*");
+        break;
+      default:
+        types.push_back("int");
+        break;
+    }
+  }
+
+  out << "typedef struct {\n";
+  for (size_t i = 0; i < loop.captures.size(); ++i) {
+    out << "  " << types[i] << (loop.capturedByAddress[i] ? "*" : "") << " "
+        << loop.fields[i] << ";\n";
+  }
+  out << "} " << loop.name << "_t;\n\n";
+
+  out << "static void " << loop.name
+      << "(void* taco_ctx, int64_t taco_begin, int64_t taco_end) {\n";
+  out << "  " << loop.name << "_t* " << ctx << " = (" << loop.name
+      << "_t*)taco_ctx;\n";
+
+  // Variables that the loop assigns are accessed through the struct, and the
+  // others are copied into locals, which lets pointers be restrict
+  map<Expr, string, ExprCompare> loopVarMap = varMap;
+  for (size_t i = 0; i < loop.captures.size(); ++i) {
+    if (loop.capturedByAddress[i]) {
+      for (auto& var : loopVarMap) {
+        if (var.second == loop.fields[i]) {
+          var.second = "(*" + ctx + "->" + loop.fields[i] + ")";
+        }
+      }
+    }
+    else {
+      const bool isPointer = types[i].back() == '*';
+      out << "  " << types[i] << (isPointer ? " " + restrictKeyword() : "")
+          << " " << loop.fields[i] << " = " << ctx << "->" << loop.fields[i]
+          << ";\n";
+    }
+  }
+
+  Expr begin = Var::make("taco_begin", Int64);
+  Expr end = Var::make("taco_end", Int64);
+  loopVarMap[begin] = "taco_begin";
+  loopVarMap[end] = "taco_end";
+
+  stringstream loopBody;
+  CodeGen_C codeGen(loopBody, ImplementationGen, false);
+  codeGen.varMap = loopVarMap;
+  codeGen.funcName = funcName;
+  codeGen.labelCount = 0;
+  codeGen.emittingCoroutine = false;
+  codeGen.outlineParallelLoops = true;
+  codeGen.outlinedLoops = outlinedLoops;
+  codeGen.indent = 1;
+  For::make(op->var, begin, end, op->increment, op->contents).accept(&codeGen);
+  out << loopBody.str();
+  out << "}\n\n";
+
+  outlinedLoops.insert({op, loop});
+}
+
+void CodeGen_C::printOutlinedLoopCall(const For* op) {
+  const OutlinedLoop& loop = outlinedLoops.at(op);
+  const string ctx = loop.name + "_ctx";
+
+  doIndent();
+  stream << "{\n";
+  indent++;
+  doIndent();
+  stream << loop.name << "_t " << ctx << ";\n";
+  for (size_t i = 0; i < loop.captures.size(); ++i) {
+    doIndent();
+    stream << ctx << "." << loop.fields[i] << " = "
+           << (loop.capturedByAddress[i] ? "&" : "");
+    loop.captures[i].accept(this);
+    stream << ";\n";
+  }
+
+  // Work stealing balances the load of loops that are not dynamically
+  // scheduled well enough with ranges that the runtime chooses
+  doIndent();
+  stream << "taco_parallel_for(";
+  parentPrecedence = Precedence::CALL;
+  op->start.accept(this);
+  stream << ", ";
+  parentPrecedence = Precedence::CALL;
+  op->end.accept(this);
+  stream << ", " << ((op->kind == LoopKind::Dynamic) ? 1 : 0) << ", "
+         << loop.name << ", &" << ctx << ");\n";
+  indent--;
+  doIndent();
+  stream << "}\n";
+}
+
+// Atomic updates that run on the work-stealing runtime, which OpenMP pragmas
+// do not apply to, compute the new value from the value that was read until
+// no other thread has changed it in the meantime
+void CodeGen_C::printAtomicUpdate(Expr lhs, Expr data) {
+  const string type = printType(lhs.type(), false);
+  Expr expected = Var::make("taco_expected", lhs.type());
+  varMap[expected] = "taco_expected";
+  data = ReplaceUpdated(lhs, expected).rewrite(data);
+
+  doIndent();
+  stream << "{\n";
+  indent++;
+  doIndent();
+  stream << type << " taco_expected;\n";
+  doIndent();
+  stream << type << " taco_desired;\n";
+  doIndent();
+  stream << "__atomic_load(&";
+  lhs.accept(this);
+  stream << ", &taco_expected, __ATOMIC_RELAXED);\n";
+  doIndent();
+  stream << "do {\n";
+  indent++;
+  doIndent();
+  stream << "taco_desired = ";
+  parentPrecedence = Precedence::TOP;
+  data.accept(this);
+  stream << ";\n";
+  indent--;
+  doIndent();
+  stream << "} while (!__atomic_compare_exchange(&";
+  lhs.accept(this);
+  stream << ", &taco_expected, &taco_desired, 0, __ATOMIC_RELAXED, "
+         << "__ATOMIC_RELAXED));\n";
+  indent--;
+  doIndent();
+  stream << "}\n";
+  varMap.erase(expected);
+}
+
 void CodeGen_C::visit(const VarDecl* op) {
   if (emittingCoroutine) {
     doIndent();
@@ -390,6 +961,20 @@ static string genVectorizePragma(int width) {
   return ret.str();
 }
 
+// Loops whose iterations are independent are vectorized with OpenMP, which
+// both GCC and Clang honor, and which lets them vectorize reductions
+static string genSimdPragma(int width, const vector<string>& reductions) {
+  stringstream ret;
+  ret << "#pragma omp simd";
+  if (width) {
+    ret << " simdlen(" << width << ")";
+  }
+  if (!reductions.empty()) {
+    ret << " reduction(+:" << util::join(reductions, ",") << ")";
+  }
+  return ret.str();
+}
+
 static string getParallelizePragma(LoopKind kind) {
   stringstream ret;
   ret << "#pragma omp parallel for schedule";
@@ -426,12 +1011,28 @@ static string getAtomicPragma() {
 // Docs for vectorization pragmas:
 // http://clang.llvm.org/docs/LanguageExtensions.html#extensions-for-loop-hint-optimizations
 void CodeGen_C::visit(const For* op) {
+  if (outlineParallelLoops && outlinedLoops.count(op) > 0) {
+    printOutlinedLoopCall(op);
+    return;
+  }
+
   switch (op->kind) {
-    case LoopKind::Vectorized:
+    case LoopKind::Vectorized: {
       doIndent();
-      out << genVectorizePragma(op->vec_width);
+      const SimdLoop simdLoop = analyzeSimdLoop(op);
+      if (simdLoop.isIndependent) {
+        vector<string> reductions;
+        for (const auto& reduction : simdLoop.reductions) {
+          reductions.push_back(varMap[reduction.as<Var>()]);
+        }
+        out << genSimdPragma(op->vec_width, reductions);
+      }
+      else {
+        out << genVectorizePragma(op->vec_width);
+      }
       out << "\n";
       break;
+    }
     case LoopKind::Static:
     case LoopKind::Dynamic:
     case LoopKind::Runtime:
@@ -500,6 +1101,42 @@ void CodeGen_C::visit(const GetProperty* op) {
   out << varMap[op];
 }
 
+void CodeGen_C::visit(const Call* op) {
+  // Searches over index arrays of other types than int, or with positions
+  // that need more than 32 bits, call the typed versions of the search
+  // functions that are defined in the header
+  const bool isSearch = op->func == "taco_gallop" ||
+                        op->func == "taco_simdAdvance" ||
+                        op->func == "taco_binarySearchAfter" ||
+                        op->func == "taco_binarySearchBefore" ||
+                        op->func == "taco_mergePathSearch";
+  if (outlineParallelLoops && op->args.empty() &&
+      (op->func == "omp_get_thread_num" || op->func == "omp_get_max_threads")) {
+    stream << ((op->func == "omp_get_thread_num") ? "taco_parallel_thread_num"
+                                                  : "taco_parallel_max_threads")
+           << "()";
+    return;
+  }
+  if (isSearch && op->args.size() == 4) {
+    bool isTyped = (op->args[0].type() != Int32);
+    for (size_t i = 1; i < op->args.size(); ++i) {
+      isTyped = isTyped || op->args[i].type().getNumBits() > 32;
+    }
+    if (isTyped) {
+      stream << op->func << "_" << printCType(op->args[0].type(), false)
+             << "(";
+      for (size_t i = 0; i < op->args.size(); ++i) {
+        parentPrecedence = Precedence::CALL;
+        stream << ((i > 0) ? ", " : "");
+        op->args[i].accept(this);
+      }
+      stream << ")";
+      return;
+    }
+  }
+  IRPrinter::visit(op);
+}
+
 void CodeGen_C::visit(const Min* op) {
   if (op->operands.size() == 1) {
     op->operands[0].accept(this);
@@ -573,6 +1210,11 @@ void CodeGen_C::visit(const Sqrt* op) {
 }
 
 void CodeGen_C::visit(const Assign* op) {
+  if (op->use_atomics && outlineParallelLoops &&
+      isLockFreeAtomic(op->lhs.type())) {
+    printAtomicUpdate(op->lhs, op->rhs);
+    return;
+  }
   if (op->use_atomics) {
     doIndent();
     stream << getAtomicPragma() << endl;
@@ -581,6 +1223,11 @@ void CodeGen_C::visit(const Assign* op) {
 }
 
 void CodeGen_C::visit(const Store* op) {
+  if (op->use_atomics && outlineParallelLoops &&
+      isLockFreeAtomic(op->data.type())) {
+    printAtomicUpdate(Load::make(op->arr, op->loc), op->data);
+    return;
+  }
   if (op->use_atomics) {
     doIndent();
     stream << getAtomicPragma() << endl;
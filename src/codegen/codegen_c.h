@@ -35,6 +35,7 @@ protected:
   void visit(const For*);
   void visit(const While*);
   void visit(const GetProperty*);
+  void visit(const Call*);
   void visit(const Min*);
   void visit(const Max*);
   void visit(const Allocate*);
@@ -52,6 +53,24 @@ protected:
   int labelCount;
   bool emittingCoroutine;
 
+  /// Whether parallel loops run on the work-stealing runtime, in which case
+  /// their bodies are emitted as functions that are passed to
+  /// taco_parallel_for along with the variables that they capture
+  bool outlineParallelLoops;
+
+  struct OutlinedLoop {
+    std::string name;
+    std::vector<Expr> captures;
+    std::vector<std::string> fields;
+    std::vector<bool> capturedByAddress;
+  };
+  std::map<const For*, OutlinedLoop> outlinedLoops;
+
+  void outlineLoops(Stmt stmt);
+  void outlineLoop(const For* op);
+  void printOutlinedLoopCall(const For* op);
+  void printAtomicUpdate(Expr lhs, Expr data);
+
   class FindVars;
 
 private:
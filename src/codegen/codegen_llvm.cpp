@@ -0,0 +1,1602 @@
+#include "codegen_llvm.h"
+
+#include "taco/error.h"
+
+#if LLVM_BUILT
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
+#include <tuple>
+
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/Mangling.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include "taco/ir/ir_visitor.h"
+#include "taco/util/strings.h"
+#endif
+
+using namespace std;
+
+namespace taco {
+namespace ir {
+
+#if LLVM_BUILT
+
+namespace {
+
+// Host implementations of the runtime functions that the C backend emits at
+// the top of every generated source file. These *must* be kept in sync with
+// the implementations in codegen_c.cpp.
+int32_t taco_gallop(int32_t* array, int32_t arrayStart, int32_t arrayEnd,
+                    int32_t target) {
+  if (array[arrayStart] >= target || arrayStart >= arrayEnd) {
+    return arrayStart;
+  }
+  int32_t step = 1;
+  int32_t curr = arrayStart;
+  while (curr + step < arrayEnd && array[curr + step] < target) {
+    curr += step;
+    step = step * 2;
+  }
+
+  step = step / 2;
+  while (step > 0) {
+    if (curr + step < arrayEnd && array[curr + step] < target) {
+      curr += step;
+    }
+    step = step / 2;
+  }
+  return curr+1;
+}
+
+int32_t taco_simdAdvance(int32_t* array, int32_t arrayStart, int32_t arrayEnd,
+                         int32_t target) {
+  const int32_t blockSize = 8;
+  int32_t curr = arrayStart;
+  if (curr >= arrayEnd || array[curr] >= target) {
+    return curr;
+  }
+  while (curr + blockSize <= arrayEnd) {
+    int32_t count = 0;
+    for (int32_t lane = 0; lane < blockSize; lane++) {
+      count += (array[curr + lane] < target);
+    }
+    curr += count;
+    if (count < blockSize) {
+      return curr;
+    }
+  }
+  while (curr < arrayEnd && array[curr] < target) {
+    curr++;
+  }
+  return curr;
+}
+
+int32_t taco_binarySearchAfter(int32_t* array, int32_t arrayStart,
+                               int32_t arrayEnd, int32_t target) {
+  if (array[arrayStart] >= target) {
+    return arrayStart;
+  }
+  int32_t lowerBound = arrayStart; // always < target
+  int32_t upperBound = arrayEnd; // always >= target
+  while (upperBound - lowerBound > 1) {
+    int32_t mid = (upperBound + lowerBound) / 2;
+    int32_t midValue = array[mid];
+    if (midValue < target) {
+      lowerBound = mid;
+    }
+    else if (midValue > target) {
+      upperBound = mid;
+    }
+    else {
+      return mid;
+    }
+  }
+  return upperBound;
+}
+
+int32_t taco_binarySearchBefore(int32_t* array, int32_t arrayStart,
+                                int32_t arrayEnd, int32_t target) {
+  if (array[arrayEnd] <= target) {
+    return arrayEnd;
+  }
+  int32_t lowerBound = arrayStart; // always <= target
+  int32_t upperBound = arrayEnd; // always > target
+  while (upperBound - lowerBound > 1) {
+    int32_t mid = (upperBound + lowerBound) / 2;
+    int32_t midValue = array[mid];
+    if (midValue < target) {
+      lowerBound = mid;
+    }
+    else if (midValue > target) {
+      upperBound = mid;
+    }
+    else {
+      return mid;
+    }
+  }
+  return lowerBound;
+}
+
+int32_t taco_mergePathSearch(int32_t* pos, int32_t numRows, int32_t nnz,
+                             int32_t diagonal) {
+  int32_t lowerBound = std::max(diagonal - nnz, 0);
+  int32_t upperBound = std::min(diagonal, numRows);
+  while (lowerBound < upperBound) {
+    int32_t mid = (lowerBound + upperBound) / 2;
+    if (pos[mid + 1] <= diagonal - mid - 1) {
+      lowerBound = mid + 1;
+    }
+    else {
+      upperBound = mid;
+    }
+  }
+  return lowerBound;
+}
+
+/// A function from the C standard library or the taco runtime that generated
+/// code may call.
+struct ExternalFunction {
+  enum Kind {
+    Search,       // int32_t f(int32_t* array, int32_t, int32_t, int32_t)
+    Calloc,       // void* calloc(size_t, size_t)
+    ThreadQuery,  // int32_t f()
+    Math          // T f(T, ...)
+  };
+  Kind kind;
+  Datatype type;
+  size_t numArgs;
+};
+
+const map<string,ExternalFunction>& getExternalFunctions() {
+  static const map<string,ExternalFunction> functions = [] {
+    map<string,ExternalFunction> functions = {
+      {"taco_gallop",             {ExternalFunction::Search, Int32, 4}},
+      {"taco_simdAdvance",        {ExternalFunction::Search, Int32, 4}},
+      {"taco_binarySearchAfter",  {ExternalFunction::Search, Int32, 4}},
+      {"taco_binarySearchBefore", {ExternalFunction::Search, Int32, 4}},
+      {"taco_mergePathSearch",    {ExternalFunction::Search, Int32, 4}},
+      {"calloc",                  {ExternalFunction::Calloc, UInt64, 2}},
+      {"omp_get_thread_num",      {ExternalFunction::ThreadQuery, Int32, 0}},
+      {"omp_get_max_threads",     {ExternalFunction::ThreadQuery, Int32, 0}},
+      {"abs",                     {ExternalFunction::Math, Int32, 1}},
+      {"labs",                    {ExternalFunction::Math, Int64, 1}}
+    };
+    const vector<string> unary = {"sqrt", "cbrt", "exp", "log", "fabs",
+                                  "sin", "cos", "tan", "asin", "acos", "atan",
+                                  "sinh", "cosh", "tanh", "asinh", "acosh",
+                                  "atanh"};
+    const vector<string> binary = {"pow", "fmod"};
+    for (auto& func : unary) {
+      functions.insert({func, {ExternalFunction::Math, Float64, 1}});
+      functions.insert({func + "f", {ExternalFunction::Math, Float32, 1}});
+    }
+    for (auto& func : binary) {
+      functions.insert({func, {ExternalFunction::Math, Float64, 2}});
+      functions.insert({func + "f", {ExternalFunction::Math, Float32, 2}});
+    }
+    return functions;
+  }();
+  return functions;
+}
+
+bool isSupportedType(Datatype type) {
+  return type.isBool() || ((type.isInt() || type.isUInt() || type.isFloat()) &&
+                           type.getNumBits() <= 64);
+}
+
+bool isSupportedProperty(TensorProperty property) {
+  switch (property) {
+    case TensorProperty::Dimension:
+    case TensorProperty::Indices:
+    case TensorProperty::Values:
+    case TensorProperty::ValuesSize:
+    case TensorProperty::FillValue:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Checks whether a function only uses features that the LLVM backend
+/// supports. Anything else (coroutines, user-defined binary operators,
+/// complex values, ...) is left to the C backend.
+class SupportChecker : public IRVisitor {
+public:
+  bool supported = true;
+
+  using IRVisitor::visit;
+
+  void visit(const Function* op) {
+    if (op->getReturnType().second != Datatype()) {
+      supported = false;
+      return;
+    }
+    for (auto& param : op->outputs) {
+      checkParameter(param);
+    }
+    for (auto& param : op->inputs) {
+      checkParameter(param);
+    }
+    op->body.accept(this);
+  }
+
+  void visit(const Literal* op) {
+    checkType(op->type);
+  }
+
+  void visit(const Var* op) {
+    checkType(op->type);
+    if (op->is_tensor && !parameters.count(op)) {
+      supported = false;
+    }
+  }
+
+  void visit(const Cast* op) {
+    checkType(op->type);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Load* op) {
+    checkType(op->type);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Call* op) {
+    auto& functions = getExternalFunctions();
+    if (!functions.count(op->func) ||
+        functions.at(op->func).numArgs != op->args.size()) {
+      supported = false;
+    } else if (functions.at(op->func).kind == ExternalFunction::Search) {
+      // The search functions are only defined for int arrays and positions
+      // (see CodeGen_C for the typed versions)
+      for (auto& arg : op->args) {
+        if (arg.type().getNumBits() > 32) {
+          supported = false;
+        }
+      }
+      if (op->args[0].type() != Int32) {
+        supported = false;
+      }
+    }
+    checkType(op->type);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const GetProperty* op) {
+    if (!parameters.count(op->tensor.ptr) ||
+        !isSupportedProperty(op->property)) {
+      supported = false;
+    }
+    checkType(op->tensor.type());
+  }
+
+  void visit(const For* op) {
+#if USE_OPENMP
+    if (op->kind != LoopKind::Serial && op->kind != LoopKind::Vectorized) {
+      supported = false;
+    }
+#endif
+    IRVisitor::visit(op);
+  }
+
+  void visit(const VarDecl* op) {
+    op->var.accept(this);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Assign* op) {
+    checkLValue(op->lhs);
+#if USE_OPENMP
+    if (op->use_atomics) {
+      supported = false;
+    }
+#endif
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Store* op) {
+#if USE_OPENMP
+    if (op->use_atomics) {
+      supported = false;
+    }
+#endif
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Allocate* op) {
+    checkLValue(op->var);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const BinOp*) {
+    supported = false;
+  }
+
+  void visit(const Yield*) {
+    supported = false;
+  }
+
+  void visit(const Sort*) {
+    supported = false;
+  }
+
+  void visit(const Print*) {
+    supported = false;
+  }
+
+private:
+  set<const IRNode*> parameters;
+
+  void checkType(Datatype type) {
+    if (!isSupportedType(type)) {
+      supported = false;
+    }
+  }
+
+  void checkParameter(Expr param) {
+    const Var* var = param.as<Var>();
+    // Scalars are passed through the shims as pointer-sized integers, which
+    // only works for integral values.
+    if (var == nullptr || var->is_parameter ||
+        (!var->is_tensor && !var->is_ptr && var->type.isFloat())) {
+      supported = false;
+      return;
+    }
+    checkType(var->type);
+    parameters.insert(param.ptr);
+  }
+
+  void checkLValue(Expr lvalue) {
+    if (!isa<Var>(lvalue) && !isa<GetProperty>(lvalue)) {
+      supported = false;
+    }
+  }
+};
+
+/// Collects the properties of the function's tensor parameters that are used
+/// in its body.
+class PropertyFinder : public IRVisitor {
+public:
+  vector<const GetProperty*> properties;
+
+  using IRVisitor::visit;
+
+  void visit(const GetProperty* op) {
+    properties.push_back(op);
+  }
+};
+
+bool hasAllocate(const Function* func) {
+  struct HasAllocate : public IRVisitor {
+    bool hasAllocate = false;
+
+    using IRVisitor::visit;
+
+    void visit(const Allocate*) {
+      hasAllocate = true;
+    }
+  };
+  HasAllocate checker;
+  func->body.accept(&checker);
+  return checker.hasAllocate;
+}
+
+template <typename T>
+T unwrap(llvm::Expected<T> value) {
+  if (!value) {
+    taco_ierror << "LLVM error: " << llvm::toString(value.takeError());
+  }
+  return std::move(*value);
+}
+
+template <typename T>
+T& unwrap(llvm::Expected<T&> value) {
+  if (!value) {
+    taco_ierror << "LLVM error: " << llvm::toString(value.takeError());
+  }
+  return *value;
+}
+
+void check(llvm::Error error) {
+  if (error) {
+    taco_ierror << "LLVM error: " << llvm::toString(std::move(error));
+  }
+}
+
+/// Returns the JIT that all modules are compiled into. Every module gets its
+/// own library in the JIT, so that functions of the same name in different
+/// modules do not clash. The JIT is never destroyed, since modules that are
+/// destroyed during static destruction still need to remove their libraries.
+llvm::orc::LLJIT& getJIT() {
+  static llvm::orc::LLJIT* jit = [] {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    // Modules may be compiled on several threads at once (e.g., by tiered
+    // compilation), so every compilation must get its own target machine
+    llvm::orc::LLJITBuilder builder;
+    builder.setCompileFunctionCreator(
+        [](llvm::orc::JITTargetMachineBuilder targetMachineBuilder)
+            -> llvm::Expected<
+                unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+          return unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>(
+              new llvm::orc::ConcurrentIRCompiler(
+                  std::move(targetMachineBuilder)));
+        });
+    return unwrap(builder.create()).release();
+  }();
+  return *jit;
+}
+
+void optimize(llvm::Module& module, int optLevel) {
+  auto targetMachineBuilder =
+      unwrap(llvm::orc::JITTargetMachineBuilder::detectHost());
+  auto targetMachine = unwrap(targetMachineBuilder.createTargetMachine());
+
+  llvm::LoopAnalysisManager lam;
+  llvm::FunctionAnalysisManager fam;
+  llvm::CGSCCAnalysisManager cgam;
+  llvm::ModuleAnalysisManager mam;
+  llvm::PassBuilder passBuilder(targetMachine.get());
+  passBuilder.registerModuleAnalyses(mam);
+  passBuilder.registerCGSCCAnalyses(cgam);
+  passBuilder.registerFunctionAnalyses(fam);
+  passBuilder.registerLoopAnalyses(lam);
+  passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+  llvm::ModulePassManager passes;
+  switch (optLevel) {
+    case 0:
+      passes = passBuilder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+      break;
+    case 1:
+      passes = passBuilder.buildPerModuleDefaultPipeline(
+          llvm::OptimizationLevel::O1);
+      break;
+    case 2:
+      passes = passBuilder.buildPerModuleDefaultPipeline(
+          llvm::OptimizationLevel::O2);
+      break;
+    default:
+      passes = passBuilder.buildPerModuleDefaultPipeline(
+          llvm::OptimizationLevel::O3);
+      break;
+  }
+  passes.run(module, mam);
+}
+
+/// Translates a lowered function into an LLVM function, mirroring the
+/// semantics of the C code that CodeGen_C generates for it.
+class FunctionGen : public IRVisitorStrict {
+public:
+  FunctionGen(llvm::Module* module)
+      : module(module), context(module->getContext()), builder(context) {
+    // Generated C code is compiled with -ffast-math
+    llvm::FastMathFlags fastMath;
+    fastMath.setFast();
+    builder.setFastMathFlags(fastMath);
+  }
+
+  void compile(const Function* func) {
+    vector<Expr> parameters = func->outputs;
+    parameters.insert(parameters.end(), func->inputs.begin(),
+                      func->inputs.end());
+
+    vector<llvm::Type*> parameterTypes;
+    for (auto& parameter : parameters) {
+      const Var* var = parameter.as<Var>();
+      parameterTypes.push_back(var->is_tensor
+                               ? getTensorType()->getPointerTo()
+                               : getType(var->type, var->is_ptr));
+    }
+    llvm::FunctionType* functionType =
+        llvm::FunctionType::get(builder.getInt32Ty(), parameterTypes, false);
+    function = llvm::Function::Create(functionType,
+                                      llvm::Function::ExternalLinkage,
+                                      func->name, module);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry",
+                                                    function));
+
+    for (size_t i = 0; i < parameters.size(); ++i) {
+      const Var* var = parameters[i].as<Var>();
+      llvm::Value* arg = function->getArg(i);
+      arg->setName(var->name);
+      if (var->is_tensor) {
+        tensors[var] = arg;
+      }
+      else {
+        builder.CreateStore(arg, getVarSlot(var));
+      }
+    }
+
+    // Unpack the tensor properties used in the body
+    PropertyFinder propertyFinder;
+    func->body.accept(&propertyFinder);
+    for (auto& property : propertyFinder.properties) {
+      unpackTensorProperty(property);
+    }
+
+    func->body.accept(this);
+
+    // Repack the output properties if the function allocated memory
+    if (hasAllocate(func)) {
+      for (auto& output : func->outputs) {
+        for (auto& property : properties) {
+          if (get<0>(property.first) == output.ptr) {
+            packTensorProperty(property.first, property.second);
+          }
+        }
+      }
+    }
+
+    builder.CreateRet(builder.getInt32(0));
+
+    generateShim(func, parameters, function);
+  }
+
+protected:
+  using IRVisitorStrict::visit;
+
+  void visit(const Literal* op) {
+    llvm::Type* type = getType(op->type);
+    if (op->type.isBool()) {
+      value = builder.getInt1(op->getBoolValue());
+    }
+    else if (op->type.isInt()) {
+      value = llvm::ConstantInt::get(type, op->getIntValue(), true);
+    }
+    else if (op->type.isUInt()) {
+      value = llvm::ConstantInt::get(type, op->getUIntValue(), false);
+    }
+    else {
+      value = llvm::ConstantFP::get(type, op->getFloatValue());
+    }
+  }
+
+  void visit(const Var* op) {
+    if (op->is_tensor) {
+      taco_iassert(tensors.count(op) > 0) << "Tensor " << op->name
+                                          << " is not a parameter";
+      value = tensors[op];
+      return;
+    }
+    taco_iassert(vars.count(op) > 0 ||
+                 (op->is_ptr && ptrVars.count(op->name) > 0))
+        << "Variable " << op->name << " is used before it is declared";
+    llvm::AllocaInst* slot = getVarSlot(op);
+    value = builder.CreateLoad(slot->getAllocatedType(), slot, op->name);
+  }
+
+  void visit(const Neg* op) {
+    llvm::Value* a = codegen(op->a, op->type);
+    if (op->type.isBool()) {
+      value = builder.CreateNot(a);
+    }
+    else if (op->type.isFloat()) {
+      value = builder.CreateFNeg(a);
+    }
+    else {
+      value = builder.CreateNeg(a);
+    }
+  }
+
+  void visit(const Sqrt* op) {
+    Datatype type = op->type.isFloat() ? op->type : Float64;
+    llvm::Value* a = codegen(op->a, type);
+    llvm::Value* sqrt = builder.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, a);
+    value = convert(sqrt, type, op->type);
+  }
+
+  void visit(const Add* op) {
+    llvm::Value* a = codegen(op->a);
+    if (a->getType()->isPointerTy()) {
+      value = builder.CreateInBoundsGEP(getType(op->a.type()), a,
+                                        codegen(op->b, Int64));
+      return;
+    }
+    llvm::Value* b = codegen(op->b, op->type);
+    a = convert(a, op->a.type(), op->type);
+    value = op->type.isFloat() ? builder.CreateFAdd(a, b)
+                               : builder.CreateAdd(a, b);
+  }
+
+  void visit(const Sub* op) {
+    llvm::Value* a = codegen(op->a);
+    if (a->getType()->isPointerTy()) {
+      llvm::Value* offset = builder.CreateNeg(codegen(op->b, Int64));
+      value = builder.CreateInBoundsGEP(getType(op->a.type()), a, offset);
+      return;
+    }
+    llvm::Value* b = codegen(op->b, op->type);
+    a = convert(a, op->a.type(), op->type);
+    value = op->type.isFloat() ? builder.CreateFSub(a, b)
+                               : builder.CreateSub(a, b);
+  }
+
+  void visit(const Mul* op) {
+    llvm::Value* a = codegen(op->a, op->type);
+    llvm::Value* b = codegen(op->b, op->type);
+    value = op->type.isFloat() ? builder.CreateFMul(a, b)
+                               : builder.CreateMul(a, b);
+  }
+
+  void visit(const Div* op) {
+    llvm::Value* a = codegen(op->a, op->type);
+    llvm::Value* b = codegen(op->b, op->type);
+    if (op->type.isFloat()) {
+      value = builder.CreateFDiv(a, b);
+    }
+    else {
+      value = isSigned(op->type) ? builder.CreateSDiv(a, b)
+                                 : builder.CreateUDiv(a, b);
+    }
+  }
+
+  void visit(const Rem* op) {
+    llvm::Value* a = codegen(op->a, op->type);
+    llvm::Value* b = codegen(op->b, op->type);
+    if (op->type.isFloat()) {
+      value = builder.CreateFRem(a, b);
+    }
+    else {
+      value = isSigned(op->type) ? builder.CreateSRem(a, b)
+                                 : builder.CreateURem(a, b);
+    }
+  }
+
+  void visit(const Min* op) {
+    value = codegenMinMax(op->operands, op->type, true);
+  }
+
+  void visit(const Max* op) {
+    value = codegenMinMax(op->operands, op->type, false);
+  }
+
+  void visit(const BitAnd* op) {
+    value = builder.CreateAnd(codegen(op->a, op->type),
+                              codegen(op->b, op->type));
+  }
+
+  void visit(const BitOr* op) {
+    value = builder.CreateOr(codegen(op->a, op->type),
+                             codegen(op->b, op->type));
+  }
+
+  void visit(const Shl* op) {
+    value = builder.CreateShl(codegen(op->a, op->type),
+                              codegen(op->b, op->type));
+  }
+
+  void visit(const Shr* op) {
+    value = isSigned(op->type)
+            ? builder.CreateAShr(codegen(op->a, op->type),
+                                 codegen(op->b, op->type))
+            : builder.CreateLShr(codegen(op->a, op->type),
+                                 codegen(op->b, op->type));
+  }
+
+  void visit(const Eq* op) {
+    value = codegenCompare(op->a, op->b, llvm::CmpInst::FCMP_OEQ,
+                           llvm::CmpInst::ICMP_EQ, llvm::CmpInst::ICMP_EQ);
+  }
+
+  void visit(const Neq* op) {
+    value = codegenCompare(op->a, op->b, llvm::CmpInst::FCMP_UNE,
+                           llvm::CmpInst::ICMP_NE, llvm::CmpInst::ICMP_NE);
+  }
+
+  void visit(const Gt* op) {
+    value = codegenCompare(op->a, op->b, llvm::CmpInst::FCMP_OGT,
+                           llvm::CmpInst::ICMP_SGT, llvm::CmpInst::ICMP_UGT);
+  }
+
+  void visit(const Lt* op) {
+    value = codegenCompare(op->a, op->b, llvm::CmpInst::FCMP_OLT,
+                           llvm::CmpInst::ICMP_SLT, llvm::CmpInst::ICMP_ULT);
+  }
+
+  void visit(const Gte* op) {
+    value = codegenCompare(op->a, op->b, llvm::CmpInst::FCMP_OGE,
+                           llvm::CmpInst::ICMP_SGE, llvm::CmpInst::ICMP_UGE);
+  }
+
+  void visit(const Lte* op) {
+    value = codegenCompare(op->a, op->b, llvm::CmpInst::FCMP_OLE,
+                           llvm::CmpInst::ICMP_SLE, llvm::CmpInst::ICMP_ULE);
+  }
+
+  void visit(const And* op) {
+    value = codegenShortCircuit(op->a, op->b, true);
+  }
+
+  void visit(const Or* op) {
+    value = codegenShortCircuit(op->a, op->b, false);
+  }
+
+  void visit(const BinOp*) {
+    taco_ierror << "BinOp is not supported by the LLVM backend";
+  }
+
+  void visit(const Cast* op) {
+    value = codegen(op->a, op->type);
+  }
+
+  void visit(const Call* op) {
+    const ExternalFunction& func = getExternalFunctions().at(op->func);
+#if !USE_OPENMP
+    // Without OpenMP, generated code runs on a single thread
+    if (func.kind == ExternalFunction::ThreadQuery) {
+      llvm::Value* result = builder.getInt32(op->func == "omp_get_thread_num"
+                                             ? 0 : 1);
+      value = convert(result, Int32, op->type);
+      return;
+    }
+#endif
+
+    llvm::Type* type = getType(func.type);
+    llvm::FunctionType* functionType = nullptr;
+    switch (func.kind) {
+      case ExternalFunction::Search:
+        functionType = llvm::FunctionType::get(type,
+            {type->getPointerTo(), type, type, type}, false);
+        break;
+      case ExternalFunction::Calloc:
+        functionType = llvm::FunctionType::get(builder.getInt8PtrTy(),
+                                               {type, type}, false);
+        break;
+      case ExternalFunction::ThreadQuery:
+        functionType = llvm::FunctionType::get(type, false);
+        break;
+      case ExternalFunction::Math:
+        functionType = llvm::FunctionType::get(type,
+            vector<llvm::Type*>(func.numArgs, type), false);
+        break;
+    }
+    llvm::FunctionCallee callee =
+        module->getOrInsertFunction(op->func, functionType);
+
+    vector<llvm::Value*> args;
+    for (size_t i = 0; i < op->args.size(); ++i) {
+      args.push_back(coerce(codegen(op->args[i]), op->args[i].type(),
+                            functionType->getParamType(i), func.type));
+    }
+    llvm::Value* result = builder.CreateCall(callee, args);
+    value = result->getType()->isPointerTy()
+            ? result : convert(result, func.type, op->type);
+  }
+
+  void visit(const IfThenElse* op) {
+    llvm::Value* cond = codegen(op->cond, Bool);
+    llvm::BasicBlock* thenBlock = createBlock("if.then");
+    llvm::BasicBlock* elseBlock = op->otherwise.defined()
+                                  ? createBlock("if.else") : nullptr;
+    llvm::BasicBlock* endBlock = createBlock("if.end");
+    builder.CreateCondBr(cond, thenBlock, elseBlock ? elseBlock : endBlock);
+
+    builder.SetInsertPoint(thenBlock);
+    op->then.accept(this);
+    builder.CreateBr(endBlock);
+
+    if (elseBlock) {
+      builder.SetInsertPoint(elseBlock);
+      op->otherwise.accept(this);
+      builder.CreateBr(endBlock);
+    }
+    builder.SetInsertPoint(endBlock);
+  }
+
+  void visit(const Case* op) {
+    llvm::BasicBlock* endBlock = createBlock("case.end");
+    for (size_t i = 0; i < op->clauses.size(); ++i) {
+      const bool isLast = (i == op->clauses.size() - 1);
+      if (isLast && op->alwaysMatch) {
+        op->clauses[i].second.accept(this);
+        builder.CreateBr(endBlock);
+        break;
+      }
+      llvm::Value* cond = codegen(op->clauses[i].first, Bool);
+      llvm::BasicBlock* bodyBlock = createBlock("case.body");
+      llvm::BasicBlock* nextBlock = isLast ? endBlock
+                                           : createBlock("case.next");
+      builder.CreateCondBr(cond, bodyBlock, nextBlock);
+
+      builder.SetInsertPoint(bodyBlock);
+      op->clauses[i].second.accept(this);
+      builder.CreateBr(endBlock);
+      builder.SetInsertPoint(nextBlock);
+    }
+    builder.SetInsertPoint(endBlock);
+  }
+
+  void visit(const Switch* op) {
+    // Each case of a generated switch ends with a break, so a switch is a
+    // chain of conditionals in which a break jumps to the end of the switch.
+    llvm::Value* control = codegen(op->controlExpr);
+    llvm::BasicBlock* endBlock = createBlock("switch.end");
+    breakTargets.push_back(endBlock);
+    for (auto& switchCase : op->cases) {
+      Datatype type = max_type(op->controlExpr.type(), switchCase.first.type());
+      llvm::Value* cond = builder.CreateICmpEQ(
+          convert(control, op->controlExpr.type(), type),
+          codegen(switchCase.first, type));
+      llvm::BasicBlock* bodyBlock = createBlock("switch.case");
+      llvm::BasicBlock* nextBlock = createBlock("switch.next");
+      builder.CreateCondBr(cond, bodyBlock, nextBlock);
+
+      builder.SetInsertPoint(bodyBlock);
+      switchCase.second.accept(this);
+      builder.CreateBr(endBlock);
+      builder.SetInsertPoint(nextBlock);
+    }
+    builder.CreateBr(endBlock);
+    breakTargets.pop_back();
+    builder.SetInsertPoint(endBlock);
+  }
+
+  void visit(const Load* op) {
+    llvm::Type* type = getType(op->type);
+    value = builder.CreateLoad(type, codegenElementPtr(op->arr, op->loc,
+                                                       type));
+  }
+
+  void visit(const Malloc* op) {
+    llvm::FunctionCallee malloc = module->getOrInsertFunction("malloc",
+        builder.getInt8PtrTy(), builder.getInt64Ty());
+    value = builder.CreateCall(malloc, {codegen(op->size, UInt64)});
+  }
+
+  void visit(const Sizeof* op) {
+    value = builder.getInt64(op->sizeofType.getDataType().getNumBytes());
+  }
+
+  void visit(const Store* op) {
+    Datatype type = op->arr.type();
+    llvm::Value* ptr = codegenElementPtr(op->arr, op->loc, getType(type));
+    builder.CreateStore(codegen(op->data, type), ptr);
+  }
+
+  void visit(const For* op) {
+    const Var* var = op->var.as<Var>();
+    taco_iassert(var) << "Loop variables must be vars";
+    llvm::AllocaInst* slot = getVarSlot(var);
+    builder.CreateStore(codegen(op->start, var->type), slot);
+
+    llvm::BasicBlock* condBlock = createBlock("for.cond");
+    llvm::BasicBlock* bodyBlock = createBlock("for.body");
+    llvm::BasicBlock* incBlock = createBlock("for.inc");
+    llvm::BasicBlock* endBlock = createBlock("for.end");
+    builder.CreateBr(condBlock);
+
+    // As in C, the loop bound is reevaluated on every iteration
+    builder.SetInsertPoint(condBlock);
+    Datatype boundType = max_type(var->type, op->end.type());
+    llvm::Value* cond = codegenCompare(
+        convert(builder.CreateLoad(slot->getAllocatedType(), slot),
+                var->type, boundType),
+        codegen(op->end, boundType), boundType,
+        llvm::CmpInst::FCMP_OLT, llvm::CmpInst::ICMP_SLT,
+        llvm::CmpInst::ICMP_ULT);
+    builder.CreateCondBr(cond, bodyBlock, endBlock);
+
+    builder.SetInsertPoint(bodyBlock);
+    breakTargets.push_back(endBlock);
+    continueTargets.push_back(incBlock);
+    op->contents.accept(this);
+    continueTargets.pop_back();
+    breakTargets.pop_back();
+    builder.CreateBr(incBlock);
+
+    builder.SetInsertPoint(incBlock);
+    Datatype incType = max_type(var->type, op->increment.type());
+    llvm::Value* current = convert(builder.CreateLoad(
+        slot->getAllocatedType(), slot), var->type, incType);
+    llvm::Value* increment = codegen(op->increment, incType);
+    llvm::Value* next = incType.isFloat()
+                        ? builder.CreateFAdd(current, increment)
+                        : builder.CreateAdd(current, increment);
+    builder.CreateStore(convert(next, incType, var->type), slot);
+    llvm::BranchInst* latch = builder.CreateBr(condBlock);
+    setLoopMetadata(latch, op->kind, op->vec_width, op->unrollFactor);
+
+    builder.SetInsertPoint(endBlock);
+  }
+
+  void visit(const While* op) {
+    llvm::BasicBlock* condBlock = createBlock("while.cond");
+    llvm::BasicBlock* bodyBlock = createBlock("while.body");
+    llvm::BasicBlock* endBlock = createBlock("while.end");
+    builder.CreateBr(condBlock);
+
+    builder.SetInsertPoint(condBlock);
+    builder.CreateCondBr(codegen(op->cond, Bool), bodyBlock, endBlock);
+
+    builder.SetInsertPoint(bodyBlock);
+    breakTargets.push_back(endBlock);
+    continueTargets.push_back(condBlock);
+    op->contents.accept(this);
+    continueTargets.pop_back();
+    breakTargets.pop_back();
+    llvm::BranchInst* latch = builder.CreateBr(condBlock);
+    setLoopMetadata(latch, op->kind, op->vec_width, 0);
+
+    builder.SetInsertPoint(endBlock);
+  }
+
+  void visit(const Block* op) {
+    for (auto& stmt : op->contents) {
+      stmt.accept(this);
+    }
+  }
+
+  void visit(const Scope* op) {
+    op->scopedStmt.accept(this);
+  }
+
+  void visit(const Function*) {
+    taco_ierror << "Nested functions are not supported";
+  }
+
+  void visit(const VarDecl* op) {
+    codegenAssign(op->var, op->rhs);
+  }
+
+  void visit(const Assign* op) {
+    codegenAssign(op->lhs, op->rhs);
+  }
+
+  void visit(const Yield*) {
+    taco_ierror << "Yield is not supported by the LLVM backend";
+  }
+
+  void visit(const Allocate* op) {
+    llvm::AllocaInst* slot = getSlot(op->var);
+    llvm::Type* type = getType(op->var.type());
+    llvm::Value* size = builder.CreateMul(
+        builder.getInt64(module->getDataLayout().getTypeAllocSize(type)),
+        codegen(op->num_elements, UInt64));
+
+    llvm::Type* voidPtr = builder.getInt8PtrTy();
+    llvm::Type* sizeType = builder.getInt64Ty();
+    llvm::Value* memory;
+    if (op->is_realloc) {
+      llvm::FunctionCallee realloc = module->getOrInsertFunction("realloc",
+          voidPtr, voidPtr, sizeType);
+      llvm::Value* old = builder.CreatePointerCast(
+          builder.CreateLoad(slot->getAllocatedType(), slot), voidPtr);
+      memory = builder.CreateCall(realloc, {old, size});
+    }
+    else if (op->clear) {
+      llvm::FunctionCallee calloc = module->getOrInsertFunction("calloc",
+          voidPtr, sizeType, sizeType);
+      memory = builder.CreateCall(calloc, {builder.getInt64(1), size});
+    }
+    else {
+      llvm::FunctionCallee malloc = module->getOrInsertFunction("malloc",
+          voidPtr, sizeType);
+      memory = builder.CreateCall(malloc, {size});
+    }
+    builder.CreateStore(builder.CreatePointerCast(memory,
+                                                  slot->getAllocatedType()),
+                        slot);
+  }
+
+  void visit(const Free* op) {
+    llvm::Type* voidPtr = builder.getInt8PtrTy();
+    llvm::FunctionCallee free = module->getOrInsertFunction("free",
+        builder.getVoidTy(), voidPtr);
+    builder.CreateCall(free, {builder.CreatePointerCast(codegen(op->var),
+                                                        voidPtr)});
+  }
+
+  void visit(const Comment*) {
+  }
+
+  void visit(const BlankLine*) {
+  }
+
+  void visit(const Continue*) {
+    taco_iassert(!continueTargets.empty()) << "Continue outside of a loop";
+    builder.CreateBr(continueTargets.back());
+    builder.SetInsertPoint(createBlock("after.continue"));
+  }
+
+  void visit(const Break*) {
+    taco_iassert(!breakTargets.empty()) << "Break outside of a loop";
+    builder.CreateBr(breakTargets.back());
+    builder.SetInsertPoint(createBlock("after.break"));
+  }
+
+  void visit(const Print*) {
+    taco_ierror << "Print is not supported by the LLVM backend";
+  }
+
+  void visit(const GetProperty* op) {
+    llvm::AllocaInst* slot = getSlot(op);
+    value = builder.CreateLoad(slot->getAllocatedType(), slot, op->name);
+  }
+
+  void visit(const Sort*) {
+    taco_ierror << "Sort is not supported by the LLVM backend";
+  }
+
+private:
+  typedef tuple<const IRNode*, TensorProperty, int, int> PropertyKey;
+
+  llvm::Module* module;
+  llvm::LLVMContext& context;
+  llvm::IRBuilder<> builder;
+  llvm::Function* function = nullptr;
+
+  /// The value of the most recently visited expression
+  llvm::Value* value = nullptr;
+
+  map<const Var*, llvm::Value*> tensors;
+  map<const Var*, llvm::AllocaInst*> vars;
+  map<string, llvm::AllocaInst*> ptrVars;
+  map<PropertyKey, llvm::AllocaInst*> properties;
+
+  vector<llvm::BasicBlock*> breakTargets;
+  vector<llvm::BasicBlock*> continueTargets;
+
+  static bool isSigned(Datatype type) {
+    return type.isInt();
+  }
+
+  llvm::Type* getType(Datatype type) {
+    switch (type.getKind()) {
+      case Datatype::Bool:
+        return builder.getInt1Ty();
+      case Datatype::UInt8:
+      case Datatype::Int8:
+        return builder.getInt8Ty();
+      case Datatype::UInt16:
+      case Datatype::Int16:
+        return builder.getInt16Ty();
+      case Datatype::UInt32:
+      case Datatype::Int32:
+        return builder.getInt32Ty();
+      case Datatype::UInt64:
+      case Datatype::Int64:
+        return builder.getInt64Ty();
+      case Datatype::Float32:
+        return builder.getFloatTy();
+      case Datatype::Float64:
+        return builder.getDoubleTy();
+      default:
+        taco_ierror << "Type " << type << " is not supported by the LLVM "
+                    << "backend";
+        return nullptr;
+    }
+  }
+
+  llvm::Type* getType(Datatype type, bool isPtr) {
+    llvm::Type* llvmType = getType(type);
+    return isPtr ? llvmType->getPointerTo() : llvmType;
+  }
+
+  /// The LLVM equivalent of taco_tensor_t, which *must* be kept in sync with
+  /// taco_tensor_t.h.
+  llvm::StructType* getTensorType() {
+    llvm::StructType* type =
+        llvm::StructType::getTypeByName(context, "taco_tensor_t");
+    if (type == nullptr) {
+      llvm::Type* i32 = builder.getInt32Ty();
+      llvm::Type* i8Ptr = builder.getInt8PtrTy();
+      type = llvm::StructType::create(context, {
+        i32,                                      // order
+        i32->getPointerTo(),                      // dimensions
+        i32,                                      // csize
+        i32->getPointerTo(),                      // mode_ordering
+        i32->getPointerTo(),                      // mode_types
+        i8Ptr->getPointerTo()->getPointerTo(),    // indices
+        i8Ptr,                                    // vals
+        i8Ptr,                                    // fill_value
+        i32                                       // vals_size
+      }, "taco_tensor_t");
+    }
+    return type;
+  }
+
+  enum TensorField {
+    DimensionsField = 1,
+    IndicesField = 5,
+    ValsField = 6,
+    FillValueField = 7,
+    ValsSizeField = 8
+  };
+
+  llvm::Value* getTensorFieldPtr(llvm::Value* tensor, TensorField field) {
+    return builder.CreateStructGEP(getTensorType(), tensor, field);
+  }
+
+  llvm::Value* getTensorIndexPtr(llvm::Value* tensor, int mode, int index) {
+    llvm::Type* i8Ptr = builder.getInt8PtrTy();
+    llvm::Type* i8PtrPtr = i8Ptr->getPointerTo();
+    llvm::Value* indices = builder.CreateLoad(i8PtrPtr->getPointerTo(),
+        getTensorFieldPtr(tensor, IndicesField));
+    llvm::Value* modeIndices = builder.CreateLoad(i8PtrPtr,
+        builder.CreateConstInBoundsGEP1_32(i8PtrPtr, indices, mode));
+    return builder.CreateConstInBoundsGEP1_32(i8Ptr, modeIndices, index);
+  }
+
+  PropertyKey getPropertyKey(const GetProperty* op) {
+    return PropertyKey(op->tensor.ptr, op->property, op->mode, op->index);
+  }
+
+  llvm::Type* getPropertyType(const GetProperty* op) {
+    Datatype type = op->tensor.type();
+    switch (op->property) {
+      case TensorProperty::Values:
+        return getType(type, true);
+      case TensorProperty::FillValue:
+        return getType(type, false);
+      case TensorProperty::Indices:
+        return getType(op->type, true);
+      default:
+        return builder.getInt32Ty();
+    }
+  }
+
+  /// Load a tensor property into a local variable, like the declarations
+  /// that CodeGen::printDecls emits at the top of generated C functions.
+  void unpackTensorProperty(const GetProperty* op) {
+    PropertyKey key = getPropertyKey(op);
+    if (properties.count(key) > 0) {
+      return;
+    }
+    const Var* tensorVar = op->tensor.as<Var>();
+    llvm::Value* tensor = tensors.at(tensorVar);
+    llvm::Type* type = getPropertyType(op);
+    llvm::AllocaInst* slot = builder.CreateAlloca(type, nullptr, op->name);
+    properties[key] = slot;
+
+    llvm::Value* property = nullptr;
+    llvm::Type* i8Ptr = builder.getInt8PtrTy();
+    switch (op->property) {
+      case TensorProperty::Dimension: {
+        llvm::Type* i32 = builder.getInt32Ty();
+        llvm::Value* dimensions = builder.CreateLoad(i32->getPointerTo(),
+            getTensorFieldPtr(tensor, DimensionsField));
+        property = builder.CreateLoad(i32,
+            builder.CreateConstInBoundsGEP1_32(i32, dimensions, op->mode));
+        break;
+      }
+      case TensorProperty::Indices:
+        property = builder.CreatePointerCast(builder.CreateLoad(i8Ptr,
+            getTensorIndexPtr(tensor, op->mode, op->index)), type);
+        break;
+      case TensorProperty::Values:
+        property = builder.CreatePointerCast(builder.CreateLoad(i8Ptr,
+            getTensorFieldPtr(tensor, ValsField)), type);
+        break;
+      case TensorProperty::ValuesSize:
+        property = builder.CreateLoad(type,
+            getTensorFieldPtr(tensor, ValsSizeField));
+        break;
+      case TensorProperty::FillValue: {
+        llvm::Value* fillValue = builder.CreatePointerCast(
+            builder.CreateLoad(i8Ptr, getTensorFieldPtr(tensor,
+                                                        FillValueField)),
+            type->getPointerTo());
+        property = builder.CreateLoad(type, fillValue);
+        break;
+      }
+      default:
+        taco_ierror << "Unsupported tensor property";
+        break;
+    }
+    builder.CreateStore(property, slot);
+  }
+
+  /// Store a local variable back into the output tensor, like the code that
+  /// CodeGen::printPack emits at the end of generated C functions.
+  void packTensorProperty(const PropertyKey& key, llvm::AllocaInst* slot) {
+    const Var* tensorVar = static_cast<const Var*>(get<0>(key));
+    llvm::Value* tensor = tensors.at(tensorVar);
+    llvm::Value* property = builder.CreateLoad(slot->getAllocatedType(), slot);
+    llvm::Type* i8Ptr = builder.getInt8PtrTy();
+    switch (get<1>(key)) {
+      case TensorProperty::Values:
+        builder.CreateStore(builder.CreatePointerCast(property, i8Ptr),
+                            getTensorFieldPtr(tensor, ValsField));
+        break;
+      case TensorProperty::ValuesSize:
+        builder.CreateStore(property, getTensorFieldPtr(tensor,
+                                                        ValsSizeField));
+        break;
+      case TensorProperty::Indices:
+        builder.CreateStore(builder.CreatePointerCast(property, i8Ptr),
+            getTensorIndexPtr(tensor, get<2>(key), get<3>(key)));
+        break;
+      default:
+        break;
+    }
+  }
+
+  /// Generate `int _shim_<name>(void** parameterPack)`, which unpacks the
+  /// parameters and calls the function (see CodeGen_C::generateShim).
+  void generateShim(const Function* func, const vector<Expr>& parameters,
+                    llvm::Function* target) {
+    llvm::Type* i8Ptr = builder.getInt8PtrTy();
+    llvm::FunctionType* shimType = llvm::FunctionType::get(
+        builder.getInt32Ty(), {i8Ptr->getPointerTo()}, false);
+    llvm::Function* shim = llvm::Function::Create(shimType,
+        llvm::Function::ExternalLinkage, "_shim_" + func->name, module);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", shim));
+
+    vector<llvm::Value*> args;
+    for (size_t i = 0; i < parameters.size(); ++i) {
+      llvm::Value* arg = builder.CreateLoad(i8Ptr,
+          builder.CreateConstInBoundsGEP1_32(i8Ptr, shim->getArg(0), i));
+      args.push_back(coerce(arg, parameters[i].type(),
+                            target->getArg(i)->getType(),
+                            parameters[i].type()));
+    }
+    builder.CreateRet(builder.CreateCall(target, args));
+  }
+
+  llvm::BasicBlock* createBlock(const string& name) {
+    return llvm::BasicBlock::Create(context, name, function);
+  }
+
+  llvm::AllocaInst* getVarSlot(const Var* var) {
+    if (vars.count(var) == 0) {
+      // The C backend does not rename pointer variables, so distinct pointer
+      // variables of the same name refer to the same memory
+      if (var->is_ptr && ptrVars.count(var->name) > 0) {
+        vars[var] = ptrVars.at(var->name);
+        return vars[var];
+      }
+
+      // Allocate all variables in the entry block so that they are promoted
+      // to registers
+      llvm::BasicBlock& entry = function->getEntryBlock();
+      llvm::IRBuilder<> entryBuilder(&entry, entry.begin());
+      vars[var] = entryBuilder.CreateAlloca(getType(var->type, var->is_ptr),
+                                            nullptr, var->name);
+      if (var->is_ptr) {
+        ptrVars[var->name] = vars[var];
+      }
+    }
+    return vars[var];
+  }
+
+  llvm::AllocaInst* getSlot(Expr lvalue) {
+    if (const Var* var = lvalue.as<Var>()) {
+      return getVarSlot(var);
+    }
+    const GetProperty* property = lvalue.as<GetProperty>();
+    taco_iassert(property) << "Cannot assign to " << lvalue;
+    taco_iassert(properties.count(getPropertyKey(property)) > 0)
+        << "Property " << lvalue << " was not unpacked";
+    return properties[getPropertyKey(property)];
+  }
+
+  llvm::Value* codegen(Expr expr) {
+    value = nullptr;
+    expr.accept(this);
+    taco_iassert(value) << "No value generated for " << expr;
+    llvm::Value* result = value;
+    value = nullptr;
+    return result;
+  }
+
+  llvm::Value* codegen(Expr expr, Datatype type) {
+    return convert(codegen(expr), expr.type(), type);
+  }
+
+  void codegenAssign(Expr lvalue, Expr rhs) {
+    llvm::AllocaInst* slot = getSlot(lvalue);
+    Datatype type = lvalue.type();
+    if (const GetProperty* property = lvalue.as<GetProperty>()) {
+      type = property->tensor.type();
+    }
+    builder.CreateStore(coerce(codegen(rhs), rhs.type(),
+                               slot->getAllocatedType(), type), slot);
+  }
+
+  /// Convert a scalar value to the given type, following the C conversion
+  /// rules. The signedness of the value is taken from `from`, but whether it
+  /// is an integer or a floating-point value is taken from its LLVM type.
+  llvm::Value* convert(llvm::Value* val, Datatype from, Datatype to) {
+    llvm::Type* type = getType(to);
+    llvm::Type* valType = val->getType();
+    if (valType->isPointerTy()) {
+      return to.isBool() ? builder.CreateIsNotNull(val)
+                         : builder.CreatePtrToInt(val, type);
+    }
+    if (valType == type && !(to.isBool() && !from.isBool())) {
+      return val;
+    }
+    if (to.isBool()) {
+      if (valType->isFloatingPointTy()) {
+        return builder.CreateFCmpUNE(val, llvm::ConstantFP::get(valType, 0.0));
+      }
+      return builder.CreateIsNotNull(val);
+    }
+    if (to.isFloat()) {
+      if (valType->isFloatingPointTy()) {
+        return builder.CreateFPCast(val, type);
+      }
+      return isSigned(from) ? builder.CreateSIToFP(val, type)
+                            : builder.CreateUIToFP(val, type);
+    }
+    if (valType->isFloatingPointTy()) {
+      return isSigned(to) ? builder.CreateFPToSI(val, type)
+                          : builder.CreateFPToUI(val, type);
+    }
+    return builder.CreateIntCast(val, type, isSigned(from));
+  }
+
+  /// Convert a value to the given LLVM type, which is either a pointer type
+  /// or the LLVM equivalent of `to`.
+  llvm::Value* coerce(llvm::Value* val, Datatype from, llvm::Type* type,
+                      Datatype to) {
+    if (val->getType() == type) {
+      return val;
+    }
+    if (type->isPointerTy()) {
+      if (val->getType()->isPointerTy()) {
+        return builder.CreatePointerCast(val, type);
+      }
+      return builder.CreateIntToPtr(convert(val, from, Int64), type);
+    }
+    return convert(val, from, to);
+  }
+
+  llvm::Value* codegenElementPtr(Expr arr, Expr loc, llvm::Type* type) {
+    llvm::Value* base = builder.CreatePointerCast(codegen(arr),
+                                                  type->getPointerTo());
+    return builder.CreateInBoundsGEP(type, base, codegen(loc, Int64));
+  }
+
+  llvm::Value* codegenCompare(llvm::Value* a, llvm::Value* b, Datatype type,
+                              llvm::CmpInst::Predicate floatPredicate,
+                              llvm::CmpInst::Predicate signedPredicate,
+                              llvm::CmpInst::Predicate unsignedPredicate) {
+    if (type.isFloat()) {
+      return builder.CreateFCmp(floatPredicate, a, b);
+    }
+    return builder.CreateICmp(isSigned(type) ? signedPredicate
+                                             : unsignedPredicate, a, b);
+  }
+
+  llvm::Value* codegenCompare(Expr a, Expr b,
+                              llvm::CmpInst::Predicate floatPredicate,
+                              llvm::CmpInst::Predicate signedPredicate,
+                              llvm::CmpInst::Predicate unsignedPredicate) {
+    Datatype type = max_type(a.type(), b.type());
+    llvm::Value* aValue = codegen(a);
+    llvm::Value* bValue = codegen(b);
+    if (aValue->getType()->isPointerTy() || bValue->getType()->isPointerTy()) {
+      // Pointer comparisons compare addresses
+      type = UInt64;
+    }
+    return codegenCompare(convert(aValue, a.type(), type),
+                          convert(bValue, b.type(), type), type,
+                          floatPredicate, signedPredicate, unsignedPredicate);
+  }
+
+  llvm::Value* codegenMinMax(const vector<Expr>& operands, Datatype type,
+                             bool isMin) {
+    // Operands are nested to the right, as in the generated C code
+    llvm::Value* result = codegen(operands.back(), type);
+    for (int i = (int)operands.size() - 2; i >= 0; --i) {
+      llvm::Value* operand = codegen(operands[i], type);
+      if (isMin && type.isFloat()) {
+        result = builder.CreateMinNum(operand, result);
+        continue;
+      }
+      llvm::Value* cond = isMin
+          ? codegenCompare(operand, result, type, llvm::CmpInst::FCMP_OLT,
+                           llvm::CmpInst::ICMP_SLT, llvm::CmpInst::ICMP_ULT)
+          : codegenCompare(operand, result, type, llvm::CmpInst::FCMP_OGT,
+                           llvm::CmpInst::ICMP_SGT, llvm::CmpInst::ICMP_UGT);
+      result = builder.CreateSelect(cond, operand, result);
+    }
+    return result;
+  }
+
+  llvm::Value* codegenShortCircuit(Expr a, Expr b, bool isAnd) {
+    llvm::Value* aValue = codegen(a, Bool);
+    llvm::BasicBlock* aBlock = builder.GetInsertBlock();
+    llvm::BasicBlock* bBlock = createBlock(isAnd ? "and.rhs" : "or.rhs");
+    llvm::BasicBlock* endBlock = createBlock(isAnd ? "and.end" : "or.end");
+    if (isAnd) {
+      builder.CreateCondBr(aValue, bBlock, endBlock);
+    }
+    else {
+      builder.CreateCondBr(aValue, endBlock, bBlock);
+    }
+
+    builder.SetInsertPoint(bBlock);
+    llvm::Value* bValue = codegen(b, Bool);
+    bBlock = builder.GetInsertBlock();
+    builder.CreateBr(endBlock);
+
+    builder.SetInsertPoint(endBlock);
+    llvm::PHINode* result = builder.CreatePHI(builder.getInt1Ty(), 2);
+    result->addIncoming(builder.getInt1(!isAnd), aBlock);
+    result->addIncoming(bValue, bBlock);
+    return result;
+  }
+
+  /// Attach the loop hints that the C backend emits as pragmas
+  void setLoopMetadata(llvm::BranchInst* latch, LoopKind kind, int vecWidth,
+                       size_t unrollFactor) {
+    vector<llvm::Metadata*> hints;
+    auto hint = [&](const string& name, llvm::Constant* value) {
+      hints.push_back(llvm::MDNode::get(context, {
+        llvm::MDString::get(context, name),
+        llvm::ConstantAsMetadata::get(value)
+      }));
+    };
+    if (kind == LoopKind::Vectorized) {
+      hint("llvm.loop.vectorize.enable", builder.getTrue());
+      if (vecWidth > 0) {
+        hint("llvm.loop.vectorize.width", builder.getInt32(vecWidth));
+      }
+    }
+    else if (unrollFactor > 0) {
+      hint("llvm.loop.unroll.count", builder.getInt32(unrollFactor));
+    }
+    if (hints.empty()) {
+      return;
+    }
+
+    // Loop metadata refers to itself in its first operand
+    auto placeholder = llvm::MDNode::getTemporary(context, llvm::None);
+    hints.insert(hints.begin(), placeholder.get());
+    llvm::MDNode* loopID = llvm::MDNode::getDistinct(context, hints);
+    loopID->replaceOperandWith(0, loopID);
+    latch->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+  }
+};
+
+} // anonymous namespace
+
+struct CodeGen_LLVM::Content {
+  int optLevel;
+  unique_ptr<llvm::LLVMContext> context;
+  unique_ptr<llvm::Module> module;
+  vector<string> funcNames;
+
+  /// The library in the JIT that holds the compiled functions
+  llvm::orc::JITDylib* library = nullptr;
+  map<string,void*> funcPtrs;
+
+  ~Content() {
+    if (library) {
+      llvm::consumeError(
+          getJIT().getExecutionSession().removeJITDylib(*library));
+    }
+  }
+};
+
+CodeGen_LLVM::CodeGen_LLVM(int optLevel) : content(new Content) {
+  llvm::orc::LLJIT& jit = getJIT();
+  content->optLevel = optLevel;
+  content->context.reset(new llvm::LLVMContext());
+  content->module.reset(new llvm::Module("taco", *content->context));
+  content->module->setDataLayout(jit.getDataLayout());
+  content->module->setTargetTriple(jit.getTargetTriple().str());
+}
+
+CodeGen_LLVM::~CodeGen_LLVM() {
+}
+
+bool CodeGen_LLVM::isSupported(const vector<Stmt>& funcs) {
+  for (auto& func : funcs) {
+    SupportChecker checker;
+    func.accept(&checker);
+    if (!checker.supported) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CodeGen_LLVM::compile(Stmt func) {
+  taco_iassert(content->module) << "Module has already been finalized";
+  const Function* function = func.as<Function>();
+  taco_iassert(function) << "Only functions can be compiled";
+  FunctionGen(content->module.get()).compile(function);
+  content->funcNames.push_back(function->name);
+  content->funcNames.push_back("_shim_" + function->name);
+}
+
+void CodeGen_LLVM::finalize() {
+  taco_iassert(content->module) << "Module has already been finalized";
+  string errors;
+  llvm::raw_string_ostream errorStream(errors);
+  taco_iassert(!llvm::verifyModule(*content->module, &errorStream))
+      << "Generated invalid LLVM IR: " << errorStream.str();
+
+  optimize(*content->module, content->optLevel);
+
+  llvm::orc::LLJIT& jit = getJIT();
+  llvm::orc::ExecutionSession& session = jit.getExecutionSession();
+  static atomic<int> libraryCount(0);
+  content->library = &unwrap(session.createJITDylib(
+      "taco_library" + util::toString(libraryCount++)));
+  content->library->addGenerator(unwrap(
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+          jit.getDataLayout().getGlobalPrefix())));
+
+  llvm::orc::MangleAndInterner mangle(session, jit.getDataLayout());
+  auto symbol = [](void* address) {
+    return llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(address),
+                                    llvm::JITSymbolFlags::Exported);
+  };
+  check(content->library->define(llvm::orc::absoluteSymbols({
+    {mangle("taco_gallop"), symbol((void*)&taco_gallop)},
+    {mangle("taco_simdAdvance"), symbol((void*)&taco_simdAdvance)},
+    {mangle("taco_binarySearchAfter"), symbol((void*)&taco_binarySearchAfter)},
+    {mangle("taco_binarySearchBefore"), symbol((void*)&taco_binarySearchBefore)},
+    {mangle("taco_mergePathSearch"), symbol((void*)&taco_mergePathSearch)}
+  })));
+
+  check(jit.addIRModule(*content->library, llvm::orc::ThreadSafeModule(
+      std::move(content->module), std::move(content->context))));
+
+  // Looking the functions up compiles them, so do it now rather than on
+  // their first call
+  for (auto& name : content->funcNames) {
+    llvm::JITEvaluatedSymbol address = unwrap(jit.lookup(*content->library,
+                                                         name));
+    content->funcPtrs[name] = llvm::jitTargetAddressToPointer<void*>(
+        address.getAddress());
+  }
+}
+
+void* CodeGen_LLVM::getFuncPtr(string name) {
+  auto funcPtr = content->funcPtrs.find(name);
+  return (funcPtr != content->funcPtrs.end()) ? funcPtr->second : nullptr;
+}
+
+#else
+
+struct CodeGen_LLVM::Content {
+};
+
+CodeGen_LLVM::CodeGen_LLVM(int optLevel) {
+  taco_ierror << "taco was built without LLVM support";
+}
+
+CodeGen_LLVM::~CodeGen_LLVM() {
+}
+
+bool CodeGen_LLVM::isSupported(const vector<Stmt>& funcs) {
+  return false;
+}
+
+void CodeGen_LLVM::compile(Stmt func) {
+  taco_ierror << "taco was built without LLVM support";
+}
+
+void CodeGen_LLVM::finalize() {
+  taco_ierror << "taco was built without LLVM support";
+}
+
+void* CodeGen_LLVM::getFuncPtr(string name) {
+  return nullptr;
+}
+
+#endif
+
+} // namespace ir
+} // namespace taco
@@ -0,0 +1,47 @@
+#ifndef TACO_BACKEND_LLVM_H
+#define TACO_BACKEND_LLVM_H
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "taco/target.h"
+#include "taco/ir/ir.h"
+
+namespace taco {
+namespace ir {
+
+/// Code generator that translates lowered functions directly to LLVM IR and
+/// compiles them to machine code in memory, so that no system compiler has to
+/// be invoked. Functions are compiled together with the `_shim_` entry points
+/// that the C backend emits, so both backends can be called the same way.
+class CodeGen_LLVM {
+public:
+  /// Initialize a code generator that optimizes the generated code at the
+  /// given level (0-3, as in -O0 through -O3).
+  CodeGen_LLVM(int optLevel=3);
+  ~CodeGen_LLVM();
+
+  /// Returns true if the functions only use features supported by this
+  /// backend. Functions that are not supported (e.g., coroutines or functions
+  /// on complex values) must be compiled through the C backend instead. This
+  /// always returns false if taco was built without LLVM.
+  static bool isSupported(const std::vector<Stmt>& funcs);
+
+  /// Add a lowered function to the code being generated
+  void compile(Stmt func);
+
+  /// Compile all the functions added so far to machine code
+  void finalize();
+
+  /// Get a pointer to a compiled function, or nullptr if there's no function
+  /// of this name
+  void* getFuncPtr(std::string name);
+
+private:
+  struct Content;
+  std::unique_ptr<Content> content;
+};
+
+} // namespace ir
+} // namespace taco
+#endif
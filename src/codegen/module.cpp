@@ -2,18 +2,33 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
 #include <dlfcn.h>
+#include <dirent.h>
 #include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
 #if USE_OPENMP
 #include <omp.h>
 #endif
 
 #include "taco/tensor.h"
+#include "taco/parallel_runtime.h"
 #include "taco/error.h"
 #include "taco/util/strings.h"
 #include "taco/util/env.h"
+#include "taco/util/hash.h"
 #include "codegen/codegen_c.h"
 #include "codegen/codegen_cuda.h"
+#include "codegen/codegen_llvm.h"
 #include "taco/cuda.h"
 
 using namespace std;
@@ -26,6 +41,57 @@ std::default_random_engine Module::gen = std::default_random_engine();
 std::uniform_int_distribution<int> Module::randint =
     std::uniform_int_distribution<int>(0, chars.length() - 1);
 
+/// A compiled library, which is either a shared library loaded with dlopen or
+/// a library that the LLVM backend compiled in memory.
+struct Module::Library {
+  CompilationTier tier;
+  void* handle;
+  shared_ptr<CodeGen_LLVM> jit;
+  bool usesParallelRuntime;
+
+  Library(CompilationTier tier, void* handle)
+      : tier(tier), handle(handle), usesParallelRuntime(false) {
+    // Libraries whose parallel loops run on the work-stealing runtime call it
+    // through a table, which is bound to the runtime of this process
+    auto runtime = (taco_parallel_runtime_t*)dlsym(handle,
+                                                   "taco_parallel_runtime");
+    if (runtime != nullptr) {
+      runtime->parallel_for = taco_parallel_for;
+      runtime->thread_num = taco_parallel_thread_num;
+      runtime->max_threads = taco_parallel_max_threads;
+      usesParallelRuntime = true;
+    }
+  }
+
+  Library(CompilationTier tier, shared_ptr<CodeGen_LLVM> jit)
+      : tier(tier), handle(nullptr), jit(jit), usesParallelRuntime(false) {
+  }
+
+  ~Library() {
+    if (handle) {
+      dlclose(handle);
+    }
+  }
+
+  void* getFuncPtr(const string& name) const {
+    return jit ? jit->getFuncPtr(name) : dlsym(handle, name.data());
+  }
+};
+
+namespace {
+mutex tierTransitionHookMutex;
+function<void(const TierTransition&)> tierTransitionHook;
+}
+
+void setTierTransitionHook(function<void(const TierTransition&)> hook) {
+  lock_guard<mutex> lock(tierTransitionHookMutex);
+  tierTransitionHook = hook;
+}
+
+Module::~Module() {
+  waitForOptimization();
+}
+
 void Module::setJITTmpdir() {
   tmpdir = util::getTmpdir();
 }
@@ -40,7 +106,7 @@ void Module::addFunction(Stmt func) {
   funcs.push_back(func);
 }
 
-void Module::compileToSource(string path, string prefix) {
+void Module::generateSource() {
   if (!moduleFromUserSource) {
   
     // create a codegen instance and add all the funcs
@@ -51,8 +117,8 @@ void Module::compileToSource(string path, string prefix) {
     source.str("");
     source.clear();
 
-    taco_tassert(target.arch == Target::C99) <<
-        "Only C99 codegen supported currently";
+    // C code is generated for every target, since functions that the LLVM
+    // backend does not support are compiled as C.
     std::shared_ptr<CodeGen> sourcegen =
         CodeGen::init_default(source, CodeGen::ImplementationGen);
     std::shared_ptr<CodeGen> headergen =
@@ -64,6 +130,10 @@ void Module::compileToSource(string path, string prefix) {
       didGenRuntime = true;
     }
   }
+}
+
+void Module::compileToSource(string path, string prefix) {
+  generateSource();
 
   ofstream source_file;
   string file_ending = should_use_CUDA_codegen() ? ".cu" : ".c";
@@ -106,14 +176,325 @@ void writeShims(vector<Stmt> funcs, string path, string prefix) {
   shims_file.close();
 }
 
+/// Returns the directory in which compiled kernels are cached across
+/// processes, or the empty string if the disk cache is disabled. The cache is
+/// enabled by pointing the TACO_CACHE_DIR environment variable at a directory.
+string getCacheDir() {
+  string cachedir = util::getFromEnv("TACO_CACHE_DIR", "");
+  if (cachedir.empty()) {
+    return cachedir;
+  }
+  if (cachedir.back() != '/') {
+    cachedir += '/';
+  }
+  if (mkdir(cachedir.c_str(), 0755) != 0 && errno != EEXIST) {
+    taco_uwarning << "Unable to create kernel cache directory " << cachedir
+                  << ", kernels will not be cached";
+    return "";
+  }
+  return cachedir;
+}
+
+/// Returns the maximum total size in bytes of the kernel disk cache, which can
+/// be set in megabytes through the TACO_CACHE_SIZE environment variable.
+size_t getCacheSizeLimit() {
+  const string limit = util::getFromEnv("TACO_CACHE_SIZE", "1024");
+  return (size_t)strtoull(limit.c_str(), nullptr, 10) << 20;
+}
+
+/// Copy `from` into the cache as `to`. The file is first written to a
+/// temporary name unique to this module and then renamed, so concurrent
+/// readers and writers only ever observe complete files.
+bool publishFile(const string& from, const string& to, const string& tmpname) {
+  const string tmp = to + "." + tmpname + ".tmp";
+  {
+    ifstream in(from, ios::binary);
+    ofstream out(tmp, ios::binary);
+    if (!in.is_open() || !out.is_open()) {
+      return false;
+    }
+    out << in.rdbuf();
+    if (!out.good()) {
+      out.close();
+      remove(tmp.c_str());
+      return false;
+    }
+  }
+  if (rename(tmp.c_str(), to.c_str()) != 0) {
+    remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+/// Evict the least recently used cache entries until the total size of the
+/// cache is within `limit` bytes. Entries are timestamped on every hit, so the
+/// modification time of the library tracks its last use.
+void evictCacheEntries(const string& cachedir, size_t limit) {
+  struct Entry {
+    string key;
+    time_t lastUse;
+    size_t size;
+  };
+
+  DIR* dir = opendir(cachedir.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+
+  const vector<string> extensions = {".so", ".c", ".cu", ".h", "_shims.cpp"};
+  vector<Entry> entries;
+  size_t totalSize = 0;
+  while (struct dirent* dirent = readdir(dir)) {
+    const string name = dirent->d_name;
+    if (name.size() <= 3 || name.compare(name.size() - 3, 3, ".so") != 0) {
+      continue;
+    }
+    Entry entry = {name.substr(0, name.size() - 3), 0, 0};
+    for (const auto& extension : extensions) {
+      struct stat st;
+      if (stat((cachedir + entry.key + extension).c_str(), &st) == 0) {
+        entry.size += st.st_size;
+        if (extension == ".so") {
+          entry.lastUse = st.st_mtime;
+        }
+      }
+    }
+    totalSize += entry.size;
+    entries.push_back(entry);
+  }
+  closedir(dir);
+
+  sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.lastUse < b.lastUse;
+  });
+  for (const auto& entry : entries) {
+    if (totalSize <= limit) {
+      break;
+    }
+    // The library is removed first so that readers never find a library
+    // whose sources have already been evicted.
+    for (const auto& extension : extensions) {
+      remove((cachedir + entry.key + extension).c_str());
+    }
+    totalSize -= entry.size;
+  }
+}
+
+/// Returns the optimization level (0-3) of the LLVM backend, which can be set
+/// through the TACO_LLVM_OPT_LEVEL environment variable.
+int getLLVMOptLevel() {
+  return atoi(util::getFromEnv("TACO_LLVM_OPT_LEVEL", "3").c_str());
+}
+
+/// The optimization level of the LLVM backend for baseline tiers
+const int baselineLLVMOptLevel = 0;
+
+/// Returns true if modules should be compiled in tiers, which is enabled by
+/// setting the TACO_TIERED_COMPILATION environment variable to 1.
+bool isTieredCompilationEnabled() {
+  return util::getFromEnv("TACO_TIERED_COMPILATION", "0") != "0";
+}
+
+/// Returns the flags that let the system compiler use the vector extensions
+/// of the host (e.g. the gathers of AVX2 and AVX-512) in vectorized loops.
+string getVectorFlags() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return " -mavx512f -mavx2 -mfma";
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return " -mavx2 -mfma";
+  }
+#endif
+  return "";
+}
+
+/// Translate the functions to LLVM IR, which must be done on the thread that
+/// owns the IR, since IR nodes are not reference counted atomically.
+shared_ptr<CodeGen_LLVM> translateToLLVM(const vector<Stmt>& funcs,
+                                         int optLevel) {
+  shared_ptr<CodeGen_LLVM> jit = make_shared<CodeGen_LLVM>(optLevel);
+  for (auto& func : funcs) {
+    jit->compile(func);
+  }
+  return jit;
+}
+
+/// The number of modules that are being recompiled in the background. They
+/// are waited for at exit, since they compile in the temporary directory that
+/// is removed at exit.
+mutex optimizerMutex;
+condition_variable optimizerDone;
+int runningOptimizers = 0;
+
+void waitForOptimizers() {
+  unique_lock<mutex> lock(optimizerMutex);
+  optimizerDone.wait(lock, []() { return runningOptimizers == 0; });
+}
+
+/// Run `optimize` on a background thread that is waited for at exit.
+thread startOptimizer(function<void()> optimize) {
+  // Handlers registered with atexit run in reverse order, so registering this
+  // one after the temporary directory was created makes it run first
+  static int registered = atexit(waitForOptimizers);
+  (void)registered;
+
+  {
+    lock_guard<mutex> lock(optimizerMutex);
+    runningOptimizers++;
+  }
+  return thread([optimize]() {
+    try {
+      optimize();
+    }
+    catch (const exception& e) {
+      taco_uwarning << "Optimized recompilation failed, the module keeps "
+                    << "running baseline code: " << e.what();
+    }
+    lock_guard<mutex> lock(optimizerMutex);
+    runningOptimizers--;
+    optimizerDone.notify_all();
+  });
+}
+
+double millisecondsSince(chrono::steady_clock::time_point begin) {
+  return chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                         begin).count();
+}
+
 } // anonymous namespace
 
+void Module::installLibrary(shared_ptr<Library> library, double compileTime) {
+  shared_ptr<Library> previous = atomic_exchange(&this->library, library);
+  if (library->tier == CompilationTier::Optimized && previous &&
+      previous->tier == CompilationTier::Baseline) {
+    retiredLibrary = previous;
+  }
+
+  function<void(const TierTransition&)> hook;
+  {
+    lock_guard<mutex> lock(tierTransitionHookMutex);
+    hook = tierTransitionHook;
+  }
+  if (hook) {
+    hook({this, library->tier, compileTime});
+  }
+}
+
+CompilationTier Module::getTier() const {
+  if (aliased) {
+    return aliased->getTier();
+  }
+  shared_ptr<Library> library = atomic_load(&this->library);
+  taco_uassert(library != nullptr) << "The module has not been compiled";
+  return library->tier;
+}
+
+void Module::waitForOptimization() {
+  if (aliased) {
+    aliased->waitForOptimization();
+  }
+  if (optimizer.joinable()) {
+    optimizer.join();
+  }
+}
+
 string Module::compile() {
+  return prepareCompile()();
+}
+
+void Module::compile(const vector<shared_ptr<Module>>& modules) {
+  vector<function<string()>> jobs;
+  for (auto& module : modules) {
+    jobs.push_back(module->prepareCompile());
+  }
+
+  atomic<size_t> next(0);
+  mutex errorMutex;
+  exception_ptr error;
+  auto worker = [&]() {
+    for (size_t i = next++; i < jobs.size(); i = next++) {
+      try {
+        jobs[i]();
+      }
+      catch (...) {
+        lock_guard<mutex> lock(errorMutex);
+        if (!error) {
+          error = current_exception();
+        }
+      }
+    }
+  };
+
+  const size_t numThreads =
+      std::min((size_t)std::max(thread::hardware_concurrency(), 1u),
+               jobs.size());
+  vector<thread> threads;
+  for (size_t i = 1; i < numThreads; ++i) {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    rethrow_exception(error);
+  }
+}
+
+shared_ptr<Module> Module::alias(shared_ptr<Module> module,
+                                 map<string,string> functionNames) {
+  shared_ptr<Module> alias = make_shared<Module>(module->target);
+  alias->aliased = module;
+  alias->aliasedNames = functionNames;
+  return alias;
+}
+
+function<string()> Module::prepareCompile() {
+  taco_uassert(!aliased) << "Aliases of modules cannot be compiled";
+  waitForOptimization();
+  retiredLibrary = nullptr;
+  const auto begin = chrono::steady_clock::now();
+  const bool tiered = isTieredCompilationEnabled() && !moduleFromUserSource &&
+                      !should_use_CUDA_codegen();
+
+  // Compile in memory if the target asks for it and every function can be
+  // compiled that way, which skips the system compiler entirely
+  if (target.arch == Target::X86 && !moduleFromUserSource &&
+      !should_use_CUDA_codegen() && CodeGen_LLVM::isSupported(funcs)) {
+    shared_ptr<CodeGen_LLVM> jit = translateToLLVM(funcs, getLLVMOptLevel());
+    if (!tiered) {
+      return [this, jit, begin]() {
+        jit->finalize();
+        installLibrary(make_shared<Library>(CompilationTier::Optimized, jit),
+                       millisecondsSince(begin));
+        return string();
+      };
+    }
+
+    shared_ptr<CodeGen_LLVM> baseline = translateToLLVM(funcs,
+                                                        baselineLLVMOptLevel);
+    return [this, jit, baseline, begin]() {
+      baseline->finalize();
+      installLibrary(make_shared<Library>(CompilationTier::Baseline, baseline),
+                     millisecondsSince(begin));
+      optimizer = startOptimizer([this, jit, begin]() {
+        jit->finalize();
+        installLibrary(make_shared<Library>(CompilationTier::Optimized, jit),
+                       millisecondsSince(begin));
+      });
+      return string();
+    };
+  }
+
   string prefix = tmpdir+libname;
   string fullpath = prefix + ".so";
   
   string cc;
   string cflags;
+  string baselineCflags;
   string file_ending;
   string shims_file;
   if (should_use_CUDA_codegen()) {
@@ -131,11 +512,20 @@ string Module::compile() {
     string defaultFlags = "-g -O0 -std=c99";
 #else
     // Otherwise, use the standard set of optimizing flags.
-    string defaultFlags = "-O3 -ffast-math -std=c99";
+    string defaultFlags = "-O3 -ffast-math -std=c99" + getVectorFlags();
 #endif
     cflags = util::getFromEnv("TACO_CFLAGS", defaultFlags) + " -shared -fPIC";
+    // Baseline tiers trade code quality for compile time
+    baselineCflags = util::getFromEnv("TACO_BASELINE_CFLAGS",
+                                      "-O0 -std=c99") +
+                     " -shared -fPIC";
 #if USE_OPENMP
     cflags += " -fopenmp";
+    baselineCflags += " -fopenmp";
+#else
+    // Vectorized loops are emitted with OpenMP SIMD pragmas, which do not
+    // need the OpenMP runtime
+    cflags += " -fopenmp-simd";
 #endif
     file_ending = ".c";
     shims_file = "";
@@ -147,23 +537,92 @@ string Module::compile() {
 
   // open the output file & write out the source
   compileToSource(tmpdir, libname);
+
+  // Kernels are cached on disk under a hash of everything that determines the
+  // contents of the compiled library: the generated code (which is a function
+  // of the concretized statement and its operand formats and types), the
+  // target, the compiler and the compiler flags.
+  const string cachedir = getCacheDir();
+  string cachedLib;
+  if (!cachedir.empty()) {
+    stringstream key;
+    key << cc << "\n" << cflags << "\n" << target.arch << "-" << target.os
+        << "\n" << header.str() << "\n" << source.str();
+    cachedLib = cachedir + util::toHexString(util::fnv1a(key.str())) + ".so";
+
+    void* cachedHandle = dlopen(cachedLib.data(), RTLD_NOW | RTLD_LOCAL);
+    if (cachedHandle) {
+      utime(cachedLib.data(), nullptr);
+      installLibrary(make_shared<Library>(CompilationTier::Optimized,
+                                          cachedHandle),
+                     millisecondsSince(begin));
+      return [cachedLib]() { return cachedLib; };
+    }
+  }
   
   // write out the shims
   writeShims(funcs, tmpdir, libname);
   
-  // now compile it
-  int err = system(cmd.data());
-  taco_uassert(err == 0) << "Compilation command failed:\n" << cmd
-    << "\nreturned " << err;
+  // Compiles the optimized library, publishes it to the disk cache and loads
+  // it. This only touches local state, so that it can run on other threads.
+  const string libname = this->libname;
+  auto compileOptimized = [=]() -> void* {
+    int err = system(cmd.data());
+    taco_uassert(err == 0) << "Compilation command failed:\n" << cmd
+      << "\nreturned " << err;
+
+    if (!cachedir.empty()) {
+      // Publish the sources before the library, since the presence of the
+      // library is what marks a cache entry as complete.
+      const string cachedPrefix = cachedLib.substr(0, cachedLib.size() - 3);
+      publishFile(prefix + file_ending, cachedPrefix + file_ending, libname);
+      publishFile(prefix + ".h", cachedPrefix + ".h", libname);
+      if (!shims_file.empty()) {
+        publishFile(shims_file, cachedPrefix + "_shims.cpp", libname);
+      }
+      if (publishFile(fullpath, cachedLib, libname)) {
+        evictCacheEntries(cachedir, getCacheSizeLimit());
+      }
+    }
+
+    // use dlsym() to open the compiled library
+    void* handle = dlopen(fullpath.data(), RTLD_NOW | RTLD_LOCAL);
+    taco_uassert(handle) << "Failed to load generated code, error is: "
+                         << dlerror();
+    return handle;
+  };
 
-  // use dlsym() to open the compiled library
-  if (lib_handle) {
-    dlclose(lib_handle);
+  if (!tiered) {
+    return [this, compileOptimized, fullpath, begin]() {
+      void* handle = compileOptimized();
+      installLibrary(make_shared<Library>(CompilationTier::Optimized, handle),
+                     millisecondsSince(begin));
+      return fullpath;
+    };
   }
-  lib_handle = dlopen(fullpath.data(), RTLD_NOW | RTLD_LOCAL);
-  taco_uassert(lib_handle) << "Failed to load generated code, error is: " << dlerror();
 
-  return fullpath;
+  string baselinePath = prefix + "_baseline.so";
+  string baselineCmd = cc + " " + baselineCflags + " " +
+    prefix + file_ending + " " + shims_file + " " +
+    "-o " + baselinePath + " -lm";
+  return [this, compileOptimized, baselinePath, baselineCmd, begin]() {
+    int err = system(baselineCmd.data());
+    taco_uassert(err == 0) << "Compilation command failed:\n" << baselineCmd
+      << "\nreturned " << err;
+    void* baselineHandle = dlopen(baselinePath.data(), RTLD_NOW | RTLD_LOCAL);
+    taco_uassert(baselineHandle) << "Failed to load generated code, error is: "
+                                 << dlerror();
+    installLibrary(make_shared<Library>(CompilationTier::Baseline,
+                                        baselineHandle),
+                   millisecondsSince(begin));
+
+    optimizer = startOptimizer([this, compileOptimized, begin]() {
+      void* handle = compileOptimized();
+      installLibrary(make_shared<Library>(CompilationTier::Optimized, handle),
+                     millisecondsSince(begin));
+    });
+    return baselinePath;
+  };
 }
 
 void Module::setSource(string source) {
@@ -172,11 +631,42 @@ void Module::setSource(string source) {
 }
 
 string Module::getSource() {
+  if (aliased) {
+    return aliased->getSource();
+  }
+  // Modules compiled in memory never write out their C source, so generate it
+  // on demand
+  shared_ptr<Library> library = atomic_load(&this->library);
+  if (library && library->jit && source.tellp() == 0) {
+    generateSource();
+  }
   return source.str();
 }
 
 void* Module::getFuncPtr(std::string name) {
-  return dlsym(lib_handle, name.data());
+  if (aliased) {
+    // Shims are named after the functions they call
+    const string shimPrefix = "_shim_";
+    const bool isShim = name.compare(0, shimPrefix.size(), shimPrefix) == 0;
+    auto aliasedName =
+        aliasedNames.find(isShim ? name.substr(shimPrefix.size()) : name);
+    if (aliasedName == aliasedNames.end()) {
+      return nullptr;
+    }
+    return aliased->getFuncPtr(isShim ? shimPrefix + aliasedName->second
+                                      : aliasedName->second);
+  }
+  shared_ptr<Library> library = atomic_load(&this->library);
+  taco_uassert(library != nullptr) << "The module has not been compiled";
+  return library->getFuncPtr(name);
+}
+
+bool Module::usesParallelRuntime() {
+  if (aliased) {
+    return aliased->usesParallelRuntime();
+  }
+  shared_ptr<Library> library = atomic_load(&this->library);
+  return library != nullptr && library->usesParallelRuntime;
 }
 
 int Module::callFuncPackedRaw(std::string name, void** args) {
@@ -187,6 +677,20 @@ int Module::callFuncPackedRaw(std::string name, void** args) {
   fnptr_t func_ptr;
   *reinterpret_cast<void**>(&func_ptr) = v_func_ptr;
 
+  // Kernels that run on the work-stealing runtime take the number of threads
+  // from a limit that only applies to the calling thread, which lets threads
+  // call kernels concurrently without changing global OpenMP state
+  if (usesParallelRuntime()) {
+    const int limit = taco_parallel_get_thread_limit();
+    if (limit > 0) {
+      return func_ptr(args);
+    }
+    taco_parallel_set_thread_limit(taco_get_num_threads());
+    int ret = func_ptr(args);
+    taco_parallel_set_thread_limit(limit);
+    return ret;
+  }
+
 #if USE_OPENMP
   omp_sched_t existingSched;
   ParallelSchedule tacoSched;
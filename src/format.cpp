@@ -9,6 +9,10 @@
 #include "taco/lower/mode_format_dense.h"
 #include "taco/lower/mode_format_compressed.h"
 #include "taco/lower/mode_format_singleton.h"
+#include "taco/lower/mode_format_bitpacked.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_bitmap.h"
+#include "taco/lower/mode_format_sliced.h"
 
 #include "taco/error.h"
 #include "taco/util/strings.h"
@@ -99,6 +103,141 @@ void Format::setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTyp
   this->levelArrayTypes = levelArrayTypes;
 }
 
+void Format::setIndexTypes(Datatype posType, Datatype crdType) {
+  taco_uassert((posType.isInt() || posType.isUInt()) &&
+               (crdType.isInt() || crdType.isUInt())) <<
+      "Position and coordinate arrays must have integer types";
+  levelArrayTypes.clear();
+  for (auto& modeFormat : getModeFormats()) {
+    if (modeFormat.getName() == Dense.getName()) {
+      levelArrayTypes.push_back({Int32});
+    } else if (modeFormat.getName() == BitPacked.getName() ||
+               modeFormat.getName() == Bitmap.getName()) {
+      // Bit-packed coordinates and bitmaps are stored in 32-bit words
+      levelArrayTypes.push_back({posType, Int32});
+    } else if (modeFormat.getName() == Hashed.getName() && crdType.isUInt()) {
+      // Empty slots of hashed levels hold the coordinate -1
+      levelArrayTypes.push_back({posType, Int(crdType.getNumBits())});
+    } else {
+      levelArrayTypes.push_back({posType, crdType});
+    }
+  }
+}
+
+void Format::setBlockSizes(const std::vector<int>& blockSizes) {
+  taco_uassert(blockSizes.size() == (size_t)getOrder()) <<
+      "The number of block sizes (" << blockSizes.size() << ") must match " <<
+      "the format order (" << getOrder() << ")";
+  for (int blockSize : blockSizes) {
+    taco_uassert(blockSize > 0) << "Block sizes must be positive";
+  }
+  this->blockSizes = blockSizes;
+}
+
+const std::vector<int>& Format::getBlockSizes() const {
+  return this->blockSizes;
+}
+
+bool Format::isBlocked() const {
+  return !blockSizes.empty();
+}
+
+Format Format::getBlockLevelFormat() const {
+  taco_iassert(isBlocked());
+  const int order = getOrder();
+
+  // The components in a block are stored in dense levels below the levels of
+  // the blocks, in the same mode ordering
+  std::vector<ModeFormatPack> levelFormatPacks = getModeFormatPacks();
+  std::vector<int> levelOrdering = getModeOrdering();
+  for (int i = 0; i < order; ++i) {
+    levelFormatPacks.push_back(Dense);
+    levelOrdering.push_back(getModeOrdering()[i] + order);
+  }
+  Format levelFormat(levelFormatPacks, levelOrdering);
+
+  std::vector<std::vector<Datatype>> levelArrayTypes = getLevelArrayTypes();
+  if (levelArrayTypes.size() == (size_t)order) {
+    levelArrayTypes.resize(2 * order, {Int32});
+    levelFormat.setLevelArrayTypes(levelArrayTypes);
+  }
+  return levelFormat;
+}
+
+std::vector<int>
+Format::getBlockLevelDimensions(const std::vector<int>& dimensions) const {
+  taco_iassert(isBlocked());
+  taco_iassert(dimensions.size() == blockSizes.size());
+  std::vector<int> levelDimensions;
+  for (size_t i = 0; i < dimensions.size(); ++i) {
+    levelDimensions.push_back(dimensions[i] / blockSizes[i]);
+  }
+  levelDimensions.insert(levelDimensions.end(), blockSizes.begin(),
+                         blockSizes.end());
+  return levelDimensions;
+}
+
+void Format::setSlicing(int chunkSize, int sortWindow) {
+  taco_uassert(getOrder() == 2) << "Only matrices can be sliced";
+  taco_uassert(chunkSize > 0) << "Chunk sizes must be positive";
+  taco_uassert(sortWindow == 1 || (sortWindow > 0 &&
+                                   sortWindow % chunkSize == 0))
+      << "The sorting window must be 1 or a multiple of the chunk size";
+  this->chunkSize = chunkSize;
+  this->sortWindow = sortWindow;
+}
+
+int Format::getChunkSize() const {
+  return this->chunkSize;
+}
+
+int Format::getSortWindow() const {
+  return this->sortWindow;
+}
+
+bool Format::isSliced() const {
+  return chunkSize > 0;
+}
+
+Format Format::getSlicedLevelFormat() const {
+  taco_iassert(isSliced());
+
+  // The padded rows of a chunk are stored below the chunk, one after another
+  // for every column of the chunk
+  ModeFormat rows(std::make_shared<SlicedModeFormat>(chunkSize));
+  Format levelFormat({Dense, Compressed, rows, Singleton(ModeFormat::PADDED)});
+  levelFormat.setLevelArrayTypes({{Int32}, {Int32, Int32}, {Int32, Int32},
+                                  {Int32, Int32}});
+  return levelFormat;
+}
+
+std::vector<int>
+Format::getSlicedLevelDimensions(const std::vector<int>& dimensions) const {
+  taco_iassert(isSliced());
+  taco_iassert(dimensions.size() == 2);
+  const int numChunks = (dimensions[0] + chunkSize - 1) / chunkSize;
+  return {numChunks, dimensions[1], dimensions[0], dimensions[1]};
+}
+
+Format Format::getLevelFormat() const {
+  if (isBlocked()) {
+    return getBlockLevelFormat();
+  } else if (isSliced()) {
+    return getSlicedLevelFormat();
+  }
+  return *this;
+}
+
+std::vector<int>
+Format::getLevelDimensions(const std::vector<int>& dimensions) const {
+  if (isBlocked()) {
+    return getBlockLevelDimensions(dimensions);
+  } else if (isSliced()) {
+    return getSlicedLevelDimensions(dimensions);
+  }
+  return dimensions;
+}
+
 
 bool operator==(const Format& a, const Format& b){
   const auto aModeTypePacks = a.getModeFormatPacks();
@@ -120,6 +259,17 @@ bool operator==(const Format& a, const Format& b){
       return false;
     }
   } 
+  if (a.getBlockSizes() != b.getBlockSizes() ||
+      a.getChunkSize() != b.getChunkSize() ||
+      a.getSortWindow() != b.getSortWindow()) {
+    return false;
+  }
+  for (int i = 0; i < a.getOrder(); ++i) {
+    if (a.getCoordinateTypePos(i) != b.getCoordinateTypePos(i) ||
+        a.getCoordinateTypeIdx(i) != b.getCoordinateTypeIdx(i)) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -128,8 +278,15 @@ bool operator!=(const Format& a, const Format& b) {
 }
 
 std::ostream &operator<<(std::ostream& os, const Format& format) {
-  return os << "(" << util::join(format.getModeFormatPacks(), ",") << "; "
-            << util::join(format.getModeOrdering(), ",") << ")";
+  os << "(" << util::join(format.getModeFormatPacks(), ",") << "; "
+     << util::join(format.getModeOrdering(), ",");
+  if (format.isBlocked()) {
+    os << "; " << util::join(format.getBlockSizes(), "x");
+  }
+  if (format.isSliced()) {
+    os << "; SELL-" << format.getChunkSize() << "-" << format.getSortWindow();
+  }
+  return os << ")";
 }
 
 
@@ -384,21 +541,37 @@ ModeFormat ModeFormat::Dense(std::make_shared<DenseModeFormat>());
 ModeFormat ModeFormat::Compressed(std::make_shared<CompressedModeFormat>());
 ModeFormat ModeFormat::Sparse = ModeFormat::Compressed;
 ModeFormat ModeFormat::Singleton(std::make_shared<SingletonModeFormat>());
+ModeFormat ModeFormat::BitPacked(std::make_shared<BitPackedModeFormat>());
+ModeFormat ModeFormat::Hashed(std::make_shared<HashedModeFormat>());
+ModeFormat ModeFormat::Bitmap(std::make_shared<BitmapModeFormat>());
+ModeFormat ModeFormat::Sliced(std::make_shared<SlicedModeFormat>());
 
 ModeFormat ModeFormat::dense = ModeFormat::Dense;
 ModeFormat ModeFormat::compressed = ModeFormat::Compressed;
 ModeFormat ModeFormat::sparse = ModeFormat::Compressed;
 ModeFormat ModeFormat::singleton = ModeFormat::Singleton;
+ModeFormat ModeFormat::bitpacked = ModeFormat::BitPacked;
+ModeFormat ModeFormat::hashed = ModeFormat::Hashed;
+ModeFormat ModeFormat::bitmap = ModeFormat::Bitmap;
+ModeFormat ModeFormat::sliced = ModeFormat::Sliced;
 
 const ModeFormat Dense = ModeFormat::Dense;
 const ModeFormat Compressed = ModeFormat::Compressed;
 const ModeFormat Sparse = ModeFormat::Compressed;
 const ModeFormat Singleton = ModeFormat::Singleton;
+const ModeFormat BitPacked = ModeFormat::BitPacked;
+const ModeFormat Hashed = ModeFormat::Hashed;
+const ModeFormat Bitmap = ModeFormat::Bitmap;
+const ModeFormat Sliced = ModeFormat::Sliced;
 
 const ModeFormat dense = ModeFormat::Dense;
 const ModeFormat compressed = ModeFormat::Compressed;
 const ModeFormat sparse = ModeFormat::Compressed;
 const ModeFormat singleton = ModeFormat::Singleton;
+const ModeFormat bitpacked = ModeFormat::BitPacked;
+const ModeFormat hashed = ModeFormat::Hashed;
+const ModeFormat bitmap = ModeFormat::Bitmap;
+const ModeFormat sliced = ModeFormat::Sliced;
 
 const Format CSR({Dense, Sparse}, {0,1});
 const Format CSC({Dense, Sparse}, {1,0});
@@ -430,6 +603,26 @@ const Format COO(int order, bool isUnique, bool isOrdered, bool isAoS,
          : Format(modeTypes, modeOrdering);
 }
 
+const Format BCSR(int rowBlockSize, int columnBlockSize) {
+  Format format({Dense, Compressed}, {0,1});
+  format.setBlockSizes({rowBlockSize, columnBlockSize});
+  return format;
+}
+
+const Format BCSF(const std::vector<int>& blockSizes) {
+  taco_uassert(!blockSizes.empty());
+  std::vector<ModeFormatPack> modeTypes(blockSizes.size(), Compressed);
+  Format format(modeTypes);
+  format.setBlockSizes(blockSizes);
+  return format;
+}
+
+const Format SELL(int chunkSize, int sortWindow) {
+  Format format({Dense, Compressed}, {0,1});
+  format.setSlicing(chunkSize, sortWindow);
+  return format;
+}
+
 bool isDense(const Format& format) {
   for (ModeFormat modeFormat : format.getModeFormats()) {
     if (modeFormat != Dense) {
@@ -32,6 +32,7 @@
 #include "taco/util/collections.h"
 #include "taco/util/functions.h"
 #include "taco/util/env.h"
+#include "taco/util/hash.h"
 
 using namespace std;
 
@@ -448,6 +449,7 @@ struct Isomorphic : public IndexNotationVisitorStrict {
     auto bnode = to<ForallNode>(bStmt.ptr);
     if (!check(anode->indexVar, bnode->indexVar) ||
         !check(anode->stmt, bnode->stmt) ||
+        anode->merge_strategy != bnode->merge_strategy ||
         anode->parallel_unit != bnode->parallel_unit ||
         anode->output_race_strategy != bnode->output_race_strategy ||
         anode->unrollFactor != bnode->unrollFactor) {
@@ -622,6 +624,219 @@ bool isomorphic(IndexStmt a, IndexStmt b) {
   return Isomorphic().check(a,b);
 }
 
+struct StructuralHash : public IndexNotationVisitorStrict {
+  size_t hash = 0;
+  std::map<TensorVar,size_t> tensorVarIds;
+  std::map<IndexVar,size_t> indexVarIds;
+
+  size_t compute(IndexStmt stmt) {
+    hashStmt(stmt);
+    return hash;
+  }
+
+  void combine(size_t value) {
+    util::hashCombine(hash, value);
+  }
+
+  void combine(const std::string& value) {
+    combine(std::hash<std::string>()(value));
+  }
+
+  void hashExpr(IndexExpr expr) {
+    if (!expr.defined()) {
+      combine(0);
+      return;
+    }
+    expr.accept(this);
+  }
+
+  void hashStmt(IndexStmt stmt) {
+    if (!stmt.defined()) {
+      combine(0);
+      return;
+    }
+    stmt.accept(this);
+  }
+
+  // Tensor and index variables are numbered in order of first occurrence, so
+  // the hash only depends on how they are used and not on their identity.
+  // This mirrors how Isomorphic builds its bijection between the variables of
+  // the two statements.
+  void hashTensorVar(TensorVar var) {
+    if (!util::contains(tensorVarIds, var)) {
+      tensorVarIds.insert({var, tensorVarIds.size()});
+      combine(util::toString(var.getType()));
+      combine(util::toString(var.getFormat()));
+    }
+    combine(tensorVarIds.at(var));
+  }
+
+  void hashIndexVar(IndexVar var) {
+    if (!util::contains(indexVarIds, var)) {
+      indexVarIds.insert({var, indexVarIds.size()});
+    }
+    combine(indexVarIds.at(var));
+  }
+
+  using IndexNotationVisitorStrict::visit;
+
+  void visit(const IndexVarNode* node) {
+    // Isomorphic requires index variables used as expressions to be the same.
+    combine(std::hash<const void*>()(node));
+  }
+
+  void visit(const AccessNode* node) {
+    combine("access");
+    hashTensorVar(node->tensorVar);
+    combine(node->indexVars.size());
+    for (auto& indexVar : node->indexVars) {
+      hashIndexVar(indexVar);
+    }
+    combine(node->isAccessingStructure);
+    for (auto& window : node->windowedModes) {
+      combine(window.first);
+      combine(window.second.lo);
+      combine(window.second.hi);
+      combine(window.second.stride);
+    }
+    for (auto& indexSet : node->indexSetModes) {
+      combine(indexSet.first);
+      for (auto& coord : *indexSet.second.set) {
+        combine(coord);
+      }
+    }
+  }
+
+  void visit(const LiteralNode* node) {
+    combine("literal");
+    combine(util::toString(node->getDataType()));
+    combine(util::fnv1a(node->val, node->getDataType().getNumBytes()));
+  }
+
+  void visit(const NegNode* node) {
+    combine("neg");
+    hashExpr(node->a);
+  }
+
+  void visit(const SqrtNode* node) {
+    combine("sqrt");
+    hashExpr(node->a);
+  }
+
+  void visit(const AddNode* node) {
+    combine("add");
+    hashExpr(node->a);
+    hashExpr(node->b);
+  }
+
+  void visit(const SubNode* node) {
+    combine("sub");
+    hashExpr(node->a);
+    hashExpr(node->b);
+  }
+
+  void visit(const MulNode* node) {
+    combine("mul");
+    hashExpr(node->a);
+    hashExpr(node->b);
+  }
+
+  void visit(const DivNode* node) {
+    combine("div");
+    hashExpr(node->a);
+    hashExpr(node->b);
+  }
+
+  void visit(const CastNode* node) {
+    combine("cast");
+    combine(util::toString(node->getDataType()));
+    hashExpr(node->a);
+  }
+
+  void visit(const CallIntrinsicNode* node) {
+    combine("intrinsic");
+    combine(node->func->getName());
+    for (auto& arg : node->args) {
+      hashExpr(arg);
+    }
+  }
+
+  void visit(const CallNode* node) {
+    // Isomorphic compares the lowering functions of calls by address, so only
+    // the arguments are hashed.
+    combine("call");
+    for (auto& arg : node->args) {
+      hashExpr(arg);
+    }
+  }
+
+  void visit(const ReductionNode* node) {
+    combine("reduction");
+    hashExpr(node->op);
+    hashIndexVar(node->var);
+    hashExpr(node->a);
+  }
+
+  void visit(const AssignmentNode* node) {
+    combine("assignment");
+    hashExpr(node->lhs);
+    hashExpr(node->rhs);
+    hashExpr(node->op);
+  }
+
+  void visit(const YieldNode* node) {
+    combine("yield");
+    for (auto& indexVar : node->indexVars) {
+      hashIndexVar(indexVar);
+    }
+    hashExpr(node->expr);
+  }
+
+  void visit(const ForallNode* node) {
+    combine("forall");
+    hashIndexVar(node->indexVar);
+    combine((size_t)node->merge_strategy);
+    combine((size_t)node->parallel_unit);
+    combine((size_t)node->output_race_strategy);
+    combine(node->unrollFactor);
+    hashStmt(node->stmt);
+  }
+
+  void visit(const WhereNode* node) {
+    combine("where");
+    hashStmt(node->consumer);
+    hashStmt(node->producer);
+  }
+
+  void visit(const SequenceNode* node) {
+    combine("sequence");
+    hashStmt(node->definition);
+    hashStmt(node->mutation);
+  }
+
+  void visit(const AssembleNode* node) {
+    combine("assemble");
+    hashStmt(node->queries);
+    hashStmt(node->compute);
+  }
+
+  void visit(const MultiNode* node) {
+    combine("multi");
+    hashStmt(node->stmt1);
+    hashStmt(node->stmt2);
+  }
+
+  void visit(const SuchThatNode* node) {
+    combine("suchthat");
+    combine(node->predicate.size());
+    hashStmt(node->stmt);
+  }
+};
+
+size_t structuralHash(IndexStmt stmt) {
+  return StructuralHash().compute(stmt);
+}
+
 struct Equals : public IndexNotationVisitorStrict {
   bool eq = false;
   IndexExpr bExpr;
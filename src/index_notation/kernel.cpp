@@ -4,6 +4,8 @@
 
 #include "taco/index_notation/index_notation.h"
 #include "taco/lower/lower.h"
+#include "taco/lower/mode_format_bitpacked.h"
+#include "taco/lower/mode_format_bitmap.h"
 #include "taco/codegen/module.h"
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
@@ -63,12 +65,34 @@ void unpackResults(size_t numResults, const vector<void*> arguments,
         Array size = makeArray({*(int*)tensorData->indices[i][0]});
         modeIndices.push_back(ModeIndex({size}));
         num *= ((int*)tensorData->indices[i][0])[0];
-      } else if (modeType.getName() == Sparse.getName()) {
-        auto size = ((int*)tensorData->indices[i][0])[num];
-        Array pos = Array(type<int>(), tensorData->indices[i][0],
-                          num+1, Array::UserOwns);
-        Array idx = Array(type<int>(), tensorData->indices[i][1],
-                          size, Array::UserOwns);
+      } else if (modeType.getName() == Sparse.getName() ||
+                 modeType.getName() == Hashed.getName()) {
+        Array pos = Array(format.getCoordinateTypePos(i),
+                          tensorData->indices[i][0], num+1, Array::UserOwns);
+        auto size = pos.get(num).getAsIndex();
+        Array idx = Array(format.getCoordinateTypeIdx(i),
+                          tensorData->indices[i][1], size, Array::UserOwns);
+        modeIndices.push_back(ModeIndex({pos, idx}));
+        num = size;
+      } else if (modeType.getName() == BitPacked.getName()) {
+        Array pos = Array(format.getCoordinateTypePos(i),
+                          tensorData->indices[i][0], num+1, Array::UserOwns);
+        auto size = pos.get(num).getAsIndex();
+        const int32_t* packed = (const int32_t*)tensorData->indices[i][1];
+        Array idx = Array(Int32, tensorData->indices[i][1],
+                          BitPackedModeFormat::getPackedSize(packed, size),
+                          Array::UserOwns);
+        modeIndices.push_back(ModeIndex({pos, idx}));
+        num = size;
+      } else if (modeType.getName() == Bitmap.getName()) {
+        Array pos = Array(format.getCoordinateTypePos(i),
+                          tensorData->indices[i][0], num+1, Array::UserOwns);
+        auto size = pos.get(num).getAsIndex();
+        const int dimension =
+            storage.getDimensions()[format.getModeOrdering()[i]];
+        Array idx = Array(Int32, tensorData->indices[i][1],
+                          2 * num * BitmapModeFormat::getNumWords(dimension),
+                          Array::UserOwns);
         modeIndices.push_back(ModeIndex({pos, idx}));
         num = size;
       } else {
@@ -902,6 +902,55 @@ OutputRaceStrategy Parallelize::getOutputRaceStrategy() const {
   return content->output_race_strategy;
 }
 
+/// Returns why a loop over the rows `i` of a sparse matrix cannot be split
+/// across threads by its rows and nonzeros together, or an empty string if it
+/// can. The loop must iterate over a dense row dimension, with a nested loop
+/// over the nonzeros of each row that sums into an element of a dense output
+/// per row (e.g. y(i) += A(i,j) * x(j)).
+static string checkMergePath(Forall foralli, const Iterator& rowIterator,
+                             const Iterators& iterators,
+                             const ProvenanceGraph& provGraph,
+                             const set<IndexVar>& definedIndexVars) {
+  const string prefix = "Precondition failed: Loops split by nonzeros ";
+  IndexVar i = foralli.getIndexVar();
+  if (!provGraph.isUnderived(i) || !rowIterator.isDimensionIterator()) {
+    return prefix + "must iterate over a dense dimension";
+  }
+  if (!isa<Forall>(foralli.getStmt()) ||
+      to<Forall>(foralli.getStmt()).getParallelUnit() != ParallelUnit::NotParallel ||
+      !isa<Assignment>(to<Forall>(foralli.getStmt()).getStmt())) {
+    return prefix + "must directly contain a serial loop over the nonzeros of "
+                    "a row, whose body is an assignment";
+  }
+  Forall forallj = to<Forall>(foralli.getStmt());
+  MergeLattice lattice = MergeLattice::make(forallj, iterators, provGraph,
+                                            definedIndexVars);
+  if (!provGraph.isUnderived(forallj.getIndexVar()) ||
+      lattice.iterators().size() != 1) {
+    return prefix + "must contain a loop over the nonzeros of one tensor";
+  }
+  Iterator nonzeros = lattice.iterators()[0];
+  if (nonzeros.isDimensionIterator() ||
+      nonzeros.getMode().getModeFormat().getName() !=
+          ModeFormat::Compressed.getName() ||
+      !nonzeros.isUnique() || nonzeros.isWindowed() ||
+      nonzeros.getParent().getIndexVar() != i ||
+      !nonzeros.getParent().isFull() || !nonzeros.getParent().hasLocate() ||
+      !nonzeros.getParent().getParent().isRoot()) {
+    return prefix + "must iterate over a matrix with a dense row dimension "
+                    "and a compressed column dimension without duplicates";
+  }
+  Assignment assignment = to<Assignment>(forallj.getStmt());
+  const TensorVar result = assignment.getLhs().getTensorVar();
+  if (!isa<taco::Add>(assignment.getOperator()) ||
+      assignment.getLhs().getIndexVars() != vector<IndexVar>({i}) ||
+      result.getFormat().getModeFormats()[0].getName() !=
+          ModeFormat::Dense.getName()) {
+    return prefix + "must sum into a dense vector indexed by the rows";
+  }
+  return "";
+}
+
 IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
   INIT_REASON(reason);
 
@@ -999,6 +1048,13 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
               }
             }
           } else {
+            // Positions of modes that store inserted coordinates (e.g. the
+            // slots of a hashed mode) depend on earlier inserts
+            if (iterator.hasInsert() && iterator.hasInsertCoord()) {
+              reason = "Precondition failed: The output tensor does not "
+                       "support parallelized inserts";
+              return;
+            }
             while (true) {
               if (!iterator.hasInsert()) {
                 reason = "Precondition failed: The output tensor must support " 
@@ -1013,6 +1069,20 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           }
         }
 
+        // Precondition 4: Loops split by nonzeros must iterate over the rows
+        // of a sparse matrix and sum every row into an output element
+        if (parallelize.getParallelUnit() == ParallelUnit::CPUMergePath) {
+          reason = checkMergePath(foralli, lattice.iterators()[0], iterators,
+                                  provGraph, definedIndexVars);
+          if (reason.empty()) {
+            stmt = forall(i, foralli.getStmt(), foralli.getMergeStrategy(),
+                          parallelize.getParallelUnit(),
+                          parallelize.getOutputRaceStrategy(),
+                          foralli.getUnrollFactor());
+          }
+          return;
+        }
+
         if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Temporary &&
             util::contains(reductionIndexVars, underivedForall.getIndexVar())) {
           // Need to precompute reduction
@@ -1869,6 +1939,12 @@ IndexStmt scalarPromote(IndexStmt stmt, ProvenanceGraph provGraph,
         return;
       }
 
+      // Loops split by nonzeros sum every row into the output directly, since
+      // rows split across threads are summed afterwards
+      if (foralli.getParallelUnit() == ParallelUnit::CPUMergePath) {
+        return;
+      }
+
       std::vector<Access> resultAccesses;
       std::tie(resultAccesses, std::ignore) = getResultAccesses(foralli);
       for (const auto& resultAccess : resultAccesses) {
@@ -413,6 +413,26 @@ Expr BitOr::make(Expr a, Expr b) {
   return bitOr;
 }
 
+Expr Shl::make(Expr a, Expr b) {
+  taco_iassert(!a.type().isFloat() && !b.type().isFloat()) <<
+      "Can't shift floating point values.";
+  Shl *shl = new Shl;
+  shl->type = a.type();
+  shl->a = a;
+  shl->b = b;
+  return shl;
+}
+
+Expr Shr::make(Expr a, Expr b) {
+  taco_iassert(!a.type().isFloat() && !b.type().isFloat()) <<
+      "Can't shift floating point values.";
+  Shr *shr = new Shr;
+  shr->type = a.type();
+  shr->a = a;
+  shr->b = b;
+  return shr;
+}
+
 // Boolean binary ops
 Expr Eq::make(Expr a, Expr b) {
   Eq *eq = new Eq;
@@ -844,6 +864,19 @@ Expr GetProperty::make(Expr tensor, TensorProperty property, int mode,
   return gp;
 }
 
+Expr GetProperty::make(Expr tensor, TensorProperty property, int mode,
+                       int index, std::string name, Datatype type) {
+  taco_iassert(property == TensorProperty::Indices);
+  GetProperty* gp = new GetProperty;
+  gp->tensor = tensor;
+  gp->property = property;
+  gp->mode = mode;
+  gp->name = name;
+  gp->index = index;
+  gp->type = type;
+  return gp;
+}
+
 // Sort
 Stmt Sort::make(std::vector<Expr> args) {
   Sort* sort = new Sort;
@@ -926,6 +959,10 @@ template<> void ExprNode<BitAnd>::accept(IRVisitorStrict *v)
     const { v->visit((const BitAnd*)this); }
 template<> void ExprNode<BitOr>::accept(IRVisitorStrict *v)
     const { v->visit((const BitOr*)this); }
+template<> void ExprNode<Shl>::accept(IRVisitorStrict *v)
+    const { v->visit((const Shl*)this); }
+template<> void ExprNode<Shr>::accept(IRVisitorStrict *v)
+    const { v->visit((const Shr*)this); }
 template<> void ExprNode<Eq>::accept(IRVisitorStrict *v)
     const { v->visit((const Eq*)this); }
 template<> void ExprNode<Neq>::accept(IRVisitorStrict *v)
@@ -142,6 +142,14 @@ void IRRewriter::visit(const BitOr* op) {
   expr = visitBinaryOp(op, this);
 }
 
+void IRRewriter::visit(const Shl* op) {
+  expr = visitBinaryOp(op, this);
+}
+
+void IRRewriter::visit(const Shr* op) {
+  expr = visitBinaryOp(op, this);
+}
+
 void IRRewriter::visit(const Eq* op) {
   expr = visitBinaryOp(op, this);
 }
@@ -489,7 +497,11 @@ void IRRewriter::visit(const GetProperty* op) {
     expr = op;
   }
   else {
-    expr = GetProperty::make(tensor, op->property, op->mode, op->index, op->name);
+    expr = (op->property == TensorProperty::Indices)
+           ? GetProperty::make(tensor, op->property, op->mode, op->index,
+                               op->name, op->type)
+           : GetProperty::make(tensor, op->property, op->mode, op->index,
+                               op->name);
   }
 }
 
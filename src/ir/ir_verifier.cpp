@@ -103,6 +103,16 @@ protected:
     op->b.accept(this);
   }
 
+  void visit(const Shl *op) {
+    op->a.accept(this);
+    op->b.accept(this);
+  }
+
+  void visit(const Shr *op) {
+    op->a.accept(this);
+    op->b.accept(this);
+  }
+
   void visit(const Eq *op) {
     verify_operand_types_consistent(op);
     op->a.accept(this);
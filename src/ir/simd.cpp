@@ -0,0 +1,348 @@
+#include "taco/ir/simd.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "taco/ir/ir_rewriter.h"
+#include "taco/ir/ir_visitor.h"
+#include "taco/util/collections.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+
+namespace taco {
+namespace ir {
+
+/// Functions without side effects that loops may call in SIMD lanes
+static const set<string> simdFunctions = {
+  "sqrt", "pow", "exp", "log", "fabs", "abs", "sin", "cos", "tan", "fmin",
+  "fmax", "TACO_MIN", "TACO_MAX", "taco_ctz", "taco_popcount"
+};
+
+/// Collects the variables and array accesses of the body of a loop.
+struct LoopBody : public IRVisitor {
+  Expr loopVar;
+
+  /// Whether the body has statements that cannot be executed in SIMD lanes
+  bool hasUnsupported = false;
+
+  set<Expr> locals;
+  map<Expr,Expr> initializers;
+  set<Expr> assignedVars;
+  vector<const Assign*> assigns;
+  map<Expr,int> uses;
+
+  /// The indices that every array is stored to and loaded from, where arrays
+  /// are identified by name
+  map<string,vector<Expr>> stores;
+  map<string,vector<Expr>> loads;
+  vector<const Store*> storeNodes;
+
+  LoopBody(const For* loop) : loopVar(loop->var) {
+    loop->contents.accept(this);
+  }
+
+  bool isLocal(Expr var) const {
+    return var == loopVar || util::contains(locals, var);
+  }
+
+  /// Whether `expr` has the same value in every iteration of the loop
+  bool isInvariant(Expr expr) const {
+    struct FindVariant : public IRVisitor {
+      const LoopBody* body;
+      bool isVariant = false;
+      using IRVisitor::visit;
+      void visit(const Var* op) {
+        isVariant |= body->isLocal(op);
+      }
+      void visit(const Load* op) {
+        isVariant |= util::contains(body->stores, util::toString(op->arr));
+        IRVisitor::visit(op);
+      }
+    } finder;
+    finder.body = this;
+    expr.accept(&finder);
+    return !finder.isVariant;
+  }
+
+  /// Whether `expr` has a different value in every iteration of the loop
+  bool isDistinct(Expr expr) const {
+    if (expr.as<Var>()) {
+      if (expr == loopVar) {
+        return true;
+      }
+      return util::contains(initializers, expr) &&
+             !util::contains(assignedVars, expr) &&
+             isDistinct(initializers.at(expr));
+    }
+    if (const Add* add = expr.as<Add>()) {
+      return (isDistinct(add->a) && isInvariant(add->b)) ||
+             (isInvariant(add->a) && isDistinct(add->b));
+    }
+    if (const Sub* sub = expr.as<Sub>()) {
+      return isDistinct(sub->a) && isInvariant(sub->b);
+    }
+    if (const Mul* mul = expr.as<Mul>()) {
+      return (isDistinct(mul->a) && isInvariant(mul->b)) ||
+             (isInvariant(mul->a) && isDistinct(mul->b));
+    }
+    return false;
+  }
+
+  /// Returns the operand that `assign` adds to its variable, if `assign` is
+  /// of the form `v = v + e`
+  static Expr getAddend(const Assign* assign) {
+    const Add* add = assign->rhs.as<Add>();
+    if (add == nullptr) {
+      return Expr();
+    }
+    if (add->a == assign->lhs) {
+      return add->b;
+    }
+    return (add->b == assign->lhs) ? add->a : Expr();
+  }
+
+  using IRVisitor::visit;
+
+  void visit(const Var* op) {
+    uses[op]++;
+  }
+
+  void visit(const VarDecl* op) {
+    locals.insert(op->var);
+    initializers.insert({op->var, op->rhs});
+    IRVisitor::visit(op);
+  }
+
+  void visit(const For* op) {
+    locals.insert(op->var);
+    assignedVars.insert(op->var);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Assign* op) {
+    assignedVars.insert(op->lhs);
+    assigns.push_back(op);
+    hasUnsupported |= op->use_atomics;
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Store* op) {
+    stores[util::toString(op->arr)].push_back(op->loc);
+    storeNodes.push_back(op);
+    hasUnsupported |= op->use_atomics;
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Load* op) {
+    loads[util::toString(op->arr)].push_back(op->loc);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Call* op) {
+    hasUnsupported |= !util::contains(simdFunctions, op->func);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const While*) {
+    hasUnsupported = true;
+  }
+
+  void visit(const Break*) {
+    hasUnsupported = true;
+  }
+
+  void visit(const Continue*) {
+    hasUnsupported = true;
+  }
+
+  void visit(const Allocate*) {
+    hasUnsupported = true;
+  }
+
+  void visit(const Free*) {
+    hasUnsupported = true;
+  }
+
+  void visit(const Sort*) {
+    hasUnsupported = true;
+  }
+
+  void visit(const Print*) {
+    hasUnsupported = true;
+  }
+};
+
+static bool isReducible(Datatype type) {
+  return !type.isComplex() && !type.isBool();
+}
+
+SimdLoop analyzeSimdLoop(const For* loop) {
+  SimdLoop simdLoop;
+  LoopBody body(loop);
+  if (body.hasUnsupported) {
+    return simdLoop;
+  }
+
+  // Variables declared outside the loop must only be summed into
+  map<Expr,int> numAdds;
+  for (const Assign* assign : body.assigns) {
+    if (body.isLocal(assign->lhs)) {
+      if (assign->lhs == body.loopVar) {
+        return simdLoop;
+      }
+      continue;
+    }
+    Expr addend = LoopBody::getAddend(assign);
+    const Var* var = assign->lhs.as<Var>();
+    if (!addend.defined() || var == nullptr || var->is_ptr ||
+        !isReducible(var->type)) {
+      return simdLoop;
+    }
+    if (!util::contains(numAdds, assign->lhs)) {
+      simdLoop.reductions.push_back(assign->lhs);
+    }
+    numAdds[assign->lhs]++;
+  }
+  for (const auto& reduction : numAdds) {
+    if (body.uses[reduction.first] != 2 * reduction.second) {
+      simdLoop.reductions.clear();
+      return simdLoop;
+    }
+  }
+
+  // Every stored array must be stored to and loaded from at one index, which
+  // differs in every iteration
+  for (const auto& stores : body.stores) {
+    const string index = util::toString(stores.second[0]);
+    vector<Expr> accesses = stores.second;
+    if (util::contains(body.loads, stores.first)) {
+      util::append(accesses, body.loads.at(stores.first));
+    }
+    for (const Expr& access : accesses) {
+      if (util::toString(access) != index) {
+        simdLoop.reductions.clear();
+        return simdLoop;
+      }
+    }
+    if (!body.isDistinct(stores.second[0])) {
+      simdLoop.reductions.clear();
+      return simdLoop;
+    }
+  }
+
+  simdLoop.isIndependent = true;
+  return simdLoop;
+}
+
+/// Replaces the stores to an array with additions to a scalar.
+struct StoreToScalar : public IRRewriter {
+  string array;
+  Expr scalar;
+
+  using IRRewriter::visit;
+
+  void visit(const Store* op) {
+    if (util::toString(op->arr) != array) {
+      stmt = op;
+      return;
+    }
+    const Add* add = op->data.as<Add>();
+    const bool isFirst = isa<Load>(add->a) &&
+                         util::toString(to<Load>(add->a)->arr) == array;
+    stmt = Assign::make(scalar, Add::make(scalar, isFirst ? add->b : add->a));
+  }
+};
+
+struct SimdReductionPromoter : public IRRewriter {
+  using IRRewriter::visit;
+
+  /// Returns whether `store` adds to the element it stores to
+  static bool isAccumulation(const Store* store) {
+    const string array = util::toString(store->arr);
+    const string index = util::toString(store->loc);
+    const Add* add = store->data.as<Add>();
+    if (add == nullptr) {
+      return false;
+    }
+    for (const Expr& operand : {add->a, add->b}) {
+      const Load* load = operand.as<Load>();
+      if (load != nullptr && util::toString(load->arr) == array &&
+          util::toString(load->loc) == index) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void visit(const For* op) {
+    IRRewriter::visit(op);
+    if (op->kind != LoopKind::Vectorized) {
+      return;
+    }
+
+    const For* loop = stmt.as<For>();
+    LoopBody body(loop);
+    if (body.hasUnsupported) {
+      return;
+    }
+
+    // Arrays whose loop-invariant element is accumulated into, and that the
+    // loop does not access otherwise
+    vector<Stmt> prologue;
+    vector<Stmt> epilogue;
+    Stmt contents = loop->contents;
+    set<string> promoted;
+    for (const Store* store : body.storeNodes) {
+      const string array = util::toString(store->arr);
+      if (util::contains(promoted, array)) {
+        continue;
+      }
+      const vector<Expr>& stores = body.stores.at(array);
+      const vector<Expr>& loads = body.loads.count(array) ?
+                                  body.loads.at(array) : vector<Expr>();
+      bool isPromotable = body.isInvariant(store->loc) &&
+                          loads.size() == stores.size() &&
+                          isReducible(store->data.type());
+      for (const Store* other : body.storeNodes) {
+        if (util::toString(other->arr) == array) {
+          isPromotable &= isAccumulation(other) &&
+                          util::toString(other->loc) ==
+                          util::toString(store->loc);
+        }
+      }
+      if (!isPromotable) {
+        continue;
+      }
+
+      Expr scalar = Var::make("t" + array, store->data.type());
+      StoreToScalar rewriter;
+      rewriter.array = array;
+      rewriter.scalar = scalar;
+      contents = rewriter.rewrite(contents);
+      prologue.push_back(VarDecl::make(scalar,
+                                       Literal::zero(store->data.type())));
+      epilogue.push_back(Store::make(store->arr, store->loc,
+          Add::make(Load::make(store->arr, store->loc), scalar)));
+      promoted.insert(array);
+    }
+    if (promoted.empty()) {
+      return;
+    }
+
+    vector<Stmt> stmts = prologue;
+    stmts.push_back(For::make(loop->var, loop->start, loop->end,
+                              loop->increment, contents, loop->kind,
+                              loop->parallel_unit, loop->unrollFactor,
+                              loop->vec_width));
+    util::append(stmts, epilogue);
+    stmt = Block::make(stmts);
+  }
+};
+
+Stmt promoteSimdReductions(const Stmt& stmt) {
+  return SimdReductionPromoter().rewrite(stmt);
+}
+
+}}
@@ -2,10 +2,22 @@
 
 namespace taco {
 
-const char *ParallelUnit_NAMES[] = {"NotParallel", "DefaultUnit", "GPUBlock", "GPUWarp", "GPUThread", "CPUThread", "CPUVector", "CPUThreadGroupReduction", "GPUBlockReduction", "GPUWarpReduction"};
+const char *ParallelUnit_NAMES[] = {"NotParallel", "DefaultUnit", "GPUBlock", "GPUWarp", "GPUThread", "CPUThread", "CPUVector", "CPUThreadGroupReduction", "GPUBlockReduction", "GPUWarpReduction", "CPUMergePath"};
 const char *OutputRaceStrategy_NAMES[] = {"IgnoreRaces", "NoRaces", "Atomics", "Temporary", "ParallelReduction"};
 const char *BoundType_NAMES[] = {"MinExact", "MinConstraint", "MaxExact", "MaxConstraint"};
 const char *AssembleStrategy_NAMES[] = {"Append", "Insert"};
-const char *MergeStrategy_NAMES[] = {"TwoFinger", "Gallop"};
+const char *MergeStrategy_NAMES[] = {"TwoFinger", "Gallop", "SIMDBlock", "Adaptive"};
+
+static int taco_adaptive_merge_threshold = 8;
+
+void taco_set_adaptive_merge_threshold(int threshold) {
+  if (threshold > 0) {
+    taco_adaptive_merge_threshold = threshold;
+  }
+}
+
+int taco_get_adaptive_merge_threshold() {
+  return taco_adaptive_merge_threshold;
+}
 
 }
@@ -87,12 +87,27 @@ Iterator::Iterator(IndexVar indexVar, Expr tensor, Mode mode, Iterator parent,
   if (useNameForPos) {
     posNamePrefix = name;
   }
-  content->posVar   = Var::make(name,            indexVar.getDataType());
-  content->endVar   = Var::make("p" + modeName + "_end",   indexVar.getDataType());
-  content->beginVar = Var::make("p" + modeName + "_begin", indexVar.getDataType());
+  // Positions are at least as wide as the elements of the position array
+  // that bounds them and as the positions of the parent level, so that
+  // iterating over levels with 64-bit positions does not overflow
+  Datatype posType = indexVar.getDataType();
+  if (parent.defined() && !parent.isRoot()) {
+    posType = max_type(posType, parent.getPosVar().type());
+  }
+  if (mode.getModePack().getNumArrays() > 0) {
+    Expr posArray = mode.getModePack().getArray(0);
+    if (isa<GetProperty>(posArray) &&
+        posArray.as<GetProperty>()->property == TensorProperty::Indices) {
+      posType = max_type(posType, posArray.type());
+    }
+  }
+
+  content->posVar   = Var::make(name,            posType);
+  content->endVar   = Var::make("p" + modeName + "_end",   posType);
+  content->beginVar = Var::make("p" + modeName + "_begin", posType);
 
   content->coordVar = Var::make(name, indexVar.getDataType());
-  content->segendVar = Var::make(modeName + "_segend", indexVar.getDataType());
+  content->segendVar = Var::make(modeName + "_segend", posType);
   content->validVar = Var::make("v" + modeName, Bool);
 }
 
@@ -589,7 +604,9 @@ void Iterators::createAccessIterators(Access access, Format format, Expr tensorI
     int modeNumber = format.getModeOrdering()[level-1];
     ModePack modePack(modeTypePack.getModeFormats().size(),
                       modeTypePack.getModeFormats()[0], tensorIR,
-                      modeNumber, level);
+                      modeNumber, level,
+                      {format.getCoordinateTypePos(level-1),
+                       format.getCoordinateTypeIdx(level-1)});
 
     int pos = 0;
     for (auto& modeType : modeTypePack.getModeFormats()) {
@@ -626,7 +643,9 @@ void Iterators::createAccessIterators(Access access, Format format, Expr tensorI
         auto tvFormat = tv.getFormat();
         auto tvShape = tv.getType().getShape();
         auto accessIvar = access.getIndexVars()[modeNumber];
-        ModePack tvModePack(1, tvFormat.getModeFormats()[0], tvVar, 0, 1);
+        ModePack tvModePack(1, tvFormat.getModeFormats()[0], tvVar, 0, 1,
+                            {tvFormat.getCoordinateTypePos(0),
+                             tvFormat.getCoordinateTypeIdx(0)});
         Mode tvMode(tvVar, tvShape.getDimension(0), 1, tvFormat.getModeFormats()[0], tvModePack, 0, ModeFormat());
         // Finally, construct the iterator and register it as an indexSetIterator.
         auto iter = Iterator(accessIvar, tvVar, tvMode, {tvVar}, accessIvar.getName() + tv.getName() + "_filter");
@@ -10,6 +10,7 @@
 #include "taco/index_notation/index_notation_nodes.h"
 
 #include "taco/ir/ir.h"
+#include "taco/ir/simd.h"
 #include "taco/ir/simplify.h"
 #include "taco/ir/ir_generators.h"
 #include "taco/ir/ir_printer.h"
@@ -53,6 +54,10 @@ ir::Stmt lower(IndexStmt stmt, std::string name,
   
   ir::Stmt lowered = lowerer.getLowererImpl()->lower(stmt, name, assemble, compute, pack, unpack);
 
+  // Accumulate into scalars in vectorized loops, so that they can be
+  // vectorized as reductions
+  lowered = ir::promoteSimdReductions(lowered);
+
   // TODO: re-enable this
   // std::string messages;
   // verify(lowered, &messages);
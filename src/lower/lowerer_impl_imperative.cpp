@@ -10,10 +10,12 @@
 #include "taco/index_notation/provenance_graph.h"
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_generators.h"
+#include "taco/ir/ir_rewriter.h"
 #include "taco/ir/ir_visitor.h"
 #include "taco/ir/simplify.h"
 #include "taco/lower/iterator.h"
 #include "taco/lower/merge_lattice.h"
+#include "taco/lower/mode_format_bitmap.h"
 #include "mode_access.h"
 #include "taco/util/collections.h"
 #include "taco/util/env.h"
@@ -209,18 +211,20 @@ static std::set<Expr> hasSparseInserts(IndexStmt stmt, Iterators iterators,
       definedIndexVars.insert(op->indexVar);
       const auto lattice = MergeLattice::make(Forall(op), iterators, 
                                               provGraph, definedIndexVars);
-      if (any(lattice.iterators(), 
+      const bool hasSparseIteration =
+          any(lattice.iterators(), 
               [](Iterator it){ return !it.isFull() && 
                                       !it.isDimensionIterator(); }) ||
           any(lattice.points()[0].locators(), 
-              [](Iterator it) { return !it.isFull(); })) {
-        for (const auto& result : lattice.results()) {
-          // FIXME: Also zero init if result is assembled by ungrouped insertion
-          // and is not compact or not unpadded (i.e., if result allocates
-          // additional space for components that aren't explicitly inserted)
-          if (result.hasInsert()) {
-            ret.insert(result.getTensor());
-          }
+              [](Iterator it) { return !it.isFull(); });
+      for (const auto& result : lattice.results()) {
+        // FIXME: Also zero init if result is assembled by ungrouped insertion
+        // and is not compact or not unpadded (i.e., if result allocates
+        // additional space for components that aren't explicitly inserted)
+        // Insert modes that are not full (e.g. hashed modes) also have
+        // positions that are never inserted into.
+        if (result.hasInsert() && (hasSparseIteration || !result.isFull())) {
+          ret.insert(result.getTensor());
         }
       }
       ctx->match(op->stmt);
@@ -644,6 +648,33 @@ LowererImplImperative::splitAppenderAndInserters(const vector<Iterator>& results
 }
 
 
+/// Returns true if the iterator iterates over a bitmap level.
+static bool isBitmap(const Iterator& iterator) {
+  return !iterator.isDimensionIterator() && iterator.getMode().defined() &&
+         iterator.getMode().getModeFormat().getName() ==
+             ModeFormat::Bitmap.getName();
+}
+
+/// Returns true if a sequential loop over the bitmap iterator locates into
+/// other bitmap iterators of the same index variable, so that the bitmaps
+/// can be intersected a word at a time.
+static bool canIntersectBitmaps(Forall forall, Iterator iterator,
+                                const vector<Iterator>& locators,
+                                const ProvenanceGraph& provGraph) {
+  if (!isBitmap(iterator) ||
+      forall.getParallelUnit() != ParallelUnit::NotParallel ||
+      !provGraph.isUnderived(iterator.getIndexVar()) ||
+      !(iterator.getParent().isRoot() || iterator.getParent().isUnique()) ||
+      iterator.isWindowed() || iterator.hasIndexSet()) {
+    return false;
+  }
+  return any(locators, [&](Iterator locator) {
+    return isBitmap(locator) &&
+           locator.getIndexVar() == iterator.getIndexVar() &&
+           !locator.isWindowed() && !locator.hasIndexSet();
+  });
+}
+
 Stmt LowererImplImperative::lowerForall(Forall forall)
 {
   bool hasExactBound = provGraph.hasExactBound(forall.getIndexVar());
@@ -851,10 +882,27 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
       loops = lowerForallDenseAcceleration(forall, locators, inserters, appenders, caseLattice, reducedAccesses, recoveryStmt);
     }
     // Emit dimension coordinate iteration loop
+    else if (iterator.isDimensionIterator() &&
+             forall.getParallelUnit() == ParallelUnit::CPUMergePath &&
+             generateComputeCode()) {
+      loops = lowerForallMergePath(forall, point.locators(), inserters,
+                                   appenders, caseLattice, reducedAccesses,
+                                   recoveryStmt);
+    }
     else if (iterator.isDimensionIterator()) {
       loops = lowerForallDimension(forall, point.locators(), inserters, appenders, caseLattice,
                                    reducedAccesses, recoveryStmt);
     }
+    // Emit a loop over the words of bitmaps that are intersected
+    else if (canIntersectBitmaps(forall, iterator, locators, provGraph)) {
+      loops = lowerForallBitmapIntersection(forall, iterator, locators,
+                                            inserters, appenders, caseLattice,
+                                            reducedAccesses, recoveryStmt);
+    }
+    else if (any(locators, isBitmap)) {
+      taco_uerror << "Bitmap levels can only be located into by sequential "
+                     "loops over other bitmap levels";
+    }
     // Emit position iteration loop
     else if (iterator.hasPosIter()) {
       loops = lowerForallPosition(forall, iterator, locators, inserters, appenders, caseLattice,
@@ -1231,6 +1279,196 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
                        posAppend);
 }
 
+/// Restricts the loop over the positions of a row to the positions from
+/// `start` to `end`, and optionally sums the values that it adds to an element
+/// of the result into a scalar instead.
+struct MergePathRow : public IRRewriter {
+  Expr posVar;
+  Expr start;
+  Expr end;
+  Expr values;
+  Expr carry;
+
+  using IRRewriter::visit;
+
+  void visit(const ir::For* op) {
+    IRRewriter::visit(op);
+    if (op->var != posVar) {
+      return;
+    }
+    const ir::For* loop = stmt.as<ir::For>();
+    stmt = ir::For::make(loop->var, ir::Max::make(loop->start, start),
+                     end.defined() ? ir::Min::make(loop->end, end) : loop->end,
+                     loop->increment, loop->contents, loop->kind,
+                     loop->parallel_unit, loop->unrollFactor, loop->vec_width);
+  }
+
+  void visit(const ir::Store* op) {
+    if (!carry.defined() || util::toString(op->arr) != util::toString(values)) {
+      IRRewriter::visit(op);
+      return;
+    }
+    const ir::Add* add = op->data.as<ir::Add>();
+    taco_iassert(add != nullptr);
+    const bool isFirst = isa<ir::Load>(add->a) &&
+        util::toString(to<ir::Load>(add->a)->arr) == util::toString(values);
+    stmt = compoundAssign(carry, isFirst ? add->b : add->a);
+  }
+};
+
+/// Collects the declarations of a row outside its loop over positions, and
+/// the element of the result that the row adds to.
+struct MergePathRowLocation : public IRVisitor {
+  Expr values;
+  vector<Stmt> decls;
+  Expr location;
+  int loopDepth = 0;
+
+  using IRVisitor::visit;
+
+  void visit(const ir::VarDecl* op) {
+    if (loopDepth == 0) {
+      decls.push_back(op);
+    }
+  }
+
+  void visit(const ir::For* op) {
+    loopDepth++;
+    op->contents.accept(this);
+    loopDepth--;
+  }
+
+  void visit(const ir::Store* op) {
+    if (util::toString(op->arr) == util::toString(values) &&
+        !location.defined()) {
+      location = op->loc;
+    }
+  }
+};
+
+Stmt LowererImplImperative::lowerForallMergePath(Forall forall,
+                                                 vector<Iterator> locators,
+                                                 vector<Iterator> inserters,
+                                                 vector<Iterator> appenders,
+                                                 MergeLattice caseLattice,
+                                                 set<Access> reducedAccesses,
+                                                 ir::Stmt recoveryStmt)
+{
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+  Forall rowForall = to<Forall>(forall.getStmt());
+  Assignment assignment = to<Assignment>(rowForall.getStmt());
+  Expr values = getValuesArray(assignment.getLhs().getTensorVar());
+
+  Stmt row = lowerForallBody(coordinate, forall.getStmt(), locators, inserters,
+                             appenders, caseLattice, reducedAccesses,
+                             forall.getMergeStrategy());
+  row = ir::Block::make(recoveryStmt, row);
+
+  // The merge path merges the ends of the rows with the nonzeros, and every
+  // thread iterates over an equal share of it
+  MergeLattice rowLattice = MergeLattice::make(rowForall, iterators, provGraph,
+                                               definedIndexVars);
+  Iterator nonzeros = rowLattice.iterators()[0];
+  Expr pos = nonzeros.getMode().getModePack().getArray(0);
+  Expr posVar = nonzeros.getPosVar();
+
+  vector<Expr> bounds = provGraph.deriveIterBounds(forall.getIndexVar(),
+                                                   definedIndexVarsOrdered,
+                                                   underivedBounds,
+                                                   indexVarToExprMap,
+                                                   iterators);
+  Expr numRows = bounds[1];
+  ModeFunction nnzBounds = nonzeros.posBounds(numRows);
+
+  const string name = forall.getIndexVar().getName();
+  Expr numThreads = ir::Var::make(name + "NumThreads", Int32);
+  Expr numNonzeros = ir::Var::make(name + "NumNonzeros", posVar.type());
+  Expr numItems = ir::Var::make(name + "ItemsPerThread", posVar.type());
+  Expr carryRows = ir::Var::make(name + "CarryRows", coordinate.type(), true);
+  Expr carryValues = ir::Var::make(name + "CarryValues", values.type(), true);
+
+  vector<Stmt> preamble;
+  preamble.push_back(ir::VarDecl::make(numThreads,
+                                   ir::Call::make("omp_get_max_threads", {},
+                                              Int32)));
+  preamble.push_back(nnzBounds.compute());
+  preamble.push_back(ir::VarDecl::make(numNonzeros, nnzBounds[0]));
+  preamble.push_back(ir::VarDecl::make(numItems,
+      ir::Div::make(ir::Add::make(ir::Add::make(numRows, numNonzeros),
+                          ir::Sub::make(numThreads, 1)), numThreads)));
+  preamble.push_back(ir::VarDecl::make(carryRows, 0));
+  preamble.push_back(ir::Allocate::make(carryRows, numThreads));
+  preamble.push_back(ir::VarDecl::make(carryValues, 0));
+  preamble.push_back(ir::Allocate::make(carryValues, numThreads));
+
+  // Every thread finds where its share of the merge path starts and ends, sums
+  // the rows that end in it and sums the nonzeros of the row that it ends in
+  // into a carry
+  Expr thread = ir::Var::make(name + "Thread", Int32);
+  Expr diagonal = ir::Var::make(name + "Diagonal", posVar.type());
+  Expr diagonalEnd = ir::Var::make(name + "DiagonalEnd", posVar.type());
+  Expr rowStart = ir::Var::make(name + "RowStart", coordinate.type());
+  Expr rowEnd = ir::Var::make(name + "RowEnd", coordinate.type());
+  Expr posStart = ir::Var::make(name + "PosStart", posVar.type());
+  Expr posEnd = ir::Var::make(name + "PosEnd", posVar.type());
+  Expr carry = ir::Var::make(name + "Carry", values.type());
+  Expr total = ir::Add::make(numRows, numNonzeros);
+
+  Expr rowSum = ir::Var::make(name + "RowSum", values.type());
+
+  MergePathRowLocation location;
+  location.values = values;
+  row.accept(&location);
+  taco_iassert(location.location.defined());
+
+  MergePathRow fullRow;
+  fullRow.posVar = posVar;
+  fullRow.start = posStart;
+  fullRow.values = values;
+  fullRow.carry = rowSum;
+  MergePathRow partialRow = fullRow;
+  partialRow.end = posEnd;
+  partialRow.carry = carry;
+
+  vector<Stmt> threadBody;
+  threadBody.push_back(ir::VarDecl::make(diagonal,
+      ir::Min::make(ir::Mul::make(thread, numItems), total)));
+  threadBody.push_back(ir::VarDecl::make(diagonalEnd,
+      ir::Min::make(ir::Add::make(diagonal, numItems), total)));
+  threadBody.push_back(ir::VarDecl::make(rowStart,
+      ir::Call::make("taco_mergePathSearch", {pos, numRows, numNonzeros, diagonal},
+                 coordinate.type())));
+  threadBody.push_back(ir::VarDecl::make(rowEnd,
+      ir::Call::make("taco_mergePathSearch",
+                 {pos, numRows, numNonzeros, diagonalEnd}, coordinate.type())));
+  threadBody.push_back(ir::VarDecl::make(posStart, ir::Sub::make(diagonal, rowStart)));
+  threadBody.push_back(ir::VarDecl::make(posEnd, ir::Sub::make(diagonalEnd, rowEnd)));
+  threadBody.push_back(ir::For::make(coordinate, rowStart, rowEnd, 1,
+      ir::Block::make(ir::VarDecl::make(rowSum, ir::Literal::zero(values.type())),
+                      fullRow.rewrite(row),
+                      compoundStore(values, location.location, rowSum))));
+  threadBody.push_back(ir::VarDecl::make(carry, ir::Literal::zero(values.type())));
+  threadBody.push_back(ir::IfThenElse::make(ir::Lt::make(rowEnd, numRows),
+      ir::Block::make(ir::VarDecl::make(coordinate, rowEnd), partialRow.rewrite(row))));
+  threadBody.push_back(ir::Store::make(carryRows, thread, rowEnd));
+  threadBody.push_back(ir::Store::make(carryValues, thread, carry));
+  Stmt threads = ir::For::make(thread, 0, numThreads, 1, ir::Block::make(threadBody),
+                           LoopKind::Static, forall.getParallelUnit());
+
+  // Add the carries to the rows that threads end in
+  vector<Stmt> fixup;
+  fixup.push_back(ir::VarDecl::make(coordinate, ir::Load::make(carryRows, thread)));
+  util::append(fixup, location.decls);
+  fixup.push_back(compoundStore(values, location.location,
+                                ir::Load::make(carryValues, thread)));
+  Stmt carries = ir::For::make(thread, 0, numThreads, 1,
+      ir::IfThenElse::make(ir::Lt::make(ir::Load::make(carryRows, thread), numRows),
+                       ir::Block::make(fixup)));
+
+  Stmt postamble = ir::Block::make(ir::Free::make(carryRows), ir::Free::make(carryValues));
+  return ir::Block::blanks(ir::Block::make(preamble), threads, carries, postamble);
+}
+
   Stmt LowererImplImperative::lowerForallDenseAcceleration(Forall forall,
                                                  vector<Iterator> locators,
                                                  vector<Iterator> inserters,
@@ -1314,8 +1552,9 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
   Stmt strideGuard = Stmt();
   Stmt boundsGuard = Stmt();
   if (provGraph.isCoordVariable(forall.getIndexVar())) {
-    Expr coordinateArray = iterator.posAccess(iterator.getPosVar(),
-                                              coordinates(iterator)).getResults()[0];
+    ModeFunction posAccess = iterator.posAccess(iterator.getPosVar(),
+                                                coordinates(iterator));
+    Expr coordinateArray = posAccess.getResults()[0];
     // If the iterator is windowed, we must recover the coordinate index
     // variable from the windowed space.
     if (iterator.isWindowed()) {
@@ -1334,7 +1573,8 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
         boundsGuard = this->upperBoundGuardForWindowPosition(iterator, coordinate);
       }
     }
-    declareCoordinate = VarDecl::make(coordinate, coordinateArray);
+    declareCoordinate = Block::make(posAccess.compute(),
+                                    VarDecl::make(coordinate, coordinateArray));
   }
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth++;
@@ -1392,6 +1632,15 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
   }
 
   Stmt loop = Block::make(strideGuard, declareCoordinate, boundsGuard, body);
+
+  // Skip the positions that do not hold a coordinate, such as the empty slots
+  // of hashed levels
+  Expr hasCoordinate = iterator.posAccess(iterator.getPosVar(),
+                                          coordinates(iterator)).getResults()[1];
+  if (!isValue(hasCoordinate, true)) {
+    loop = IfThenElse::make(hasCoordinate, loop);
+  }
+
   if (iterator.isBranchless() && iterator.isCompact() && 
       (iterator.getParent().isRoot() || iterator.getParent().isUnique())) {
     loop = Block::make(VarDecl::make(iterator.getPosVar(), startBound), loop);
@@ -1415,6 +1664,80 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
   return Block::blanks(boundsCompute, loop, posAppend);
 }
 
+Stmt LowererImplImperative::lowerForallBitmapIntersection(Forall forall,
+                                      Iterator iterator,
+                                      vector<Iterator> locators,
+                                      vector<Iterator> inserters,
+                                      vector<Iterator> appenders,
+                                      MergeLattice caseLattice,
+                                      set<Access> reducedAccesses,
+                                      ir::Stmt recoveryStmt)
+{
+  vector<Iterator> bitmaps = {iterator};
+  vector<Iterator> otherLocators;
+  for (auto& locator : locators) {
+    if (isBitmap(locator) &&
+        locator.getIndexVar() == iterator.getIndexVar() &&
+        !locator.isWindowed() && !locator.hasIndexSet()) {
+      bitmaps.push_back(locator);
+    } else {
+      otherLocators.push_back(locator);
+    }
+  }
+
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+  Expr numWords = BitmapModeFormat::getNumWords(iterator.getMode());
+  Expr word = Var::make(iterator.getIndexVar().getName() + "_word", Int());
+  Expr bits = Var::make(iterator.getIndexVar().getName() + "_bits", UInt32);
+  Expr bit = Var::make(iterator.getIndexVar().getName() + "_bit", Int());
+
+  // Load the words of every bitmap and AND them together
+  vector<Stmt> rowDecls;
+  vector<Stmt> wordDecls;
+  vector<Stmt> posDecls;
+  Expr intersection;
+  for (auto& bitmap : bitmaps) {
+    const Mode& mode = bitmap.getMode();
+    Expr row = Var::make(mode.getName() + "_row", Int());
+    Expr bitmapWord = Var::make(mode.getName() + "_word", Int());
+    Expr bitmapBits = Var::make(mode.getName() + "_bits", UInt32);
+    rowDecls.push_back(VarDecl::make(row,
+        ir::Mul::make(bitmap.getParent().getPosVar(),
+                      BitmapModeFormat::getNumWords(mode))));
+    wordDecls.push_back(VarDecl::make(bitmapWord, ir::Add::make(row, word)));
+    wordDecls.push_back(VarDecl::make(bitmapBits,
+        BitmapModeFormat::loadWord(bitmapWord, mode)));
+    posDecls.push_back(VarDecl::make(bitmap.getPosVar(),
+        ir::Add::make(BitmapModeFormat::loadWordPos(bitmapWord, mode),
+                      BitmapModeFormat::countBitsBelow(bitmapBits, bit))));
+    intersection = intersection.defined()
+                   ? BitAnd::make(intersection, bitmapBits) : bitmapBits;
+  }
+  wordDecls.push_back(VarDecl::make(bits, intersection));
+
+  Stmt body = lowerForallBody(coordinate, forall.getStmt(), otherLocators,
+                              inserters, appenders, caseLattice,
+                              reducedAccesses, forall.getMergeStrategy());
+  body = Block::make(recoveryStmt, body);
+
+  // Visit the coordinates in both bitmaps, clearing each bit before the body
+  // so that the body may continue to the next coordinate
+  Stmt declareCoordinate = Block::make(
+      VarDecl::make(bit, ir::Call::make("taco_ctz", {bits}, Int())),
+      Assign::make(bits, BitAnd::make(bits, ir::Sub::make(bits, 1))),
+      VarDecl::make(coordinate,
+          ir::Add::make(ir::Mul::make(word, BitmapModeFormat::WORD_SIZE), bit)));
+  Stmt scan = While::make(Neq::make(bits, 0),
+      Block::make(declareCoordinate, Block::make(posDecls), body));
+  Stmt loop = For::make(word, 0, numWords, 1,
+                        Block::make(Block::make(wordDecls), scan));
+
+  // Code to append positions
+  Stmt posAppend = generateAppendPositions(appenders);
+
+  return Block::blanks(Block::make(rowDecls), loop, posAppend);
+}
+
 Stmt LowererImplImperative::lowerForallFusedPosition(Forall forall, Iterator iterator,
                                       vector<Iterator> locators,
                                       vector<Iterator> inserters,
@@ -1603,16 +1926,50 @@ Stmt LowererImplImperative::lowerMergeLattice(MergeLattice caseLattice, IndexVar
           });
   bool resolvedCoordDeclared = !modeIteratorsNonMergers.empty();
 
-  vector<Stmt> mergeLoopsVec;
-  for (MergePoint point : loopLattice.points()) {
-    // Each iteration of this loop generates a while loop for one of the merge
-    // points in the merge lattice.
-    IndexStmt zeroedStmt = zero(statement, getExhaustedAccesses(point, caseLattice));
-    MergeLattice sublattice = caseLattice.subLattice(point);
-    Stmt mergeLoop = lowerMergePoint(sublattice, coordinate, coordinateVar, zeroedStmt, reducedAccesses, resolvedCoordDeclared, mergestrategy);
-    mergeLoopsVec.push_back(mergeLoop);
+  auto lowerMergeLoops = [&](MergeStrategy strategy) {
+    vector<Stmt> mergeLoopsVec;
+    for (MergePoint point : loopLattice.points()) {
+      // Each iteration of this loop generates a while loop for one of the merge
+      // points in the merge lattice.
+      IndexStmt zeroedStmt = zero(statement, getExhaustedAccesses(point, caseLattice));
+      MergeLattice sublattice = caseLattice.subLattice(point);
+      Stmt mergeLoop = lowerMergePoint(sublattice, coordinate, coordinateVar, zeroedStmt, reducedAccesses, resolvedCoordDeclared, strategy);
+      mergeLoopsVec.push_back(mergeLoop);
+    }
+    return Block::make(mergeLoopsVec);
+  };
+
+  Stmt mergeLoops;
+  if (mergestrategy == MergeStrategy::Adaptive) {
+    // Emit both a galloping and a two-finger merge loop, and choose between
+    // them at the start of every segment from the numbers of positions that
+    // the iterators have left:
+    //   bool jGallop = max(A_len, B_len) / threshold > min(A_len, B_len);
+    //   if (jGallop) { <galloping merge> } else { <two-finger merge> }
+    vector<Iterator> searched = filter(mergers, [](Iterator it) {
+      return it.hasPosIter() && it.isUnique() && !it.isFull();
+    });
+    if (searched.size() > 1) {
+      vector<Expr> lengths;
+      for (auto& iterator : searched) {
+        lengths.push_back(ir::Sub::make(iterator.getEndVar(),
+                                        iterator.getIteratorVar()));
+      }
+      Expr threshold = ir::Literal::make(taco_get_adaptive_merge_threshold(),
+                                         lengths[0].type());
+      Expr isSkewed = ir::Gt::make(ir::Div::make(ir::Max::make(lengths), threshold),
+                                   ir::Min::make(lengths));
+      Expr useGallop = ir::Var::make(coordinateVar.getName() + "Gallop", Bool);
+      mergeLoops = Block::make(ir::VarDecl::make(useGallop, isSkewed),
+                               ir::IfThenElse::make(useGallop,
+                                   lowerMergeLoops(MergeStrategy::Gallop),
+                                   lowerMergeLoops(MergeStrategy::TwoFinger)));
+    } else {
+      mergeLoops = lowerMergeLoops(MergeStrategy::TwoFinger);
+    }
+  } else {
+    mergeLoops = lowerMergeLoops(mergestrategy);
   }
-  Stmt mergeLoops = Block::make(mergeLoopsVec);
 
   // Append position to the pos array
   Stmt appendPositions = generateAppendPositions(appenders);
@@ -1703,7 +2060,8 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
 
   // Merge iterator coordinate variables
   bool mergeWithMax;
-  if (mergeStrategy == MergeStrategy::Gallop) {
+  if (mergeStrategy == MergeStrategy::Gallop ||
+      mergeStrategy == MergeStrategy::SIMDBlock) {
     mergeWithMax = true;
   } else {
     mergeWithMax = false;
@@ -2124,8 +2482,10 @@ Stmt LowererImplImperative::lowerForallBody(Expr coordinate, IndexStmt stmt,
 
   std::vector<Stmt> stmts;
   
-  // Code to increment iterators when merging by galloping.
-  if (mergeStrategy == MergeStrategy::Gallop && caseLattice.iterators().size() > 1) {
+  // Code to increment iterators when merging by galloping or by blocks.
+  if ((mergeStrategy == MergeStrategy::Gallop ||
+       mergeStrategy == MergeStrategy::SIMDBlock) &&
+      caseLattice.iterators().size() > 1) {
     for (auto it : caseLattice.iterators()) {
       Expr ivar = it.getIteratorVar();
       stmts.push_back(compoundAssign(ivar, 1));
@@ -3379,8 +3739,10 @@ Stmt LowererImplImperative::declLocatePosVars(vector<Iterator> locators) {
 
     if (doLocate) {
       Iterator locateIterator = locator;
-      if (locateIterator.hasPosIter()) {
-        taco_iassert(!provGraph.isUnderived(locateIterator.getIndexVar()));
+      // Modes with position iteration are located into (e.g. hashed modes)
+      // unless they are iterated over by a derived position variable
+      if (locateIterator.hasPosIter() &&
+          !provGraph.isUnderived(locateIterator.getIndexVar())) {
         continue; // these will be recovered with separate procedure
       }
       do {
@@ -3399,12 +3761,25 @@ Stmt LowererImplImperative::declLocatePosVars(vector<Iterator> locators) {
           auto coordArray = indexSetIterator.posAccess(expr, coordinates(indexSetIterator)).getResults()[0];
           coords[coords.size() - 1] = coordArray;
         }
+        // Locating a coordinate that is not stored in a mode that does not
+        // store every coordinate (e.g. a hashed mode) yields a position whose
+        // value is the fill value, so the found result can be ignored.
         ModeFunction locate = locateIterator.locate(coords);
-        taco_iassert(isValue(locate.getResults()[1], true));
+        taco_iassert(isValue(locate.getResults()[1], true) ||
+                     !locateIterator.isFull());
+        result.push_back(locate.compute());
         Stmt declarePosVar = VarDecl::make(locateIterator.getPosVar(),
                                            locate.getResults()[0]);
         result.push_back(declarePosVar);
 
+        // Result modes that store their coordinates insert the coordinate at
+        // the located position
+        if (generateAssembleCode() && locateIterator.hasInsertCoord() &&
+            util::contains(capacityVars, locateIterator.getTensor())) {
+          result.push_back(locateIterator.getInsertCoord(
+              locateIterator.getPosVar(), coords));
+        }
+
         if (locateIterator.isLeaf()) {
           break;
         }
@@ -3644,7 +4019,8 @@ Stmt LowererImplImperative::codeToIncIteratorVars(Expr coordinate, IndexVar coor
       if (iterator.isFull()) {
         Expr increment = 1;
         result.push_back(compoundAssign(ivar, increment));
-      } else if (strategy == MergeStrategy::Gallop) {
+      } else if (strategy == MergeStrategy::Gallop ||
+                 strategy == MergeStrategy::SIMDBlock) {
         Expr iteratorParentPos = iterator.getParent().getPosVar();
         ModeFunction iterBounds = iterator.posBounds(iteratorParentPos);
         result.push_back(iterBounds.compute());
@@ -3653,7 +4029,9 @@ Stmt LowererImplImperative::codeToIncIteratorVars(Expr coordinate, IndexVar coor
           ivar, iterBounds[1],
           coordinate,
         };
-        result.push_back(ir::Assign::make(ivar, ir::Call::make("taco_gallop", gallopArgs, ivar.type())));
+        const string search = (strategy == MergeStrategy::Gallop)
+                              ? "taco_gallop" : "taco_simdAdvance";
+        result.push_back(ir::Assign::make(ivar, ir::Call::make(search, gallopArgs, ivar.type())));
       } else { // strategy == MergeStrategy::TwoFinger
         Expr increment = ir::Cast::make(Eq::make(iterator.getCoordVar(), coordinate), ivar.type());
         result.push_back(compoundAssign(ivar, increment));
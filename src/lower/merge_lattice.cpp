@@ -5,6 +5,7 @@
 #include <algorithm>
 
 #include "taco/lower/iterator.h"
+#include "taco/lower/mode.h"
 #include "taco/index_notation/index_notation.h"
 #include "taco/index_notation/index_notation_nodes.h"
 #include "taco/index_notation/index_notation_visitor.h"
@@ -619,7 +620,7 @@ private:
    * The union of two lattices is an intersection followed by the lattice
    * points of the first lattice followed by the merge points of the second.
    */
-  static MergeLattice unionLattices(MergeLattice left, MergeLattice right)
+  MergeLattice unionLattices(MergeLattice left, MergeLattice right)
   {
     vector<MergePoint> points;
 
@@ -689,7 +690,8 @@ private:
 
     // Optimization: insert a dimension iterator if one of the iterators in the
     //               iterate set is not ordered.
-    points = insertDimensionIteratorIfNotOrdered(points);
+    points = insertDimensionIteratorIfNotOrdered(points,
+                                                 iterators.modeIterator(i));
 
     // Optimization: move iterators to the locate set if they support locate and
     //               are subsets of some other iterator.
@@ -789,15 +791,14 @@ private:
   }
 
   static vector<MergePoint>
-  insertDimensionIteratorIfNotOrdered(const vector<MergePoint>& points)
+  insertDimensionIteratorIfNotOrdered(const vector<MergePoint>& points,
+                                      const Iterator& dimension)
   {
     vector<MergePoint> results;
     for (auto& point : points) {
       vector<Iterator> iterators = point.iterators();
       if (any(iterators, [](Iterator it){ return !it.isOrdered(); }) &&
           !any(iterators, [](Iterator it){ return it.isDimensionIterator(); })) {
-        taco_iassert(point.iterators().size() > 0);
-        Iterator dimension(iterators[0].getIndexVar());
         results.push_back(MergePoint(combine(iterators, {dimension}),
                                      point.locators(),
                                      point.results(),
@@ -1002,6 +1003,36 @@ MergeLattice::MergeLattice(vector<MergePoint> points, set<set<Iterator>> regions
 {
 }
 
+static bool isBitmap(Iterator it) {
+  return !it.isDimensionIterator() && it.getMode().defined() &&
+         it.getMode().getModeFormat().getName() ==
+             ModeFormat::Bitmap.getName();
+}
+
+/**
+ * Locating a coordinate that is not stored in a bitmap mode yields the position
+ * of the next stored coordinate instead of a position with the fill value, so
+ * bitmap modes are only located into by lattices with a single point that
+ * iterates over a bitmap, whose loops intersect the bitmaps a word at a time.
+ * The bitmap locators of other lattices are co-iterated instead.
+ */
+static MergeLattice coiterateBitmapLocators(MergeLattice lattice) {
+  if (lattice.points().empty() ||
+      (lattice.points().size() == 1 && lattice.iterators().size() == 1 &&
+       isBitmap(lattice.iterators()[0]))) {
+    return lattice;
+  }
+  vector<MergePoint> points;
+  for (auto& point : lattice.points()) {
+    vector<Iterator> bitmaps;
+    vector<Iterator> locators;
+    tie(bitmaps, locators) = split(point.locators(), isBitmap);
+    points.push_back(MergePoint(combine(point.iterators(), bitmaps), locators,
+                                point.results(), point.isOmitter()));
+  }
+  return MergeLattice(points, lattice.getTensorRegionsToKeep());
+}
+
 MergeLattice MergeLattice::make(Forall forall, Iterators iterators, ProvenanceGraph provGraph, std::set<IndexVar> definedIndexVars, std::map<TensorVar, const AccessNode *> whereTempsToResult)
 {
   // Can emit merge lattice once underived ancestor can be recovered
@@ -1016,7 +1047,8 @@ MergeLattice MergeLattice::make(Forall forall, Iterators iterators, ProvenanceGr
     }
   }
 
-  MergeLattice lattice = builder.build(forall.getStmt());
+  MergeLattice lattice = coiterateBitmapLocators(
+      builder.build(forall.getStmt()));
 
   // Can't remove points if lattice contains omitters since we lose merge cases during lowering.
   if(lattice.anyModeIteratorIsLeaf() && lattice.needExplicitZeroChecks()) {
@@ -106,15 +106,36 @@ ModePack::ModePack() : content(new Content) {
 }
 
 ModePack::ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor,
-                   int mode, int level) : ModePack() {
+                   int mode, int level, vector<Datatype> arrayTypes)
+    : ModePack() {
   content->numModes = numModes;
   content->arrays = modeType.impl->getArrays(tensor, mode, level);
+
+  // Index arrays are typed by the format's level array types, and arrays
+  // of other types (such as the dimension of a dense level) are kept as is
+  for (auto& array : content->arrays) {
+    const ir::GetProperty* property = array.as<ir::GetProperty>();
+    if (property == nullptr ||
+        property->property != ir::TensorProperty::Indices ||
+        (size_t)property->index >= arrayTypes.size() ||
+        property->type == arrayTypes[property->index]) {
+      continue;
+    }
+    array = ir::GetProperty::make(property->tensor, property->property,
+                                  property->mode, property->index,
+                                  property->name,
+                                  arrayTypes[property->index]);
+  }
 }
 
 size_t ModePack::getNumModes() const {
   return content->numModes;
 }
 
+size_t ModePack::getNumArrays() const {
+  return content->arrays.size();
+}
+
 ir::Expr ModePack::getArray(size_t i) const {
   return content->arrays[i];
 }
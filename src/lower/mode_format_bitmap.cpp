@@ -0,0 +1,222 @@
+#include "taco/lower/mode_format_bitmap.h"
+
+#include "taco/ir/ir_generators.h"
+#include "taco/ir/simplify.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+BitmapModeFormat::BitmapModeFormat() : BitmapModeFormat(false) {
+}
+
+BitmapModeFormat::BitmapModeFormat(bool isZeroless, long long allocSize) :
+    CompressedModeFormat("bitmap", false, true, true, isZeroless, false, false,
+                         true, allocSize) {
+}
+
+ModeFormat BitmapModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isZeroless = this->isZeroless;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::NOT_ORDERED:
+        taco_uerror << "Bitmap modes must be ordered";
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        taco_uerror << "Bitmap modes must be unique";
+        break;
+      case ModeFormat::ZEROLESS:
+        isZeroless = true;
+        break;
+      case ModeFormat::NOT_ZEROLESS:
+        isZeroless = false;
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(std::make_shared<BitmapModeFormat>(isZeroless, allocSize));
+}
+
+ModeFunction BitmapModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  ModeFunction bounds = CompressedModeFormat::posIterBounds(parentPos, mode);
+
+  // The scan starts at the first word of the parent's bitmap, whose lowest
+  // set bit (if any) is the coordinate of the first position
+  Expr row = getScanVar(mode, "row", Int());
+  Expr word = getScanVar(mode, "word", Int());
+  Expr bits = getScanVar(mode, "bits", UInt32);
+  Expr last = getScanVar(mode, "last", Int());
+  Stmt initScan = Block::make(
+      VarDecl::make(row, ir::Mul::make(parentPos, getNumWords(mode))),
+      VarDecl::make(word, 0),
+      VarDecl::make(bits, loadWord(row, mode)),
+      VarDecl::make(last, bounds[0]));
+  return ModeFunction(initScan, {bounds[0], bounds[1]});
+}
+
+ModeFunction BitmapModeFormat::posIterAccess(Expr pos, vector<Expr> coords,
+                                             Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  Expr row = getScanVar(mode, "row", Int());
+  Expr word = getScanVar(mode, "word", Int());
+  Expr bits = getScanVar(mode, "bits", UInt32);
+  Expr last = getScanVar(mode, "last", Int());
+
+  // Clear the lowest set bit when the loop moves on to the next position, and
+  // skip the words that are left without coordinates
+  Stmt nextPos = IfThenElse::make(Lt::make(last, pos), Block::make(
+      Assign::make(bits, BitAnd::make(bits, ir::Sub::make(bits, 1))),
+      Assign::make(last, pos)));
+  Stmt nextWord = While::make(Eq::make(bits, 0), Block::make(
+      Assign::make(word, ir::Add::make(word, 1)),
+      Assign::make(bits, loadWord(ir::Add::make(row, word), mode))));
+
+  Expr coord = ir::Add::make(ir::Mul::make(word, WORD_SIZE),
+                             ir::Call::make("taco_ctz", {bits}, Int()));
+  return ModeFunction(Block::make(nextPos, nextWord), {coord, true});
+}
+
+ModeFunction BitmapModeFormat::coordBounds(Expr parentPos, Mode mode) const {
+  return ModeFunction(Stmt(), {0, mode.getModePack().getArray(2)});
+}
+
+ModeFunction BitmapModeFormat::locate(Expr parentPos, vector<Expr> coords,
+                                      Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  Expr coord = coords.back();
+  Expr word = Var::make(mode.getName() + "_word", Int());
+  Expr bits = Var::make(mode.getName() + "_bits", UInt32);
+  Expr bit = Var::make(mode.getName() + "_bit", Int());
+  Stmt declWord = VarDecl::make(word,
+      ir::Add::make(ir::Mul::make(parentPos, getNumWords(mode)),
+                    Shr::make(coord, 5)));
+  Stmt declBits = VarDecl::make(bits, loadWord(word, mode));
+  Stmt declBit = VarDecl::make(bit, BitAnd::make(coord, WORD_SIZE - 1));
+
+  Expr pos = ir::Add::make(loadWordPos(word, mode), countBitsBelow(bits, bit));
+  Expr found = Neq::make(BitAnd::make(Shr::make(bits, bit), 1), 0);
+  return ModeFunction(Block::make(declWord, declBits, declBit), {pos, found});
+}
+
+Stmt BitmapModeFormat::getAppendCoord(Expr p, Expr i, Mode mode) const {
+  taco_uassert(mode.getModePack().getNumModes() == 1) <<
+      "Bitmap modes cannot share their arrays with other modes";
+  return CompressedModeFormat::getAppendCoord(p, i, mode);
+}
+
+Stmt BitmapModeFormat::getAppendFinalizeLevel(Expr szPrev, Expr sz,
+                                              Mode mode) const {
+  Stmt finalizePos = CompressedModeFormat::getAppendFinalizeLevel(szPrev, sz,
+                                                                  mode);
+  const string name = mode.getName();
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr crdArray = getCoordArray(mode.getModePack());
+
+  // The appended coordinates become the buffer that the bitmaps are built
+  // from
+  Expr buffer = Var::make(name + "_crd_buffer", Int32, true);
+  Expr numWords = Var::make(name + "_words", Int());
+  Stmt initBuffer = VarDecl::make(buffer, crdArray);
+  Stmt initNumWords = VarDecl::make(numWords,
+      ir::Mul::make(szPrev, getNumWords(mode)));
+  Stmt allocCrd = Allocate::make(crdArray, ir::Mul::make(numWords, 2), false,
+                                 Expr(), true);
+
+  // Set the bit of every coordinate in the bitmap of its parent
+  Expr pVar = Var::make("p" + name, Int());
+  Expr qVar = Var::make("q" + name, Int());
+  Expr coord = Var::make(name + "_coord", Int());
+  Expr word = Var::make(name + "_word", Int());
+  Stmt setBit = Block::make(
+      VarDecl::make(coord, Load::make(buffer, qVar)),
+      VarDecl::make(word, ir::Mul::make(ir::Add::make(
+          ir::Mul::make(pVar, getNumWords(mode)), Shr::make(coord, 5)), 2)),
+      Store::make(crdArray, word, BitOr::make(
+          ir::Cast::make(Load::make(crdArray, word), UInt32),
+          Shl::make(ir::Cast::make(1, UInt32),
+                    BitAnd::make(coord, WORD_SIZE - 1)))));
+  Stmt setBits = For::make(pVar, 0, szPrev, 1,
+      For::make(qVar, Load::make(posArray, pVar),
+                Load::make(posArray, ir::Add::make(pVar, 1)), 1, setBit));
+
+  // Positions are numbered in the order of the words, so the position of the
+  // first coordinate in a word counts the bits of the words before it
+  Expr wVar = Var::make("w" + name, Int());
+  Expr count = Var::make(name + "_count", Int());
+  Stmt storeWordPos = Block::make(
+      Store::make(crdArray, ir::Add::make(ir::Mul::make(wVar, 2), 1), count),
+      Assign::make(count, ir::Add::make(count, ir::Call::make("taco_popcount",
+          {loadWord(wVar, mode)}, Int()))));
+  Stmt countBits = Block::make(VarDecl::make(count, 0),
+      For::make(wVar, 0, numWords, 1, storeWordPos));
+
+  return Block::make({finalizePos, initBuffer, initNumWords, allocCrd, setBits,
+                      countBits, Free::make(buffer)});
+}
+
+vector<Expr> BitmapModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  vector<Expr> arrays = CompressedModeFormat::getArrays(tensor, mode, level);
+  arrays.push_back(GetProperty::make(tensor, TensorProperty::Dimension, mode));
+  return arrays;
+}
+
+Expr BitmapModeFormat::getNumWords(Mode mode) {
+  Expr dimension = mode.getModePack().getArray(2);
+  return Shr::make(ir::Add::make(dimension, WORD_SIZE - 1), 5);
+}
+
+Expr BitmapModeFormat::loadWord(Expr word, Mode mode) {
+  Expr crdArray = mode.getModePack().getArray(1);
+  return ir::Cast::make(Load::make(crdArray, ir::Mul::make(word, 2)), UInt32);
+}
+
+Expr BitmapModeFormat::loadWordPos(Expr word, Mode mode) {
+  Expr crdArray = mode.getModePack().getArray(1);
+  return Load::make(crdArray, ir::Add::make(ir::Mul::make(word, 2), 1));
+}
+
+Expr BitmapModeFormat::countBitsBelow(Expr bits, Expr bit) {
+  Expr below = ir::Sub::make(Shl::make(ir::Cast::make(1, UInt32), bit), 1);
+  return ir::Call::make("taco_popcount", {BitAnd::make(bits, below)}, Int());
+}
+
+size_t BitmapModeFormat::getNumWords(size_t dimension) {
+  return (dimension + WORD_SIZE - 1) / WORD_SIZE;
+}
+
+int BitmapModeFormat::countBits(uint32_t bits) {
+  return __builtin_popcount(bits);
+}
+
+void BitmapModeFormat::unpack(const int32_t* words, size_t numParents,
+                              size_t dimension, int32_t* crd) {
+  const size_t numWords = getNumWords(dimension);
+  size_t q = 0;
+  for (size_t w = 0; w < numParents * numWords; ++w) {
+    uint32_t bits = (uint32_t)words[2 * w];
+    while (bits != 0) {
+      crd[q++] = (int32_t)((w % numWords) * WORD_SIZE + __builtin_ctz(bits));
+      bits &= bits - 1;
+    }
+  }
+}
+
+Expr BitmapModeFormat::getScanVar(Mode mode, string name,
+                                  Datatype type) const {
+  const std::string varName = mode.getName() + "_" + name;
+
+  if (!mode.hasVar(varName)) {
+    Expr var = Var::make(varName, type);
+    mode.addVar(varName, var);
+    return var;
+  }
+
+  return mode.getVar(varName);
+}
+
+}
@@ -0,0 +1,276 @@
+#include "taco/lower/mode_format_bitpacked.h"
+
+#include <algorithm>
+
+#include "taco/ir/ir_generators.h"
+#include "taco/ir/simplify.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+// The number of padding words after the deltas, which lets decoding load the
+// word after the one that holds the start of a delta.
+static const size_t NUM_PADDING_WORDS = 2;
+
+BitPackedModeFormat::BitPackedModeFormat() :
+    BitPackedModeFormat(false, false) {
+}
+
+BitPackedModeFormat::BitPackedModeFormat(bool isFull, bool isZeroless,
+                                         long long allocSize) :
+    CompressedModeFormat("bitpacked", isFull, true, true, isZeroless, false,
+                         false, false, allocSize) {
+}
+
+ModeFormat BitPackedModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isFull = this->isFull;
+  bool isZeroless = this->isZeroless;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::FULL:
+        isFull = true;
+        break;
+      case ModeFormat::NOT_FULL:
+        isFull = false;
+        break;
+      case ModeFormat::NOT_ORDERED:
+        taco_uerror << "Bit-packed modes must be ordered";
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        taco_uerror << "Bit-packed modes must be unique";
+        break;
+      case ModeFormat::ZEROLESS:
+        isZeroless = true;
+        break;
+      case ModeFormat::NOT_ZEROLESS:
+        isZeroless = false;
+        break;
+      default:
+        break;
+    }
+  }
+  const auto bitPackedVariant =
+      std::make_shared<BitPackedModeFormat>(isFull, isZeroless, allocSize);
+  return ModeFormat(bitPackedVariant);
+}
+
+Expr BitPackedModeFormat::decode(Expr pos, Mode mode) const {
+  taco_iassert(mode.getModePack().getNumModes() == 1);
+  Expr crdArray = getCoordArray(mode.getModePack());
+
+  // The header of the block that holds the position
+  Expr header = ir::Mul::make(Shr::make(pos, 5), 2);
+  Expr base = Load::make(crdArray, header);
+  Expr start = Load::make(crdArray, ir::Add::make(header, 1));
+  Expr width = ir::Sub::make(Load::make(crdArray, ir::Add::make(header, 3)),
+                             start);
+
+  // The delta starts `bit` bits into the block's deltas and may continue into
+  // the next word, so two words are loaded and shifted together
+  Expr bit = ir::Mul::make(BitAnd::make(pos, BLOCK_SIZE - 1), width, Int32);
+  Expr word = ir::Add::make(start, Shr::make(bit, 5));
+  Expr low = ir::Cast::make(ir::Cast::make(Load::make(crdArray, word), UInt32),
+                            UInt64);
+  Expr high = ir::Cast::make(ir::Cast::make(Load::make(crdArray,
+                                                       ir::Add::make(word, 1)),
+                                            UInt32), UInt64);
+  Expr bits = ir::Add::make(Shl::make(high, 32), low, UInt64);
+  Expr mask = ir::Sub::make(Shl::make(ir::Cast::make(1, UInt64), width),
+                            ir::Cast::make(1, UInt64), UInt64);
+  Expr delta = BitAnd::make(Shr::make(bits, BitAnd::make(bit, 31)), mask);
+  return ir::Add::make(base, ir::Cast::make(delta, Int32), Int32);
+}
+
+ModeFunction BitPackedModeFormat::posIterAccess(ir::Expr pos,
+                                                std::vector<ir::Expr> coords,
+                                                Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  return ModeFunction(Stmt(), {decode(pos, mode), true});
+}
+
+ModeFunction BitPackedModeFormat::coordBounds(Expr parentPos,
+                                              Mode mode) const {
+  Expr pend = Load::make(getPosArray(mode.getModePack()),
+                         ir::Add::make(parentPos, 1));
+  Expr coordend = decode(ir::Sub::make(pend, 1), mode);
+  return ModeFunction(Stmt(), {0, coordend});
+}
+
+Stmt BitPackedModeFormat::getAppendCoord(Expr p, Expr i, Mode mode) const {
+  taco_uassert(mode.getModePack().getNumModes() == 1) <<
+      "Bit-packed modes cannot share their arrays with other modes";
+  return CompressedModeFormat::getAppendCoord(p, i, mode);
+}
+
+Stmt BitPackedModeFormat::getAppendInitLevel(Expr szPrev, Expr sz,
+                                             Mode mode) const {
+  // The coordinates are appended to the crd array as they would be to that of
+  // a compressed mode, and packed when the level is finalized
+  return CompressedModeFormat::getAppendInitLevel(szPrev, sz, mode);
+}
+
+Stmt BitPackedModeFormat::getAppendFinalizeLevel(Expr szPrev, Expr sz,
+                                                 Mode mode) const {
+  Stmt finalizePos = CompressedModeFormat::getAppendFinalizeLevel(szPrev, sz,
+                                                                  mode);
+  const string name = mode.getName();
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr buffer = getCoordBuffer(mode);
+
+  Expr n = Var::make(name + "_nnz", Int());
+  Expr numBlocks = Var::make(name + "_blocks", Int());
+  Expr words = Var::make(name + "_words", Int());
+  Stmt initN = VarDecl::make(n, getSize(szPrev, mode));
+  Stmt initNumBlocks = VarDecl::make(numBlocks,
+      Shr::make(ir::Add::make(n, BLOCK_SIZE - 1), 5));
+  Stmt initWords = VarDecl::make(words,
+      ir::Add::make(ir::Mul::make(numBlocks, 2), 2));
+
+  // The appended coordinates become the buffer that the packed coordinates
+  // are read from
+  Stmt initBuffer = VarDecl::make(buffer, crdArray);
+  Expr maxSize = ir::Add::make(ir::Add::make(words,
+      ir::Mul::make(numBlocks, BLOCK_SIZE)), (int)NUM_PADDING_WORDS);
+  Stmt allocCrd = Allocate::make(crdArray, maxSize);
+
+  // Find the smallest and largest coordinate of the block
+  Expr b = Var::make("b" + name, Int());
+  Expr q = Var::make("q" + name, Int());
+  Expr lo = Var::make(name + "_block_begin", Int());
+  Expr hi = Var::make(name + "_block_end", Int());
+  Expr minCrd = Var::make(name + "_min", Int());
+  Expr maxCrd = Var::make(name + "_max", Int());
+  Expr width = Var::make(name + "_width", Int());
+  Stmt initLo = VarDecl::make(lo, ir::Mul::make(b, BLOCK_SIZE));
+  Stmt initHi = VarDecl::make(hi, Min::make(ir::Add::make(lo, BLOCK_SIZE), n));
+  Stmt initMin = VarDecl::make(minCrd, Load::make(buffer, lo));
+  Stmt initMax = VarDecl::make(maxCrd, Load::make(buffer, lo));
+  Stmt findRange = For::make(q, ir::Add::make(lo, 1), hi, 1, Block::make(
+      Assign::make(minCrd, Min::make(minCrd, Load::make(buffer, q))),
+      Assign::make(maxCrd, Max::make(maxCrd, Load::make(buffer, q)))));
+
+  // Find the number of bits of the largest delta
+  Stmt initWidth = VarDecl::make(width, 0);
+  Stmt findWidth = While::make(
+      Neq::make(Shr::make(ir::Sub::make(maxCrd, minCrd), width), 0),
+      Assign::make(width, ir::Add::make(width, 1)));
+
+  Stmt storeHeader = Block::make(
+      Store::make(crdArray, ir::Mul::make(b, 2), minCrd),
+      Store::make(crdArray, ir::Add::make(ir::Mul::make(b, 2), 1), words));
+  Stmt clearDeltas = For::make(q, words, ir::Add::make(words, width), 1,
+                               Store::make(crdArray, q, 0));
+
+  // Or every delta into the word it starts in and the word it continues in
+  Expr bit = Var::make(name + "_bit", Int());
+  Expr word = Var::make(name + "_word", Int());
+  Expr delta = Var::make(name + "_delta", UInt64);
+  Stmt initBit = VarDecl::make(bit,
+      ir::Mul::make(ir::Sub::make(q, lo), width));
+  Stmt initWord = VarDecl::make(word, ir::Add::make(words, Shr::make(bit, 5)));
+  Stmt initDelta = VarDecl::make(delta,
+      Shl::make(ir::Cast::make(ir::Cast::make(
+                    ir::Sub::make(Load::make(buffer, q), minCrd), UInt32),
+                    UInt64),
+                BitAnd::make(bit, 31)));
+  Stmt storeLow = Store::make(crdArray, word,
+      BitOr::make(Load::make(crdArray, word), ir::Cast::make(delta, UInt32)));
+  Stmt storeHigh = IfThenElse::make(
+      Gt::make(ir::Add::make(BitAnd::make(bit, 31), width), 32),
+      Store::make(crdArray, ir::Add::make(word, 1),
+          BitOr::make(Load::make(crdArray, ir::Add::make(word, 1)),
+                      ir::Cast::make(Shr::make(delta, 32), UInt32))));
+  Stmt storeDeltas = For::make(q, lo, hi, 1, Block::make(
+      initBit, initWord, initDelta, storeLow, storeHigh));
+
+  Stmt nextBlock = Assign::make(words, ir::Add::make(words, width));
+  Stmt packBlocks = For::make(b, 0, numBlocks, 1, Block::make({
+      initLo, initHi, initMin, initMax, findRange, initWidth, findWidth,
+      storeHeader, clearDeltas, storeDeltas, nextBlock}));
+
+  // The header of the block after the last marks where the deltas end
+  Stmt storeEnd = Block::make(
+      Store::make(crdArray, ir::Mul::make(numBlocks, 2), 0),
+      Store::make(crdArray, ir::Add::make(ir::Mul::make(numBlocks, 2), 1),
+                  words));
+  Stmt clearPadding = For::make(q, words,
+      ir::Add::make(words, (int)NUM_PADDING_WORDS), 1,
+      Store::make(crdArray, q, 0));
+
+  return Block::make({finalizePos, initN, initNumBlocks, initWords, initBuffer,
+                      allocCrd, packBlocks, storeEnd, clearPadding,
+                      Free::make(buffer)});
+}
+
+Expr BitPackedModeFormat::getCoordBuffer(Mode mode) const {
+  const std::string varName = mode.getName() + "_crd_buffer";
+
+  if (!mode.hasVar(varName)) {
+    Expr buffer = Var::make(varName, Int32, true);
+    mode.addVar(varName, buffer);
+    return buffer;
+  }
+
+  return mode.getVar(varName);
+}
+
+size_t BitPackedModeFormat::getMaxPackedSize(size_t n) {
+  const size_t numBlocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  return 2 * numBlocks + 2 + numBlocks * BLOCK_SIZE + NUM_PADDING_WORDS;
+}
+
+size_t BitPackedModeFormat::pack(const int32_t* crd, size_t n,
+                                 int32_t* packed) {
+  const size_t numBlocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  uint32_t* words = (uint32_t*)packed;
+  size_t start = 2 * numBlocks + 2;
+  for (size_t b = 0; b < numBlocks; ++b) {
+    const size_t lo = b * BLOCK_SIZE;
+    const size_t hi = std::min(lo + BLOCK_SIZE, n);
+    const int32_t minCrd = *std::min_element(crd + lo, crd + hi);
+    const int32_t maxCrd = *std::max_element(crd + lo, crd + hi);
+    int width = 0;
+    while (((uint32_t)(maxCrd - minCrd) >> width) != 0) {
+      width++;
+    }
+    packed[2 * b] = minCrd;
+    packed[2 * b + 1] = (int32_t)start;
+    std::fill(words + start, words + start + width, 0);
+    for (size_t q = lo; q < hi; ++q) {
+      const size_t bit = (q - lo) * width;
+      const uint64_t delta = (uint64_t)(uint32_t)(crd[q] - minCrd) << (bit % 32);
+      words[start + bit / 32] |= (uint32_t)delta;
+      if (bit % 32 + width > 32) {
+        words[start + bit / 32 + 1] |= (uint32_t)(delta >> 32);
+      }
+    }
+    start += width;
+  }
+  packed[2 * numBlocks] = 0;
+  packed[2 * numBlocks + 1] = (int32_t)start;
+  std::fill(words + start, words + start + NUM_PADDING_WORDS, 0);
+  return start + NUM_PADDING_WORDS;
+}
+
+size_t BitPackedModeFormat::getPackedSize(const int32_t* packed, size_t n) {
+  const size_t numBlocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  return packed[2 * numBlocks + 1] + NUM_PADDING_WORDS;
+}
+
+int32_t BitPackedModeFormat::unpack(const int32_t* packed, size_t p) {
+  const uint32_t* words = (const uint32_t*)packed;
+  const size_t header = 2 * (p / BLOCK_SIZE);
+  const size_t start = packed[header + 1];
+  const int width = packed[header + 3] - packed[header + 1];
+  const size_t bit = (p % BLOCK_SIZE) * width;
+  const size_t word = start + bit / 32;
+  const uint64_t bits = ((uint64_t)words[word + 1] << 32) | words[word];
+  const uint64_t mask = ((uint64_t)1 << width) - 1;
+  return packed[header] + (int32_t)((bits >> (bit % 32)) & mask);
+}
+
+}
@@ -16,9 +16,20 @@ CompressedModeFormat::CompressedModeFormat() :
 CompressedModeFormat::CompressedModeFormat(bool isFull, bool isOrdered,
                                            bool isUnique, bool isZeroless, 
                                            long long allocSize) :
-    ModeFormatImpl("compressed", isFull, isOrdered, isUnique, false, true,
-                   isZeroless, false, false, true, false, false, true, true,  
-                   true, false), 
+    CompressedModeFormat("compressed", isFull, isOrdered, isUnique, isZeroless,
+                         true, true, false, allocSize) {
+}
+
+CompressedModeFormat::CompressedModeFormat(std::string name, bool isFull,
+                                           bool isOrdered, bool isUnique,
+                                           bool isZeroless,
+                                           bool hasSeqInsertEdge,
+                                           bool hasInsertCoord,
+                                           bool hasLocate,
+                                           long long allocSize) :
+    ModeFormatImpl(name, isFull, isOrdered, isUnique, false, true, isZeroless,
+                   false, false, true, hasLocate, false, true, hasSeqInsertEdge,
+                   hasInsertCoord, false),
     allocSize(allocSize) {
 }
 
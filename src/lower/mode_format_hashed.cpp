@@ -0,0 +1,206 @@
+#include "taco/lower/mode_format_hashed.h"
+
+#include "taco/ir/ir_generators.h"
+#include "taco/ir/simplify.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+HashedModeFormat::HashedModeFormat() : HashedModeFormat(false) {
+}
+
+HashedModeFormat::HashedModeFormat(bool isZeroless) :
+    ModeFormatImpl("hashed", false, false, true, false, false, isZeroless,
+                   false, false, true, true, true, false, false, true, false) {
+}
+
+ModeFormat HashedModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isZeroless = this->isZeroless;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::ORDERED:
+        taco_uerror << "Hashed modes cannot be ordered";
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        taco_uerror << "Hashed modes must be unique";
+        break;
+      case ModeFormat::ZEROLESS:
+        isZeroless = true;
+        break;
+      case ModeFormat::NOT_ZEROLESS:
+        isZeroless = false;
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(std::make_shared<HashedModeFormat>(isZeroless));
+}
+
+ModeFunction HashedModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  Expr pbegin = Load::make(getPosArray(mode.getModePack()), parentPos);
+  Expr pend = Load::make(getPosArray(mode.getModePack()),
+                         ir::Add::make(parentPos, 1));
+  return ModeFunction(Stmt(), {pbegin, pend});
+}
+
+ModeFunction HashedModeFormat::posIterAccess(Expr pos, vector<Expr> coords,
+                                             Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  Expr idx = Load::make(getCoordArray(mode.getModePack()), pos);
+  return ModeFunction(Stmt(), {idx, Neq::make(idx, -1)});
+}
+
+ModeFunction HashedModeFormat::locate(Expr parentPos, vector<Expr> coords,
+                                      Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr coord = coords.back();
+
+  // Probe the table of the parent from the hash of the coordinate until the
+  // coordinate or an empty slot is found
+  Expr begin = Var::make(mode.getName() + "_begin", Int());
+  Expr capacity = Var::make(mode.getName() + "_capacity", Int());
+  Expr slot = Var::make(mode.getName() + "_slot", Int());
+  Stmt declBegin = VarDecl::make(begin, Load::make(posArray, parentPos));
+  Stmt declCapacity = VarDecl::make(capacity,
+      ir::Sub::make(Load::make(posArray, ir::Add::make(parentPos, 1)), begin));
+  Expr hash = ir::Cast::make(
+      ir::Mul::make(ir::Cast::make(coord, UInt32),
+                    ir::Literal::make(2654435761u, UInt32)), UInt32);
+  Stmt declSlot = VarDecl::make(slot,
+      ir::Cast::make(Rem::make(hash, ir::Cast::make(capacity, UInt32)),
+                     Int()));
+
+  Expr crd = Load::make(crdArray, ir::Add::make(begin, slot));
+  Expr isProbing = And::make(Neq::make(crd, coord), Neq::make(crd, -1));
+  Stmt nextSlot = Block::make(
+      Assign::make(slot, ir::Add::make(slot, 1)),
+      IfThenElse::make(Eq::make(slot, capacity), Assign::make(slot, 0)));
+  Stmt probe = While::make(isProbing, nextSlot);
+
+  return ModeFunction(Block::make(declBegin, declCapacity, declSlot, probe),
+                      {ir::Add::make(begin, slot), Eq::make(crd, coord)});
+}
+
+Stmt HashedModeFormat::getInsertCoord(Expr p, const vector<Expr>& i,
+                                      Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  return Store::make(getCoordArray(mode.getModePack()), p, i.back());
+}
+
+Expr HashedModeFormat::getWidth(Mode mode) const {
+  // Tables that can hold every coordinate at a load factor of at most 1/2
+  return ir::Add::make(ir::Mul::make(getSizeArray(mode.getModePack()), 2), 1);
+}
+
+Stmt HashedModeFormat::getInsertInitCoords(Expr pBegin, Expr pEnd,
+                                           Mode mode) const {
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr width = getWidth(mode);
+
+  // Tables below positions of an append mode are added as the positions are
+  // appended, so the arrays may have to be resized first
+  vector<Stmt> initStmts;
+  Expr parentEnd = ir::Div::make(pEnd, width);
+  initStmts.push_back(atLeastDoubleSizeIfFull(posArray, getPosCapacity(mode),
+                                              parentEnd));
+  initStmts.push_back(atLeastDoubleSizeIfFull(crdArray, getCoordCapacity(mode),
+                                              ir::Sub::make(pEnd, 1)));
+
+  Expr qVar = Var::make("q" + mode.getName(), Int());
+  Stmt storePos = Store::make(posArray, ir::Add::make(qVar, 1),
+                              ir::Mul::make(ir::Add::make(qVar, 1), width));
+  initStmts.push_back(For::make(qVar, ir::Div::make(pBegin, width), parentEnd,
+                                1, storePos));
+
+  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Stmt clearSlot = Store::make(crdArray, pVar, -1);
+  initStmts.push_back(For::make(pVar, pBegin, pEnd, 1, clearSlot));
+  return Block::make(initStmts);
+}
+
+Stmt HashedModeFormat::getInsertInitLevel(Expr szPrev, Expr sz,
+                                          Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr crdArray = getCoordArray(mode.getModePack());
+
+  // The tables are initialized by getInsertInitCoords. If the parent mode is
+  // assembled by appending, the arrays grow as the parent's positions are
+  // appended.
+  const bool szPrevIsZero = isa<ir::Literal>(szPrev) &&
+                            to<ir::Literal>(szPrev)->equalsScalar(0);
+  Expr defaultCapacity = ir::Literal::make(DEFAULT_ALLOC_SIZE, Datatype::Int32);
+  Expr posCapacity = szPrevIsZero ? defaultCapacity
+                                  : ir::Add::make(szPrev, 1);
+  Expr crdCapacity = szPrevIsZero ? defaultCapacity : sz;
+  return Block::make({VarDecl::make(getPosCapacity(mode), posCapacity),
+                      Allocate::make(posArray, getPosCapacity(mode)),
+                      VarDecl::make(getCoordCapacity(mode), crdCapacity),
+                      Allocate::make(crdArray, getCoordCapacity(mode)),
+                      Store::make(posArray, 0, 0)});
+}
+
+Stmt HashedModeFormat::getInsertFinalizeLevel(Expr szPrev, Expr sz,
+                                              Mode mode) const {
+  return Stmt();
+}
+
+vector<Expr> HashedModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_pos"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_crd"),
+          GetProperty::make(tensor, TensorProperty::Dimension, mode)};
+}
+
+size_t HashedModeFormat::getCapacity(size_t n) {
+  return 2 * n + 1;
+}
+
+Expr HashedModeFormat::getPosArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr HashedModeFormat::getCoordArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr HashedModeFormat::getSizeArray(ModePack pack) const {
+  return pack.getArray(2);
+}
+
+Expr HashedModeFormat::getPosCapacity(Mode mode) const {
+  const std::string varName = mode.getName() + "_pos_size";
+
+  if (!mode.hasVar(varName)) {
+    Expr posCapacity = Var::make(varName, Int());
+    mode.addVar(varName, posCapacity);
+    return posCapacity;
+  }
+
+  return mode.getVar(varName);
+}
+
+Expr HashedModeFormat::getCoordCapacity(Mode mode) const {
+  const std::string varName = mode.getName() + "_crd_size";
+
+  if (!mode.hasVar(varName)) {
+    Expr idxCapacity = Var::make(varName, Int());
+    mode.addVar(varName, idxCapacity);
+    return idxCapacity;
+  }
+
+  return mode.getVar(varName);
+}
+
+}
@@ -0,0 +1,79 @@
+#include "taco/lower/mode_format_sliced.h"
+
+#include "taco/ir/ir_generators.h"
+#include "taco/ir/simplify.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+SlicedModeFormat::SlicedModeFormat() : SlicedModeFormat(DEFAULT_CHUNK_SIZE) {
+}
+
+SlicedModeFormat::SlicedModeFormat(int chunkSize) :
+    ModeFormatImpl("sliced", false, false, true, false, true, false, true,
+                   false, true, false, false, false, false, false, true),
+    chunkSize(chunkSize) {
+  taco_iassert(chunkSize > 0);
+}
+
+ModeFormat SlicedModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::ORDERED:
+        taco_uerror << "Sliced modes cannot be ordered";
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        taco_uerror << "Sliced modes must be unique";
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(std::make_shared<SlicedModeFormat>(chunkSize));
+}
+
+ModeFunction SlicedModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  Expr begin = ir::Mul::make(parentPos, chunkSize);
+  return ModeFunction(Stmt(), {begin, ir::Add::make(begin, chunkSize)});
+}
+
+ModeFunction SlicedModeFormat::posIterAccess(Expr pos, vector<Expr> coords,
+                                             Mode mode) const {
+  taco_iassert(mode.getPackLocation() == 0);
+  taco_iassert(coords.size() >= 3);
+
+  // The coordinates end with those of the chunk, of the column of the chunk
+  // and of this level
+  Expr chunk = coords[coords.size() - 3];
+  Expr slot = ir::Add::make(ir::Mul::make(chunk, chunkSize),
+                            Rem::make(pos, chunkSize));
+  Expr row = Load::make(getRowsArray(mode.getModePack()), slot);
+  return ModeFunction(Stmt(), {row, Gte::make(row, 0)});
+}
+
+vector<Expr> SlicedModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {Expr(),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_rows")};
+}
+
+int SlicedModeFormat::getChunkSize() const {
+  return chunkSize;
+}
+
+Expr SlicedModeFormat::getRowsArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+bool SlicedModeFormat::equals(const ModeFormatImpl& other) const {
+  return ModeFormatImpl::equals(other) &&
+         static_cast<const SlicedModeFormat&>(other).chunkSize == chunkSize;
+}
+
+}
@@ -0,0 +1,347 @@
+#include "taco/parallel_runtime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace taco {
+
+static atomic<ParallelRuntime> parallelRuntime(ParallelRuntime::OpenMP);
+
+void taco_set_parallel_runtime(ParallelRuntime runtime) {
+  parallelRuntime = runtime;
+}
+
+ParallelRuntime taco_get_parallel_runtime() {
+  return parallelRuntime;
+}
+
+namespace {
+
+/// The most threads that the pool starts, and the most threads (workers and
+/// threads that call parallel loops) that have deques at a time. Threads that
+/// call parallel loops when all deques are taken run them serially.
+const int maxWorkers = 255;
+const int maxDeques = 1024;
+
+/// A parallel loop, whose iterations are run by at most `limit` threads. Every
+/// thread that runs some of them is given a slot, which is the index that
+/// taco_parallel_thread_num returns while it runs them.
+struct Job {
+  taco_parallel_body_t body;
+  void* ctx;
+  int64_t grain;
+  int limit;
+  atomic<int64_t> remaining;
+  atomic<int> numSlots;
+  unique_ptr<atomic<int>[]> slots;
+
+  Job(taco_parallel_body_t body, void* ctx, int64_t grain, int limit,
+      int64_t iterations)
+      : body(body), ctx(ctx), grain(grain), limit(limit),
+        remaining(iterations), numSlots(0), slots(new atomic<int>[limit]) {
+    for (int i = 0; i < limit; ++i) {
+      slots[i] = -1;
+    }
+  }
+
+  /// Returns the slot of the thread with deque `id`, giving it one if it does
+  /// not have one, or -1 if all slots are taken.
+  int claimSlot(int id) {
+    const int claimed = std::min(numSlots.load(), limit);
+    for (int slot = 0; slot < claimed; ++slot) {
+      if (slots[slot].load() == id) {
+        return slot;
+      }
+    }
+    const int slot = numSlots.fetch_add(1);
+    if (slot >= limit) {
+      return -1;
+    }
+    slots[slot] = id;
+    return slot;
+  }
+};
+
+/// A range of the iterations of a job.
+struct Task {
+  Job* job;
+  int64_t begin;
+  int64_t end;
+};
+
+/// The tasks of a thread. The thread pushes and pops tasks at the back, and
+/// other threads steal them from the front, where the largest ranges are.
+struct Deque {
+  mutex lock;
+  deque<Task> tasks;
+
+  void push(Task task) {
+    lock_guard<mutex> guard(lock);
+    tasks.push_back(task);
+  }
+
+  /// Pops the newest task if it is a task of `job`, or of any job if `job` is
+  /// null.
+  bool pop(Job* job, Task* task) {
+    lock_guard<mutex> guard(lock);
+    if (tasks.empty() || (job != nullptr && tasks.back().job != job)) {
+      return false;
+    }
+    *task = tasks.back();
+    tasks.pop_back();
+    return true;
+  }
+
+  /// Steals the oldest task of `job`, or of any job if `job` is null, that the
+  /// thread with deque `id` can be given a slot in.
+  bool steal(int id, Job* job, Task* task, int* slot) {
+    lock_guard<mutex> guard(lock);
+    for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+      if (job != nullptr && it->job != job) {
+        continue;
+      }
+      *slot = it->job->claimSlot(id);
+      if (*slot < 0) {
+        continue;
+      }
+      *task = *it;
+      tasks.erase(it);
+      return true;
+    }
+    return false;
+  }
+};
+
+/// The pool of worker threads and the deques of all threads. It is never
+/// destroyed, since workers may still run when the process exits.
+struct Runtime {
+  atomic<Deque*> deques[maxDeques];
+  atomic<int> numDeques{0};
+  atomic<int> numWorkers{0};
+
+  mutex lock;
+  condition_variable wake;
+  vector<int> freeDeques;
+  atomic<int> numSleeping{0};
+  atomic<uint64_t> epoch{0};
+
+  /// Returns an unused deque, or -1 if all of them are used.
+  int acquireDeque() {
+    lock_guard<mutex> guard(lock);
+    if (!freeDeques.empty()) {
+      const int id = freeDeques.back();
+      freeDeques.pop_back();
+      return id;
+    }
+    const int id = numDeques.load();
+    if (id == maxDeques) {
+      return -1;
+    }
+    deques[id] = new Deque;
+    numDeques = id + 1;
+    return id;
+  }
+
+  void releaseDeque(int id) {
+    lock_guard<mutex> guard(lock);
+    freeDeques.push_back(id);
+  }
+
+  /// Wakes a sleeping worker to steal a task that was just pushed.
+  void notify() {
+    epoch.fetch_add(1);
+    if (numSleeping.load() > 0) {
+      lock_guard<mutex> guard(lock);
+      wake.notify_one();
+    }
+  }
+
+  /// Starts workers until there are `count` of them.
+  void startWorkers(int count) {
+    count = std::min(count, maxWorkers);
+    while (numWorkers.load() < count) {
+      lock_guard<mutex> guard(lock);
+      if (numWorkers.load() >= count) {
+        break;
+      }
+      numWorkers.fetch_add(1);
+      thread(&Runtime::work, this).detach();
+    }
+  }
+
+  void work();
+};
+
+Runtime& getRuntime() {
+  static Runtime* runtime = new Runtime;
+  return *runtime;
+}
+
+/// The deque of a thread and the job that it runs.
+struct ThreadState {
+  int id = -1;
+  bool hasDeque = false;
+  Job* job = nullptr;
+  int slot = 0;
+  int limit = 0;
+
+  ~ThreadState() {
+    if (id >= 0) {
+      getRuntime().releaseDeque(id);
+    }
+  }
+
+  /// Returns the deque of the thread, or -1 if it cannot have one.
+  int getDeque() {
+    if (!hasDeque) {
+      hasDeque = true;
+      id = getRuntime().acquireDeque();
+    }
+    return id;
+  }
+};
+
+thread_local ThreadState state;
+
+int getLimit() {
+  if (state.job != nullptr) {
+    return state.job->limit;
+  }
+  if (state.limit > 0) {
+    return std::min(state.limit, maxWorkers + 1);
+  }
+  return std::min((int)std::max(thread::hardware_concurrency(), 1u),
+                  maxWorkers + 1);
+}
+
+/// Runs a task in the given slot of its job, pushing the upper halves of its
+/// range for other threads to steal until the range is at most a grain.
+void run(Task task, int slot) {
+  Runtime& runtime = getRuntime();
+  Job* job = task.job;
+  Job* outerJob = state.job;
+  const int outerSlot = state.slot;
+  state.job = job;
+  state.slot = slot;
+
+  while (task.end - task.begin > job->grain) {
+    const int64_t middle = task.begin + (task.end - task.begin) / 2;
+    runtime.deques[state.id].load()->push({job, middle, task.end});
+    runtime.notify();
+    task.end = middle;
+  }
+  job->body(job->ctx, task.begin, task.end);
+
+  state.job = outerJob;
+  state.slot = outerSlot;
+  job->remaining.fetch_sub(task.end - task.begin);
+}
+
+/// Runs one task of the thread's own deque or one that it steals from another
+/// thread, and returns whether there was one. Threads that wait for a loop only
+/// run tasks of that loop (passed as `job`), since a thread that ran another
+/// iteration of an enclosing loop in the same slot would share its per-thread
+/// workspaces with the iteration that waits.
+bool runTask(Job* job) {
+  Runtime& runtime = getRuntime();
+  const int id = state.id;
+  Task task;
+  if (runtime.deques[id].load()->pop(job, &task)) {
+    run(task, task.job->claimSlot(id));
+    return true;
+  }
+
+  const int numDeques = runtime.numDeques.load();
+  for (int i = 1; i < numDeques; ++i) {
+    const int victim = (id + i) % numDeques;
+    int slot;
+    if (runtime.deques[victim].load()->steal(id, job, &task, &slot)) {
+      run(task, slot);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Runtime::work() {
+  if (state.getDeque() < 0) {
+    numWorkers.fetch_sub(1);
+    return;
+  }
+  while (true) {
+    const uint64_t seen = epoch.load();
+    if (runTask(nullptr)) {
+      continue;
+    }
+    unique_lock<mutex> guard(lock);
+    numSleeping.fetch_add(1);
+    wake.wait(guard, [&]() { return epoch.load() != seen; });
+    numSleeping.fetch_sub(1);
+  }
+}
+
+}
+}
+
+using namespace taco;
+
+void taco_parallel_for(int64_t begin, int64_t end, int64_t grain,
+                       taco_parallel_body_t body, void* ctx) {
+  if (begin >= end) {
+    return;
+  }
+  const int64_t iterations = end - begin;
+  const int limit = getLimit();
+  if (grain <= 0) {
+    grain = std::max(iterations / (8 * (int64_t)limit), (int64_t)1);
+  }
+
+  Job job(body, ctx, grain, limit, iterations);
+  if (limit == 1 || iterations <= grain || state.getDeque() < 0) {
+    Job* outerJob = state.job;
+    const int outerSlot = state.slot;
+    state.job = &job;
+    state.slot = 0;
+    body(ctx, begin, end);
+    state.job = outerJob;
+    state.slot = outerSlot;
+    return;
+  }
+
+  Runtime& runtime = getRuntime();
+  runtime.startWorkers(limit - 1);
+  run({&job, begin, end}, job.claimSlot(state.id));
+
+  // Help with the tasks of the loop that are left
+  while (job.remaining.load() > 0) {
+    if (!runTask(&job)) {
+      this_thread::yield();
+    }
+  }
+}
+
+int taco_parallel_thread_num(void) {
+  return (state.job != nullptr) ? state.slot : 0;
+}
+
+int taco_parallel_max_threads(void) {
+  return getLimit();
+}
+
+int taco_parallel_set_thread_limit(int limit) {
+  const int previous = state.limit;
+  state.limit = limit;
+  return previous;
+}
+
+int taco_parallel_get_thread_limit(void) {
+  return state.limit;
+}
@@ -0,0 +1,95 @@
+#include "taco/storage/coordinate_buffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "taco/util/parallel.h"
+
+using namespace std;
+
+namespace taco {
+
+// Smallest number of components per thread for copying components into the
+// buffer to be split across threads
+static const size_t copyGrain = (size_t)1 << 16;
+
+CoordinateBuffer::CoordinateBuffer(int order, Datatype type)
+    : order(order), type(type), numComponents(0), capacity(0),
+      columns(order, nullptr), values(nullptr) {
+}
+
+CoordinateBuffer::~CoordinateBuffer() {
+  clear();
+}
+
+static void* grow(void* data, size_t size) {
+  void* grown = realloc(data, std::max(size, (size_t)1));
+  taco_uassert(grown != nullptr) << "Out of memory inserting components";
+  return grown;
+}
+
+void CoordinateBuffer::reserve(size_t capacity) {
+  if (capacity <= this->capacity) {
+    return;
+  }
+  for (auto& column : columns) {
+    column = (int*)grow(column, capacity * sizeof(int));
+  }
+  values = (char*)grow(values, capacity * type.getNumBytes());
+  this->capacity = capacity;
+}
+
+void CoordinateBuffer::push(const int* coordinates, const void* values,
+                            size_t numComponents) {
+  const size_t used = this->numComponents;
+  if (used + numComponents > capacity) {
+    reserve(std::max(used + numComponents, 2 * capacity));
+  }
+  const size_t csize = type.getNumBytes();
+  util::parallelFor(numComponents, util::getNumWorkers(numComponents, copyGrain),
+                    [&](size_t, size_t begin, size_t end) {
+    for (int i = 0; i < order; ++i) {
+      int* column = columns[i] + used;
+      for (size_t j = begin; j < end; ++j) {
+        column[j] = coordinates[j * order + i];
+      }
+    }
+    memcpy(this->values + (used + begin) * csize,
+           (const char*)values + begin * csize, (end - begin) * csize);
+  });
+  this->numComponents += numComponents;
+}
+
+void CoordinateBuffer::push(const std::vector<const int*>& coordinates,
+                            const void* values, size_t numComponents) {
+  taco_iassert(coordinates.size() == (size_t)order);
+  const size_t used = this->numComponents;
+  if (used + numComponents > capacity) {
+    reserve(std::max(used + numComponents, 2 * capacity));
+  }
+  const size_t csize = type.getNumBytes();
+  util::parallelFor(numComponents, util::getNumWorkers(numComponents, copyGrain),
+                    [&](size_t, size_t begin, size_t end) {
+    for (int i = 0; i < order; ++i) {
+      memcpy(columns[i] + used + begin, coordinates[i] + begin,
+             (end - begin) * sizeof(int));
+    }
+    memcpy(this->values + (used + begin) * csize,
+           (const char*)values + begin * csize, (end - begin) * csize);
+  });
+  this->numComponents += numComponents;
+}
+
+void CoordinateBuffer::clear() {
+  for (auto& column : columns) {
+    free(column);
+    column = nullptr;
+  }
+  free(values);
+  values = nullptr;
+  numComponents = 0;
+  capacity = 0;
+}
+
+}
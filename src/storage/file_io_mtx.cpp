@@ -5,6 +5,10 @@
 #include <sstream>
 #include <cstdlib>
 #include <climits>
+#include <algorithm>
+#include <complex>
+#include <iterator>
+#include <vector>
 
 #include "taco/tensor.h"
 #include "taco/format.h"
@@ -12,222 +16,505 @@
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/files.h"
+#include "taco/util/parallel.h"
+#include "taco/storage/pack.h"
+#include "text_parsing.h"
 
 using namespace std;
 
 namespace taco {
 
-template <typename T>
-TensorBase dispatchReadMTX(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readMTX(file, format, pack);
-  file.close();
-  return tensor;
+namespace {
+/// The qualifiers on the header line of a MatrixMarket file
+struct MTXHeader {
+  std::string object;    // matrix or tensor
+  std::string format;    // coordinate or array
+  std::string field;     // real, integer, complex or pattern
+  std::string symmetry;  // general, symmetric, skew-symmetric or hermitian
+};
 }
 
-TensorBase readMTX(std::string filename, const ModeFormat& modetype, bool pack) {
-  return dispatchReadMTX(filename, modetype, pack);
+// Smallest number of entries per thread for sorting the entries of an outer
+// coordinate to be split across threads
+static const size_t sortGrain = (size_t)1 << 16;
+
+static const char* parseValue(const char* pos, const char* end, double* value) {
+  return parseDouble(pos, end, value);
 }
 
-TensorBase readMTX(std::string filename, const Format& format, bool pack) {
-  return dispatchReadMTX(filename, format, pack);
+static const char* parseValue(const char* pos, const char* end,
+                              std::complex<double>* value) {
+  double real, imag;
+  pos = parseDouble(pos, end, &real);
+  pos = parseDouble(pos, end, &imag);
+  *value = std::complex<double>(real, imag);
+  return pos;
 }
 
-template <typename T>
-TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
-  string line;
-  if (!std::getline(stream, line)) {
-    return TensorBase();
+/// Returns the value of the entry that mirrors an entry with the given value
+/// in a symmetric, skew-symmetric or hermitian matrix.
+static double mirror(double value, const MTXHeader& header) {
+  return (header.symmetry == "skew-symmetric") ? -value : value;
+}
+
+static std::complex<double> mirror(std::complex<double> value,
+                                   const MTXHeader& header) {
+  if (header.symmetry == "hermitian") {
+    return std::conj(value);
   }
+  return (header.symmetry == "skew-symmetric") ? -value : value;
+}
 
-  // Read Header
-  std::stringstream lineStream(line);
-  string head, type, formats, field, symmetry;
-  lineStream >> head >> type >> formats >> field >> symmetry;
-  taco_uassert(head=="%%MatrixMarket") << "Unknown header of MatrixMarket";
-  // type = [matrix tensor]
-  taco_uassert((type=="matrix") || (type=="tensor"))
-                                       << "Unknown type of MatrixMarket";
-  // formats = [coordinate array]
-  // field = [real integer complex pattern]
-  taco_uassert(field=="real")          << "MatrixMarket field not available";
-  // symmetry = [general symmetric skew-symmetric Hermitian]
-  taco_uassert((symmetry=="general") || (symmetry=="symmetric"))
-                                       << "MatrixMarket symmetry not available";
+/// Returns the first line at or after `pos` that is not a comment or blank.
+static const char* skipComments(const char* pos, const char* end) {
+  while (pos < end && !isDataLine(pos, end, '%')) {
+    pos = nextLine(pos, end);
+  }
+  return pos;
+}
 
-  bool symm = (symmetry=="symmetric");
+/// Parse the line with the dimensions (and for coordinate files the number
+/// of entries) that follows the comments at the top of a MatrixMarket file.
+static vector<int> parseSizeLine(const char* line, const char* end) {
+  taco_uassert(line < end) << "MatrixMarket file has no size line";
+  vector<int> sizes(countTokens(line, end));
+  const char* pos = line;
+  for (auto& size : sizes) {
+    long value;
+    pos = parseInt(pos, end, &value);
+    taco_uassert(value >= 0) << "Dimension is negative";
+    size = (int)value;
+  }
+  return sizes;
+}
 
-  TensorBase tensor;
-  if (formats=="coordinate")
-    tensor = readSparse(stream,format,symm);
-  else if (formats=="array")
-    tensor = readDense(stream,format,symm);
-  else
-    taco_uerror << "MatrixMarket format not available";
+/// Parse at most `maxEntries` data lines in [begin, end) in line-aligned
+/// chunks in parallel, and return how many were parsed. Any lines after those
+/// are ignored, as the size line determines the size of the tensor. `resize`
+/// is called with the number of entries before they are parsed, and
+/// `parseLine` with the start of every data line and its index.
+template <typename R, typename F>
+static size_t parseDataLines(const char* begin, const char* end,
+                             size_t maxEntries, R resize, F parseLine) {
+  const size_t numWorkers = util::getNumWorkers(end - begin, parseGrain);
+  const vector<const char*> chunks = splitLines(begin, end, numWorkers);
+  const vector<size_t> offsets = countDataLines(chunks, end, '%');
+  const size_t numEntries = std::min(offsets[numWorkers], maxEntries);
+  resize(numEntries);
+  util::parallelFor(numWorkers, numWorkers, [&](size_t worker, size_t, size_t) {
+    size_t i = offsets[worker];
+    for (const char* line = chunks[worker];
+         line < chunks[worker + 1] && i < numEntries;
+         line = nextLine(line, end)) {
+      if (isDataLine(line, end, '%')) {
+        parseLine(line, i++);
+      }
+    }
+  });
+  return numEntries;
+}
 
-  if (pack) {
-    tensor.pack();
+/// Parse the size line of a coordinate MatrixMarket file, which holds the
+/// dimensions followed by the number of entries.
+static vector<int> parseCoordinateSizeLine(const char* sizeLine,
+                                           const char* end,
+                                           const MTXHeader& header,
+                                           size_t* numEntries) {
+  vector<int> dimensions = parseSizeLine(sizeLine, end);
+  taco_uassert(dimensions.size() >= 2)
+      << "Expected dimensions and number of entries in MatrixMarket file";
+  *numEntries = dimensions.back();
+  dimensions.pop_back();
+  if (header.symmetry != "general") {
+    taco_uassert(dimensions.size() == 2 && dimensions[0] == dimensions[1])
+        << "Symmetry only available for square matrices";
   }
-
-  return tensor;
+  return dimensions;
 }
 
-TensorBase readMTX(std::istream& stream, const ModeFormat& modetype, bool pack) {
-  return dispatchReadMTX(stream, modetype, pack);
+/// Parse the entries of a coordinate MatrixMarket file in [begin, end), which
+/// starts at a line, into coordinates and values. At most `maxEntries` entries
+/// are parsed, and the number of entries parsed is returned.
+template <typename V>
+static size_t parseEntries(const char* begin, const char* end,
+                           size_t maxEntries, const MTXHeader& header,
+                           const vector<int>& dimensions,
+                           vector<int>& coordinates, vector<V>& values) {
+  const size_t order = dimensions.size();
+  const bool isPattern = (header.field == "pattern");
+  return parseDataLines(begin, end, maxEntries, [&](size_t numEntries) {
+    coordinates.resize(numEntries * order);
+    values.resize(numEntries);
+  }, [&](const char* pos, size_t i) {
+    for (size_t j = 0; j < order; j++) {
+      long idx;
+      pos = parseInt(pos, end, &idx);
+      taco_uassert(idx >= 1 && idx <= dimensions[j])
+          << "Coordinate " << idx << " is out of bounds";
+      coordinates[i*order + j] = (int)idx - 1;
+    }
+    if (isPattern) {
+      values[i] = 1;
+    } else {
+      parseValue(pos, end, &values[i]);
+    }
+  });
 }
 
-TensorBase readMTX(std::istream& stream, const Format& format, bool pack) {
-  return dispatchReadMTX(stream, format, pack);
+/// Append the entries that mirror the off-diagonal entries of a symmetric,
+/// skew-symmetric or hermitian matrix.
+template <typename V>
+static void appendMirrored(vector<int>& coordinates, vector<V>& values,
+                           const MTXHeader& header) {
+  if (header.symmetry == "general") {
+    return;
+  }
+  const size_t numEntries = values.size();
+  for (size_t i = 0; i < numEntries; i++) {
+    if (coordinates[2*i] != coordinates[2*i + 1]) {
+      coordinates.push_back(coordinates[2*i + 1]);
+      coordinates.push_back(coordinates[2*i]);
+      values.push_back(mirror(values[i], header));
+    }
+  }
 }
 
-template <typename T>
-TensorBase dispatchReadSparse(std::istream& stream, const T& format, 
-                              bool symm) {
-  string line;
-  std::getline(stream,line);
-
-  // Skip comments at the top of the file
-  string token;
-  do {
-    std::stringstream lineStream(line);
-    lineStream >> token;
-    if (token[0] != '%') {
-      break;
+/// Pack the entries of a matrix straight into the tensor's storage. The
+/// entries are placed in one segment per coordinate of the outer storage
+/// mode with a counting sort, adding the mirrored entries of symmetric
+/// matrices as they are placed, so only the entries of each segment need to
+/// be sorted (which they already are in the common case of a file whose
+/// entries are ordered by the outer mode).
+template <typename V>
+static void packMatrix(TensorBase& tensor, const vector<int>& coordinates,
+                       const vector<V>& values, const MTXHeader& header) {
+  const bool isSymmetric = (header.symmetry != "general");
+  const vector<int> ordering = tensor.getFormat().getModeOrdering();
+  const int outerMode = ordering[0];
+  const int innerMode = ordering[1];
+  const size_t numSegments = tensor.getDimension(outerMode);
+  const size_t numEntries = values.size();
+
+  vector<size_t> segments(numSegments + 1, 0);
+  for (size_t i = 0; i < numEntries; ++i) {
+    const int outer = coordinates[2*i + outerMode];
+    const int inner = coordinates[2*i + innerMode];
+    segments[outer + 1]++;
+    if (isSymmetric && outer != inner) {
+      segments[inner + 1]++;
+    }
+  }
+  for (size_t i = 0; i < numSegments; ++i) {
+    segments[i + 1] += segments[i];
+  }
+  const size_t numCoordinates = segments[numSegments];
+
+  vector<int> outerCoordinates(numCoordinates);
+  vector<int> innerCoordinates(numCoordinates);
+  vector<V> sortedValues(numCoordinates);
+  vector<size_t> next(segments.begin(), segments.end() - 1);
+  for (size_t i = 0; i < numEntries; ++i) {
+    const int outer = coordinates[2*i + outerMode];
+    const int inner = coordinates[2*i + innerMode];
+    size_t k = next[outer]++;
+    innerCoordinates[k] = inner;
+    sortedValues[k] = values[i];
+    if (isSymmetric && outer != inner) {
+      k = next[inner]++;
+      innerCoordinates[k] = outer;
+      sortedValues[k] = mirror(values[i], header);
     }
-  } while (std::getline(stream, line));
-
-  // The first non-comment line is the header with dimensions
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
   }
-  size_t nnz = dimensions[dimensions.size()-1];
-  dimensions.pop_back();
-  if (symm)
-    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
 
-  vector<int> coordinates;
-  vector<double> values;
-  coordinates.reserve(nnz*dimensions.size());
-  values.reserve(nnz);
-
-  while (std::getline(stream, line)) {
-    linePtr = (char*)line.data();
-    for (size_t i=0; i < dimensions.size(); i++) {
-      long index = strtol(linePtr, &linePtr, 10);
-      taco_uassert(index <= INT_MAX) << "Index exceeds INT_MAX";
-      coordinates.push_back(static_cast<int>(index));
+  const size_t numWorkers = util::getNumWorkers(numCoordinates, sortGrain);
+  util::parallelFor(numSegments, numWorkers,
+                    [&](size_t, size_t begin, size_t end) {
+    vector<pair<int,V>> entries;
+    for (size_t segment = begin; segment < end; ++segment) {
+      const size_t first = segments[segment];
+      const size_t last = segments[segment + 1];
+      std::fill(outerCoordinates.data() + first, outerCoordinates.data() + last,
+                (int)segment);
+      if (std::is_sorted(innerCoordinates.data() + first,
+                         innerCoordinates.data() + last)) {
+        continue;
+      }
+      entries.clear();
+      for (size_t k = first; k < last; ++k) {
+        entries.push_back({innerCoordinates[k], sortedValues[k]});
+      }
+      std::sort(entries.begin(), entries.end(),
+                [](const pair<int,V>& a, const pair<int,V>& b) {
+                  return a.first < b.first;
+                });
+      for (size_t k = first; k < last; ++k) {
+        innerCoordinates[k] = entries[k - first].first;
+        sortedValues[k] = entries[k - first].second;
+      }
     }
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
+  });
+
+  packSorted(tensor.getStorage(),
+             {outerCoordinates.data(), innerCoordinates.data()},
+             sortedValues.data(), numCoordinates);
+  tensor.setStorage(tensor.getStorage());
+}
+
+/// Read the entries of a coordinate MatrixMarket file that follow its header
+/// line. Matrices in formats that can be packed without generating code are
+/// packed directly; other tensors are inserted and then packed.
+template <typename V, typename T>
+static TensorBase parseSparse(const char* begin, const char* end,
+                              const MTXHeader& header, const T& format,
+                              bool pack) {
+  const char* sizeLine = skipComments(begin, end);
+  size_t nnz;
+  const vector<int> dimensions = parseCoordinateSizeLine(sizeLine, end, header,
+                                                         &nnz);
+  vector<int> coordinates;
+  vector<V> values;
+  const size_t numEntries = parseEntries(nextLine(sizeLine, end), end, nnz,
+                                         header, dimensions, coordinates,
+                                         values);
+  taco_uassert(numEntries == nnz)
+      << "MatrixMarket file has " << numEntries << " entries, but its size "
+      << "line says it has " << nnz;
+
+  TensorBase tensor(type<V>(), dimensions, format);
+  if (pack && dimensions.size() == 2 && canPackSorted(tensor.getFormat())) {
+    packMatrix(tensor, coordinates, values, header);
+    return tensor;
   }
 
-  // Create matrix
-  TensorBase tensor(type<double>(), dimensions, format);
-  if (symm)
-    tensor.reserve(2*nnz);
-  else
-    tensor.reserve(nnz);
-
-  // Insert coordinates
-  std::vector<int> coord;
-  for (size_t i = 0; i < nnz; i++) {
-    coord.clear();
-    for (size_t mode = 0; mode < dimensions.size(); mode++) {
-      coord.push_back(coordinates[i*dimensions.size() + mode] -1);
+  appendMirrored(coordinates, values, header);
+  tensor.insert(coordinates.data(), values.data(), values.size());
+  if (pack) {
+    tensor.pack();
+  }
+  return tensor;
+}
+
+/// Read the values of an array MatrixMarket file that follow its header line.
+/// The values are listed in column-major order, and for symmetric matrices
+/// only the lower triangle is listed.
+template <typename V, typename T>
+static TensorBase parseDense(const char* begin, const char* end,
+                             const MTXHeader& header, const T& format,
+                             bool pack) {
+  const char* sizeLine = skipComments(begin, end);
+  vector<int> dimensions = parseSizeLine(sizeLine, end);
+  const size_t order = dimensions.size();
+  const bool isSymmetric = (header.symmetry != "general");
+  const bool isSkew = (header.symmetry == "skew-symmetric");
+  size_t numValues = 1;
+  for (int dimension : dimensions) {
+    numValues *= dimension;
+  }
+  if (isSymmetric) {
+    taco_uassert(order == 2 && dimensions[0] == dimensions[1])
+        << "Symmetry only available for square matrices";
+    const size_t n = dimensions[0];
+    numValues = isSkew ? n * (n - 1) / 2 : n * (n + 1) / 2;
+  }
+
+  vector<V> values;
+  const size_t numParsed = parseDataLines(nextLine(sizeLine, end), end,
+                                          numValues, [&](size_t numEntries) {
+    values.resize(numEntries);
+  }, [&](const char* pos, size_t i) {
+    parseValue(pos, end, &values[i]);
+  });
+  taco_uassert(numParsed == numValues)
+      << "MatrixMarket file has " << numParsed << " values, but its size "
+      << "line says it has " << numValues;
+
+  vector<int> coordinates;
+  if (isSymmetric) {
+    const int n = dimensions[0];
+    vector<V> expanded;
+    size_t k = 0;
+    for (int j = 0; j < n; ++j) {
+      for (int i = isSkew ? j + 1 : j; i < n; ++i, ++k) {
+        coordinates.push_back(i);
+        coordinates.push_back(j);
+        expanded.push_back(values[k]);
+        if (i != j) {
+          coordinates.push_back(j);
+          coordinates.push_back(i);
+          expanded.push_back(mirror(values[k], header));
+        }
+      }
     }
-    tensor.insert(coord, values[i]);
-    if (symm && coord.front() != coord.back()) {
-      std::reverse(coord.begin(), coord.end());
-      tensor.insert(coord, values[i]);
+    values.swap(expanded);
+  } else {
+    coordinates.resize(numValues * order);
+    for (size_t n = 0; n < numValues; n++) {
+      size_t index = n;
+      for (size_t mode = 0; mode < order; mode++) {
+        coordinates[n*order + mode] = index % dimensions[mode];
+        index /= dimensions[mode];
+      }
     }
   }
 
+  TensorBase tensor(type<V>(), dimensions, format);
+  tensor.insert(coordinates.data(), values.data(), values.size());
+  if (pack) {
+    tensor.pack();
+  }
   return tensor;
 }
 
-TensorBase readSparse(std::istream& stream, const ModeFormat& modetype, 
-                      bool symm) {
-  return dispatchReadSparse(stream, modetype, symm);
+template <typename V, typename T>
+static TensorBase parseBody(const char* begin, const char* end,
+                            const MTXHeader& header, const T& format,
+                            bool pack) {
+  if (header.format == "coordinate") {
+    return parseSparse<V>(begin, end, header, format, pack);
+  }
+  taco_uassert(header.format == "array")
+      << "MatrixMarket format not available";
+  taco_uassert(header.field != "pattern")
+      << "MatrixMarket array files cannot have the pattern field";
+  return parseDense<V>(begin, end, header, format, pack);
 }
 
-TensorBase readSparse(std::istream& stream, const Format& format, bool symm) {
-  return dispatchReadSparse(stream, format, symm);
+/// Parse the header line of a MatrixMarket file and return the line after it.
+static const char* parseHeader(const char* begin, const char* end,
+                               MTXHeader* header) {
+  const char* body = nextLine(begin, end);
+  std::stringstream lineStream(string(begin, body));
+  string head;
+  lineStream >> head >> header->object >> header->format >> header->field
+             >> header->symmetry;
+  for (string* qualifier : {&header->object, &header->format, &header->field,
+                            &header->symmetry}) {
+    std::transform(qualifier->begin(), qualifier->end(), qualifier->begin(),
+                   ::tolower);
+  }
+  taco_uassert(head=="%%MatrixMarket") << "Unknown header of MatrixMarket";
+  // object = [matrix tensor]
+  taco_uassert((header->object=="matrix") || (header->object=="tensor"))
+                                       << "Unknown type of MatrixMarket";
+  // field = [real integer complex pattern]
+  taco_uassert((header->field=="real") || (header->field=="integer") ||
+               (header->field=="complex") || (header->field=="pattern"))
+                                       << "MatrixMarket field not available";
+  // symmetry = [general symmetric skew-symmetric hermitian]
+  taco_uassert((header->symmetry=="general") ||
+               (header->symmetry=="symmetric") ||
+               (header->symmetry=="skew-symmetric") ||
+               (header->symmetry=="hermitian" && header->field=="complex"))
+                                       << "MatrixMarket symmetry not available";
+  return body;
 }
 
+/// Read an mtx tensor from the text in [begin, end). The entries are parsed
+/// in parallel in line-aligned chunks.
 template <typename T>
-TensorBase dispatchReadDense(std::istream& stream, const T& format, bool symm) {
-  string line;
-  std::getline(stream,line);
-
-  // Skip comments at the top of the file
-  string token;
-  do {
-    std::stringstream lineStream(line);
-    lineStream >> token;
-    if (token[0] != '%') {
-      break;
-    }
-  } while (std::getline(stream, line));
-
-  // The first non-comment line is the header with dimension sizes
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
+static TensorBase parseMTX(const char* begin, const char* end, const T& format,
+                           bool pack) {
+  if (begin == end) {
+    return TensorBase();
   }
-  if (symm)
-    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
 
-  vector<double> values;
-  auto size = std::accumulate(begin(dimensions), end(dimensions),
-                              1, std::multiplies<double>());
-  values.reserve(size);
-
-  while (std::getline(stream, line)) {
-    linePtr = (char*)line.data();
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
+  MTXHeader header;
+  const char* body = parseHeader(begin, end, &header);
+  if (header.field == "complex") {
+    return parseBody<std::complex<double>>(body, end, header, format, pack);
   }
+  return parseBody<double>(body, end, header, format, pack);
+}
 
-  // Create matrix
-  TensorBase tensor(type<double>(), dimensions, format);
-  if (symm)
-    tensor.reserve(2*size);
-  else
-    tensor.reserve(size);
-
-  // Insert coordinates
-  std::vector<int> coord;
-  for (auto n = 0; n<size; n++) {
-    coord.clear();
-    auto index=n;
-    for (size_t mode = 0; mode < dimensions.size()-1; mode++) {
-      coord.push_back(index%dimensions[mode]);
-      index=index/dimensions[mode];
-    }
-    coord.push_back(index);
-    tensor.insert(coord, values[n]);
-    if (symm && coord.front() != coord.back()) {
-      std::reverse(coord.begin(), coord.end());
-      tensor.insert(coord, values[n]);
-    }
+vector<int> readMTXBatches(const char* begin, const char* end,
+                           size_t batchBytes, const ComponentBatchFn& f) {
+  taco_iassert(batchBytes > 0);
+  taco_uassert(begin < end) << "Empty MatrixMarket file";
+  MTXHeader header;
+  const char* body = parseHeader(begin, end, &header);
+  taco_uassert(header.format == "coordinate" && header.field != "complex")
+      << "Only real coordinate MatrixMarket files can be read in batches";
+
+  const char* sizeLine = skipComments(body, end);
+  size_t nnz;
+  const vector<int> dimensions = parseCoordinateSizeLine(sizeLine, end, header,
+                                                         &nnz);
+  vector<int> coordinates;
+  vector<double> values;
+  size_t numEntries = 0;
+  const char* batch = nextLine(sizeLine, end);
+  while (batch < end && numEntries < nnz) {
+    const size_t numBytes = std::min(batchBytes, (size_t)(end - batch));
+    const char* batchEnd = nextLine(batch + numBytes - 1, end);
+    numEntries += parseEntries(batch, batchEnd, nnz - numEntries, header,
+                               dimensions, coordinates, values);
+    appendMirrored(coordinates, values, header);
+    f(dimensions.size(), coordinates, values);
+    batch = batchEnd;
   }
+  taco_uassert(numEntries == nnz)
+      << "MatrixMarket file has " << numEntries << " entries, but its size "
+      << "line says it has " << nnz;
+  return dimensions;
+}
 
-  return tensor;
+template <typename T>
+TensorBase dispatchReadMTX(std::string filename, const T& format, bool pack) {
+  util::MappedFile file(filename);
+  return parseMTX(file.getData(), file.getData() + file.getSize(), format,
+                  pack);
+}
+
+TensorBase readMTX(std::string filename, const ModeFormat& modetype, bool pack) {
+  return dispatchReadMTX(filename, modetype, pack);
+}
+
+TensorBase readMTX(std::string filename, const Format& format, bool pack) {
+  return dispatchReadMTX(filename, format, pack);
+}
+
+template <typename T>
+TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
+  const std::string text((std::istreambuf_iterator<char>(stream)),
+                         std::istreambuf_iterator<char>());
+  return parseMTX(text.data(), text.data() + text.size(), format, pack);
+}
+
+TensorBase readMTX(std::istream& stream, const ModeFormat& modetype, bool pack) {
+  return dispatchReadMTX(stream, modetype, pack);
+}
+
+TensorBase readMTX(std::istream& stream, const Format& format, bool pack) {
+  return dispatchReadMTX(stream, format, pack);
+}
+
+template <typename T>
+TensorBase dispatchReadBody(std::istream& stream, const T& format,
+                            const std::string& layout, bool symm) {
+  const std::string text((std::istreambuf_iterator<char>(stream)),
+                         std::istreambuf_iterator<char>());
+  const MTXHeader header = {"matrix", layout, "real",
+                            symm ? "symmetric" : "general"};
+  return parseBody<double>(text.data(), text.data() + text.size(), header,
+                           format, false);
+}
+
+TensorBase readSparse(std::istream& stream, const ModeFormat& modetype, 
+                      bool symm) {
+  return dispatchReadBody(stream, modetype, "coordinate", symm);
+}
+
+TensorBase readSparse(std::istream& stream, const Format& format, bool symm) {
+  return dispatchReadBody(stream, format, "coordinate", symm);
 }
 
 TensorBase readDense(std::istream& stream, const ModeFormat& modetype, 
                      bool symm) {
-  return dispatchReadDense(stream, modetype, symm);
+  return dispatchReadBody(stream, modetype, "array", symm);
 }
 
 TensorBase readDense(std::istream& stream, const Format& format, bool symm) {
-  return dispatchReadDense(stream, format, symm);
+  return dispatchReadBody(stream, format, "array", symm);
 }
 
 void writeMTX(std::string filename, const TensorBase& tensor) {
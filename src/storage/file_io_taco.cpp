@@ -0,0 +1,848 @@
+#include "taco/storage/file_io_taco.h"
+
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "taco/tensor.h"
+#include "taco/format.h"
+#include "taco/error.h"
+#include "taco/storage/storage.h"
+#include "taco/storage/index.h"
+#include "taco/storage/array.h"
+#include "taco/storage/pack.h"
+#include "taco/util/files.h"
+#include "taco/util/radix_sort.h"
+#include "taco/util/uncopyable.h"
+#include "text_parsing.h"
+
+using namespace std;
+
+namespace taco {
+
+// A .taco file is stored in native byte order and consists of:
+//
+//   magic number, version, byte order mark, component type, order, whether
+//   the fill value is defined, and the fill value (16 bytes)
+//   for every mode in storage order: mode format, properties, mode ordering
+//   for every mode: dimension
+//   for every mode in storage order: number of level array types, types
+//   number of arrays, and for every array: mode it belongs to (the order for
+//   the values), type, byte offset and number of elements
+//
+// followed by the index arrays of every mode and the values. The arrays start
+// at offsets that are multiples of 64 bytes, so they are as aligned in a
+// memory-mapped file as they would be if they had been allocated.
+
+static const char magic[8] = {'T','A','C','O','B','I','N','\0'};
+static const uint32_t version = 1;
+static const uint32_t byteOrderMark = 0x01020304;
+static const size_t alignment = 64;
+static const size_t fillSize = 16;
+
+enum ModeFormatKind : uint32_t {DenseMode, CompressedMode, SingletonMode};
+enum ModeProperties : uint32_t {OrderedMode = 1, UniqueMode = 2};
+
+static size_t align(size_t offset) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+static void put(vector<char>& buffer, T value) {
+  const char* bytes = (const char*)&value;
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+namespace {
+/// Reads the fields of a .taco file and checks that they are in bounds.
+struct Reader {
+  const char* data;
+  size_t size;
+  size_t offset;
+
+  template <typename T>
+  T get() {
+    T value;
+    taco_uassert(offset + sizeof(T) <= size) << "Truncated .taco file";
+    memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+  }
+};
+}
+
+template <typename T>
+static Literal makeLiteral(const char* bytes) {
+  T value;
+  memcpy(&value, bytes, sizeof(T));
+  return Literal(value);
+}
+
+static Literal makeLiteral(Datatype type, const char* bytes) {
+  switch (type.getKind()) {
+    case Datatype::Bool: return makeLiteral<bool>(bytes);
+    case Datatype::UInt8: return makeLiteral<uint8_t>(bytes);
+    case Datatype::UInt16: return makeLiteral<uint16_t>(bytes);
+    case Datatype::UInt32: return makeLiteral<uint32_t>(bytes);
+    case Datatype::UInt64: return makeLiteral<uint64_t>(bytes);
+    case Datatype::Int8: return makeLiteral<int8_t>(bytes);
+    case Datatype::Int16: return makeLiteral<int16_t>(bytes);
+    case Datatype::Int32: return makeLiteral<int32_t>(bytes);
+    case Datatype::Int64: return makeLiteral<int64_t>(bytes);
+    case Datatype::Float32: return makeLiteral<float>(bytes);
+    case Datatype::Float64: return makeLiteral<double>(bytes);
+    case Datatype::Complex64: return makeLiteral<std::complex<float>>(bytes);
+    case Datatype::Complex128: return makeLiteral<std::complex<double>>(bytes);
+    default:
+      taco_uerror << "Unsupported component type in .taco file: " << type;
+      return Literal();
+  }
+}
+
+/// Read a taco tensor from memory. The tensor's arrays refer to the memory,
+/// which `owner` keeps alive.
+static TensorBase readTACO(char* data, size_t size,
+                           std::shared_ptr<void> owner) {
+  Reader reader = {data, size, 0};
+  char fileMagic[sizeof(magic)];
+  for (size_t i = 0; i < sizeof(magic); ++i) {
+    fileMagic[i] = reader.get<char>();
+  }
+  taco_uassert(memcmp(fileMagic, magic, sizeof(magic)) == 0)
+      << "Not a .taco file";
+  const uint32_t fileVersion = reader.get<uint32_t>();
+  taco_uassert(fileVersion == version)
+      << "Unsupported .taco file version " << fileVersion;
+  taco_uassert(reader.get<uint32_t>() == byteOrderMark)
+      << "The .taco file was written on a machine with another byte order";
+
+  const Datatype componentType((Datatype::Kind)reader.get<uint32_t>());
+  const int order = (int)reader.get<uint32_t>();
+  const bool isFillDefined = reader.get<uint32_t>() != 0;
+  char fill[fillSize];
+  for (size_t i = 0; i < fillSize; ++i) {
+    fill[i] = reader.get<char>();
+  }
+
+  vector<ModeFormatPack> modeFormats;
+  vector<int> modeOrdering(order);
+  for (int i = 0; i < order; ++i) {
+    const uint32_t kind = reader.get<uint32_t>();
+    const uint32_t properties = reader.get<uint32_t>();
+    modeOrdering[i] = (int)reader.get<uint32_t>();
+    vector<ModeFormat::Property> modeProperties = {
+      (properties & OrderedMode) ? ModeFormat::ORDERED
+                                 : ModeFormat::NOT_ORDERED,
+      (properties & UniqueMode) ? ModeFormat::UNIQUE : ModeFormat::NOT_UNIQUE
+    };
+    switch (kind) {
+      case DenseMode:
+        modeFormats.push_back(Dense(modeProperties));
+        break;
+      case CompressedMode:
+        modeFormats.push_back(Compressed(modeProperties));
+        break;
+      case SingletonMode:
+        modeFormats.push_back(Singleton(modeProperties));
+        break;
+      default:
+        taco_uerror << "Unsupported mode format in .taco file";
+    }
+  }
+  vector<int> dimensions(order);
+  for (int i = 0; i < order; ++i) {
+    dimensions[i] = (int)reader.get<uint32_t>();
+  }
+  vector<vector<Datatype>> levelArrayTypes(order);
+  bool hasLevelArrayTypes = false;
+  for (int i = 0; i < order; ++i) {
+    const uint32_t numTypes = reader.get<uint32_t>();
+    for (uint32_t j = 0; j < numTypes; ++j) {
+      levelArrayTypes[i].push_back(Datatype((Datatype::Kind)
+                                            reader.get<uint32_t>()));
+    }
+    hasLevelArrayTypes = hasLevelArrayTypes || numTypes > 0;
+  }
+  Format format(modeFormats, modeOrdering);
+  if (hasLevelArrayTypes) {
+    format.setLevelArrayTypes(levelArrayTypes);
+  }
+
+  vector<vector<Array>> modeArrays(order);
+  Array values;
+  const uint32_t numArrays = reader.get<uint32_t>();
+  for (uint32_t i = 0; i < numArrays; ++i) {
+    const uint32_t mode = reader.get<uint32_t>();
+    const Datatype type((Datatype::Kind)reader.get<uint32_t>());
+    const uint64_t offset = reader.get<uint64_t>();
+    const uint64_t numElements = reader.get<uint64_t>();
+    taco_uassert(mode <= (uint32_t)order && offset % alignment == 0 &&
+                 offset + numElements * type.getNumBytes() <= size)
+        << "Corrupt .taco file";
+    Array array(type, data + offset, numElements, owner);
+    if (mode == (uint32_t)order) {
+      values = array;
+    } else {
+      modeArrays[mode].push_back(array);
+    }
+  }
+
+  TensorBase tensor(componentType, dimensions, format,
+                    isFillDefined ? makeLiteral(componentType, fill)
+                                  : Literal());
+  vector<ModeIndex> modeIndices;
+  for (int i = 0; i < order; ++i) {
+    modeIndices.push_back(ModeIndex(modeArrays[i]));
+  }
+  TensorStorage storage = tensor.getStorage();
+  storage.setIndex(Index(format, modeIndices));
+  storage.setValues(values);
+  tensor.setStorage(storage);
+  return tensor;
+}
+
+template <typename T>
+static void insertComponents(const TensorBase& source, TensorBase& target) {
+  for (auto& component : iterate<T>(source)) {
+    target.insert(component.first.toVector(), component.second);
+  }
+}
+
+/// Returns the tensor in the given format, converting it if it is stored in
+/// another format.
+static TensorBase convert(TensorBase tensor, const Format& format, bool pack) {
+  if (tensor.getFormat() == format) {
+    return tensor;
+  }
+  TensorBase converted(tensor.getComponentType(), tensor.getDimensions(),
+                       format, tensor.getFillValue());
+  switch (tensor.getComponentType().getKind()) {
+    case Datatype::Bool: insertComponents<bool>(tensor, converted); break;
+    case Datatype::UInt8: insertComponents<uint8_t>(tensor, converted); break;
+    case Datatype::UInt16: insertComponents<uint16_t>(tensor, converted); break;
+    case Datatype::UInt32: insertComponents<uint32_t>(tensor, converted); break;
+    case Datatype::UInt64: insertComponents<uint64_t>(tensor, converted); break;
+    case Datatype::Int8: insertComponents<int8_t>(tensor, converted); break;
+    case Datatype::Int16: insertComponents<int16_t>(tensor, converted); break;
+    case Datatype::Int32: insertComponents<int32_t>(tensor, converted); break;
+    case Datatype::Int64: insertComponents<int64_t>(tensor, converted); break;
+    case Datatype::Float32: insertComponents<float>(tensor, converted); break;
+    case Datatype::Float64: insertComponents<double>(tensor, converted); break;
+    case Datatype::Complex64:
+      insertComponents<std::complex<float>>(tensor, converted);
+      break;
+    case Datatype::Complex128:
+      insertComponents<std::complex<double>>(tensor, converted);
+      break;
+    default:
+      taco_not_supported_yet;
+  }
+  if (pack) {
+    converted.pack();
+  }
+  return converted;
+}
+
+static Format getFormat(int order, const ModeFormat& modetype) {
+  return Format(vector<ModeFormatPack>(order, modetype));
+}
+
+TensorBase readTACO(std::string filename) {
+  auto file = std::make_shared<util::MappedFile>(filename, true);
+  return readTACO((char*)file->getData(), file->getSize(), file);
+}
+
+TensorBase readTACO(std::string filename, const ModeFormat& modetype,
+                    bool pack) {
+  TensorBase tensor = readTACO(filename);
+  return convert(tensor, getFormat(tensor.getOrder(), modetype), pack);
+}
+
+TensorBase readTACO(std::string filename, const Format& format, bool pack) {
+  return convert(readTACO(filename), format, pack);
+}
+
+static TensorBase readTACO(std::istream& stream) {
+  const std::string contents((std::istreambuf_iterator<char>(stream)),
+                             std::istreambuf_iterator<char>());
+  void* data = nullptr;
+  taco_uassert(posix_memalign(&data, alignment,
+                              std::max(contents.size(), (size_t)1)) == 0)
+      << "Out of memory reading .taco file";
+  std::shared_ptr<void> buffer(data, free);
+  memcpy(data, contents.data(), contents.size());
+  return readTACO((char*)data, contents.size(), buffer);
+}
+
+TensorBase readTACO(std::istream& stream, const ModeFormat& modetype,
+                    bool pack) {
+  TensorBase tensor = readTACO(stream);
+  return convert(tensor, getFormat(tensor.getOrder(), modetype), pack);
+}
+
+TensorBase readTACO(std::istream& stream, const Format& format, bool pack) {
+  return convert(readTACO(stream), format, pack);
+}
+
+void writeTACO(std::string filename, const TensorBase& tensor) {
+  std::fstream file;
+  util::openStream(file, filename, fstream::out | fstream::binary);
+  writeTACO(file, tensor);
+  file.close();
+}
+
+namespace {
+/// An array that is stored in a .taco file.
+struct ArrayEntry {
+  uint32_t mode;  // The order for the values
+  Datatype type;
+  size_t size;
+};
+}
+
+/// Returns the header of a .taco file, including the table of its arrays.
+static vector<char> makeHeader(Datatype componentType, const Format& format,
+                               const vector<int>& dimensions, Literal fill,
+                               const vector<ArrayEntry>& arrays) {
+  const int order = format.getOrder();
+  vector<char> header(magic, magic + sizeof(magic));
+  put<uint32_t>(header, version);
+  put<uint32_t>(header, byteOrderMark);
+  put<uint32_t>(header, componentType.getKind());
+  put<uint32_t>(header, order);
+  char fillBytes[fillSize] = {0};
+  if (fill.defined()) {
+    memcpy(fillBytes, fill.getValPtr(), fill.getDataType().getNumBytes());
+  }
+  put<uint32_t>(header, fill.defined());
+  header.insert(header.end(), fillBytes, fillBytes + fillSize);
+
+  for (int i = 0; i < order; ++i) {
+    const ModeFormat modeFormat = format.getModeFormats()[i];
+    uint32_t kind = DenseMode;
+    if (modeFormat.getName() == Compressed.getName()) {
+      kind = CompressedMode;
+    } else if (modeFormat.getName() == Singleton.getName()) {
+      kind = SingletonMode;
+    } else {
+      taco_uassert(modeFormat.getName() == Dense.getName())
+          << "The .taco format does not support " << modeFormat.getName()
+          << " modes";
+    }
+    put<uint32_t>(header, kind);
+    const uint32_t properties =
+        (modeFormat.isOrdered() ? (uint32_t)OrderedMode : 0) |
+        (modeFormat.isUnique() ? (uint32_t)UniqueMode : 0);
+    put<uint32_t>(header, properties);
+    put<uint32_t>(header, format.getModeOrdering()[i]);
+  }
+  for (int dimension : dimensions) {
+    put<uint32_t>(header, dimension);
+  }
+  for (int i = 0; i < order; ++i) {
+    const auto& levelArrayTypes = format.getLevelArrayTypes();
+    const size_t numTypes = (size_t)i < levelArrayTypes.size()
+                            ? levelArrayTypes[i].size() : 0;
+    put<uint32_t>(header, numTypes);
+    for (size_t j = 0; j < numTypes; ++j) {
+      put<uint32_t>(header, levelArrayTypes[i][j].getKind());
+    }
+  }
+
+  const size_t arrayEntrySize = 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+  size_t offset = align(header.size() + sizeof(uint32_t) +
+                        arrays.size() * arrayEntrySize);
+  put<uint32_t>(header, arrays.size());
+  for (auto& array : arrays) {
+    put<uint32_t>(header, array.mode);
+    put<uint32_t>(header, array.type.getKind());
+    put<uint64_t>(header, offset);
+    put<uint64_t>(header, array.size);
+    offset = align(offset + array.size * array.type.getNumBytes());
+  }
+  return header;
+}
+
+/// Pad the stream with zeros up to the alignment of the arrays.
+static void pad(std::ostream& stream, size_t* written) {
+  static const char padding[alignment] = {0};
+  stream.write(padding, align(*written) - *written);
+  *written = align(*written);
+}
+
+void writeTACO(std::ostream& stream, const TensorBase& tensor) {
+  TensorBase& synced = const_cast<TensorBase&>(tensor);
+  if (synced.needsPack()) {
+    synced.pack();
+  } else if (synced.needsCompute()) {
+    synced.compile();
+    synced.assemble();
+    synced.compute();
+  }
+
+  TensorStorage storage = tensor.getStorage();
+  const Format& format = storage.getFormat();
+  const int order = format.getOrder();
+  taco_uassert(storage.getIndex().numModeIndices() == order)
+      << "Cannot write a tensor that has no index to a .taco file";
+
+  vector<Array> arrays;
+  vector<ArrayEntry> entries;
+  for (int i = 0; i < order; ++i) {
+    const ModeIndex& modeIndex = storage.getIndex().getModeIndex(i);
+    for (int j = 0; j < modeIndex.numIndexArrays(); ++j) {
+      const Array array = modeIndex.getIndexArray(j);
+      arrays.push_back(array);
+      entries.push_back({(uint32_t)i, array.getType(), array.getSize()});
+    }
+  }
+  arrays.push_back(storage.getValues());
+  entries.push_back({(uint32_t)order, storage.getValues().getType(),
+                     storage.getValues().getSize()});
+
+  const vector<char> header = makeHeader(storage.getComponentType(), format,
+                                         tensor.getDimensions(),
+                                         storage.getFillValue(), entries);
+  stream.write(header.data(), header.size());
+  size_t written = header.size();
+  for (auto& array : arrays) {
+    pad(stream, &written);
+    const size_t numBytes = array.getSize() * array.getType().getNumBytes();
+    stream.write((const char*)array.getData(), numBytes);
+    written += numBytes;
+  }
+  taco_uassert(stream.good()) << "Error writing .taco file";
+}
+
+namespace {
+/// Temporary files that are removed when they go out of scope.
+struct TemporaryFiles : util::Uncopyable {
+  std::vector<std::string> paths;
+
+  ~TemporaryFiles() {
+    for (auto& path : paths) {
+      std::remove(path.c_str());
+    }
+  }
+};
+
+/// Appends the elements of an array to a temporary file.
+class ArrayFile : util::Uncopyable {
+public:
+  ArrayFile(std::string path, Datatype type) : path(path), type(type) {
+    util::openStream(stream, path, fstream::out | fstream::binary);
+  }
+
+  template <typename T>
+  void push(T value) {
+    taco_iassert(sizeof(T) == type.getNumBytes());
+    const char* bytes = (const char*)&value;
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    size++;
+    if (buffer.size() >= flushSize) {
+      flush();
+    }
+  }
+
+  /// Append a position or coordinate, as an element of the array's integer
+  /// type.
+  void pushIndex(size_t value) {
+    switch (type.getKind()) {
+      case Datatype::UInt8:  pushIndex<uint8_t>(value);  break;
+      case Datatype::UInt16: pushIndex<uint16_t>(value); break;
+      case Datatype::UInt32: pushIndex<uint32_t>(value); break;
+      case Datatype::UInt64: pushIndex<uint64_t>(value); break;
+      case Datatype::Int8:   pushIndex<int8_t>(value);   break;
+      case Datatype::Int16:  pushIndex<int16_t>(value);  break;
+      case Datatype::Int32:  pushIndex<int32_t>(value);  break;
+      case Datatype::Int64:  pushIndex<int64_t>(value);  break;
+      default:
+        taco_ierror << "Index arrays must have integer types";
+        break;
+    }
+  }
+
+  void flush() {
+    stream.write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+
+  /// Flush and close the file.
+  void close() {
+    flush();
+    stream.close();
+    taco_uassert(!stream.fail()) << "Error writing " << path;
+  }
+
+  std::string path;
+  Datatype type;
+  size_t size = 0;
+
+private:
+  static const size_t flushSize = (size_t)1 << 20;
+  std::fstream stream;
+  std::vector<char> buffer;
+
+  template <typename T>
+  void pushIndex(size_t value) {
+    const T index = (T)value;
+    taco_uassert((size_t)index == value) << value <<
+        " does not fit in the " << type << " elements of " << path;
+    push<T>(index);
+  }
+};
+
+/// Builds the index arrays and values of a tensor in a format that
+/// `canPackSorted` accepts, from components that are added in lexicographic
+/// order of their coordinates in storage order, without duplicates. The
+/// arrays are written to temporary files as they are built, so only the
+/// coordinates of the last component are held in memory.
+class StreamingPacker {
+public:
+  StreamingPacker(const Format& format, const vector<int>& dimensions,
+                  const std::string& prefix, TemporaryFiles& temporaries)
+      : order(format.getOrder()), positions(order, 0),
+        numPosEntries(order, 0), previous(order, 0) {
+    for (int k = 0; k < order; ++k) {
+      const ModeFormat modeFormat = format.getModeFormats()[k];
+      modeFormats.push_back(modeFormat.getName() == Dense.getName()
+                            ? DenseMode
+                            : (modeFormat.getName() == Compressed.getName()
+                               ? CompressedMode : SingletonMode));
+      isUnique.push_back(modeFormat.isUnique());
+      this->dimensions.push_back(dimensions[format.getModeOrdering()[k]]);
+
+      // Dense levels store their dimension, compressed levels their pos and
+      // crd arrays, and singleton levels an empty pos array and a crd array
+      const int numArrays = (modeFormats[k] == DenseMode) ? 1 : 2;
+      levelArrays.push_back(arrays.size());
+      for (int j = 0; j < numArrays; ++j) {
+        const std::string path = prefix + ".level" + std::to_string(k) +
+                                 "_" + std::to_string(j);
+        temporaries.paths.push_back(path);
+        const Datatype type = (modeFormats[k] == DenseMode)
+                              ? Int32
+                              : ((j == 0) ? format.getCoordinateTypePos(k)
+                                          : format.getCoordinateTypeIdx(k));
+        arrays.emplace_back(new ArrayFile(path, type));
+        arrayModes.push_back(k);
+      }
+      if (modeFormats[k] == DenseMode) {
+        arrays.back()->push<int32_t>(this->dimensions[k]);
+      }
+    }
+    temporaries.paths.push_back(prefix + ".vals");
+    arrays.emplace_back(new ArrayFile(prefix + ".vals", Float64));
+    arrayModes.push_back(order);
+  }
+
+  /// Add a component, whose coordinates are given in storage order.
+  void add(const int* coordinates, double value) {
+    int firstDiff = 0;
+    if (numComponents > 0) {
+      while (firstDiff < order &&
+             coordinates[firstDiff] == previous[firstDiff]) {
+        firstDiff++;
+      }
+      taco_iassert(firstDiff < order) << "Components must be unique";
+    }
+
+    size_t parent = 0;
+    for (int k = 0; k < order; ++k) {
+      if (numComponents > 0 && firstDiff > (isUnique[k] ? k : order - 1)) {
+        parent = positions[k];
+        continue;
+      }
+      switch (modeFormats[k]) {
+        case DenseMode:
+          positions[k] = parent * dimensions[k] + coordinates[k];
+          break;
+        case CompressedMode:
+          while (numPosEntries[k] <= parent) {
+            pos(k).pushIndex(crd(k).size);
+            numPosEntries[k]++;
+          }
+          positions[k] = crd(k).size;
+          crd(k).pushIndex(coordinates[k]);
+          break;
+        case SingletonMode:
+          positions[k] = crd(k).size;
+          crd(k).pushIndex(coordinates[k]);
+          break;
+      }
+      parent = positions[k];
+    }
+
+    while (vals().size < parent) {
+      vals().push<double>(0.0);
+    }
+    vals().push<double>(value);
+    std::copy(coordinates, coordinates + order, previous.begin());
+    numComponents++;
+  }
+
+  /// Complete the arrays and close their files. Returns the arrays in the
+  /// order they are stored in a .taco file.
+  vector<ArrayEntry> finish() {
+    size_t numParents = 1;
+    for (int k = 0; k < order; ++k) {
+      if (modeFormats[k] == CompressedMode) {
+        while (numPosEntries[k] <= numParents) {
+          pos(k).pushIndex(crd(k).size);
+          numPosEntries[k]++;
+        }
+      }
+      numParents = (modeFormats[k] == DenseMode) ? numParents * dimensions[k]
+                                                 : crd(k).size;
+    }
+    while (vals().size < numParents) {
+      vals().push<double>(0.0);
+    }
+
+    vector<ArrayEntry> entries;
+    for (size_t i = 0; i < arrays.size(); ++i) {
+      arrays[i]->close();
+      entries.push_back({arrayModes[i], arrays[i]->type, arrays[i]->size});
+    }
+    return entries;
+  }
+
+  const std::string& getPath(size_t i) const {
+    return arrays[i]->path;
+  }
+
+private:
+  int order;
+  vector<uint32_t> modeFormats;
+  vector<bool> isUnique;
+  vector<int> dimensions;
+  vector<std::unique_ptr<ArrayFile>> arrays;
+  vector<uint32_t> arrayModes;
+  vector<size_t> levelArrays;
+
+  /// The position of the last component in every level
+  vector<size_t> positions;
+  /// The number of pos array entries written for every compressed level
+  vector<size_t> numPosEntries;
+  vector<int> previous;
+  size_t numComponents = 0;
+
+  ArrayFile& pos(int k) {return *arrays[levelArrays[k]];}
+  ArrayFile& crd(int k) {return *arrays[levelArrays[k] + 1];}
+  ArrayFile& vals() {return *arrays.back();}
+};
+
+/// Reads the sorted records of a run file through a buffer.
+class RunReader : util::Uncopyable {
+public:
+  RunReader(std::string path, size_t recordSize, size_t bufferSize)
+      : recordSize(recordSize),
+        buffer(std::max(bufferSize / recordSize, (size_t)1) * recordSize) {
+    util::openStream(stream, path, fstream::in | fstream::binary);
+    refill();
+  }
+
+  bool done() const {
+    return next == end;
+  }
+
+  const char* current() const {
+    return buffer.data() + next;
+  }
+
+  void advance() {
+    next += recordSize;
+    if (next == end) {
+      refill();
+    }
+  }
+
+private:
+  size_t recordSize;
+  std::vector<char> buffer;
+  std::fstream stream;
+  size_t next = 0;
+  size_t end = 0;
+
+  void refill() {
+    stream.read(buffer.data(), buffer.size());
+    next = 0;
+    end = stream.gcount();
+    taco_uassert(end % recordSize == 0) << "Truncated run file";
+  }
+};
+}
+
+/// Returns true if the record `a` has smaller coordinates than `b`.
+static bool isBefore(const char* a, const char* b, int order) {
+  const int* aCoordinates = (const int*)a;
+  const int* bCoordinates = (const int*)b;
+  for (int i = 0; i < order; ++i) {
+    if (aCoordinates[i] != bCoordinates[i]) {
+      return aCoordinates[i] < bCoordinates[i];
+    }
+  }
+  return false;
+}
+
+void convertToTACO(std::string inputFilename, std::string outputFilename,
+                   const Format& format, size_t memoryLimit) {
+  taco_uassert(canPackSorted(format))
+      << "Tensors can only be converted out of core to formats of dense, "
+      << "compressed and singleton modes with 32-bit coordinates";
+  const int order = format.getOrder();
+  const vector<int>& modeOrdering = format.getModeOrdering();
+  const size_t recordSize = order * sizeof(int) + sizeof(double);
+  const std::string extension =
+      inputFilename.substr(inputFilename.find_last_of(".") + 1);
+  taco_uassert(extension == "tns" || extension == "mtx")
+      << "Only .tns and .mtx files can be converted out of core";
+
+  // Sort batches of components by their coordinates in storage order and
+  // spill them to run files, summing duplicates within each batch. A batch
+  // of text is parsed into coordinates, values, a permutation and the sorted
+  // records, which together take up to about four times as much memory.
+  TemporaryFiles temporaries;
+  const std::string prefix = outputFilename + ".tmp";
+  vector<std::string> runs;
+  const size_t batchBytes = std::max(memoryLimit / 4, (size_t)1);
+  ComponentBatchFn spill = [&](size_t batchOrder,
+                               const vector<int>& coordinates,
+                               const vector<double>& values) {
+    taco_uassert((int)batchOrder == order)
+        << "The tensor has order " << batchOrder << ", but the format has "
+        << "order " << order;
+    vector<const void*> fields;
+    for (int i = 0; i < order; ++i) {
+      fields.push_back(coordinates.data() + modeOrdering[i]);
+    }
+    const vector<uint32_t> permutation =
+        util::radixSortPermutation(fields, order * sizeof(int), values.size());
+
+    vector<char> records;
+    records.reserve(values.size() * recordSize);
+    for (uint32_t i : permutation) {
+      const int* coordinate = &coordinates[i * order];
+      char* last = records.empty() ? nullptr
+                                   : &records[records.size() - recordSize];
+      bool isDuplicate = (last != nullptr);
+      for (int j = 0; j < order && isDuplicate; ++j) {
+        isDuplicate = ((int*)last)[j] == coordinate[modeOrdering[j]];
+      }
+      if (isDuplicate) {
+        double sum;
+        memcpy(&sum, last + order * sizeof(int), sizeof(double));
+        sum += values[i];
+        memcpy(last + order * sizeof(int), &sum, sizeof(double));
+        continue;
+      }
+      records.resize(records.size() + recordSize);
+      char* record = &records[records.size() - recordSize];
+      for (int j = 0; j < order; ++j) {
+        ((int*)record)[j] = coordinate[modeOrdering[j]];
+      }
+      memcpy(record + order * sizeof(int), &values[i], sizeof(double));
+    }
+
+    const std::string path = prefix + ".run" + std::to_string(runs.size());
+    temporaries.paths.push_back(path);
+    runs.push_back(path);
+    std::fstream run;
+    util::openStream(run, path, fstream::out | fstream::binary);
+    run.write(records.data(), records.size());
+    run.close();
+    taco_uassert(!run.fail()) << "Error writing " << path;
+  };
+
+  vector<int> dimensions;
+  {
+    util::MappedFile input(inputFilename);
+    const char* begin = input.getData();
+    const char* end = begin + input.getSize();
+    dimensions = (extension == "tns")
+                 ? readTNSBatches(begin, end, batchBytes, spill)
+                 : readMTXBatches(begin, end, batchBytes, spill);
+  }
+  taco_uassert((int)dimensions.size() == order)
+      << "The tensor has order " << dimensions.size() << ", but the format "
+      << "has order " << order;
+
+  // Merge the runs and pack the merged components as they come out, summing
+  // duplicates across runs
+  vector<std::unique_ptr<RunReader>> readers;
+  const size_t bufferSize = memoryLimit / std::max(runs.size(), (size_t)1) / 2;
+  for (auto& run : runs) {
+    readers.emplace_back(new RunReader(run, recordSize, bufferSize));
+  }
+  auto isAfter = [&](size_t a, size_t b) {
+    return isBefore(readers[b]->current(), readers[a]->current(), order);
+  };
+  std::priority_queue<size_t, vector<size_t>, decltype(isAfter)> heap(isAfter);
+  for (size_t i = 0; i < readers.size(); ++i) {
+    if (!readers[i]->done()) {
+      heap.push(i);
+    }
+  }
+
+  StreamingPacker packer(format, dimensions, prefix, temporaries);
+  vector<int> coordinates(order);
+  double value = 0.0;
+  bool hasComponent = false;
+  while (!heap.empty()) {
+    RunReader& reader = *readers[heap.top()];
+    const char* record = reader.current();
+    double recordValue;
+    memcpy(&recordValue, record + order * sizeof(int), sizeof(double));
+    if (hasComponent &&
+        memcmp(record, coordinates.data(), order * sizeof(int)) == 0) {
+      value += recordValue;
+    } else {
+      if (hasComponent) {
+        packer.add(coordinates.data(), value);
+      }
+      memcpy(coordinates.data(), record, order * sizeof(int));
+      value = recordValue;
+      hasComponent = true;
+    }
+    const size_t run = heap.top();
+    heap.pop();
+    reader.advance();
+    if (!reader.done()) {
+      heap.push(run);
+    }
+  }
+  if (hasComponent) {
+    packer.add(coordinates.data(), value);
+  }
+  readers.clear();
+  const vector<ArrayEntry> entries = packer.finish();
+
+  // Write the header and copy the arrays into the .taco file
+  std::fstream output;
+  util::openStream(output, outputFilename, fstream::out | fstream::binary);
+  const vector<char> header = makeHeader(Float64, format, dimensions,
+                                         Literal::zero(Float64), entries);
+  output.write(header.data(), header.size());
+  size_t written = header.size();
+  vector<char> buffer((size_t)1 << 20);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    pad(output, &written);
+    std::fstream array;
+    util::openStream(array, packer.getPath(i), fstream::in | fstream::binary);
+    while (array.read(buffer.data(), buffer.size()) || array.gcount() > 0) {
+      output.write(buffer.data(), array.gcount());
+      written += array.gcount();
+    }
+  }
+  output.close();
+  taco_uassert(!output.fail()) << "Error writing .taco file";
+}
+
+}
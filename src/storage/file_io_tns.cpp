@@ -7,77 +7,98 @@
 #include <vector>
 #include <cmath>
 #include <climits>
+#include <cstring>
+#include <iterator>
 
 #include "taco/tensor.h"
 #include "taco/format.h"
 #include "taco/error.h"
 #include "taco/util/strings.h"
 #include "taco/util/files.h"
+#include "taco/util/parallel.h"
+#include "text_parsing.h"
 
 using namespace std;
 
 namespace taco {
 
-template <typename T>
-TensorBase dispatchReadTNS(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readTNS(file, format, pack);
-  file.close();
-  return tensor;
+/// Returns the first line of a tns file that holds a component, and sets
+/// `order` to the order of the tensor.
+static const char* findFirstComponent(const char* begin, const char* end,
+                                      size_t* order) {
+  const char* first = begin;
+  while (first < end && !isDataLine(first, end, '#')) {
+    first = nextLine(first, end);
+  }
+  *order = (first < end) ? countTokens(first, end) - 1 : 0;
+  return first;
 }
 
-TensorBase readTNS(std::string filename, const ModeFormat& modetype, bool pack) {
-  return dispatchReadTNS(filename, modetype, pack);
-}
+/// Parse the components in the text [begin, end) of a tns file, which starts
+/// at a line, into coordinates and values. The text is split into
+/// line-aligned chunks that are parsed in parallel. The dimensions are grown
+/// to fit the coordinates.
+static void parseComponents(const char* begin, const char* end, size_t order,
+                            vector<int>& coordinates, vector<double>& values,
+                            vector<int>& dimensions) {
+  const size_t numWorkers = util::getNumWorkers(end - begin, parseGrain);
+  const vector<const char*> chunks = splitLines(begin, end, numWorkers);
 
-TensorBase readTNS(std::string filename, const Format& format, bool pack) {
-  return dispatchReadTNS(filename, format, pack);
+  // Count the components in every chunk to find where they are stored
+  const vector<size_t> offsets = countDataLines(chunks, end, '#');
+  const size_t nnz = offsets[numWorkers];
+
+  // Load data
+  coordinates.resize(nnz * order);
+  values.resize(nnz);
+  vector<vector<int>> workerDimensions(numWorkers, dimensions);
+  util::parallelFor(numWorkers, numWorkers, [&](size_t worker, size_t, size_t) {
+    vector<int>& dimensions = workerDimensions[worker];
+    size_t i = offsets[worker];
+    for (const char* line = chunks[worker]; line < chunks[worker + 1];
+         line = nextLine(line, end)) {
+      if (!isDataLine(line, end, '#')) {
+        continue;
+      }
+      const char* pos = line;
+      for (size_t j = 0; j < order; j++) {
+        long idx;
+        pos = parseInt(pos, end, &idx);
+        coordinates[i*order + j] = (int)idx - 1;
+        dimensions[j] = std::max(dimensions[j], (int)idx);
+      }
+      pos = parseDouble(pos, end, &values[i]);
+      i++;
+    }
+  });
+  for (auto& workerDims : workerDimensions) {
+    for (size_t j = 0; j < order; j++) {
+      dimensions[j] = std::max(dimensions[j], workerDims[j]);
+    }
+  }
 }
 
+/// Read a tns tensor from the text in [begin, end). The components are parsed
+/// in parallel straight into one coordinate and one value array, which are
+/// then bulk-inserted.
 template <typename T>
-TensorBase dispatchReadTNS(std::istream& stream, const T& format, bool pack) {
-  std::vector<int>    coordinates;
-  std::vector<double> values;
-
-  std::string line;
-  if (!std::getline(stream, line)) {
+static TensorBase parseTNS(const char* begin, const char* end, const T& format,
+                           bool pack) {
+  // Infer tensor order from the first coordinate
+  size_t order;
+  const char* first = findFirstComponent(begin, end, &order);
+  if (first == end) {
     return TensorBase();
   }
 
-  // Infer tensor order from the first coordinate
-  vector<string> toks = util::split(line, " ");
-  size_t order = toks.size()-1;
-  std::vector<int> dimensions(order);
-  std::vector<int> coordinate(order);
-
-  // Load data
-  do {
-    char* linePtr = (char*)line.data();
-    for (size_t i = 0; i < order; i++) {
-      long idx = strtol(linePtr, &linePtr, 10);
-      taco_uassert(idx <= INT_MAX)<<"Coordinate in file is larger than INT_MAX";
-      coordinate[i] = (int)idx - 1;
-      dimensions[i] = std::max(dimensions[i], (int)idx);
-    }
-    coordinates.insert(coordinates.end(), coordinate.begin(), coordinate.end());
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
-
-  } while (std::getline(stream, line));
+  vector<int> coordinates;
+  vector<double> values;
+  vector<int> dimensions(order, 0);
+  parseComponents(first, end, order, coordinates, values, dimensions);
 
   // Create tensor
-  const size_t nnz = values.size();
   TensorBase tensor(type<double>(), dimensions, format);
-  tensor.reserve(nnz);
-
-  // Insert coordinates (TODO add and use bulk insertion)
-  for (size_t i = 0; i < nnz; i++) {
-    for (size_t j = 0; j < order; j++) {
-      coordinate[j] = coordinates[i*order + j];
-    }
-    tensor.insert(coordinate, values[i]);
-  }
+  tensor.insert(coordinates.data(), values.data(), values.size());
 
   if (pack) {
     tensor.pack();
@@ -86,6 +107,46 @@ TensorBase dispatchReadTNS(std::istream& stream, const T& format, bool pack) {
   return tensor;
 }
 
+vector<int> readTNSBatches(const char* begin, const char* end,
+                           size_t batchBytes, const ComponentBatchFn& f) {
+  taco_iassert(batchBytes > 0);
+  size_t order;
+  const char* batch = findFirstComponent(begin, end, &order);
+  vector<int> coordinates;
+  vector<double> values;
+  vector<int> dimensions(order, 0);
+  while (batch < end) {
+    const size_t numBytes = std::min(batchBytes, (size_t)(end - batch));
+    const char* batchEnd = nextLine(batch + numBytes - 1, end);
+    parseComponents(batch, batchEnd, order, coordinates, values, dimensions);
+    f(order, coordinates, values);
+    batch = batchEnd;
+  }
+  return dimensions;
+}
+
+template <typename T>
+TensorBase dispatchReadTNS(std::string filename, const T& format, bool pack) {
+  util::MappedFile file(filename);
+  return parseTNS(file.getData(), file.getData() + file.getSize(), format,
+                  pack);
+}
+
+TensorBase readTNS(std::string filename, const ModeFormat& modetype, bool pack) {
+  return dispatchReadTNS(filename, modetype, pack);
+}
+
+TensorBase readTNS(std::string filename, const Format& format, bool pack) {
+  return dispatchReadTNS(filename, format, pack);
+}
+
+template <typename T>
+TensorBase dispatchReadTNS(std::istream& stream, const T& format, bool pack) {
+  const std::string text((std::istreambuf_iterator<char>(stream)),
+                         std::istreambuf_iterator<char>());
+  return parseTNS(text.data(), text.data() + text.size(), format, pack);
+}
+
 TensorBase readTNS(std::istream& stream, const ModeFormat& modetype, bool pack) {
   return dispatchReadTNS(stream, modetype, pack);
 }
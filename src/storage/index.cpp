@@ -57,7 +57,10 @@ size_t Index::getSize() const {
     auto modeIndex = getModeIndex(i);
     if (modeType.getName() == Dense.getName()) {
       size *= modeIndex.getIndexArray(0).get(0).getAsIndex();
-    } else if (modeType.getName() == Sparse.getName()) {
+    } else if (modeType.getName() == Sparse.getName() ||
+               modeType.getName() == BitPacked.getName() ||
+               modeType.getName() == Hashed.getName() ||
+               modeType.getName() == Bitmap.getName()) {
       size = modeIndex.getIndexArray(0).get(size).getAsIndex();
     } else {
       taco_not_supported_yet;
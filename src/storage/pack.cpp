@@ -1,15 +1,23 @@
 #include "taco/storage/pack.h"
 
+#include <algorithm>
 #include <climits>
+#include <complex>
+#include <cstring>
+#include <type_traits>
 
 #include "taco/format.h"
 #include "taco/error.h"
 #include "taco/ir/ir.h"
+#include "taco/lower/mode_format_bitpacked.h"
+#include "taco/lower/mode_format_bitmap.h"
+#include "taco/lower/mode_format_hashed.h"
 #include "taco/index_notation/index_notation.h"
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
 #include "taco/storage/array.h"
 #include "taco/util/collections.h"
+#include "taco/util/parallel.h"
 
 using namespace std;
 
@@ -195,4 +203,758 @@ TensorStorage pack(Datatype                             componentType,
   return storage;
 }
 
+
+// Smallest number of coordinates or positions per thread for a pass of
+// packSorted to be split across threads
+static const size_t packGrain = (size_t)1 << 16;
+
+static bool isIndexType(Datatype type) {
+  return type.isInt() || type.isUInt();
+}
+
+/// Returns true if `value` can be stored in an index array of the type.
+static bool fitsIndexType(size_t value, Datatype type) {
+  const int bits = type.getNumBits() - (type.isInt() ? 1 : 0);
+  return bits >= 64 || value < ((size_t)1 << bits);
+}
+
+/// Calls `f` with a pointer to the elements of an index array, which has the
+/// array's integer type.
+template <typename F>
+static void dispatchIndexArray(Array array, F f) {
+  void* data = array.getData();
+  switch (array.getType().getKind()) {
+    case Datatype::UInt8:
+      f((uint8_t*)data);
+      break;
+    case Datatype::UInt16:
+      f((uint16_t*)data);
+      break;
+    case Datatype::UInt32:
+      f((uint32_t*)data);
+      break;
+    case Datatype::UInt64:
+      f((uint64_t*)data);
+      break;
+    case Datatype::Int8:
+      f((int8_t*)data);
+      break;
+    case Datatype::Int16:
+      f((int16_t*)data);
+      break;
+    case Datatype::Int32:
+      f((int32_t*)data);
+      break;
+    case Datatype::Int64:
+      f((int64_t*)data);
+      break;
+    default:
+      taco_ierror << "Index arrays must have integer types";
+      break;
+  }
+}
+
+bool canPackSorted(const Format& format) {
+  // Blocked and sliced tensors are packed as the tensor of their levels
+  if (format.isBlocked() || format.isSliced()) {
+    return false;
+  }
+  bool isParentUnique = true;
+  bool isSingletonChain = false;
+  for (int i = 0; i < format.getOrder(); ++i) {
+    const ModeFormat modeFormat = format.getModeFormats()[i];
+    if (!isIndexType(format.getCoordinateTypePos(i)) ||
+        !isIndexType(format.getCoordinateTypeIdx(i))) {
+      return false;
+    }
+    if (modeFormat.getName() == Singleton.getName()) {
+      if (isParentUnique) {
+        return false;
+      }
+    } else if (isSingletonChain) {
+      // Only singleton modes may follow a non-unique mode
+      return false;
+    } else if (modeFormat.getName() == Compressed.getName()) {
+      isSingletonChain = !modeFormat.isUnique();
+    } else if (modeFormat.getName() == BitPacked.getName() ||
+               modeFormat.getName() == Bitmap.getName()) {
+      if (format.getCoordinateTypeIdx(i) != Int32) {
+        return false;
+      }
+    } else if (modeFormat.getName() == Hashed.getName()) {
+      if (!format.getCoordinateTypeIdx(i).isInt()) {
+        return false;
+      }
+    } else if (modeFormat.getName() != Dense.getName()) {
+      return false;
+    }
+    isParentUnique = modeFormat.isUnique();
+  }
+  return true;
+}
+
+/// Returns the bitmaps of a bitmap level with the coordinates `crd` below
+/// the `numParents` parent positions of `pos`.
+static Array packBitmaps(const Array& pos, const Array& crd, size_t numParents,
+                         int dimension) {
+  Array result = makeArray(Int32, 2 * numParents *
+                                  BitmapModeFormat::getNumWords(dimension));
+  dispatchIndexArray(pos, [&](auto* posData) {
+    BitmapModeFormat::pack(posData, (const int32_t*)crd.getData(), numParents,
+                           dimension, (int32_t*)result.getData());
+  });
+  return result;
+}
+
+/// Returns the `n` coordinates of a bitmap level below `numParents` parent
+/// positions.
+static Array unpackBitmaps(const Array& words, size_t numParents,
+                           int dimension, size_t n) {
+  Array result = makeArray(Int32, n);
+  BitmapModeFormat::unpack((const int32_t*)words.getData(), numParents,
+                           dimension, (int32_t*)result.getData());
+  return result;
+}
+
+/// Returns the bit-packed coordinates of a bit-packed level.
+static Array packBits(const Array& crd) {
+  const size_t n = crd.getSize();
+  vector<int32_t> packed(BitPackedModeFormat::getMaxPackedSize(n));
+  const size_t size = BitPackedModeFormat::pack((const int32_t*)crd.getData(),
+                                                n, packed.data());
+  Array result = makeArray(Int32, size);
+  memcpy(result.getData(), packed.data(), size * sizeof(int32_t));
+  return result;
+}
+
+/// Returns the `n` coordinates of a bit-packed level.
+static Array unpackBits(const Array& packed, size_t n) {
+  Array result = makeArray(Int32, n);
+  int32_t* crd = (int32_t*)result.getData();
+  const int32_t* words = (const int32_t*)packed.getData();
+  util::parallelFor(n, util::getNumWorkers(n, packGrain),
+                    [&](size_t, size_t begin, size_t end) {
+    for (size_t p = begin; p < end; ++p) {
+      crd[p] = BitPackedModeFormat::unpack(words, p);
+    }
+  });
+  return result;
+}
+
+template <typename T>
+static void packValues(Array array, const void* values, const void* fill,
+                       const vector<size_t>& begins) {
+  T* vals = (T*)array.getData();
+  const T* coordVals = (const T*)values;
+  T fillVal = T();
+  if (fill != nullptr) {
+    memcpy(&fillVal, fill, sizeof(T));
+  }
+  const size_t numPositions = begins.size() - 1;
+  util::parallelFor(numPositions, util::getNumWorkers(numPositions, packGrain),
+                    [&](size_t, size_t begin, size_t end) {
+    for (size_t p = begin; p < end; ++p) {
+      if (begins[p] == begins[p+1]) {
+        vals[p] = fillVal;
+        continue;
+      }
+      T val = coordVals[begins[p]];
+      for (size_t k = begins[p] + 1; k < begins[p+1]; ++k) {
+        val += coordVals[k];
+      }
+      vals[p] = val;
+    }
+  });
+}
+
+void packSorted(TensorStorage storage, const vector<const int*>& sortedCoordinates,
+                const void* sortedValues, size_t numCoordinates) {
+  const Format& format = storage.getFormat();
+  const vector<int>& dimensions = storage.getDimensions();
+  const int order = format.getOrder();
+  taco_iassert(canPackSorted(format));
+  taco_iassert(coordinates.size() == (size_t)order);
+  const size_t numWorkers = util::getNumWorkers(numCoordinates, packGrain);
+
+  // Hashed modes reorder the components below every parent into the order of
+  // the slots of the parent's table, so the coordinates and values are copied
+  // into these when the first hashed mode is packed.
+  vector<const int*> coordinates = sortedCoordinates;
+  const void* values = sortedValues;
+  vector<vector<int>> permutedCoordinates;
+  vector<char> permutedValues;
+
+  // For every coordinate, the first mode (in storage order) where it differs
+  // from the previous coordinate, or the order if the two are duplicates. A
+  // coordinate starts a new position in a unique mode if it differs in that or
+  // an earlier mode, and in a non-unique mode if it is not a duplicate.
+  vector<uint8_t> firstDiff(numCoordinates);
+  util::parallelFor(numCoordinates, numWorkers,
+                    [&](size_t, size_t begin, size_t end) {
+    for (size_t k = begin; k < end; ++k) {
+      int i = 0;
+      if (k > 0) {
+        while (i < order && coordinates[i][k] == coordinates[i][k-1]) {
+          i++;
+        }
+      }
+      firstDiff[k] = (uint8_t)i;
+    }
+  });
+
+  // The coordinates of the segment below every position of the current mode,
+  // which is [begins[p], begins[p+1]) for position p. The root has one
+  // position whose segment holds all coordinates.
+  vector<size_t> begins = {0, numCoordinates};
+  vector<ModeIndex> modeIndices;
+  for (int i = 0; i < order; ++i) {
+    const ModeFormat modeFormat = format.getModeFormats()[i];
+    const size_t numParents = begins.size() - 1;
+    const int* modeCoords = coordinates[i];
+    if (modeFormat.getName() != Dense.getName()) {
+      const int dimension = dimensions[format.getModeOrdering()[i]];
+      const Datatype crdType = format.getCoordinateTypeIdx(i);
+      taco_uassert(fitsIndexType(std::max(dimension - 1, 0), crdType)) <<
+          "Cannot store coordinates of a mode of dimension " << dimension <<
+          " in " << crdType << " coordinates";
+    }
+
+    if (modeFormat.getName() == Dense.getName()) {
+      const int dimension = dimensions[format.getModeOrdering()[i]];
+      vector<size_t> denseBegins(numParents * dimension + 1);
+      util::parallelFor(numParents,
+                        util::getNumWorkers(numParents * dimension, packGrain),
+                        [&](size_t, size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+          size_t k = begins[p];
+          for (int j = 0; j < dimension; ++j) {
+            while (k < begins[p+1] && modeCoords[k] < j) {
+              k++;
+            }
+            denseBegins[p * dimension + j] = k;
+          }
+        }
+      });
+      denseBegins.back() = numCoordinates;
+      begins.swap(denseBegins);
+      modeIndices.push_back(ModeIndex({makeArray({dimension})}));
+    } else if (modeFormat.getName() == Compressed.getName() ||
+               modeFormat.getName() == BitPacked.getName() ||
+               modeFormat.getName() == Bitmap.getName()) {
+      const int maxDiff = modeFormat.isUnique() ? i : order - 1;
+
+      // Count the positions that start in every worker's range
+      vector<size_t> offsets(numWorkers + 1, 0);
+      util::parallelFor(numCoordinates, numWorkers,
+                        [&](size_t worker, size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t k = begin; k < end; ++k) {
+          count += (firstDiff[k] <= maxDiff);
+        }
+        offsets[worker + 1] = count;
+      });
+      for (size_t worker = 0; worker < numWorkers; ++worker) {
+        offsets[worker + 1] += offsets[worker];
+      }
+      const size_t numPositions = offsets[numWorkers];
+      const Datatype posType = format.getCoordinateTypePos(i);
+      taco_uassert(fitsIndexType(numPositions, posType)) << "Cannot pack " <<
+          numPositions << " positions into a level with " << posType <<
+          " positions";
+
+      Array idx = makeArray(format.getCoordinateTypeIdx(i), numPositions);
+      vector<size_t> compressedBegins(numPositions + 1);
+      dispatchIndexArray(idx, [&](auto* idxData) {
+        typedef typename std::remove_pointer<decltype(idxData)>::type T;
+        util::parallelFor(numCoordinates, numWorkers,
+                          [&](size_t worker, size_t begin, size_t end) {
+          size_t p = offsets[worker];
+          for (size_t k = begin; k < end; ++k) {
+            if (firstDiff[k] <= maxDiff) {
+              idxData[p] = (T)modeCoords[k];
+              compressedBegins[p] = k;
+              p++;
+            }
+          }
+        });
+      });
+      compressedBegins.back() = numCoordinates;
+
+      // Every parent's segment starts at the first position whose coordinates
+      // are not in the segments of earlier parents
+      Array pos = makeArray(posType, numParents + 1);
+      dispatchIndexArray(pos, [&](auto* posData) {
+        typedef typename std::remove_pointer<decltype(posData)>::type T;
+        util::parallelFor(numParents + 1,
+                          util::getNumWorkers(numParents + 1, packGrain),
+                          [&](size_t, size_t begin, size_t end) {
+          size_t p = std::lower_bound(compressedBegins.begin(),
+                                      compressedBegins.end() - 1,
+                                      begins[begin]) - compressedBegins.begin();
+          for (size_t parent = begin; parent < end; ++parent) {
+            while (p < numPositions && compressedBegins[p] < begins[parent]) {
+              p++;
+            }
+            posData[parent] = (T)p;
+          }
+        });
+      });
+      begins.swap(compressedBegins);
+      if (modeFormat.getName() == BitPacked.getName()) {
+        idx = packBits(idx);
+      } else if (modeFormat.getName() == Bitmap.getName()) {
+        idx = packBitmaps(pos, idx, numParents,
+                          dimensions[format.getModeOrdering()[i]]);
+      }
+      modeIndices.push_back(ModeIndex({pos, idx}));
+    } else if (modeFormat.getName() == Hashed.getName()) {
+      // Size the table of every parent by its number of coordinates
+      vector<size_t> tableBegins(numParents + 1, 0);
+      util::parallelFor(numParents,
+                        util::getNumWorkers(numCoordinates, packGrain),
+                        [&](size_t, size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+          size_t count = 0;
+          for (size_t k = begins[p]; k < begins[p+1]; ++k) {
+            count += (firstDiff[k] <= i);
+          }
+          tableBegins[p + 1] = HashedModeFormat::getCapacity(count);
+        }
+      });
+      for (size_t p = 0; p < numParents; ++p) {
+        tableBegins[p + 1] += tableBegins[p];
+      }
+      const size_t numSlots = tableBegins[numParents];
+      const Datatype posType = format.getCoordinateTypePos(i);
+      taco_uassert(fitsIndexType(numSlots, posType)) << "Cannot pack " <<
+          numSlots << " slots into a level with " << posType << " positions";
+
+      Array pos = makeArray(posType, numParents + 1);
+      dispatchIndexArray(pos, [&](auto* posData) {
+        typedef typename std::remove_pointer<decltype(posData)>::type T;
+        for (size_t p = 0; p <= numParents; ++p) {
+          posData[p] = (T)tableBegins[p];
+        }
+      });
+
+      // Insert the coordinates of every parent into its table, and order the
+      // components below the parent by the slots of their coordinates
+      Array idx = makeArray(format.getCoordinateTypeIdx(i), numSlots);
+      vector<size_t> slotBegins(numSlots + 1);
+      vector<size_t> permutation(numCoordinates);
+      vector<uint8_t> permutedFirstDiff(numCoordinates);
+      dispatchIndexArray(idx, [&](auto* idxData) {
+        typedef typename std::remove_pointer<decltype(idxData)>::type T;
+        util::parallelFor(numParents,
+                          util::getNumWorkers(numCoordinates, packGrain),
+                          [&](size_t, size_t begin, size_t end) {
+          vector<size_t> slotEnds;
+          for (size_t p = begin; p < end; ++p) {
+            T* table = &idxData[tableBegins[p]];
+            const size_t capacity = tableBegins[p+1] - tableBegins[p];
+            slotEnds.assign(capacity, 0);
+            for (size_t s = 0; s < capacity; ++s) {
+              table[s] = (T)-1;
+            }
+            for (size_t k = begins[p]; k < begins[p+1]; ++k) {
+              if (firstDiff[k] > i) {
+                continue;
+              }
+              size_t s = HashedModeFormat::hash(modeCoords[k], capacity);
+              while (table[s] != (T)-1) {
+                s = (s + 1 == capacity) ? 0 : s + 1;
+              }
+              table[s] = (T)modeCoords[k];
+              slotBegins[tableBegins[p] + s] = k;
+              size_t kend = k + 1;
+              while (kend < begins[p+1] && firstDiff[kend] > i) {
+                kend++;
+              }
+              slotEnds[s] = kend;
+            }
+            size_t offset = begins[p];
+            for (size_t s = 0; s < capacity; ++s) {
+              const size_t kbegin = slotBegins[tableBegins[p] + s];
+              slotBegins[tableBegins[p] + s] = offset;
+              if (table[s] == (T)-1) {
+                continue;
+              }
+              for (size_t k = kbegin; k < slotEnds[s]; ++k) {
+                permutedFirstDiff[offset] = (k == kbegin) ? (uint8_t)i
+                                                          : firstDiff[k];
+                permutation[offset++] = k;
+              }
+            }
+            if (begins[p] < begins[p+1]) {
+              permutedFirstDiff[begins[p]] = firstDiff[begins[p]];
+            }
+          }
+        });
+      });
+      slotBegins.back() = numCoordinates;
+      modeIndices.push_back(ModeIndex({pos, idx}));
+
+      // Reorder the coordinates of the modes below and the values
+      const size_t csize = storage.getComponentType().getNumBytes();
+      vector<vector<int>> reorderedCoordinates(order);
+      for (int j = i + 1; j < order; ++j) {
+        reorderedCoordinates[j].resize(numCoordinates);
+      }
+      vector<char> reorderedValues(numCoordinates * csize);
+      util::parallelFor(numCoordinates, numWorkers,
+                        [&](size_t, size_t begin, size_t end) {
+        for (int j = i + 1; j < order; ++j) {
+          for (size_t k = begin; k < end; ++k) {
+            reorderedCoordinates[j][k] = coordinates[j][permutation[k]];
+          }
+        }
+        for (size_t k = begin; k < end; ++k) {
+          memcpy(&reorderedValues[k * csize],
+                 (const char*)values + permutation[k] * csize, csize);
+        }
+      });
+      permutedCoordinates.swap(reorderedCoordinates);
+      permutedValues.swap(reorderedValues);
+      for (int j = i + 1; j < order; ++j) {
+        coordinates[j] = permutedCoordinates[j].data();
+      }
+      values = permutedValues.data();
+      firstDiff.swap(permutedFirstDiff);
+      begins.swap(slotBegins);
+    } else {
+      taco_iassert(modeFormat.getName() == Singleton.getName());
+      Array idx = makeArray(format.getCoordinateTypeIdx(i), numParents);
+      dispatchIndexArray(idx, [&](auto* idxData) {
+        typedef typename std::remove_pointer<decltype(idxData)>::type T;
+        util::parallelFor(numParents,
+                          util::getNumWorkers(numParents, packGrain),
+                          [&](size_t, size_t begin, size_t end) {
+          for (size_t p = begin; p < end; ++p) {
+            idxData[p] = (T)modeCoords[begins[p]];
+          }
+        });
+      });
+      modeIndices.push_back(ModeIndex({makeArray(Int32, 0), idx}));
+    }
+  }
+
+  const Datatype componentType = storage.getComponentType();
+  Array vals = makeArray(componentType, begins.size() - 1);
+  Literal fill = storage.getFillValue();
+  const void* fillPtr = fill.defined() ? fill.getValPtr() : nullptr;
+  switch (componentType.getKind()) {
+    case Datatype::Bool:
+      packValues<bool>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::UInt8:
+      packValues<uint8_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::UInt16:
+      packValues<uint16_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::UInt32:
+      packValues<uint32_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::UInt64:
+      packValues<uint64_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Int8:
+      packValues<int8_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Int16:
+      packValues<int16_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Int32:
+      packValues<int32_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Int64:
+      packValues<int64_t>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Float32:
+      packValues<float>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Float64:
+      packValues<double>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Complex64:
+      packValues<std::complex<float>>(vals, values, fillPtr, begins);
+      break;
+    case Datatype::Complex128:
+      packValues<std::complex<double>>(vals, values, fillPtr, begins);
+      break;
+    default:
+      taco_ierror << "unsupported type";
+      break;
+  }
+
+  storage.setIndex(Index(format, modeIndices));
+  storage.setValues(vals);
+}
+
+
+bool canMergeSorted(const TensorStorage& storage) {
+  const Format& format = storage.getFormat();
+  if (!canPackSorted(format) ||
+      storage.getIndex().numModeIndices() != format.getOrder() ||
+      storage.getValues().getData() == nullptr) {
+    return false;
+  }
+  for (const ModeFormat& modeFormat : format.getModeFormats()) {
+    if (!modeFormat.isOrdered()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Returns the number of components stored in the storage, and stores their
+/// coordinates (as for `packSorted`) in storage order.
+static size_t unpackSorted(const TensorStorage& storage,
+                           vector<vector<int>>* coordinates) {
+  const Format& format = storage.getFormat();
+  const vector<int>& dimensions = storage.getDimensions();
+  const Index& index = storage.getIndex();
+  const int order = format.getOrder();
+
+  // The coordinates of every position in the sparse modes, and the parent of
+  // every position in the compressed modes. Coordinates and parents in dense
+  // modes, and parents in singleton modes, follow from the positions.
+  vector<Array> crds(order);
+  vector<vector<size_t>> parents(order);
+  vector<int> denseDimensions(order, 0);
+  size_t numPositions = 1;
+  for (int i = 0; i < order; ++i) {
+    const ModeFormat modeFormat = format.getModeFormats()[i];
+    const size_t numParents = numPositions;
+    if (modeFormat.getName() == Dense.getName()) {
+      denseDimensions[i] = dimensions[format.getModeOrdering()[i]];
+      numPositions = numParents * denseDimensions[i];
+      continue;
+    }
+    crds[i] = index.getModeIndex(i).getIndexArray(1);
+    if (modeFormat.getName() == Compressed.getName() ||
+        modeFormat.getName() == BitPacked.getName() ||
+        modeFormat.getName() == Bitmap.getName()) {
+      dispatchIndexArray(index.getModeIndex(i).getIndexArray(0),
+                         [&](auto* pos) {
+        numPositions = pos[numParents];
+        parents[i].resize(numPositions);
+        util::parallelFor(numParents,
+                          util::getNumWorkers(numPositions, packGrain),
+                          [&](size_t, size_t begin, size_t end) {
+          for (size_t p = begin; p < end; ++p) {
+            for (size_t q = pos[p]; q < (size_t)pos[p+1]; ++q) {
+              parents[i][q] = p;
+            }
+          }
+        });
+      });
+    }
+    if (modeFormat.getName() == BitPacked.getName()) {
+      crds[i] = unpackBits(crds[i], numPositions);
+    } else if (modeFormat.getName() == Bitmap.getName()) {
+      crds[i] = unpackBitmaps(crds[i], numParents,
+                              dimensions[format.getModeOrdering()[i]],
+                              numPositions);
+    }
+  }
+
+  coordinates->resize(order);
+  for (int i = 0; i < order; ++i) {
+    (*coordinates)[i].resize(numPositions);
+  }
+  util::parallelFor(numPositions, util::getNumWorkers(numPositions, packGrain),
+                    [&](size_t, size_t begin, size_t end) {
+    // The positions of the leaves in [begin, end) in the current mode
+    vector<size_t> qs(end - begin);
+    for (size_t leaf = begin; leaf < end; ++leaf) {
+      qs[leaf - begin] = leaf;
+    }
+    for (int i = order - 1; i >= 0; --i) {
+      int* modeCoords = (*coordinates)[i].data();
+      if (denseDimensions[i] > 0) {
+        for (size_t leaf = begin; leaf < end; ++leaf) {
+          size_t& q = qs[leaf - begin];
+          modeCoords[leaf] = (int)(q % denseDimensions[i]);
+          q /= denseDimensions[i];
+        }
+        continue;
+      }
+      dispatchIndexArray(crds[i], [&](auto* crd) {
+        for (size_t leaf = begin; leaf < end; ++leaf) {
+          size_t& q = qs[leaf - begin];
+          modeCoords[leaf] = (int)crd[q];
+          if (!parents[i].empty()) {
+            q = parents[i][q];
+          }
+        }
+      });
+    }
+  });
+  return numPositions;
+}
+
+void mergeSorted(TensorStorage storage, const vector<const int*>& coordinates,
+                 const void* values, size_t numCoordinates) {
+  taco_iassert(canMergeSorted(storage));
+  const int order = storage.getFormat().getOrder();
+  const size_t csize = storage.getComponentType().getNumBytes();
+
+  vector<vector<int>> storedCoordinates;
+  const size_t numStored = unpackSorted(storage, &storedCoordinates);
+  const char* storedValues = (const char*)storage.getValues().getData();
+  const char* newValues = (const char*)values;
+
+  // Merge the stored and new components, with stored components first among
+  // duplicates
+  const size_t numMerged = numStored + numCoordinates;
+  vector<vector<int>> merged(order, vector<int>(numMerged));
+  vector<char> mergedValues(numMerged * csize);
+  size_t stored = 0;
+  size_t added = 0;
+  for (size_t k = 0; k < numMerged; ++k) {
+    bool takeStored = (added == numCoordinates);
+    if (!takeStored && stored < numStored) {
+      takeStored = true;
+      for (int i = 0; i < order; ++i) {
+        const int storedCoord = storedCoordinates[i][stored];
+        const int newCoord = coordinates[i][added];
+        if (storedCoord != newCoord) {
+          takeStored = (storedCoord < newCoord);
+          break;
+        }
+      }
+    }
+    if (takeStored) {
+      for (int i = 0; i < order; ++i) {
+        merged[i][k] = storedCoordinates[i][stored];
+      }
+      memcpy(&mergedValues[k * csize], &storedValues[stored * csize], csize);
+      stored++;
+    } else {
+      for (int i = 0; i < order; ++i) {
+        merged[i][k] = coordinates[i][added];
+      }
+      memcpy(&mergedValues[k * csize], &newValues[added * csize], csize);
+      added++;
+    }
+  }
+  storedCoordinates.clear();
+
+  vector<const int*> mergedPtrs(order);
+  for (int i = 0; i < order; ++i) {
+    mergedPtrs[i] = merged[i].data();
+  }
+  packSorted(storage, mergedPtrs, mergedValues.data(), numMerged);
+}
+
+void packSliced(TensorStorage storage, const TensorStorage& csr) {
+  const Format& format = storage.getFormat();
+  taco_iassert(format.isSliced());
+  taco_uassert(csr.getFormat().getModeFormatPacks() ==
+                   CSR.getModeFormatPacks() &&
+               csr.getFormat().getModeOrdering() == CSR.getModeOrdering())
+      << "Sliced matrices can only be packed from CSR matrices";
+  const int numRows = csr.getDimensions()[0];
+  const int chunkSize = format.getChunkSize();
+  const int sortWindow = format.getSortWindow();
+  const size_t numChunks = (numRows + chunkSize - 1) / chunkSize;
+  const size_t numSlots = numChunks * chunkSize;
+  const size_t csize = storage.getComponentType().getNumBytes();
+
+  const ModeIndex& rowIndex = csr.getIndex().getModeIndex(1);
+  vector<size_t> rowPos(numRows + 1);
+  vector<int> colidx;
+  dispatchIndexArray(rowIndex.getIndexArray(0), [&](auto* pos) {
+    for (int r = 0; r <= numRows; ++r) {
+      rowPos[r] = (size_t)pos[r];
+    }
+  });
+  colidx.resize(rowPos[numRows]);
+  dispatchIndexArray(rowIndex.getIndexArray(1), [&](auto* crd) {
+    for (size_t q = 0; q < colidx.size(); ++q) {
+      colidx[q] = (int)crd[q];
+    }
+  });
+  auto rowLength = [&](int row) {
+    return (row < 0) ? (size_t)0 : rowPos[row + 1] - rowPos[row];
+  };
+
+  // Sort the rows of every window by decreasing length, and pad the last
+  // chunk with empty slots
+  Array rows = makeArray(Int32, numSlots);
+  int32_t* rowsData = (int32_t*)rows.getData();
+  for (size_t s = 0; s < numSlots; ++s) {
+    rowsData[s] = (s < (size_t)numRows) ? (int32_t)s : -1;
+  }
+  for (int begin = 0; begin < numRows; begin += sortWindow) {
+    const int end = std::min(begin + sortWindow, numRows);
+    std::stable_sort(rowsData + begin, rowsData + end,
+                     [&](int32_t a, int32_t b) {
+      return rowLength(a) > rowLength(b);
+    });
+  }
+
+  // Every chunk is as wide as its longest row
+  Array chunkPos = makeArray(Int32, numChunks + 1);
+  int32_t* chunkPosData = (int32_t*)chunkPos.getData();
+  chunkPosData[0] = 0;
+  for (size_t c = 0; c < numChunks; ++c) {
+    size_t width = 0;
+    for (size_t s = c * chunkSize; s < (c + 1) * chunkSize; ++s) {
+      width = std::max(width, rowLength(rowsData[s]));
+    }
+    taco_uassert((chunkPosData[c] + width) * chunkSize <= INT_MAX)
+        << "The sliced matrix has too many slots for 32-bit positions";
+    chunkPosData[c + 1] = chunkPosData[c] + (int32_t)width;
+  }
+  const size_t numColumns = chunkPosData[numChunks];
+  Array chunkColumns = makeArray(Int32, numColumns);
+  int32_t* chunkColumnsData = (int32_t*)chunkColumns.getData();
+  for (size_t c = 0; c < numChunks; ++c) {
+    for (int32_t k = chunkPosData[c]; k < chunkPosData[c + 1]; ++k) {
+      chunkColumnsData[k] = k - chunkPosData[c];
+    }
+  }
+
+  // Store the columns and values of the rows of every chunk column-major
+  Array crd = makeArray(Int32, numColumns * chunkSize);
+  Array vals = makeArray(storage.getComponentType(), numColumns * chunkSize);
+  int32_t* crdData = (int32_t*)crd.getData();
+  char* valsData = (char*)vals.getData();
+  const char* csrVals = (const char*)csr.getValues().getData();
+  const void* fill = storage.getFillValue().getValPtr();
+  util::parallelFor(numChunks, util::getNumWorkers(numChunks, 1024),
+                    [&](size_t, size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      for (int lane = 0; lane < chunkSize; ++lane) {
+        const int row = rowsData[c * chunkSize + lane];
+        const size_t length = rowLength(row);
+        const int32_t lastColumn = (length > 0)
+                                   ? colidx[rowPos[row + 1] - 1] : 0;
+        for (int32_t k = chunkPosData[c]; k < chunkPosData[c + 1]; ++k) {
+          const size_t slot = (size_t)k * chunkSize + lane;
+          const size_t column = k - chunkPosData[c];
+          if (column < length) {
+            crdData[slot] = colidx[rowPos[row] + column];
+            memcpy(&valsData[slot * csize],
+                   &csrVals[(rowPos[row] + column) * csize], csize);
+          } else {
+            crdData[slot] = lastColumn;
+            memcpy(&valsData[slot * csize], fill, csize);
+          }
+        }
+      }
+    }
+  });
+
+  const Format levelFormat = format.getLevelFormat();
+  storage.setIndex(Index(levelFormat,
+      {ModeIndex({makeArray({(int)numChunks})}),
+       ModeIndex({chunkPos, chunkColumns}),
+       ModeIndex({makeArray(Int32, 0), rows}),
+       ModeIndex({makeArray(Int32, 0), crd})}));
+  storage.setValues(vals);
+}
+
 }
@@ -31,14 +31,19 @@ struct TensorStorage::Content {
 
   Content(Datatype componentType, vector<int> dimensions, Format format, Literal fill)
       : componentType(componentType), dimensions(dimensions), format(format),
-        index(format) {
-    int order = (int)dimensions.size();
-
+        index(format.getLevelFormat()) {
     taco_iassert(fill.getDataType() == componentType) << "Fill value must be of same type as data array";
-    taco_iassert(order <= INT_MAX && componentType.getNumBits() <= INT_MAX);
-    taco_uassert(order == format.getOrder()) <<
+    taco_uassert((int)dimensions.size() == format.getOrder()) <<
         "The number of format mode types (" << format.getOrder() << ") " <<
         "must match the tensor order (" << dimensions.size() << ").";
+
+    // Blocked and sliced tensors are passed to kernels as the tensor of their
+    // levels
+    dimensions = format.getLevelDimensions(dimensions);
+    format = format.getLevelFormat();
+    int order = (int)dimensions.size();
+    taco_iassert(order <= INT_MAX && componentType.getNumBits() <= INT_MAX);
+
     vector<int32_t> dimensionsInt32(order);
     vector<int32_t> modeOrdering(order);
     vector<taco_mode_t> modeTypes(order);
@@ -48,9 +53,13 @@ struct TensorStorage::Content {
       auto modeType  = format.getModeFormats()[i];
       if (modeType.getName() == Dense.getName()) {
         modeTypes[i] = taco_mode_dense;
-      } else if (modeType.getName() == Sparse.getName()) {
+      } else if (modeType.getName() == Sparse.getName() ||
+                 modeType.getName() == BitPacked.getName() ||
+                 modeType.getName() == Hashed.getName() ||
+                 modeType.getName() == Bitmap.getName()) {
         modeTypes[i] = taco_mode_sparse;
-      } else if (modeType.getName() == Singleton.getName()) {
+      } else if (modeType.getName() == Singleton.getName() ||
+                 modeType.getName() == Sliced.getName()) {
         modeTypes[i] = taco_mode_sparse;
       } else {
         taco_not_supported_yet;
@@ -128,8 +137,8 @@ TensorStorage::operator struct taco_tensor_t*() const {
   taco_tensor_t* tensorData = content->tensorData;
 
   taco_iassert(getComponentType().getNumBits() <= INT_MAX);
-  int order = getOrder();
-  Format format = getFormat();
+  Format format = getFormat().getLevelFormat();
+  int order = format.getOrder();
   Index index = getIndex();
 
   for (int i = 0; i < order; i++) {
@@ -145,7 +154,10 @@ TensorStorage::operator struct taco_tensor_t*() const {
       tensorData->indices[i][0] = (uint8_t*)size.getData();
     }
     // Sparse levels have two indices (pos and idx)
-    else if (modeType.getName() == Sparse.getName()) {
+    else if (modeType.getName() == Sparse.getName() ||
+             modeType.getName() == BitPacked.getName() ||
+             modeType.getName() == Hashed.getName() ||
+             modeType.getName() == Bitmap.getName()) {
       // TODO Uncomment assert and remove conditional
       // taco_iassert(modeIndex.numIndexArrays() == 2)
       //     << modeIndex.numIndexArrays();
@@ -156,7 +168,8 @@ TensorStorage::operator struct taco_tensor_t*() const {
         tensorData->indices[i][1] = (uint8_t*)idx.getData();
       }
     }
-    else if (modeType.getName() == Singleton.getName()) {
+    else if (modeType.getName() == Singleton.getName() ||
+             modeType.getName() == Sliced.getName()) {
       // TODO Uncomment assert and remove conditional
       // taco_iassert(modeIndex.numIndexArrays() == 2)
       //     << modeIndex.numIndexArrays();
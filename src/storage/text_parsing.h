@@ -0,0 +1,196 @@
+#ifndef TACO_STORAGE_TEXT_PARSING_H
+#define TACO_STORAGE_TEXT_PARSING_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "taco/error.h"
+#include "taco/util/parallel.h"
+
+namespace taco {
+
+/// Helpers for the text tensor file readers, which parse a file that has been
+/// read or mapped into memory in line-aligned chunks, one chunk per thread.
+
+// Smallest number of bytes per thread for parsing to be split across threads
+static const size_t parseGrain = (size_t)1 << 20;
+
+/// Called with every batch of components that is read from a tensor file.
+/// The coordinates of each component are stored next to each other.
+typedef std::function<void(size_t order, const std::vector<int>& coordinates,
+                           const std::vector<double>& values)>
+    ComponentBatchFn;
+
+/// Read the components of the .tns file in [begin, end) in batches that are
+/// each parsed from about `batchBytes` of text, so that only one batch is held
+/// in memory at a time. Returns the dimensions of the tensor.
+std::vector<int> readTNSBatches(const char* begin, const char* end,
+                                size_t batchBytes, const ComponentBatchFn& f);
+
+/// Read the components of the coordinate .mtx file in [begin, end) in batches
+/// as `readTNSBatches` does. Symmetric matrices are expanded. Returns the
+/// dimensions of the tensor.
+std::vector<int> readMTXBatches(const char* begin, const char* end,
+                                size_t batchBytes, const ComponentBatchFn& f);
+
+inline bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/// Returns the start of the first line at or after `pos`.
+inline const char* nextLine(const char* pos, const char* end) {
+  const char* newline = (const char*)memchr(pos, '\n', end - pos);
+  return newline ? newline + 1 : end;
+}
+
+/// Returns true if the line that starts at `pos` holds data, and not only
+/// whitespace or a comment that starts with `comment`.
+inline bool isDataLine(const char* pos, const char* end, char comment) {
+  while (pos < end && isBlank(*pos)) {
+    pos++;
+  }
+  return pos < end && *pos != '\n' && *pos != comment;
+}
+
+/// Returns the number of whitespace separated tokens on the line at `pos`.
+inline size_t countTokens(const char* pos, const char* end) {
+  size_t numTokens = 0;
+  while (pos < end && *pos != '\n') {
+    while (pos < end && isBlank(*pos)) {
+      pos++;
+    }
+    if (pos < end && *pos != '\n') {
+      numTokens++;
+    }
+    while (pos < end && !isBlank(*pos) && *pos != '\n') {
+      pos++;
+    }
+  }
+  return numTokens;
+}
+
+/// Split [begin, end) into at most `numWorkers` chunks that start at line
+/// boundaries. Chunk i is [chunks[i], chunks[i+1]).
+inline std::vector<const char*> splitLines(const char* begin, const char* end,
+                                           size_t numWorkers) {
+  std::vector<const char*> chunks(numWorkers + 1, end);
+  chunks[0] = begin;
+  for (size_t worker = 1; worker < numWorkers; ++worker) {
+    const char* chunk = begin + worker * (end - begin) / numWorkers;
+    chunks[worker] = std::max(nextLine(chunk - 1, end), chunks[worker - 1]);
+  }
+  return chunks;
+}
+
+/// Returns the offsets of the data lines of every chunk into a single array,
+/// where the last offset is the total number of data lines.
+inline std::vector<size_t> countDataLines(const std::vector<const char*>& chunks,
+                                          const char* end, char comment) {
+  const size_t numWorkers = chunks.size() - 1;
+  std::vector<size_t> offsets(numWorkers + 1, 0);
+  util::parallelFor(numWorkers, numWorkers, [&](size_t worker, size_t, size_t) {
+    size_t count = 0;
+    for (const char* line = chunks[worker]; line < chunks[worker + 1];
+         line = nextLine(line, end)) {
+      count += isDataLine(line, end, comment);
+    }
+    offsets[worker + 1] = count;
+  });
+  for (size_t worker = 0; worker < numWorkers; ++worker) {
+    offsets[worker + 1] += offsets[worker];
+  }
+  return offsets;
+}
+
+inline const char* parseInt(const char* pos, const char* end, long* result) {
+  while (pos < end && isBlank(*pos)) {
+    pos++;
+  }
+  bool negative = false;
+  if (pos < end && (*pos == '-' || *pos == '+')) {
+    negative = (*pos == '-');
+    pos++;
+  }
+  long value = 0;
+  const char* digits = pos;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    value = value * 10 + (*pos - '0');
+    taco_uassert(value <= INT_MAX) << "Coordinate in file is larger than INT_MAX";
+    pos++;
+  }
+  taco_uassert(pos != digits) << "Expected a coordinate in file";
+  *result = negative ? -value : value;
+  return pos;
+}
+
+inline const char* parseDouble(const char* pos, const char* end,
+                               double* result) {
+  // Powers of ten that are exactly representable as doubles
+  static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  while (pos < end && isBlank(*pos)) {
+    pos++;
+  }
+  const char* token = pos;
+  while (pos < end && !isBlank(*pos) && *pos != '\n') {
+    pos++;
+  }
+
+  // Decimal numbers with at most 15 significant digits and small exponents
+  // are converted exactly from their integer mantissa. Anything else is left
+  // to strtod.
+  const char* c = token;
+  bool negative = false;
+  if (c < pos && (*c == '-' || *c == '+')) {
+    negative = (*c == '-');
+    c++;
+  }
+  uint64_t mantissa = 0;
+  int numDigits = 0;
+  int exponent = 0;
+  bool isSimple = (c < pos);
+  for (; c < pos && *c >= '0' && *c <= '9'; c++) {
+    mantissa = mantissa * 10 + (*c - '0');
+    numDigits += (mantissa != 0);
+  }
+  if (c < pos && *c == '.') {
+    for (c++; c < pos && *c >= '0' && *c <= '9'; c++) {
+      mantissa = mantissa * 10 + (*c - '0');
+      numDigits += (mantissa != 0);
+      exponent--;
+    }
+  }
+  if (c < pos && (*c == 'e' || *c == 'E')) {
+    long exp;
+    c = parseInt(c + 1, pos, &exp);
+    exponent += (int)exp;
+  }
+  isSimple = isSimple && c == pos && numDigits <= 15 &&
+             exponent >= -22 && exponent <= 22;
+  if (isSimple) {
+    double value = (double)mantissa;
+    value = (exponent < 0) ? value / powersOfTen[-exponent]
+                           : value * powersOfTen[exponent];
+    *result = negative ? -value : value;
+  } else {
+    taco_uassert(pos - token < 64) << "Value in file is too long";
+    char buffer[64];
+    memcpy(buffer, token, pos - token);
+    buffer[pos - token] = '\0';
+    char* parsedEnd;
+    *result = strtod(buffer, &parsedEnd);
+    taco_uassert(parsedEnd != buffer) << "Expected a value in file";
+  }
+  return pos;
+}
+
+}
+#endif
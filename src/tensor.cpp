@@ -1,14 +1,21 @@
 #include "taco/tensor.h"
 
+#include <algorithm>
+#include <map>
 #include <set>
 #include <cstring>
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
 #include <climits>
+#include <limits>
 #include <vector>
 #include <utility>
 #include <mutex>
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "taco/cuda.h"
 #include "taco/format.h"
@@ -17,6 +24,7 @@
 #include "taco/error/error_messages.h"
 #include "taco/index_notation/index_notation.h"
 #include "taco/index_notation/index_notation_nodes.h"
+#include "taco/index_notation/index_notation_rewriter.h"
 //#include "codegen/codegen_c.h"
 //#include "codegen/codegen_cuda.h"
 //#include "taco/taco_tensor_t.h"
@@ -25,6 +33,8 @@
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_printer.h"
 #include "taco/lower/lower.h"
+#include "taco/lower/mode_format_bitpacked.h"
+#include "taco/lower/mode_format_bitmap.h"
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
 #include "taco/storage/array.h"
@@ -32,11 +42,16 @@
 #include "taco/storage/file_io_tns.h"
 #include "taco/storage/file_io_mtx.h"
 #include "taco/storage/file_io_rb.h"
+#include "taco/storage/file_io_taco.h"
 #include "taco/storage/typed_vector.h"
 #include "taco/util/collections.h"
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/name_generator.h"
+#include "taco/util/env.h"
+#include "taco/util/hash.h"
+#include "taco/util/parallel.h"
+#include "taco/util/radix_sort.h"
 
 #include "codegen/codegen_c.h"
 #include "codegen/codegen_cuda.h"
@@ -93,10 +108,14 @@ static Format initFormat(Format format) {
       ModeFormat modeType = format.getModeFormats()[i];
       if (modeType.getName() == Dense.getName()) {
         arrayTypes.push_back(Int32);
-      } else if (modeType.getName() == Sparse.getName()) {
+      } else if (modeType.getName() == Sparse.getName() ||
+                 modeType.getName() == BitPacked.getName() ||
+                 modeType.getName() == Hashed.getName() ||
+                 modeType.getName() == Bitmap.getName()) {
         arrayTypes.push_back(Int32);
         arrayTypes.push_back(Int32);
-      } else if (modeType.getName() == Singleton.getName()) {
+      } else if (modeType.getName() == Singleton.getName() ||
+                 modeType.getName() == Sliced.getName()) {
         arrayTypes.push_back(Int32);
         arrayTypes.push_back(Int32);
       } else {
@@ -125,16 +144,27 @@ TensorBase::TensorBase(string name, Datatype ctype, vector<int> dimensions,
 
   content->allocSize = 1 << 20;
 
-  vector<ModeIndex> modeIndices(format.getOrder());
+  // Blocked and sliced tensors are stored as the tensor of their levels
+  if (format.isBlocked()) {
+    for (int i = 0; i < format.getOrder(); ++i) {
+      taco_uassert(dimensions[i] % format.getBlockSizes()[i] == 0) <<
+          "The dimensions of blocked tensors must be multiples of the " <<
+          "block sizes";
+    }
+  }
+  const Format levelFormat = getFormat().getLevelFormat();
+  const vector<int> levelDimensions = format.getLevelDimensions(dimensions);
+
+  vector<ModeIndex> modeIndices(levelFormat.getOrder());
   // Initialize dense storage modes
   // TODO: Get rid of this and make code use dimensions instead of dense indices
-  for (int i = 0; i < format.getOrder(); ++i) {
-    if (format.getModeFormats()[i].getName() == Dense.getName()) {
-      const size_t idx = format.getModeOrdering()[i];
-      modeIndices[i] = ModeIndex({makeArray({content->dimensions[idx]})});
+  for (int i = 0; i < levelFormat.getOrder(); ++i) {
+    if (levelFormat.getModeFormats()[i].getName() == Dense.getName()) {
+      const size_t idx = levelFormat.getModeOrdering()[i];
+      modeIndices[i] = ModeIndex({makeArray({levelDimensions[idx]})});
     }
   }
-  content->storage.setIndex(Index(format, modeIndices));
+  content->storage.setIndex(Index(levelFormat, modeIndices));
 
   content->assembleWhileCompute = false;
   content->module = make_shared<Module>();
@@ -145,9 +175,7 @@ TensorBase::TensorBase(string name, Datatype ctype, vector<int> dimensions,
   content->needsAssemble = false;
   content->needsCompute = false;
 
-  content->coordinateBuffer = shared_ptr<vector<char>>(new vector<char>);
-  content->coordinateBufferUsed = 0;
-  content->coordinateSize = getOrder()*sizeof(int) + ctype.getNumBytes();
+  content->coordinateBuffer = make_shared<CoordinateBuffer>(getOrder(), ctype);
 }
 
 void TensorBase::setName(std::string name) const {
@@ -167,9 +195,8 @@ const Format& TensorBase::getFormat() const {
 }
 
 void TensorBase::reserve(size_t numCoordinates) {
-  size_t newSize = content->coordinateBuffer->size() +
-                   numCoordinates * content->coordinateSize;
-  content->coordinateBuffer->resize(newSize);
+  content->coordinateBuffer->reserve(content->coordinateBuffer->size() +
+                                     numCoordinates);
 }
 
 int TensorBase::getDimension(int mode) const {
@@ -249,38 +276,54 @@ void TensorBase::setAssembleWhileCompute(bool assembleWhileCompute) {
   content->assembleWhileCompute = assembleWhileCompute;
 }
 
-static size_t numIntegersToCompare = 0;
-static int lexicographicalCmp(const void* a, const void* b) {
-  for (size_t i = 0; i < numIntegersToCompare; i++) {
-    int diff = ((int*)a)[i] - ((int*)b)[i];
-    if (diff != 0) {
-      return diff;
-    }
-  }
-  return 0;
-}
-
 static size_t unpackTensorData(const taco_tensor_t& tensorData,
                                const TensorBase& tensor) {
   auto storage = tensor.getStorage();
   auto format = storage.getFormat();
+  auto dimensions = tensor.getDimensions();
+  dimensions = format.getLevelDimensions(dimensions);
+  format = format.getLevelFormat();
 
   vector<ModeIndex> modeIndices;
   size_t numVals = 1;
-  for (int i = 0; i < tensor.getOrder(); i++) {
+  for (int i = 0; i < format.getOrder(); i++) {
     ModeFormat modeType = format.getModeFormats()[i];
     if (modeType.getName() == Dense.getName()) {
       Array size = makeArray({*(int*)tensorData.indices[i][0]});
       modeIndices.push_back(ModeIndex({size}));
       numVals *= ((int*)tensorData.indices[i][0])[0];
-    } else if (modeType.getName() == Sparse.getName()) {
-      auto size = ((int*)tensorData.indices[i][0])[numVals];
-      Array pos = Array(type<int>(), tensorData.indices[i][0], numVals+1, Array::UserOwns);
-      Array idx = Array(type<int>(), tensorData.indices[i][1], size, Array::UserOwns);
+    } else if (modeType.getName() == Sparse.getName() ||
+               modeType.getName() == Hashed.getName()) {
+      Array pos = Array(format.getCoordinateTypePos(i), tensorData.indices[i][0],
+                        numVals+1, Array::UserOwns);
+      auto size = pos.get(numVals).getAsIndex();
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        size, Array::UserOwns);
+      modeIndices.push_back(ModeIndex({pos, idx}));
+      numVals = size;
+    } else if (modeType.getName() == BitPacked.getName()) {
+      Array pos = Array(format.getCoordinateTypePos(i), tensorData.indices[i][0],
+                        numVals+1, Array::UserOwns);
+      auto size = pos.get(numVals).getAsIndex();
+      const int32_t* packed = (const int32_t*)tensorData.indices[i][1];
+      Array idx = Array(Int32, tensorData.indices[i][1],
+                        BitPackedModeFormat::getPackedSize(packed, size),
+                        Array::UserOwns);
+      modeIndices.push_back(ModeIndex({pos, idx}));
+      numVals = size;
+    } else if (modeType.getName() == Bitmap.getName()) {
+      Array pos = Array(format.getCoordinateTypePos(i), tensorData.indices[i][0],
+                        numVals+1, Array::UserOwns);
+      auto size = pos.get(numVals).getAsIndex();
+      const int dimension = dimensions[format.getModeOrdering()[i]];
+      Array idx = Array(Int32, tensorData.indices[i][1],
+                        2 * numVals * BitmapModeFormat::getNumWords(dimension),
+                        Array::UserOwns);
       modeIndices.push_back(ModeIndex({pos, idx}));
       numVals = size;
     } else if (modeType.getName() == Singleton.getName()) {
-      Array idx = Array(type<int>(), tensorData.indices[i][1], numVals, Array::UserOwns);
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        numVals, Array::UserOwns);
       modeIndices.push_back(ModeIndex({makeArray(type<int>(), 0), idx}));
     } else {
       taco_not_supported_yet;
@@ -291,6 +334,28 @@ static size_t unpackTensorData(const taco_tensor_t& tensorData,
   return numVals;
 }
 
+/// Returns true if the coordinates, where `coordinates[i]` holds the
+/// coordinates of the i-th mode to sort by, are sorted lexicographically.
+static bool isSorted(const std::vector<const int*>& coordinates, size_t n) {
+  const size_t numWorkers = util::getNumWorkers(n, 1<<16);
+  std::vector<char> workerSorted(numWorkers, true);
+  util::parallelFor(n, numWorkers, [&](size_t worker, size_t begin, size_t end) {
+    for (size_t i = std::max(begin, (size_t)1); i < end; ++i) {
+      for (const int* column : coordinates) {
+        if (column[i - 1] != column[i]) {
+          if (column[i - 1] > column[i]) {
+            workerSorted[worker] = false;
+            return;
+          }
+          break;
+        }
+      }
+    }
+  });
+  return std::all_of(workerSorted.begin(), workerSorted.end(),
+                     [](char sorted) {return sorted;});
+}
+
 /// Pack coordinates into a data structure given by the tensor format.
 void TensorBase::pack() {
   if (!needsPack()) {
@@ -298,16 +363,15 @@ void TensorBase::pack() {
   }
   setNeedsPack(false);
 
+  // Packed components of common formats are merged with the sorted unpacked
+  // components, which implements increment semantics
+  const bool merge = !neverPacked() && canMergeSorted(getStorage());
   if (neverPacked()) {
     unsetNeverPacked();
-  } else {
+  } else if (!merge) {
     // Reinsert packed components into temporary buffer and repack them along
     // with unpacked components. This is needed to implement increment
-    // semantics.
-    // TODO: Change to using code that adds packed components (stored in packed
-    //       data structure) with unpacked components (stored in temporary
-    //       buffer). We can already generate such code, but currently
-    //       compiling it is too expensive.
+    // semantics for other formats.
     switch (getComponentType().getKind()) {
       case Datatype::Bool:
         reinsertPackedComponents<bool>();
@@ -358,37 +422,27 @@ void TensorBase::pack() {
   const int csize = getComponentType().getNumBytes();
   const std::vector<int>& dimensions = getDimensions();
 
-  taco_iassert((content->coordinateBufferUsed % content->coordinateSize) == 0);
-  const size_t numCoordinates = content->coordinateBufferUsed / content->coordinateSize;
-
-  const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType(),
-                                              dimensions);
+  CoordinateBuffer& buffer = *content->coordinateBuffer;
+  const size_t numCoordinates = buffer.size();
 
   // Pack scalars
   if (order == 0) {
-    Array array = makeArray(getComponentType(), 1);
-
-    std::vector<taco_mode_t> bufferModeType = {taco_mode_sparse};
-    std::vector<int> bufferDim = {1};
-    std::vector<int> bufferModeOrdering = {0};
-    std::vector<int> bufferCoords(numCoordinates, 0);
-
-    void* fillPtr = getStorage().getFillValue().defined()? getStorage().getFillValue().getValPtr() : nullptr;
-    taco_tensor_t* bufferStorage = init_taco_tensor_t(1, csize,
-        (int32_t*)bufferDim.data(), (int32_t*)bufferModeOrdering.data(),
-        (taco_mode_t*)bufferModeType.data(), fillPtr);
-    std::vector<int> pos = {0, (int)numCoordinates};
-    bufferStorage->indices[0][0] = (uint8_t*)pos.data();
-    bufferStorage->indices[0][1] = (uint8_t*)bufferCoords.data();
-
-    bufferStorage->vals = (uint8_t*)content->coordinateBuffer->data();
-
-    std::vector<void*> arguments = {content->storage, bufferStorage};
-    helperFuncs->callFuncPacked("pack", arguments.data());
-    content->valuesSize = unpackTensorData(*((taco_tensor_t*)arguments[0]), *this);
+    if (merge) {
+      mergeSorted(getStorage(), {}, buffer.getValues(), numCoordinates);
+    } else {
+      packSorted(getStorage(), {}, buffer.getValues(), numCoordinates);
+    }
+    content->valuesSize = 1;
+    buffer.clear();
+    return;
+  }
 
-    deinit_taco_tensor_t(bufferStorage);
-    content->coordinateBuffer->clear();
+  if (getFormat().isBlocked()) {
+    packBlocked();
+    return;
+  }
+  if (getFormat().isSliced()) {
+    packSliced();
     return;
   }
 
@@ -397,50 +451,67 @@ void TensorBase::pack() {
   // ordering of the modes.
   taco_iassert(getFormat().getOrder() == order);
   std::vector<int> permutation = getFormat().getModeOrdering();
-  std::vector<int> permutedDimensions(order);
-  for (int i = 0; i < order; ++i) {
-    permutedDimensions[i] = dimensions[permutation[i]];
-  }
 
-  const size_t coordSize = content->coordinateSize;
-  char* coordinatesPtr = content->coordinateBuffer->data();
-  vector<int> permuteBuffer(order);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordinate = (int*)coordinatesPtr;
-    for (int j = 0; j < order; j++) {
-      permuteBuffer[j] = coordinate[permutation[j]];
+  // The pack code expects the coordinates to be sorted by their permuted
+  // modes. Buffers that are already sorted, e.g. because the components were
+  // inserted in order, are packed straight from the buffer's columns, and
+  // other buffers are sorted into new columns.
+  std::vector<const int*> coordinatePtrs(order);
+  for (int i = 0; i < order; ++i) {
+    coordinatePtrs[i] = buffer.getCoordinates(permutation[i]);
+  }
+  const void* values = buffer.getValues();
+  std::vector<std::vector<int>> coordinates;
+  std::vector<char> sortedValues;
+  if (!isSorted(coordinatePtrs, numCoordinates)) {
+    std::vector<const void*> sortFields(coordinatePtrs.begin(),
+                                        coordinatePtrs.end());
+    const std::vector<uint32_t> sorted =
+        util::radixSortPermutation(sortFields, sizeof(int), numCoordinates);
+
+    coordinates.resize(order);
+    for (int i = 0; i < order; ++i) {
+      coordinates[i] = std::vector<int>(numCoordinates);
     }
-    for (int j = 0; j < order; j++) {
-      coordinate[j] = permuteBuffer[j];
+    sortedValues.resize(numCoordinates * csize);
+    util::parallelFor(numCoordinates, util::getNumWorkers(numCoordinates, 1<<16),
+                      [&](size_t, size_t begin, size_t end) {
+      for (int d = 0; d < order; ++d) {
+        const int* column = coordinatePtrs[d];
+        int* sortedColumn = coordinates[d].data();
+        for (size_t i = begin; i < end; ++i) {
+          sortedColumn[i] = column[sorted[i]];
+        }
+      }
+      const char* unsortedValues = (const char*)values;
+      for (size_t i = begin; i < end; ++i) {
+        memcpy(&sortedValues[i * csize], &unsortedValues[sorted[i] * csize],
+               csize);
+      }
+    });
+
+    // Release the buffer, since it is usually much larger than the packed
+    // tensor
+    buffer.clear();
+    for (int i = 0; i < order; ++i) {
+      coordinatePtrs[i] = coordinates[i].data();
     }
-    coordinatesPtr += content->coordinateSize;
+    values = sortedValues.data();
   }
-  coordinatesPtr = content->coordinateBuffer->data();
-
-  // The pack code expects the coordinates to be sorted
-  numIntegersToCompare = order;
-  qsort(coordinatesPtr, numCoordinates, coordSize, lexicographicalCmp);
-
 
-  // Move coords into separate arrays
-  std::vector<std::vector<int>> coordinates(order);
-  for (int i = 0; i < order; ++i) {
-    coordinates[i] = std::vector<int>(numCoordinates);
-  }
-  char* values = (char*) malloc(numCoordinates * csize);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordLoc = (int*)&coordinatesPtr[i * coordSize];
-    for (int d = 0; d < order; ++d) {
-      coordinates[d][i] = *coordLoc;
-      coordLoc++;
+  // Common formats are packed directly, and other formats with a generated
+  // pack function that is compiled for every format, type and shape
+  if (canPackSorted(getFormat())) {
+    if (merge) {
+      mergeSorted(getStorage(), coordinatePtrs, values, numCoordinates);
+    } else {
+      packSorted(getStorage(), coordinatePtrs, values, numCoordinates);
     }
-    memcpy(&values[i * csize], coordLoc, csize);
+    content->valuesSize = getStorage().getValues().getSize();
+    buffer.clear();
+    return;
   }
 
-
-  content->coordinateBuffer->clear();
-  content->coordinateBufferUsed = 0;
-
   void* fillPtr = getStorage().getFillValue().defined()? getStorage().getFillValue().getValPtr() : nullptr;
   std::vector<taco_mode_t> bufferModeTypes(order, taco_mode_sparse);
   taco_tensor_t* bufferStorage = init_taco_tensor_t(order, csize,
@@ -449,27 +520,84 @@ void TensorBase::pack() {
   std::vector<int> pos = {0, (int)numCoordinates};
   bufferStorage->indices[0][0] = (uint8_t*)pos.data();
   for (int i = 0; i < order; ++i) {
-    bufferStorage->indices[i][1] = (uint8_t*)coordinates[i].data();
+    bufferStorage->indices[i][1] = (uint8_t*)coordinatePtrs[i];
   }
   bufferStorage->vals = (uint8_t*)values;
 
   // Pack nonzero components into required format
+  const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType());
   std::vector<void*> arguments = {content->storage, bufferStorage};
   helperFuncs->callFuncPacked("pack", arguments.data());
   content->valuesSize = unpackTensorData(*((taco_tensor_t*)arguments[0]), *this);
 
-  free(values);
+  buffer.clear();
   deinit_taco_tensor_t(bufferStorage);
 }
 
+void TensorBase::packBlocked() {
+  const Format& format = getFormat();
+  const int order = getOrder();
+  const vector<int>& blockSizes = format.getBlockSizes();
+  CoordinateBuffer& buffer = *content->coordinateBuffer;
+  const size_t numCoordinates = buffer.size();
+
+  // The components are packed into a tensor whose modes index the blocks and
+  // the components in a block, which the tensor then takes the arrays of
+  vector<vector<int>> levelCoordinates(2 * order,
+                                       vector<int>(numCoordinates));
+  for (int mode = 0; mode < order; ++mode) {
+    const int* column = buffer.getCoordinates(mode);
+    const int blockSize = blockSizes[mode];
+    for (size_t i = 0; i < numCoordinates; ++i) {
+      levelCoordinates[mode][i] = column[i] / blockSize;
+      levelCoordinates[order + mode][i] = column[i] % blockSize;
+    }
+  }
+  vector<const int*> levelColumns;
+  for (auto& column : levelCoordinates) {
+    levelColumns.push_back(column.data());
+  }
+
+  TensorBase levels(getComponentType(),
+                    format.getBlockLevelDimensions(getDimensions()),
+                    format.getBlockLevelFormat(), getFillValue());
+  levels.content->coordinateBuffer->push(levelColumns, buffer.getValues(),
+                                         numCoordinates);
+  buffer.clear();
+  levels.pack();
+
+  content->storage.setIndex(levels.getStorage().getIndex());
+  content->storage.setValues(levels.getStorage().getValues());
+  content->valuesSize = levels.content->valuesSize;
+}
+
+void TensorBase::packSliced() {
+  CoordinateBuffer& buffer = *content->coordinateBuffer;
+  const size_t numCoordinates = buffer.size();
+
+  // The components are packed into a CSR matrix first, which sorts them and
+  // sums duplicates, and the CSR matrix is then sliced
+  TensorBase csr(getComponentType(), getDimensions(), CSR, getFillValue());
+  csr.content->coordinateBuffer->push({buffer.getCoordinates(0),
+                                       buffer.getCoordinates(1)},
+                                      buffer.getValues(), numCoordinates);
+  buffer.clear();
+  csr.pack();
+
+  taco::packSliced(content->storage, csr.getStorage());
+  content->valuesSize = content->storage.getValues().getSize();
+}
+
 void TensorBase::setStorage(TensorStorage storage) {
   // TODO(pnoyola): figure out all possible interactions between
   // setStorage and automatic compilation machinery.
   content->needsPack = false;
+  content->neverPacked = false;
   content->storage = storage;
 }
 
 static inline map<TensorVar, TensorBase> getTensors(const IndexExpr& expr);
+static bool accessesViewedTensors(const TensorBase& tensor);
 
 /// Inherits Access and adds a TensorBase object, so that we can retrieve the
 /// tensors that was used in an expression when we later want to pack arguments.
@@ -577,32 +705,125 @@ const Access TensorBase::operator()() const {
   return this->operator()(std::vector<IndexVar>());
 }
 
-TensorBase::KernelsCache TensorBase::computeKernels;
-std::mutex TensorBase::computeKernelsMutex;
+/// A cache of compiled modules, bucketed by a hash of the key they were
+/// compiled for so that a lookup only compares keys that share a bucket.
+/// Lookups take a shared lock so that they do not serialize. Once the cache
+/// holds more than `capacity` modules the least recently used entries are
+/// evicted, which unloads their modules once no tensor holds on to them.
+template <typename Key>
+class TensorBase::ModuleCache {
+public:
+  ModuleCache(size_t capacity) : clock(0), size(0), capacity(capacity) {
+  }
+
+  /// Returns a cached module whose key is in the bucket of `hash` and for
+  /// which `matches` returns true, or nullptr if there is no such module.
+  template <typename Matcher>
+  std::shared_ptr<Module> get(size_t hash, Matcher matches) {
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    const auto bucket = buckets.find(hash);
+    if (bucket == buckets.end()) {
+      return nullptr;
+    }
+    const auto entriesReverse =
+        util::ReverseConstIterable<Bucket>(bucket->second);
+    for (const auto& entry : entriesReverse) {
+      if (matches(entry->key)) {
+        entry->lastUse = ++clock;
+        return entry->module;
+      }
+    }
+    return nullptr;
+  }
+
+  void insert(size_t hash, const Key& key, std::shared_ptr<Module> module) {
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    buckets[hash].emplace_back(new Entry(key, module, ++clock));
+    size++;
+    while (capacity > 0 && size > capacity) {
+      evictLeastRecentlyUsed();
+    }
+  }
 
-std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
-  computeKernelsMutex.lock();
-  const auto computeKernelsReverse =
-      util::ReverseConstIterable<TensorBase::KernelsCache>(computeKernels);
-  for (const auto& computeKernel : computeKernelsReverse) {
-    if (isomorphic(stmt, computeKernel.first)) {
-      const auto kernelModule = computeKernel.second;
-      computeKernelsMutex.unlock();
-      return kernelModule;
+private:
+  struct Entry {
+    Entry(const Key& key, std::shared_ptr<Module> module, uint64_t lastUse)
+        : key(key), module(module), lastUse(lastUse) {
+    }
+
+    Key key;
+    std::shared_ptr<Module> module;
+    std::atomic<uint64_t> lastUse;
+  };
+  typedef std::vector<std::unique_ptr<Entry>> Bucket;
+
+  // Eviction scans every entry, but it only happens after a module has been
+  // compiled, which dominates its cost.
+  void evictLeastRecentlyUsed() {
+    auto lruBucket = buckets.end();
+    size_t lruIndex = 0;
+    uint64_t lruTime = std::numeric_limits<uint64_t>::max();
+    for (auto bucket = buckets.begin(); bucket != buckets.end(); ++bucket) {
+      for (size_t i = 0; i < bucket->second.size(); ++i) {
+        if (bucket->second[i]->lastUse < lruTime) {
+          lruBucket = bucket;
+          lruIndex = i;
+          lruTime = bucket->second[i]->lastUse;
+        }
+      }
+    }
+    taco_iassert(lruBucket != buckets.end());
+    lruBucket->second.erase(lruBucket->second.begin() + lruIndex);
+    if (lruBucket->second.empty()) {
+      buckets.erase(lruBucket);
     }
+    size--;
   }
-  computeKernelsMutex.unlock();
-  return nullptr;
+
+  std::unordered_map<size_t, Bucket> buckets;
+  std::shared_timed_mutex mutex;
+  std::atomic<uint64_t> clock;
+  size_t size;
+  const size_t capacity;
+};
+
+/// Returns the capacity of a module cache, which can be set through the given
+/// environment variable. A capacity of zero means the cache is unbounded.
+static size_t getModuleCacheCapacity(std::string flag, size_t dflt) {
+  const std::string capacity = util::getFromEnv(flag, std::to_string(dflt));
+  return (size_t)strtoull(capacity.c_str(), nullptr, 10);
+}
+
+TensorBase::KernelsCache TensorBase::computeKernels(
+    getModuleCacheCapacity("TACO_KERNEL_CACHE_CAPACITY", 1024));
+
+std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
+  return computeKernels.get(structuralHash(stmt), [&](const IndexStmt& key) {
+    return isomorphic(stmt, key);
+  });
 }
 
 void TensorBase::cacheComputeKernel(const IndexStmt stmt,
                                     const std::shared_ptr<Module> kernel) {
-  computeKernelsMutex.lock();
-  computeKernels.emplace_back(stmt, kernel);
-  computeKernelsMutex.unlock();
+  computeKernels.insert(structuralHash(stmt), stmt, kernel);
+}
+
+/// Returns true unless kernel caching is disabled by setting the
+/// CACHE_KERNELS environment variable to 0.
+static bool isKernelCachingEnabled() {
+  return !std::getenv("CACHE_KERNELS") ||
+         std::string(std::getenv("CACHE_KERNELS")) != "0";
 }
 
 void TensorBase::compile() {
+  if (needsCompile() && accessesViewedTensors(*this)) {
+    compileViews();
+    return;
+  }
+  compile(getConcreteAssignment(), content->assembleWhileCompute);
+}
+
+IndexStmt TensorBase::getConcreteAssignment() {
   Assignment assignment = getAssignment();
   taco_uassert(assignment.defined())
       << error::compile_without_expr;
@@ -638,7 +859,7 @@ void TensorBase::compile() {
   stmt = reorderLoopsTopologically(stmt);
   stmt = insertTemporaries(stmt);
   stmt = parallelizeOuterLoop(stmt);
-  compile(stmt, content->assembleWhileCompute);
+  return stmt;
 }
 
 void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
@@ -646,13 +867,14 @@ void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
     return;
   }
   setNeedsCompile(false);
+  content->viewResult = nullptr;
+  content->viewOperands.clear();
 
   IndexStmt concretizedAssign = stmt;
   IndexStmt stmtToCompile = stmt.concretize();
   stmtToCompile = scalarPromote(stmtToCompile);
 
-  if (!std::getenv("CACHE_KERNELS") ||
-      std::string(std::getenv("CACHE_KERNELS")) != "0") {
+  if (isKernelCachingEnabled()) {
     concretizedAssign = stmtToCompile;
     const auto cachedKernel = getComputeKernel(concretizedAssign);
     if (cachedKernel) {
@@ -673,6 +895,387 @@ void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
   cacheComputeKernel(concretizedAssign, content->module);
 }
 
+void TensorBase::compile(std::vector<TensorBase> tensors) {
+  struct Kernel {
+    TensorBase tensor;
+    IndexStmt stmt;
+    size_t hash;
+    std::shared_ptr<Module> module;
+  };
+  std::vector<Kernel> kernels;
+
+  // Tensors whose kernel is isomorphic to a kernel compiled in this batch,
+  // along with the index of that kernel
+  std::vector<std::pair<TensorBase,size_t>> duplicates;
+
+  const bool caching = isKernelCachingEnabled();
+  for (auto& tensor : tensors) {
+    if (!tensor.needsCompile()) {
+      continue;
+    }
+    if (accessesViewedTensors(tensor)) {
+      tensor.compile();
+      continue;
+    }
+    IndexStmt stmt = tensor.getConcreteAssignment().concretize();
+    stmt = scalarPromote(stmt);
+    tensor.setNeedsCompile(false);
+
+    const size_t hash = structuralHash(stmt);
+    if (caching) {
+      const auto cachedKernel = getComputeKernel(stmt);
+      if (cachedKernel) {
+        tensor.content->module = cachedKernel;
+        continue;
+      }
+      auto kernel = std::find_if(kernels.begin(), kernels.end(),
+                                 [&](const Kernel& kernel) {
+        return kernel.hash == hash && isomorphic(kernel.stmt, stmt);
+      });
+      if (kernel != kernels.end()) {
+        duplicates.push_back({tensor, kernel - kernels.begin()});
+        continue;
+      }
+    }
+    kernels.push_back({tensor, stmt, hash, nullptr});
+  }
+  if (kernels.empty()) {
+    return;
+  }
+
+  // Kernels are grouped into one module per hardware thread, and every module
+  // is compiled as one translation unit
+  const size_t numModules =
+      std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u),
+               kernels.size());
+  std::vector<std::shared_ptr<Module>> modules;
+  for (size_t i = 0; i < numModules; ++i) {
+    modules.push_back(make_shared<Module>());
+  }
+
+  std::vector<std::map<std::string,std::string>> functionNames;
+  for (size_t i = 0; i < kernels.size(); ++i) {
+    Kernel& kernel = kernels[i];
+    Content* content = kernel.tensor.content.get();
+    const std::string suffix = "_" + util::toString(i);
+    content->assembleFunc = lower(kernel.stmt, "assemble" + suffix, true,
+                                  false);
+    content->computeFunc = lower(kernel.stmt, "compute" + suffix,
+                                 content->assembleWhileCompute, true);
+    kernel.module = modules[i * numModules / kernels.size()];
+    kernel.module->addFunction(content->assembleFunc);
+    kernel.module->addFunction(content->computeFunc);
+    functionNames.push_back({{"assemble", "assemble" + suffix},
+                             {"compute", "compute" + suffix}});
+  }
+
+  Module::compile(modules);
+
+  for (size_t i = 0; i < kernels.size(); ++i) {
+    Kernel& kernel = kernels[i];
+    kernel.tensor.content->module = Module::alias(kernel.module,
+                                                  functionNames[i]);
+    if (caching) {
+      cacheComputeKernel(kernel.stmt, kernel.tensor.content->module);
+    }
+  }
+  for (auto& duplicate : duplicates) {
+    TensorBase tensor = duplicate.first;
+    const TensorBase& original = kernels[duplicate.second].tensor;
+    tensor.content->assembleFunc = original.content->assembleFunc;
+    tensor.content->computeFunc = original.content->computeFunc;
+    tensor.content->module = original.content->module;
+  }
+}
+
+/// Returns true if the assignment of `tensor` accesses a blocked or sliced
+/// tensor.
+static bool accessesViewedTensors(const TensorBase& tensor) {
+  const Format& format = tensor.getFormat();
+  if (format.isBlocked() || format.isSliced()) {
+    return true;
+  }
+  for (auto& operand : getTensors(tensor.getAssignment().getRhs())) {
+    const Format& operandFormat = operand.second.getFormat();
+    if (operandFormat.isBlocked() || operandFormat.isSliced()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Kernels that access blocked tensors are compiled for views of the tensors,
+/// which the lowerer treats as any other tensor. Every index variable that
+/// accesses a blocked mode is split into an index variable over the blocks
+/// and one over the components in a block. A blocked tensor is viewed as the
+/// tensor of its block levels, which is accessed with the index variables
+/// over the blocks of its modes followed by those over the components in the
+/// blocks. Dense tensors are viewed as tensors whose modes are split into the
+/// same blocks, which store their components in the same order. The loops
+/// over the components in a block are thus dense loops without indirection.
+///
+/// A sliced matrix `A(i,j)` is viewed as the tensor of its levels, which is
+/// accessed as `A(c,k,i,j)` with fresh index variables over the chunks and
+/// over the columns of a chunk, so the loop over `i` is a loop over the rows
+/// of a chunk that is nested in the loops over the chunks and their columns.
+void TensorBase::compileViews() {
+  setNeedsCompile(false);
+  Assignment assignment = getAssignment();
+  Access lhs = assignment.getLhs();
+  taco_uassert(!getFormat().isSliced())
+      << "Sliced matrices cannot be computed, they can only be packed";
+
+  // Collect the block size of every index variable that accesses a blocked
+  // mode
+  map<IndexVar,int> blockSizes;
+  auto addBlockSizes = [&](const TensorBase& tensor,
+                           const vector<IndexVar>& indexVars) {
+    if (!tensor.getFormat().isBlocked()) {
+      return;
+    }
+    for (size_t mode = 0; mode < indexVars.size(); ++mode) {
+      const IndexVar& indexVar = indexVars[mode];
+      const int blockSize = tensor.getFormat().getBlockSizes()[mode];
+      taco_uassert(!util::contains(blockSizes, indexVar) ||
+                   blockSizes.at(indexVar) == blockSize)
+          << "Index variable " << indexVar << " accesses blocked modes with "
+          << "different block sizes";
+      blockSizes[indexVar] = blockSize;
+    }
+  };
+  addBlockSizes(*this, lhs.getIndexVars());
+  match(assignment.getRhs(), function<void(const AccessNode*)>(
+      [&](const AccessNode* op) {
+    if (isa<AccessTensorNode>(op)) {
+      addBlockSizes(to<AccessTensorNode>(op)->tensor, op->indexVars);
+    }
+  }));
+
+  map<IndexVar,pair<IndexVar,IndexVar>> splitVars;
+  for (auto& blockSize : blockSizes) {
+    const string name = blockSize.first.getName();
+    splitVars.insert({blockSize.first, {IndexVar(name + "_block"),
+                                        IndexVar(name + "_inner")}});
+  }
+
+  // Views are created once per tensor, so a tensor must be accessed with the
+  // same blocks every time it is accessed
+  map<TensorBase,pair<TensorBase,vector<bool>>> views;
+  auto getView = [&](const TensorBase& tensor,
+                     const vector<IndexVar>& indexVars,
+                     vector<IndexVar>* viewVars) -> TensorBase {
+    const Format& format = tensor.getFormat();
+    vector<bool> isBlockedMode;
+    for (auto& indexVar : indexVars) {
+      isBlockedMode.push_back(util::contains(splitVars, indexVar));
+    }
+
+    TensorBase view;
+    if (util::contains(views, tensor)) {
+      taco_uassert(views.at(tensor).second == isBlockedMode)
+          << "Tensor " << tensor.getName() << " is accessed with different "
+          << "blocks";
+      view = views.at(tensor).first;
+    } else if (format.isBlocked() || format.isSliced()) {
+      taco_uassert(!format.isSliced() ||
+                   std::find(isBlockedMode.begin(), isBlockedMode.end(),
+                             true) == isBlockedMode.end())
+          << "Sliced matrices cannot be accessed with the index variables of "
+          << "blocked modes";
+      view = TensorBase(tensor.getName(), tensor.getComponentType(),
+                        format.getLevelDimensions(tensor.getDimensions()),
+                        format.getLevelFormat(), tensor.getFillValue());
+    } else if (std::find(isBlockedMode.begin(), isBlockedMode.end(), true) ==
+               isBlockedMode.end()) {
+      view = TensorBase(tensor.getName(), tensor.getComponentType(),
+                        tensor.getDimensions(), format, tensor.getFillValue());
+    } else {
+      taco_uassert(isDense(format))
+          << "Tensor " << tensor.getName() << " is accessed with the index "
+          << "variables of blocked modes, so it must be blocked or dense";
+      vector<int> dimensions;
+      for (int level = 0; level < tensor.getOrder(); ++level) {
+        const int mode = format.getModeOrdering()[level];
+        const int dimension = tensor.getDimension(mode);
+        if (isBlockedMode[mode]) {
+          const int blockSize = blockSizes.at(indexVars[mode]);
+          taco_uassert(dimension % blockSize == 0)
+              << "The dimensions of dense tensors that are accessed with the "
+              << "index variables of blocked modes must be multiples of the "
+              << "block sizes";
+          dimensions.push_back(dimension / blockSize);
+          dimensions.push_back(blockSize);
+        } else {
+          dimensions.push_back(dimension);
+        }
+      }
+      view = TensorBase(tensor.getName(), tensor.getComponentType(),
+                        dimensions,
+                        Format(vector<ModeFormatPack>(dimensions.size(),
+                                                      ModeFormat::Dense)),
+                        tensor.getFillValue());
+    }
+    views.insert({tensor, {view, isBlockedMode}});
+
+    if (format.isBlocked()) {
+      for (auto& indexVar : indexVars) {
+        viewVars->push_back(splitVars.at(indexVar).first);
+      }
+      for (auto& indexVar : indexVars) {
+        viewVars->push_back(splitVars.at(indexVar).second);
+      }
+    } else if (format.isSliced()) {
+      const string name = indexVars[0].getName();
+      viewVars->push_back(IndexVar(name + "_chunk"));
+      viewVars->push_back(IndexVar(name + "_column"));
+      viewVars->insert(viewVars->end(), indexVars.begin(), indexVars.end());
+    } else {
+      for (int level = 0; level < tensor.getOrder(); ++level) {
+        const IndexVar& indexVar = indexVars[format.getModeOrdering()[level]];
+        if (util::contains(splitVars, indexVar)) {
+          viewVars->push_back(splitVars.at(indexVar).first);
+          viewVars->push_back(splitVars.at(indexVar).second);
+        } else {
+          viewVars->push_back(indexVar);
+        }
+      }
+    }
+    return view;
+  };
+
+  struct BlockRewriter : public IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+    const map<IndexVar,pair<IndexVar,IndexVar>>& splitVars;
+    function<TensorBase(const TensorBase&, const vector<IndexVar>&,
+                        vector<IndexVar>*)> getView;
+    vector<pair<TensorBase,TensorBase>> operands;
+
+    // Every component of a sliced matrix is stored below one chunk and one
+    // column of the chunk, which are summed over. The sums are hoisted out of
+    // products, so that the loops over the chunks and their columns enclose
+    // the loops over the components of the product, and are added around the
+    // terms of sums.
+    vector<IndexVar> slicedVars;
+
+    IndexExpr sumSlicedVars(IndexExpr expr, size_t begin) {
+      while (slicedVars.size() > begin) {
+        expr = sum(slicedVars.back(), expr);
+        slicedVars.pop_back();
+      }
+      return expr;
+    }
+
+    BlockRewriter(const map<IndexVar,pair<IndexVar,IndexVar>>& splitVars,
+                  decltype(getView) getView)
+        : splitVars(splitVars), getView(getView) {}
+
+    void visit(const AccessNode* op) {
+      if (!isa<AccessTensorNode>(op)) {
+        expr = op;
+        return;
+      }
+      TensorBase tensor = to<AccessTensorNode>(op)->tensor;
+      bool isViewed = tensor.getFormat().isBlocked() ||
+                      tensor.getFormat().isSliced();
+      for (auto& indexVar : op->indexVars) {
+        isViewed |= util::contains(splitVars, indexVar);
+      }
+      if (!isViewed) {
+        expr = op;
+        return;
+      }
+      taco_uassert(op->windowedModes.empty() && op->indexSetModes.empty())
+          << "Blocked and sliced tensors cannot be windowed";
+      vector<IndexVar> viewVars;
+      TensorBase view = getView(tensor, op->indexVars, &viewVars);
+      operands.push_back({tensor, view});
+      expr = view(viewVars);
+      if (tensor.getFormat().isSliced()) {
+        slicedVars.push_back(viewVars[0]);
+        slicedVars.push_back(viewVars[1]);
+      }
+    }
+
+    void visit(const AddNode* op) {
+      const size_t begin = slicedVars.size();
+      IndexExpr a = sumSlicedVars(rewrite(op->a), begin);
+      IndexExpr b = sumSlicedVars(rewrite(op->b), begin);
+      expr = a + b;
+    }
+
+    void visit(const SubNode* op) {
+      const size_t begin = slicedVars.size();
+      IndexExpr a = sumSlicedVars(rewrite(op->a), begin);
+      IndexExpr b = sumSlicedVars(rewrite(op->b), begin);
+      expr = a - b;
+    }
+
+    void visit(const ReductionNode* op) {
+      IndexExpr a = rewrite(op->a);
+      if (util::contains(splitVars, op->var)) {
+        const auto& vars = splitVars.at(op->var);
+        expr = Reduction(op->op, vars.first, Reduction(op->op, vars.second, a));
+      } else {
+        expr = Reduction(op->op, op->var, a);
+      }
+    }
+  };
+  BlockRewriter rewriter(splitVars, getView);
+  IndexExpr rhs = rewriter.sumSlicedVars(rewriter.rewrite(assignment.getRhs()),
+                                         0);
+
+  vector<IndexVar> resultVars;
+  TensorBase result = getView(*this, lhs.getIndexVars(), &resultVars);
+  result.setAssembleWhileCompute(content->assembleWhileCompute);
+  result.setAssignment(Assignment(result(resultVars), rhs,
+                                  assignment.getOperator()));
+  result.setNeedsCompile(true);
+
+  result.compile(result.getConcreteAssignment(),
+                 content->assembleWhileCompute);
+
+  content->viewResult = make_shared<TensorBase>(result);
+  content->viewOperands = rewriter.operands;
+  content->assembleFunc = result.content->assembleFunc;
+  content->computeFunc = result.content->computeFunc;
+  content->module = result.content->module;
+}
+
+/// Returns storage of `view` that shares the arrays of `tensor`.
+static TensorStorage getViewStorage(const TensorBase& tensor,
+                                    const TensorBase& view) {
+  TensorStorage storage(view.getComponentType(), view.getDimensions(),
+                        view.getFormat(), view.getFillValue());
+  if (tensor.getFormat().getLevelFormat().getOrder() == view.getOrder()) {
+    storage.setIndex(tensor.getStorage().getIndex());
+  } else {
+    vector<ModeIndex> modeIndices;
+    for (int mode = 0; mode < view.getOrder(); ++mode) {
+      modeIndices.push_back(ModeIndex({makeArray({view.getDimension(mode)})}));
+    }
+    storage.setIndex(Index(view.getFormat(), modeIndices));
+  }
+  storage.setValues(tensor.getStorage().getValues());
+  return storage;
+}
+
+void TensorBase::refreshViews() {
+  for (auto& operand : content->viewOperands) {
+    operand.second.setStorage(getViewStorage(operand.first, operand.second));
+  }
+  content->viewResult->setStorage(getViewStorage(*this,
+                                                    *content->viewResult));
+}
+
+void TensorBase::unpackViewResult() {
+  const TensorBase& result = *content->viewResult;
+  if (getFormat().getLevelFormat().getOrder() == result.getOrder()) {
+    content->storage.setIndex(result.getStorage().getIndex());
+  }
+  content->storage.setValues(result.getStorage().getValues());
+  content->valuesSize = result.content->valuesSize;
+}
+
 taco_tensor_t* TensorBase::getTacoTensorT() {
   return getStorage();
 }
@@ -816,6 +1419,17 @@ void TensorBase::assemble() {
     operand.second.syncValues();
   }
 
+  if (content->viewResult) {
+    refreshViews();
+    content->viewResult->setNeedsAssemble(true);
+    content->viewResult->assemble();
+    if (!content->assembleWhileCompute) {
+      setNeedsAssemble(false);
+      unpackViewResult();
+    }
+    return;
+  }
+
   auto arguments = packArguments(*this);
   content->module->callFuncPacked("assemble", arguments.data());
 
@@ -839,6 +1453,17 @@ void TensorBase::compute() {
     operand.second.removeDependentTensor(*this);
   }
 
+  if (content->viewResult) {
+    refreshViews();
+    content->viewResult->setNeedsCompute(true);
+    content->viewResult->compute();
+    if (content->assembleWhileCompute) {
+      setNeedsAssemble(false);
+    }
+    unpackViewResult();
+    return;
+  }
+
   auto arguments = packArguments(*this);
   this->content->module->callFuncPacked("compute", arguments.data());
 
@@ -929,34 +1554,34 @@ void TensorBase::compileSource(std::string source) {
   setNeedsCompile(false);
 }
 
-TensorBase::HelperFuncsCache TensorBase::helperFunctions;
-std::mutex TensorBase::helperFunctionsMutex;
+TensorBase::HelperFuncsCache TensorBase::helperFunctions(
+    getModuleCacheCapacity("TACO_HELPER_CACHE_CAPACITY", 256));
+
+static size_t hashHelperFunctionsKey(const Format& format, Datatype ctype) {
+  size_t hash = std::hash<std::string>()(util::toString(format));
+  util::hashCombine(hash, (size_t)ctype.getKind());
+  return hash;
+}
 
 std::shared_ptr<ir::Module>
-TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
-                               const std::vector<int>& dimensions) {
-  helperFunctionsMutex.lock();
-  const auto helperFunctionsReverse =
-      util::ReverseConstIterable<TensorBase::HelperFuncsCache>(helperFunctions);
-  for (const auto& helperFuncs : helperFunctionsReverse) {
-    if (std::get<0>(helperFuncs) == format &&
-        std::get<1>(helperFuncs) == ctype &&
-        std::get<2>(helperFuncs) == dimensions) {
-      // If helper functions had already been generated for specified tensor
-      // format and type, then use cached version.
-      const auto helperFuncsModule = std::get<3>(helperFuncs);
-      helperFunctionsMutex.unlock();
-      return helperFuncsModule;
-    }
+TensorBase::getHelperFunctions(const Format& format, Datatype ctype) {
+  // If helper functions had already been generated for specified tensor
+  // format and type, then use cached version.
+  const size_t hash = hashHelperFunctionsKey(format, ctype);
+  const auto key = std::make_pair(format, ctype);
+  const auto cachedHelperFuncs = helperFunctions.get(hash,
+      [&](const std::pair<Format,Datatype>& cachedKey) {
+        return cachedKey == key;
+      });
+  if (cachedHelperFuncs) {
+    return cachedHelperFuncs;
   }
-  helperFunctionsMutex.unlock();
 
   std::shared_ptr<Module> helperModule = std::make_shared<Module>();
 
-  std::function<Dimension(int)> getDim = [](int dim) {
-    return Dimension(dim);
-  };
-  const auto dims = util::map(dimensions, getDim);
+  // The helpers read the dimensions from the tensors they are called with, so
+  // one module serves tensors of every shape
+  const std::vector<Dimension> dims(format.getOrder(), Dimension());
 
   if (format.getOrder() > 0) {
     const Format bufferFormat = COO(format.getOrder(), false, true, false,
@@ -975,6 +1600,13 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
       iterateStmt = forall(indexVars[mode], iterateStmt);
     }
 
+    // Formats with levels that can only be iterated (e.g. the levels of
+    // sliced matrices) are packed by the tensor instead
+    bool canAssemble = true;
+    for (const auto& modeFormat : format.getModeFormats()) {
+      canAssemble &= (modeFormat.hasAppend() || modeFormat.hasInsert());
+    }
+
     bool doAppend = true;
     for (int i = format.getOrder() - 1; i >= 0; --i) {
       const auto modeFormat = format.getModeFormats()[i];
@@ -986,12 +1618,14 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
         }
       }
     }
-    if (!doAppend) {
+    if (!doAppend && canAssemble) {
       packStmt = packStmt.assemble(packedTensor, AssembleStrategy::Insert);
     }
 
     // Lower packing and iterator code.
-    helperModule->addFunction(lower(packStmt, "pack", true, true));
+    if (canAssemble) {
+      helperModule->addFunction(lower(packStmt, "pack", true, true));
+    }
     helperModule->addFunction(lower(iterateStmt, "iterate", false, true));
   } else {
     const Format bufferFormat = COO(1, false, true, false);
@@ -1011,10 +1645,7 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
     helperModule->addFunction(lower(iterateStmt, "iterate", false, true));
   }
   helperModule->compile();
-
-  helperFunctionsMutex.lock();
-  helperFunctions.emplace_back(format, ctype, dimensions, helperModule);
-  helperFunctionsMutex.unlock();
+  helperFunctions.insert(hash, key, helperModule);
 
   return helperModule;
 }
@@ -1181,26 +1812,31 @@ ostream& operator<<(ostream& os, const TensorBase& tensor) {
      << tensor.getFormat() << ":" << std::endl;
 
   // Print coordinates
-  size_t numCoordinates = tensor.content->coordinateBufferUsed / tensor.content->coordinateSize;
-  for (size_t i = 0; i < numCoordinates; i++) {
-    int* ptr = (int*)&tensor.content->coordinateBuffer->data()[i * tensor.content->coordinateSize];
-    os << "(" << util::join(ptr, ptr+tensor.getOrder()) << "): ";
+  const CoordinateBuffer& buffer = *tensor.content->coordinateBuffer;
+  const size_t csize = tensor.getComponentType().getNumBytes();
+  vector<int> coordinate(tensor.getOrder());
+  for (size_t i = 0; i < buffer.size(); i++) {
+    for (int mode = 0; mode < tensor.getOrder(); ++mode) {
+      coordinate[mode] = buffer.getCoordinates(mode)[i];
+    }
+    const char* ptr = (const char*)buffer.getValues() + i * csize;
+    os << "(" << util::join(coordinate) << "): ";
     switch(tensor.getComponentType().getKind()) {
       case Datatype::Bool: taco_ierror; break;
-      case Datatype::UInt8: os << ((uint8_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt16: os << ((uint16_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt32: os << ((uint32_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt64: os << ((uint64_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt128: os << ((unsigned long long*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int8: os << ((int8_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int16: os << ((int16_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int32: os << ((int32_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int64: os << ((int64_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int128: os << ((long long*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Float32: os << ((float*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Float64: os << ((double*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Complex64: os << ((std::complex<float>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Complex128: os << ((std::complex<double>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
+      case Datatype::UInt8: os << ((uint8_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt16: os << ((uint16_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt32: os << ((uint32_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt64: os << ((uint64_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt128: os << ((unsigned long long*)ptr)[0] << std::endl; break;
+      case Datatype::Int8: os << ((int8_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int16: os << ((int16_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int32: os << ((int32_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int64: os << ((int64_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int128: os << ((long long*)ptr)[0] << std::endl; break;
+      case Datatype::Float32: os << ((float*)ptr)[0] << std::endl; break;
+      case Datatype::Float64: os << ((double*)ptr)[0] << std::endl; break;
+      case Datatype::Complex64: os << ((std::complex<float>*)ptr)[0] << std::endl; break;
+      case Datatype::Complex128: os << ((std::complex<double>*)ptr)[0] << std::endl; break;
       case Datatype::Undefined: taco_ierror; break;
     }
   }
@@ -1221,26 +1857,31 @@ ostream& operator<<(ostream& os, TensorBase& tensor) {
      << tensor.getFormat() << ":" << std::endl;
 
   // Print coordinates
-  size_t numCoordinates = tensor.content->coordinateBufferUsed / tensor.content->coordinateSize;
-  for (size_t i = 0; i < numCoordinates; i++) {
-    int* ptr = (int*)&tensor.content->coordinateBuffer->data()[i*tensor.content->coordinateSize];
-    os << "(" << util::join(ptr, ptr+tensor.getOrder()) << "): ";
+  const CoordinateBuffer& buffer = *tensor.content->coordinateBuffer;
+  const size_t csize = tensor.getComponentType().getNumBytes();
+  vector<int> coordinate(tensor.getOrder());
+  for (size_t i = 0; i < buffer.size(); i++) {
+    for (int mode = 0; mode < tensor.getOrder(); ++mode) {
+      coordinate[mode] = buffer.getCoordinates(mode)[i];
+    }
+    const char* ptr = (const char*)buffer.getValues() + i * csize;
+    os << "(" << util::join(coordinate) << "): ";
     switch(tensor.getComponentType().getKind()) {
       case Datatype::Bool: taco_ierror; break;
-      case Datatype::UInt8: os << ((uint8_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt16: os << ((uint16_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt32: os << ((uint32_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt64: os << ((uint64_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::UInt128: os << ((unsigned long long*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int8: os << ((int8_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int16: os << ((int16_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int32: os << ((int32_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int64: os << ((int64_t*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Int128: os << ((long long*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Float32: os << ((float*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Float64: os << ((double*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Complex64: os << ((std::complex<float>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
-      case Datatype::Complex128: os << ((std::complex<double>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
+      case Datatype::UInt8: os << ((uint8_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt16: os << ((uint16_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt32: os << ((uint32_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt64: os << ((uint64_t*)ptr)[0] << std::endl; break;
+      case Datatype::UInt128: os << ((unsigned long long*)ptr)[0] << std::endl; break;
+      case Datatype::Int8: os << ((int8_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int16: os << ((int16_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int32: os << ((int32_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int64: os << ((int64_t*)ptr)[0] << std::endl; break;
+      case Datatype::Int128: os << ((long long*)ptr)[0] << std::endl; break;
+      case Datatype::Float32: os << ((float*)ptr)[0] << std::endl; break;
+      case Datatype::Float64: os << ((double*)ptr)[0] << std::endl; break;
+      case Datatype::Complex64: os << ((std::complex<float>*)ptr)[0] << std::endl; break;
+      case Datatype::Complex128: os << ((std::complex<double>*)ptr)[0] << std::endl; break;
       case Datatype::Undefined: taco_ierror; break;
     }
   }
@@ -1269,6 +1910,9 @@ TensorBase dispatchRead(T& file, FileType filetype, U format, bool pack) {
     case FileType::rb:
       tensor = readRB(file, format, pack);
       break;
+    case FileType::taco:
+      tensor = readTACO(file, format, pack);
+      break;
   }
   return tensor;
 }
@@ -1290,6 +1934,9 @@ TensorBase dispatchRead(std::string filename, U format, bool pack) {
   else if (extension == "rb") {
     tensor = dispatchRead(filename, FileType::rb, format, pack);
   }
+  else if (extension == "taco") {
+    tensor = dispatchRead(filename, FileType::taco, format, pack);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
@@ -1341,6 +1988,9 @@ void dispatchWrite(T& file, const TensorBase& tensor, FileType filetype) {
     case FileType::rb:
       writeRB(file, tensor);
       break;
+    case FileType::taco:
+      writeTACO(file, tensor);
+      break;
   }
 }
 
@@ -1361,6 +2011,9 @@ void write(string filename, const TensorBase& tensor) {
   else if (extension == "rb") {
     dispatchWrite(filename, tensor, FileType::rb);
   }
+  else if (extension == "taco") {
+    dispatchWrite(filename, tensor, FileType::taco);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
@@ -1374,6 +2027,17 @@ void write(ofstream& stream, FileType filetype, const TensorBase& tensor) {
   dispatchWrite(stream, tensor, filetype);
 }
 
+TensorBase makeSELL(const std::string& name, const TensorBase& csr,
+                    int chunkSize, int sortWindow) {
+  taco_uassert(csr.getOrder() == 2) << error::requires_matrix;
+  TensorBase tensor(name, csr.getComponentType(), csr.getDimensions(),
+                    SELL(chunkSize, sortWindow), csr.getFillValue());
+  TensorStorage storage = tensor.getStorage();
+  packSliced(storage, csr.getStorage());
+  tensor.setStorage(storage);
+  return tensor;
+}
+
 void packOperands(const TensorBase& tensor) {
   auto operands = getArguments(makeConcreteNotation(tensor.getAssignment()));
 
@@ -5,6 +5,10 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -24,4 +28,43 @@ void openStream(std::fstream& stream, std::string path, fstream::openmode mode)
   taco_uassert(stream.is_open()) << "Error opening file: " << path;
 }
 
+MappedFile::MappedFile(std::string path, bool copyOnWrite)
+    : data(nullptr), size(0) {
+  int fd = open(sanitizePath(path).c_str(), O_RDONLY);
+  taco_uassert(fd != -1) << "Error opening file: " << path;
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) == -1) {
+    close(fd);
+    taco_uerror << "Error reading file: " << path;
+  }
+  size = fileStat.st_size;
+  if (size > 0) {
+    const int protection = copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* mapped = mmap(nullptr, size, protection, MAP_PRIVATE, fd, 0);
+    close(fd);
+    taco_uassert(mapped != MAP_FAILED) << "Error mapping file: " << path;
+    if (!copyOnWrite) {
+      // Read-only maps are parsed front to back
+      madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    data = (const char*)mapped;
+  } else {
+    close(fd);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data != nullptr) {
+    munmap((void*)data, size);
+  }
+}
+
+const char* MappedFile::getData() const {
+  return data;
+}
+
+size_t MappedFile::getSize() const {
+  return size;
+}
+
 }}
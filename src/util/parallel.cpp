@@ -0,0 +1,56 @@
+#include "taco/util/parallel.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace taco {
+namespace util {
+
+size_t getNumWorkers(size_t n, size_t grain, size_t maxThreads) {
+  if (maxThreads == 0) {
+    maxThreads = std::max(thread::hardware_concurrency(), 1u);
+  }
+  return std::max(std::min(maxThreads, n / std::max(grain, (size_t)1)),
+                  (size_t)1);
+}
+
+void parallelFor(size_t n, size_t numWorkers,
+                 const function<void(size_t,size_t,size_t)>& f) {
+  numWorkers = std::max(numWorkers, (size_t)1);
+  if (numWorkers == 1) {
+    f(0, 0, n);
+    return;
+  }
+
+  mutex errorMutex;
+  exception_ptr error;
+  auto run = [&](size_t worker) {
+    try {
+      f(worker, worker * n / numWorkers, (worker + 1) * n / numWorkers);
+    } catch (...) {
+      lock_guard<mutex> lock(errorMutex);
+      if (!error) {
+        error = current_exception();
+      }
+    }
+  };
+
+  vector<thread> threads;
+  for (size_t worker = 1; worker < numWorkers; ++worker) {
+    threads.emplace_back(run, worker);
+  }
+  run(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    rethrow_exception(error);
+  }
+}
+
+}}
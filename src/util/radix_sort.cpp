@@ -0,0 +1,143 @@
+#include "taco/util/radix_sort.h"
+
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+#include "taco/error.h"
+#include "taco/util/parallel.h"
+
+using namespace std;
+
+namespace taco {
+namespace util {
+
+static const int digitBits = 8;
+static const size_t numBuckets = (size_t)1 << digitBits;
+
+// Smallest number of records per thread for a pass to be split across threads
+static const size_t grain = (size_t)1 << 16;
+
+static inline uint32_t getField(const void* field, size_t stride, size_t i) {
+  uint32_t value;
+  memcpy(&value, (const char*)field + i*stride, sizeof(value));
+  return value;
+}
+
+vector<uint32_t> radixSortPermutation(const vector<const void*>& fields,
+                                      size_t stride, size_t n,
+                                      size_t maxThreads) {
+  taco_uassert(n <= UINT32_MAX) << "Cannot sort more than " << UINT32_MAX
+                                << " records";
+  const size_t numWorkers = getNumWorkers(n, grain, maxThreads);
+  const int numFields = (int)fields.size();
+
+  // Compute the number of bits needed by each field
+  vector<vector<uint32_t>> setBits(numWorkers, vector<uint32_t>(numFields, 0));
+  parallelFor(n, numWorkers, [&](size_t worker, size_t begin, size_t end) {
+    for (int j = 0; j < numFields; ++j) {
+      uint32_t bits = 0;
+      for (size_t i = begin; i < end; ++i) {
+        bits |= getField(fields[j], stride, i);
+      }
+      setBits[worker][j] = bits;
+    }
+  });
+  vector<int> fieldBits(numFields, 0);
+  for (int j = 0; j < numFields; ++j) {
+    uint32_t bits = 0;
+    for (size_t worker = 0; worker < numWorkers; ++worker) {
+      bits |= setBits[worker][j];
+    }
+    fieldBits[j] = (bits == 0) ? 0 : 32 - __builtin_clz(bits);
+  }
+
+  // Pack the fields into as few 64-bit words as possible. Words are ordered
+  // from least to most significant, which is the order they are sorted in.
+  struct Word {
+    int begin;
+    int end;
+    int bits;
+  };
+  vector<Word> words;
+  for (int j = numFields - 1; j >= 0; --j) {
+    if (words.empty() || words.back().bits + fieldBits[j] > 64) {
+      words.push_back({j, j + 1, 0});
+    }
+    words.back().begin = j;
+    words.back().bits += fieldBits[j];
+  }
+
+  vector<uint32_t> perm(n), permTmp(n);
+  vector<uint64_t> keys(n), keysTmp(n);
+  vector<size_t> offsets(numWorkers * numBuckets);
+  bool isIdentity = true;
+  for (const Word& word : words) {
+    if (word.bits == 0) {
+      continue;
+    }
+
+    // Gather the keys of this word in the order sorted so far
+    parallelFor(n, numWorkers, [&](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const uint32_t record = isIdentity ? (uint32_t)i : perm[i];
+        uint64_t key = 0;
+        for (int j = word.begin; j < word.end; ++j) {
+          key = (key << fieldBits[j]) | getField(fields[j], stride, record);
+        }
+        keys[i] = key;
+        perm[i] = record;
+      }
+    });
+    isIdentity = false;
+
+    for (int shift = 0; shift < word.bits; shift += digitBits) {
+      // Count the digits in every worker's range
+      parallelFor(n, numWorkers, [&](size_t worker, size_t begin, size_t end) {
+        size_t* counts = &offsets[worker * numBuckets];
+        std::fill(counts, counts + numBuckets, 0);
+        for (size_t i = begin; i < end; ++i) {
+          counts[(keys[i] >> shift) & (numBuckets - 1)]++;
+        }
+      });
+
+      // Turn the counts into the position of each worker's first record with
+      // each digit. A pass where every record has the same digit is skipped.
+      size_t offset = 0;
+      bool isUniform = false;
+      for (size_t digit = 0; digit < numBuckets; ++digit) {
+        const size_t digitBegin = offset;
+        for (size_t worker = 0; worker < numWorkers; ++worker) {
+          const size_t count = offsets[worker * numBuckets + digit];
+          offsets[worker * numBuckets + digit] = offset;
+          offset += count;
+        }
+        if (offset - digitBegin == n) {
+          isUniform = true;
+        }
+      }
+      if (isUniform) {
+        continue;
+      }
+
+      parallelFor(n, numWorkers, [&](size_t worker, size_t begin, size_t end) {
+        size_t* positions = &offsets[worker * numBuckets];
+        for (size_t i = begin; i < end; ++i) {
+          const size_t position =
+              positions[(keys[i] >> shift) & (numBuckets - 1)]++;
+          keysTmp[position] = keys[i];
+          permTmp[position] = perm[i];
+        }
+      });
+      std::swap(keys, keysTmp);
+      std::swap(perm, permTmp);
+    }
+  }
+
+  if (isIdentity) {
+    std::iota(perm.begin(), perm.end(), 0);
+  }
+  return perm;
+}
+
+}}
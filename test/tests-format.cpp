@@ -72,3 +72,359 @@ TEST(format, dense) {
   A.pack();
   ASSERT_COMPONENTS_EQUALS({{{3}}, {{3}}}, {0,2,0, 0,0,0, 3,0,4}, A);
 }
+
+TEST(format, bitpacked) {
+  Format dbp({Dense, BitPacked});
+  Tensor<double> A("A", {40, 5000}, dbp);
+  Tensor<double> B("B", {40, 5000}, dbp);
+  Tensor<double> Acsr("Acsr", {40, 5000}, CSR);
+  Tensor<double> Bcsr("Bcsr", {40, 5000}, CSR);
+  Tensor<double> x("x", {5000}, Dense);
+  for (int i = 0; i < 40; i++) {
+    // Rows of clustered, scattered and no coordinates, so that blocks have
+    // every delta width from 0 to 12 bits
+    for (int j = 0; j < 5000; j += (i % 3 == 0) ? 1 + i : 97 + 7 * i) {
+      if (i % 5 == 4) break;
+      A.insert({i, j}, (double)(i + j));
+      Acsr.insert({i, j}, (double)(i + j));
+    }
+    for (int j = i; j < 5000; j += 3 + 11 * i) {
+      B.insert({i, j}, 1.0);
+      Bcsr.insert({i, j}, 1.0);
+    }
+  }
+  for (int j = 0; j < 5000; j++) {
+    x.insert({j}, (double)(j % 7));
+  }
+  A.pack();
+  B.pack();
+  Acsr.pack();
+  Bcsr.pack();
+  x.pack();
+  ASSERT_TRUE(equals(A, Acsr));
+
+  // The packed coordinates take fewer words than the compressed ones
+  const size_t nnz = Acsr.getStorage().getIndex().getModeIndex(1)
+                         .getIndexArray(1).getSize();
+  EXPECT_LT(A.getStorage().getIndex().getModeIndex(1).getIndexArray(1)
+                .getSize(), nnz / 2);
+
+  IndexVar i, j;
+  Tensor<double> y("y", {40}, Dense);
+  Tensor<double> ycsr("ycsr", {40}, Dense);
+  y(i) = A(i,j) * x(j);
+  ycsr(i) = Acsr(i,j) * x(j);
+  y.evaluate();
+  ycsr.evaluate();
+  ASSERT_TRUE(equals(y, ycsr));
+
+  // Results are assembled with bit-packed coordinates
+  Tensor<double> C("C", {40, 5000}, dbp);
+  Tensor<double> Ccsr("Ccsr", {40, 5000}, CSR);
+  C(i,j) = A(i,j) + B(i,j);
+  Ccsr(i,j) = Acsr(i,j) + Bcsr(i,j);
+  C.evaluate();
+  Ccsr.evaluate();
+  ASSERT_TRUE(equals(C, Ccsr));
+
+  ASSERT_THROW(BitPacked(ModeFormat::NOT_UNIQUE), TacoException);
+}
+
+TEST(format, hashed) {
+  Format dh({Dense, Hashed});
+  Format dd({Dense, Dense});
+  Tensor<double> A("A", {6, 50}, dh);
+  Tensor<double> Acsr("Acsr", {6, 50}, CSR);
+  Tensor<double> B("B", {6, 50}, CSR);
+  Tensor<double> x("x", {50}, Dense);
+  for (int i = 0; i < 6; i++) {
+    for (int j = i; j < 50; j += 3 + i) {
+      A.insert({i, j}, (double)(i + j));
+      Acsr.insert({i, j}, (double)(i + j));
+    }
+    for (int j = 2 * i; j < 50; j += 17) {
+      B.insert({i, j}, 1.0 + j);
+    }
+  }
+  for (int j = 0; j < 50; j++) {
+    x.insert({j}, (double)(j % 7));
+  }
+  A.pack();
+  Acsr.pack();
+  B.pack();
+  x.pack();
+
+  // Hashed levels are unordered, so they are compared in a dense format
+  IndexVar i, j;
+  Tensor<double> Ad("Ad", {6, 50}, dd);
+  Tensor<double> Acsrd("Acsrd", {6, 50}, dd);
+  Ad(i,j) = A(i,j);
+  Acsrd(i,j) = Acsr(i,j);
+  Ad.evaluate();
+  Acsrd.evaluate();
+  ASSERT_TRUE(equals(Ad, Acsrd));
+
+  Tensor<double> y("y", {6}, Dense);
+  Tensor<double> ycsr("ycsr", {6}, Dense);
+  y(i) = A(i,j) * x(j);
+  ycsr(i) = Acsr(i,j) * x(j);
+  y.evaluate();
+  ycsr.evaluate();
+  ASSERT_TRUE(equals(y, ycsr));
+
+  // Coordinates of B are located in the tables of A
+  Tensor<double> z("z", {6}, Dense);
+  Tensor<double> zcsr("zcsr", {6}, Dense);
+  z(i) = B(i,j) * A(i,j);
+  zcsr(i) = B(i,j) * Acsr(i,j);
+  z.evaluate();
+  zcsr.evaluate();
+  ASSERT_TRUE(equals(z, zcsr));
+
+  Tensor<double> U("U", {6, 50}, dd);
+  Tensor<double> Ucsr("Ucsr", {6, 50}, dd);
+  U(i,j) = A(i,j) + B(i,j);
+  Ucsr(i,j) = Acsr(i,j) + B(i,j);
+  U.evaluate();
+  Ucsr.evaluate();
+  ASSERT_TRUE(equals(U, Ucsr));
+
+  // Results are assembled by inserting into the tables
+  Tensor<double> C("C", {6, 50}, dh);
+  Tensor<double> Cd("Cd", {6, 50}, dd);
+  Tensor<double> Cexpected("Cexpected", {6, 50}, dd);
+  C(i,j) = B(i,j) * 2.0;
+  C.evaluate();
+  Cd(i,j) = C(i,j);
+  Cexpected(i,j) = B(i,j) * 2.0;
+  Cd.evaluate();
+  Cexpected.evaluate();
+  ASSERT_TRUE(equals(Cd, Cexpected));
+
+  Tensor<double> w("w", {6}, Format({Hashed}));
+  Tensor<double> wd("wd", {6}, Dense);
+  Tensor<double> wexpected("wexpected", {6}, Dense);
+  w(i) = B(i,j) * x(j);
+  w.evaluate();
+  wd(i) = w(i);
+  wexpected(i) = B(i,j) * x(j);
+  wd.evaluate();
+  wexpected.evaluate();
+  ASSERT_TRUE(equals(wd, wexpected));
+
+  ASSERT_THROW(Hashed(ModeFormat::NOT_UNIQUE), TacoException);
+}
+
+TEST(format, bitmap) {
+  Format db({Dense, Bitmap});
+  Tensor<double> A("A", {6, 70}, db);
+  Tensor<double> Acsr("Acsr", {6, 70}, CSR);
+  Tensor<double> B("B", {6, 70}, db);
+  Tensor<double> Bcsr("Bcsr", {6, 70}, CSR);
+  Tensor<double> x("x", {70}, Dense);
+  for (int i = 0; i < 6; i++) {
+    for (int j = i; j < 70; j += 3 + i) {
+      A.insert({i, j}, (double)(i + j));
+      Acsr.insert({i, j}, (double)(i + j));
+    }
+    for (int j = 2 * i; j < 70; j += 5) {
+      B.insert({i, j}, 1.0 + j);
+      Bcsr.insert({i, j}, 1.0 + j);
+    }
+  }
+  for (int j = 0; j < 70; j++) {
+    x.insert({j}, (double)(j % 7));
+  }
+  A.pack();
+  Acsr.pack();
+  B.pack();
+  Bcsr.pack();
+  x.pack();
+  ASSERT_TRUE(equals(A, Acsr));
+
+  IndexVar i, j;
+  Tensor<double> y("y", {6}, Dense);
+  Tensor<double> ycsr("ycsr", {6}, Dense);
+  y(i) = A(i,j) * x(j);
+  ycsr(i) = Acsr(i,j) * x(j);
+  y.evaluate();
+  ycsr.evaluate();
+  ASSERT_TRUE(equals(y, ycsr));
+
+  // The bitmaps of A and B are intersected a word at a time
+  Tensor<double> z("z", {6}, Dense);
+  Tensor<double> zcsr("zcsr", {6}, Dense);
+  z(i) = A(i,j) * B(i,j);
+  zcsr(i) = Acsr(i,j) * Bcsr(i,j);
+  z.evaluate();
+  zcsr.evaluate();
+  ASSERT_TRUE(equals(z, zcsr));
+
+  Tensor<double> v("v", {6}, Dense);
+  v(i) = Bcsr(i,j) * A(i,j);
+  v.evaluate();
+  ASSERT_TRUE(equals(v, zcsr));
+
+  Tensor<double> U("U", {6, 70}, CSR);
+  Tensor<double> Ucsr("Ucsr", {6, 70}, CSR);
+  U(i,j) = A(i,j) + Bcsr(i,j);
+  Ucsr(i,j) = Acsr(i,j) + Bcsr(i,j);
+  U.evaluate();
+  Ucsr.evaluate();
+  ASSERT_TRUE(equals(U, Ucsr));
+
+  // Results are assembled by appending coordinates and building the bitmaps
+  Tensor<double> C("C", {6, 70}, db);
+  Tensor<double> Cexpected("Cexpected", {6, 70}, CSR);
+  C(i,j) = A(i,j) + B(i,j);
+  C.evaluate();
+  Cexpected(i,j) = Acsr(i,j) + Bcsr(i,j);
+  Cexpected.evaluate();
+  ASSERT_TRUE(equals(C, Cexpected));
+
+  Tensor<double> D("D", {6, 70}, db);
+  Tensor<double> Dexpected("Dexpected", {6, 70}, CSR);
+  D(i,j) = A(i,j) * B(i,j);
+  D.evaluate();
+  Dexpected(i,j) = Acsr(i,j) * Bcsr(i,j);
+  Dexpected.evaluate();
+  ASSERT_TRUE(equals(D, Dexpected));
+
+  ASSERT_THROW(Format({Dense, Bitmap(ModeFormat::NOT_UNIQUE)}), TacoException);
+}
+
+TEST(format, blocked) {
+  Tensor<double> A("A", {6, 8}, BCSR(2, 2));
+  Tensor<double> Acsr("Acsr", {6, 8}, CSR);
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      if ((3 * i + 5 * j) % 4 == 0) {
+        A.insert({i, j}, (double)(i + j + 1));
+        Acsr.insert({i, j}, (double)(i + j + 1));
+      }
+    }
+  }
+  A.pack();
+  Acsr.pack();
+  ASSERT_EQ(6, A.getStorage().getIndex().getModeIndex(1).getIndexArray(1)
+                .getSize());
+
+  Tensor<double> x("x", {8}, Dense);
+  Tensor<double> B("B", {8, 4}, Format({Dense, Dense}));
+  for (int j = 0; j < 8; ++j) {
+    x.insert({j}, (double)(j + 1));
+    for (int k = 0; k < 4; ++k) {
+      B.insert({j, k}, (double)(j - k));
+    }
+  }
+  x.pack();
+  B.pack();
+
+  IndexVar i, j, k;
+  Tensor<double> y("y", {6}, Dense);
+  Tensor<double> yexpected("yexpected", {6}, Dense);
+  y(i) = A(i,j) * x(j);
+  y.evaluate();
+  yexpected(i) = Acsr(i,j) * x(j);
+  yexpected.evaluate();
+  ASSERT_TRUE(equals(y, yexpected));
+
+  Tensor<double> C("C", {6, 4}, Format({Dense, Dense}));
+  Tensor<double> Cexpected("Cexpected", {6, 4}, Format({Dense, Dense}));
+  C(i,k) = A(i,j) * B(j,k);
+  C.evaluate();
+  Cexpected(i,k) = Acsr(i,j) * B(j,k);
+  Cexpected.evaluate();
+  ASSERT_TRUE(equals(C, Cexpected));
+
+  Tensor<double> D("D", {6, 8}, BCSR(2, 2));
+  Tensor<double> Ddense("Ddense", {6, 8}, Format({Dense, Dense}));
+  Tensor<double> Dexpected("Dexpected", {6, 8}, Format({Dense, Dense}));
+  D(i,j) = A(i,j) + A(i,j);
+  D.evaluate();
+  Ddense(i,j) = D(i,j);
+  Ddense.evaluate();
+  Dexpected(i,j) = Acsr(i,j) + Acsr(i,j);
+  Dexpected.evaluate();
+  ASSERT_TRUE(equals(Ddense, Dexpected));
+
+  Tensor<double> T("T", {2, 4, 6}, BCSF({1, 2, 2}));
+  T.insert({1, 2, 3}, 2.0);
+  T.insert({0, 3, 5}, 3.0);
+  T.pack();
+  Tensor<double> z("z", {6}, Dense);
+  for (int l = 0; l < 6; ++l) {
+    z.insert({l}, (double)l);
+  }
+  z.pack();
+  IndexVar l;
+  Tensor<double> E("E", {2, 4}, Format({Dense, Dense}));
+  E(i,j) = T(i,j,l) * z(l);
+  E.evaluate();
+  Tensor<double> Eexpected("Eexpected", {2, 4}, Format({Dense, Dense}));
+  Eexpected.insert({1, 2}, 6.0);
+  Eexpected.insert({0, 3}, 15.0);
+  Eexpected.pack();
+  ASSERT_TRUE(equals(E, Eexpected));
+
+  ASSERT_THROW(Tensor<double>("F", {5, 8}, BCSR(2, 2)), TacoException);
+}
+
+TEST(format, sliced) {
+  Tensor<double> A("A", {11, 9}, SELL(4, 8));
+  Tensor<double> Acsr("Acsr", {11, 9}, CSR);
+  for (int i = 0; i < 11; ++i) {
+    for (int j = 0; j < 9; ++j) {
+      if ((7 * i + 3 * j) % (i % 4 + 2) == 0) {
+        A.insert({i, j}, (double)(i + j + 1));
+        Acsr.insert({i, j}, (double)(i + j + 1));
+      }
+    }
+  }
+  A.pack();
+  Acsr.pack();
+
+  Tensor<double> x("x", {9}, Dense);
+  Tensor<double> B("B", {9, 3}, Format({Dense, Dense}));
+  for (int j = 0; j < 9; ++j) {
+    x.insert({j}, (double)(j + 1));
+    for (int k = 0; k < 3; ++k) {
+      B.insert({j, k}, (double)(j - k));
+    }
+  }
+  x.pack();
+  B.pack();
+
+  IndexVar i, j, k;
+  Tensor<double> y("y", {11}, Dense);
+  Tensor<double> yexpected("yexpected", {11}, Dense);
+  y(i) = A(i,j) * x(j);
+  y.evaluate();
+  yexpected(i) = Acsr(i,j) * x(j);
+  yexpected.evaluate();
+  ASSERT_TRUE(equals(y, yexpected));
+
+  Tensor<double> C("C", {11, 3}, Format({Dense, Dense}));
+  Tensor<double> Cexpected("Cexpected", {11, 3}, Format({Dense, Dense}));
+  C(i,k) = A(i,j) * B(j,k);
+  C.evaluate();
+  Cexpected(i,k) = Acsr(i,j) * B(j,k);
+  Cexpected.evaluate();
+  ASSERT_TRUE(equals(C, Cexpected));
+
+  Tensor<double> Adense("Adense", {11, 9}, Format({Dense, Dense}));
+  Adense(i,j) = A(i,j);
+  Adense.evaluate();
+  ASSERT_TRUE(equals(Adense, Acsr));
+
+  TensorBase S = makeSELL("S", Acsr, 2);
+  Tensor<double> z("z", {11}, Dense);
+  z(i) = S(i,j) * x(j);
+  z.evaluate();
+  ASSERT_TRUE(equals(z, yexpected));
+
+  ASSERT_THROW(SELL(4, 6), TacoException);
+  Tensor<double> D("D", {11, 9}, SELL(4));
+  D(i,j) = Acsr(i,j);
+  ASSERT_THROW(D.compile(), TacoException);
+}
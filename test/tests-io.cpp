@@ -1,6 +1,14 @@
 #include "test.h"
 
 #include "taco/tensor.h"
+#include "taco/storage/file_io_tns.h"
+#include "taco/storage/file_io_taco.h"
+#include "taco/storage/file_io_mtx.h"
+#include "taco/util/env.h"
+
+#include <complex>
+#include <fstream>
+#include <sstream>
 
 using namespace taco;
 
@@ -20,6 +28,24 @@ TEST(io, tns) {
   ASSERT_TRUE(equals(expected, tensor));
 }
 
+TEST(io, tns_stream) {
+  std::stringstream stream;
+  stream << "# comment\n"
+         << "2 3 1.5\r\n"
+         << "\n"
+         << "  1\t1 -2e-3\n"
+         << "4 2 12345678901234567890\n"
+         << "2 3 0.25";
+  TensorBase tensor = readTNS(stream, Format({Sparse,Sparse}));
+
+  TensorBase expected(Float64, {4,3}, Format({Sparse,Sparse}));
+  expected.insert({1, 2}, 1.75);
+  expected.insert({0, 0}, -2e-3);
+  expected.insert({3, 1}, 12345678901234567890.0);
+  expected.pack();
+  ASSERT_TRUE(equals(expected, tensor));
+}
+
 TEST(io, mtx) {
   TensorBase tensor = read(testDataDirectory()+"2tensor.mtx", Sparse);
   ASSERT_EQ(2, tensor.getOrder());
@@ -127,3 +153,146 @@ TEST(io, mtxsymmetric) {
 
   ASSERT_TRUE(equals(expected, tensor));
 }
+
+TEST(io, taco) {
+  const std::string filename = util::getTmpdir() + "io_taco.taco";
+  const std::vector<Format> formats = {CSR, COO(2), Format({Dense,Dense}),
+                                       Format({Dense,Sparse}, {1,0})};
+  for (const Format& format : formats) {
+    TensorBase tensor(Float64, {5,4}, format, 1.5);
+    tensor.insert({0, 1}, 1.0);
+    tensor.insert({3, 0}, 2.0);
+    tensor.insert({3, 3}, 3.0);
+    tensor.insert({4, 2}, 4.0);
+    tensor.pack();
+    write(filename, tensor);
+
+    TensorBase mapped = readTACO(filename);
+    ASSERT_EQ(format, mapped.getFormat());
+    ASSERT_EQ(1.5, mapped.getFillValue().getVal<double>());
+    ASSERT_TRUE(equals(tensor, mapped));
+
+    const Format dcsr({Sparse,Sparse}, format.getModeOrdering());
+    TensorBase converted = read(filename, dcsr);
+    ASSERT_EQ(dcsr, converted.getFormat());
+    ASSERT_TRUE(equals(tensor, converted));
+
+    mapped.insert({0, 1}, 1.0);
+    mapped.pack();
+    tensor.insert({0, 1}, 1.0);
+    tensor.pack();
+    ASSERT_TRUE(equals(tensor, mapped));
+  }
+
+  TensorBase scalar(Int32, {});
+  scalar.insert({}, 42);
+  scalar.pack();
+  std::stringstream stream;
+  writeTACO(stream, scalar);
+  ASSERT_TRUE(equals(scalar, readTACO(stream, Format())));
+}
+
+TEST(io, mtx_qualifiers) {
+  const std::vector<Format> formats = {CSR, CSC, Format({Sparse,Sparse}),
+                                       Format({Dense,Dense})};
+  for (const Format& format : formats) {
+    for (bool pack : {true, false}) {
+      std::stringstream skew("%%MatrixMarket matrix coordinate real "
+                             "Skew-Symmetric\n% comment\n\n3 3 2\n"
+                             "2 1 1.5\n3 1 -2\n");
+      TensorBase tensor = readMTX(skew, format, pack);
+      tensor.pack();
+      TensorBase expected(Float64, {3,3}, format);
+      expected.insert({1, 0}, 1.5);
+      expected.insert({0, 1}, -1.5);
+      expected.insert({2, 0}, -2.0);
+      expected.insert({0, 2}, 2.0);
+      expected.pack();
+      ASSERT_TRUE(equals(expected, tensor));
+
+      std::stringstream pattern("%%MatrixMarket matrix coordinate pattern "
+                                "symmetric\n3 3 3\n1 1\n3 1\n3 2\n");
+      tensor = readMTX(pattern, format, pack);
+      tensor.pack();
+      expected = TensorBase(Float64, {3,3}, format);
+      expected.insert({0, 0}, 1.0);
+      expected.insert({2, 0}, 1.0);
+      expected.insert({0, 2}, 1.0);
+      expected.insert({2, 1}, 1.0);
+      expected.insert({1, 2}, 1.0);
+      expected.pack();
+      ASSERT_TRUE(equals(expected, tensor));
+
+      std::stringstream unsorted("%%MatrixMarket matrix coordinate integer "
+                                 "general\n3 3 4\n1 3 1\n1 1 2\n2 2 3\n"
+                                 "1 3 4\n");
+      tensor = readMTX(unsorted, format, pack);
+      tensor.pack();
+      expected = TensorBase(Float64, {3,3}, format);
+      expected.insert({0, 0}, 2.0);
+      expected.insert({0, 2}, 5.0);
+      expected.insert({1, 1}, 3.0);
+      expected.pack();
+      ASSERT_TRUE(equals(expected, tensor));
+
+      std::stringstream hermitian("%%MatrixMarket matrix coordinate complex "
+                                  "hermitian\n2 2 2\n1 1 1 0\n2 1 1 2\n");
+      tensor = readMTX(hermitian, format, pack);
+      tensor.pack();
+      expected = TensorBase(Complex128, {2,2}, format);
+      expected.insert({0, 0}, std::complex<double>(1, 0));
+      expected.insert({1, 0}, std::complex<double>(1, 2));
+      expected.insert({0, 1}, std::complex<double>(1, -2));
+      expected.pack();
+      ASSERT_TRUE(equals(expected, tensor));
+
+      std::stringstream array("%%MatrixMarket matrix array real symmetric\n"
+                              "2 2\n1\n2\n3\n");
+      tensor = readMTX(array, format, pack);
+      tensor.pack();
+      expected = TensorBase(Float64, {2,2}, format);
+      expected.insert({0, 0}, 1.0);
+      expected.insert({1, 0}, 2.0);
+      expected.insert({0, 1}, 2.0);
+      expected.insert({1, 1}, 3.0);
+      expected.pack();
+      ASSERT_TRUE(equals(expected, tensor));
+    }
+  }
+}
+
+TEST(io, taco_out_of_core) {
+  const std::string tnsFilename = util::getTmpdir() + "io_out_of_core.tns";
+  const std::string tacoFilename = util::getTmpdir() + "io_out_of_core.taco";
+  {
+    std::ofstream tns(tnsFilename);
+    srand(0);
+    for (int i = 0; i < 2000; ++i) {
+      tns << rand() % 7 + 1 << " " << rand() % 50 + 1 << " "
+          << rand() % 30 + 1 << " " << i % 9 << "\n";
+    }
+  }
+  const std::vector<Format> formats = {
+    Format({Sparse,Sparse,Sparse}), Format({Dense,Sparse,Sparse}),
+    Format({Dense,Sparse,Dense}), COO(3), Format({Sparse,Dense,Sparse}, {2,0,1})
+  };
+  for (const Format& format : formats) {
+    // A small memory limit spills the components into many sorted runs
+    convertToTACO(tnsFilename, tacoFilename, format, 4096);
+    TensorBase tensor = readTACO(tacoFilename);
+    ASSERT_EQ(format, tensor.getFormat());
+    ASSERT_TRUE(equals(read(tnsFilename, format), tensor));
+  }
+
+  const std::string mtxFilename = util::getTmpdir() + "io_out_of_core.mtx";
+  {
+    std::ofstream mtx(mtxFilename);
+    mtx << "%%MatrixMarket matrix coordinate real symmetric\n40 40 400\n";
+    for (int i = 0; i < 400; ++i) {
+      const int row = rand() % 40 + 1;
+      mtx << row << " " << rand() % row + 1 << " " << i << "\n";
+    }
+  }
+  convertToTACO(mtxFilename, tacoFilename, CSR, 1024);
+  ASSERT_TRUE(equals(read(mtxFilename, CSR), readTACO(tacoFilename)));
+}
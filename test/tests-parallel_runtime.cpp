@@ -0,0 +1,281 @@
+#include "test.h"
+#include "test_tensors.h"
+
+#include <atomic>
+#include <thread>
+
+#include "taco/tensor.h"
+#include "taco/parallel_runtime.h"
+#include "taco/index_notation/index_notation.h"
+#include "taco/codegen/module.h"
+#include "taco/lower/lower.h"
+
+using namespace taco;
+
+namespace {
+
+// Restores the runtime that kernels are compiled for when a test ends
+struct ParallelRuntimeScope {
+  ParallelRuntimeScope(ParallelRuntime runtime)
+      : previous(taco_get_parallel_runtime()) {
+    taco_set_parallel_runtime(runtime);
+  }
+  ~ParallelRuntimeScope() {
+    taco_set_parallel_runtime(previous);
+  }
+  ParallelRuntime previous;
+};
+
+struct Iterations {
+  vector<atomic<int>> counts;
+  atomic<bool> inBounds;
+
+  Iterations(size_t size) : counts(size), inBounds(true) {
+    for (auto& count : counts) {
+      count = 0;
+    }
+  }
+};
+
+void countIterations(void* ctx, int64_t begin, int64_t end) {
+  Iterations* iterations = (Iterations*)ctx;
+  if (taco_parallel_thread_num() >= taco_parallel_max_threads()) {
+    iterations->inBounds = false;
+  }
+  for (int64_t i = begin; i < end; ++i) {
+    iterations->counts[i]++;
+  }
+}
+
+const int64_t innerSize = 37;
+
+void countNestedIterations(void* ctx, int64_t begin, int64_t end) {
+  Iterations* iterations = (Iterations*)ctx;
+  for (int64_t i = begin; i < end; ++i) {
+    Iterations inner(innerSize);
+    taco_parallel_for(0, innerSize, 1, countIterations, &inner);
+    for (int64_t j = 0; j < innerSize; ++j) {
+      iterations->counts[i * innerSize + j] += inner.counts[j];
+    }
+    if (!inner.inBounds) {
+      iterations->inBounds = false;
+    }
+  }
+}
+
+Tensor<double> spmvMatrix(int rows, int cols) {
+  Tensor<double> A("A", {rows, cols}, CSR);
+  for (int i = 0; i < rows; ++i) {
+    for (int k = 0; k < i % 17; ++k) {
+      A.insert({i, (i * 7 + k * 31) % cols}, 1.0 + k % 5);
+    }
+  }
+  A.pack();
+  return A;
+}
+
+Tensor<double> spmvVector(int cols) {
+  Tensor<double> x("x", {cols}, Dense);
+  for (int j = 0; j < cols; ++j) {
+    x.insert({j}, 1.0 + j % 7);
+  }
+  x.pack();
+  return x;
+}
+
+}
+
+TEST(parallel_runtime, parallel_for) {
+  const int previous = taco_parallel_set_thread_limit(4);
+  for (int64_t grain : {0, 1, 5, 1000}) {
+    SCOPED_TRACE("grain: " + to_string(grain));
+    Iterations iterations(1000);
+    taco_parallel_for(0, 1000, grain, countIterations, &iterations);
+    for (auto& count : iterations.counts) {
+      ASSERT_EQ(1, count);
+    }
+    ASSERT_TRUE(iterations.inBounds);
+  }
+
+  // Empty ranges run no iterations
+  Iterations iterations(1);
+  taco_parallel_for(5, 5, 1, countIterations, &iterations);
+  ASSERT_EQ(0, iterations.counts[0]);
+  taco_parallel_set_thread_limit(previous);
+}
+
+TEST(parallel_runtime, nested) {
+  const int previous = taco_parallel_set_thread_limit(4);
+  const int64_t outerSize = 23;
+  Iterations iterations(outerSize * innerSize);
+  taco_parallel_for(0, outerSize, 1, countNestedIterations, &iterations);
+  for (auto& count : iterations.counts) {
+    ASSERT_EQ(1, count);
+  }
+  ASSERT_TRUE(iterations.inBounds);
+  taco_parallel_set_thread_limit(previous);
+}
+
+TEST(parallel_runtime, thread_limit) {
+  const int previous = taco_parallel_set_thread_limit(3);
+  ASSERT_EQ(3, taco_parallel_get_thread_limit());
+  ASSERT_EQ(3, taco_parallel_max_threads());
+  ASSERT_EQ(0, taco_parallel_thread_num());
+
+  // Limits only apply to the threads that set them
+  int otherLimit = -1;
+  thread other([&]() {
+    taco_parallel_set_thread_limit(2);
+    otherLimit = taco_parallel_max_threads();
+  });
+  other.join();
+  ASSERT_EQ(2, otherLimit);
+  ASSERT_EQ(3, taco_parallel_max_threads());
+
+  // Loops that may only run on one thread run on the calling thread
+  taco_parallel_set_thread_limit(1);
+  const thread::id caller = this_thread::get_id();
+  atomic<bool> onCaller(true);
+  taco_parallel_for(0, 100, 1, [](void* ctx, int64_t, int64_t) {
+    if (taco_parallel_thread_num() != 0) {
+      *(atomic<bool>*)ctx = false;
+    }
+  }, &onCaller);
+  ASSERT_TRUE(onCaller);
+  ASSERT_EQ(caller, this_thread::get_id());
+
+  ASSERT_EQ(1, taco_parallel_set_thread_limit(previous));
+}
+
+TEST(parallel_runtime, generated_code) {
+  ParallelRuntimeScope runtime(ParallelRuntime::WorkStealing);
+  Tensor<double> A = spmvMatrix(100, 50);
+  Tensor<double> x = spmvVector(50);
+  Tensor<double> y("y", {100}, Dense);
+  Tensor<double> expected("expected", {100}, Dense);
+  IndexVar i("i"), j("j");
+  y(i) = A(i,j) * x(j);
+  expected(i) = A(i,j) * x(j);
+
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.parallelize(i, ParallelUnit::CPUThread,
+                          OutputRaceStrategy::NoRaces);
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+
+  const string source = y.getSource();
+  ASSERT_NE(string::npos, source.find("taco_parallel_for("));
+  ASSERT_EQ(string::npos, source.find("#pragma omp parallel for"));
+
+  expected.compile();
+  expected.assemble();
+  expected.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+}
+
+TEST(parallel_runtime, atomics) {
+  ParallelRuntimeScope runtime(ParallelRuntime::WorkStealing);
+  const int previous = taco_parallel_set_thread_limit(4);
+  const int n = 40;
+  Tensor<double> A("A", {n, n}, {Dense, Dense});
+  Tensor<double> x = spmvVector(n);
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      A.insert({i, j}, (double)((i * j) % 7));
+    }
+  }
+  A.pack();
+  Tensor<double> y("y", {n}, Dense);
+  Tensor<double> expected("expected", {n}, Dense);
+  IndexVar i("i"), j("j");
+  y(i) = A(i,j) * x(j);
+  expected(i) = A(i,j) * x(j);
+
+  // Parallelizing the reduction makes updates of y race
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.reorder({j, i}).parallelize(j, ParallelUnit::CPUThread,
+                                          OutputRaceStrategy::Atomics);
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+  ASSERT_NE(string::npos, y.getSource().find("__atomic_compare_exchange"));
+
+  expected.compile();
+  expected.assemble();
+  expected.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+  taco_parallel_set_thread_limit(previous);
+}
+
+TEST(parallel_runtime, concurrent_kernels) {
+  ParallelRuntimeScope runtime(ParallelRuntime::WorkStealing);
+  const int rows = 500, cols = 80, numCallers = 8, numCalls = 20;
+  Tensor<double> A = spmvMatrix(rows, cols);
+  Tensor<double> B("B", {cols, 16}, {Dense, Dense});
+  for (int j = 0; j < cols; ++j) {
+    for (int k = 0; k < 16; ++k) {
+      B.insert({j, k}, 1.0 + (j + k) % 3);
+    }
+  }
+  B.pack();
+  Tensor<double> x = spmvVector(cols);
+  IndexVar i("i"), j("j"), k("k");
+
+  // An SpMV, and an SpMM whose outer sparse and inner dense loops are both
+  // parallel, that all callers share
+  Tensor<double> expectedY("expectedY", {rows}, Dense);
+  expectedY(i) = A(i,j) * x(j);
+  IndexStmt spmv = expectedY.getAssignment().concretize()
+      .parallelize(i, ParallelUnit::CPUThread, OutputRaceStrategy::NoRaces);
+  Tensor<double> expectedC("expectedC", {rows, 16}, {Dense, Dense});
+  expectedC(i,k) = A(i,j) * B(j,k);
+  IndexStmt spmm = expectedC.getAssignment().concretize()
+      .parallelize(i, ParallelUnit::CPUThread, OutputRaceStrategy::NoRaces)
+      .parallelize(k, ParallelUnit::CPUThread, OutputRaceStrategy::NoRaces);
+  ir::Module module;
+  module.addFunction(lower(spmv, "spmv", false, true));
+  module.addFunction(lower(spmm, "spmm", false, true));
+  module.compile();
+  expectedY.evaluate();
+  expectedC.evaluate();
+
+  // Every caller computes into its own results, with its own limit on the
+  // number of threads
+  vector<Tensor<double>> ys, Cs;
+  for (int caller = 0; caller < numCallers; ++caller) {
+    Tensor<double> y("y", {rows}, Dense);
+    for (int r = 0; r < rows; ++r) {
+      y.insert({r}, 0.0);
+    }
+    y.pack();
+    ys.push_back(y);
+    Tensor<double> C("C", {rows, 16}, {Dense, Dense});
+    C.insert({0, 0}, 0.0);
+    C.pack();
+    Cs.push_back(C);
+  }
+
+  vector<thread> callers;
+  for (int caller = 0; caller < numCallers; ++caller) {
+    callers.emplace_back([&, caller]() {
+      taco_parallel_set_thread_limit(1 + caller % 4);
+      for (int call = 0; call < numCalls; ++call) {
+        module.callFuncPackedRaw("spmv", {ys[caller].getTacoTensorT(),
+                                          A.getTacoTensorT(),
+                                          x.getTacoTensorT()});
+        module.callFuncPackedRaw("spmm", {Cs[caller].getTacoTensorT(),
+                                          A.getTacoTensorT(),
+                                          B.getTacoTensorT()});
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+
+  for (int caller = 0; caller < numCallers; ++caller) {
+    ASSERT_TENSOR_EQ(expectedY, ys[caller]);
+    ASSERT_TENSOR_EQ(expectedC, Cs[caller]);
+  }
+}
@@ -888,6 +888,105 @@ TEST(scheduling_eval, spmvCPU) {
   ASSERT_TENSOR_EQ(expected, y);
 }
 
+TEST(scheduling_eval, spmvCPUMergePath) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  int NUM_I = 1021/10;
+  int NUM_J = 1039/10;
+  Tensor<double> A("A", {NUM_I, NUM_J}, CSR);
+  Tensor<double> x("x", {NUM_J}, Format({Dense}));
+  Tensor<double> y("y", {NUM_I}, Format({Dense}));
+
+  // Rows whose lengths vary from empty to full, so that threads split rows
+  srand(120);
+  for (int i = 0; i < NUM_I; i++) {
+    int rowLength = (i % 7 == 0) ? 0 : (i % 13 == 0) ? NUM_J : rand() % 5;
+    for (int k = 0; k < rowLength; k++) {
+      A.insert({i, (rowLength == NUM_J) ? k : rand() % NUM_J}, (double) (k % 3 + 1));
+    }
+  }
+
+  for (int j = 0; j < NUM_J; j++) {
+    x.insert({j}, (double) (j % 5));
+  }
+
+  x.pack();
+  A.pack();
+
+  y(i) = A(i, j) * x(j);
+
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.parallelize(i, ParallelUnit::CPUMergePath, OutputRaceStrategy::NoRaces);
+
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+
+  Tensor<double> expected("expected", {NUM_I}, Format({Dense}));
+  expected(i) = A(i, j) * x(j);
+  expected.compile();
+  expected.assemble();
+  expected.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+}
+
+TEST(scheduling_eval, spmvCPUVector) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  int NUM_I = 1021/10;
+  int NUM_J = 1039/10;
+  float SPARSITY = .3;
+  Tensor<double> A("A", {NUM_I, NUM_J}, CSR);
+  Tensor<double> x("x", {NUM_J}, Format({Dense}));
+  Tensor<double> y("y", {NUM_I}, Format({Dense}));
+
+  srand(4357);
+  for (int i = 0; i < NUM_I; i++) {
+    for (int j = 0; j < NUM_J; j++) {
+      float rand_float = (float)rand()/(float)(RAND_MAX);
+      if (rand_float < SPARSITY) {
+        A.insert({i, j}, (double) ((int) (rand_float * 3 / SPARSITY)));
+      }
+    }
+  }
+
+  for (int j = 0; j < NUM_J; j++) {
+    float rand_float = (float)rand()/(float)(RAND_MAX);
+    x.insert({j}, (double) ((int) (rand_float*3/SPARSITY)));
+  }
+
+  x.pack();
+  A.pack();
+
+  y(i) = A(i, j) * x(j);
+
+  IndexVar jpos("jpos"), jpos0("jpos0"), jpos1("jpos1");
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.pos(j, jpos, A(i,j))
+          .split(jpos, jpos0, jpos1, 8)
+          .parallelize(jpos1, ParallelUnit::CPUVector,
+                       OutputRaceStrategy::ParallelReduction);
+
+  // The accumulation into y is promoted to a scalar reduction
+  stringstream source;
+  std::shared_ptr<ir::CodeGen> codegen = ir::CodeGen::init_default(source, ir::CodeGen::ImplementationGen);
+  codegen->compile(lower(stmt, "compute", false, true), true);
+  ASSERT_NE(string::npos, source.str().find("#pragma omp simd reduction(+:"));
+
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+
+  Tensor<double> expected("expected", {NUM_I}, Format({Dense}));
+  expected(i) = A(i, j) * x(j);
+  expected.compile();
+  expected.assemble();
+  expected.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+}
+
 TEST(scheduling_eval, precompute2D) {
   if (should_use_CUDA_codegen()) {
     return;
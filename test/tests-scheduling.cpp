@@ -1102,6 +1102,29 @@ TEST(scheduling, mergeby) {
     return stmt.mergeby(j, MergeStrategy::TwoFinger);
   });
 
+  // Testing merging by blocks of coordinates.
+  test([&](IndexStmt stmt) {
+    return stmt.mergeby(j, MergeStrategy::SIMDBlock);
+  });
+
+  test([&](IndexStmt stmt) {
+    return stmt.mergeby(j, MergeStrategy::SIMDBlock).mergeby(i, MergeStrategy::Gallop);
+  });
+
+  // Testing choosing between galloping and two-finger merging per segment.
+  test([&](IndexStmt stmt) {
+    return stmt.mergeby(j, MergeStrategy::Adaptive);
+  });
+
+  const int threshold = taco_get_adaptive_merge_threshold();
+  for (int segmentRatio : {1, 1000}) {
+    taco_set_adaptive_merge_threshold(segmentRatio);
+    test([&](IndexStmt stmt) {
+      return stmt.mergeby(j, MergeStrategy::Adaptive);
+    });
+  }
+  taco_set_adaptive_merge_threshold(threshold);
+
   // Merging a dimension with a dense iterator with Gallop should be no-op.
   test([&](IndexStmt stmt) {
     return stmt.mergeby(i, MergeStrategy::Gallop);
@@ -1134,4 +1157,46 @@ TEST(scheduling, mergeby_gallop_error) {
 
   IndexStmt stmt = y.getAssignment().concretize();
   ASSERT_THROW(stmt.mergeby(i, MergeStrategy::Gallop), taco::TacoException);
-}
\ No newline at end of file
+  ASSERT_THROW(stmt.mergeby(i, MergeStrategy::SIMDBlock), taco::TacoException);
+  ASSERT_THROW(stmt.mergeby(i, MergeStrategy::Adaptive), taco::TacoException);
+}
+
+TEST(scheduling, mergeby_adaptive) {
+  Tensor<double> x("x", {8}, Format({Sparse}));
+  Tensor<double> y("y", {8}, Format({Sparse}));
+  Tensor<double> z("z");
+  IndexVar i("i");
+  z() = x(i) * y(i);
+
+  IndexStmt stmt = z.getAssignment().concretize().mergeby(i, MergeStrategy::Adaptive);
+  std::stringstream source;
+  std::shared_ptr<ir::CodeGen> codegen = ir::CodeGen::init_default(source, ir::CodeGen::ImplementationGen);
+  codegen->compile(lower(stmt, "compute", false, true), false);
+  ASSERT_NE(source.str().find("taco_gallop("), std::string::npos);
+  ASSERT_NE(source.str().find("if (iGallop)"), std::string::npos);
+}
+
+TEST(scheduling, parallelize_merge_path_error) {
+  Tensor<double> A("A", {8, 8}, CSR);
+  Tensor<double> B("B", {8, 8}, CSR);
+  Tensor<double> C("C", {8, 8}, CSC);
+  Tensor<double> x("x", {8}, Format({Dense}));
+  Tensor<double> y("y", {8}, Format({Dense}));
+  Tensor<double> z("z", {8}, Format({Sparse}));
+
+  y(i) = A(i,j) * B(i,j);
+  ASSERT_THROW(y.getAssignment().concretize().parallelize(i, ParallelUnit::CPUMergePath, OutputRaceStrategy::NoRaces),
+               taco::TacoException);
+
+  y(i) = C(i,j) * x(j);
+  ASSERT_THROW(y.getAssignment().concretize().parallelize(i, ParallelUnit::CPUMergePath, OutputRaceStrategy::NoRaces),
+               taco::TacoException);
+
+  z(i) = A(i,j) * x(j);
+  ASSERT_THROW(z.getAssignment().concretize().parallelize(i, ParallelUnit::CPUMergePath, OutputRaceStrategy::NoRaces),
+               taco::TacoException);
+
+  y(i) = A(i,j) * x(j);
+  ASSERT_THROW(y.getAssignment().concretize().parallelize(j, ParallelUnit::CPUMergePath, OutputRaceStrategy::NoRaces),
+               taco::TacoException);
+}
@@ -3,10 +3,19 @@
 #include "taco/tensor.h"
 #include "test_tensors.h"
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
 #include "taco/util/collections.h"
+#include "taco/util/env.h"
+#include "taco/util/radix_sort.h"
+#include "taco/codegen/module.h"
+#include "taco/lower/lower.h"
 
 using namespace taco;
 
@@ -78,6 +87,221 @@ TEST(tensor, duplicates) {
   }
 }
 
+TEST(tensor, pack_unsorted) {
+  // The coordinates need more than 64 bits, so they are sorted by more than one
+  // key word, and there are enough of them to split the sort across threads
+  const int dim = 1 << 30;
+  Tensor<double> a({dim,dim,dim}, Format({Sparse,Sparse,Sparse}, {2,0,1}));
+  map<vector<int>,double> vals;
+  uint64_t seed = 42;
+  for (int n = 0; n < 200000; n++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    vector<int> coord = {(int)((seed >> 20) % 64) * (dim / 64),
+                         (int)((seed >> 30) % 512),
+                         (int)((seed >> 40) % dim)};
+    if (n % 4 == 0 && n > 0) {
+      coord = vals.begin()->first;
+    }
+    a.insert(coord, 1.0);
+    vals[coord] += 1.0;
+  }
+  a.pack();
+
+  size_t numVals = 0;
+  vector<int> prev;
+  for (auto val = a.beginTyped<int>(); val != a.endTyped<int>(); ++val) {
+    vector<int> coord = val->first.toVector();
+    vector<int> storageCoord = {coord[2], coord[0], coord[1]};
+    ASSERT_TRUE(prev < storageCoord);
+    ASSERT_TRUE(util::contains(vals, coord));
+    ASSERT_EQ(vals.at(coord), val->second);
+    prev = storageCoord;
+    numVals++;
+  }
+  ASSERT_EQ(vals.size(), numVals);
+}
+
+TEST(tensor, pack_without_codegen) {
+  // Formats built from dense, compressed and singleton modes are packed
+  // without compiling a pack function
+  std::atomic<int> compiledModules(0);
+  ir::setTierTransitionHook([&](const ir::TierTransition&) {
+    compiledModules++;
+  });
+  const std::vector<Format> formats = {
+    Format({Dense,Dense}), CSR, CSC, DCSR, DCSC, COO(2), COO(2, false),
+    Format({Sparse,Dense}), Format({Dense,Dense}, {1,0}),
+    Format({Compressed(ModeFormat::NOT_UNIQUE),Singleton}, {1,0})
+  };
+  std::vector<Tensor<double>> tensors;
+  for (auto& format : formats) {
+    Tensor<double> a({4,5}, format, (format == formats[0]) ? 2.0 : 0.0);
+    a.insert({3,1}, 1.0);
+    a.insert({1,4}, 2.0);
+    a.insert({1,0}, 3.0);
+    a.insert({3,1}, 4.0);
+    a.pack();
+    tensors.push_back(a);
+  }
+  Tensor<int> b({4}, Format({Sparse}));
+  b.insert({2}, 2);
+  b.pack();
+  Tensor<float> c;
+  c.insert({}, 1.5f);
+  c.insert({}, 1.0f);
+  c.pack();
+  ir::setTierTransitionHook(nullptr);
+  ASSERT_EQ(0, compiledModules);
+
+  map<vector<int>,double> vals = {{{1,0}, 3.0}, {{1,4}, 2.0}, {{3,1}, 5.0}};
+  for (auto& a : tensors) {
+    SCOPED_TRACE(util::toString(a.getFormat()));
+    size_t numNonFills = 0;
+    for (auto val = a.beginTyped<int>(); val != a.endTyped<int>(); ++val) {
+      if (util::contains(vals, val->first.toVector())) {
+        ASSERT_EQ(vals.at(val->first.toVector()), val->second);
+        numNonFills++;
+      } else {
+        ASSERT_TRUE(equals(a.getFillValue(), Literal(val->second)));
+      }
+    }
+    ASSERT_EQ(vals.size(), numNonFills);
+  }
+  ASSERT_EQ(2, b.begin()->second);
+  ASSERT_EQ(2.5f, c.begin()->second);
+}
+
+TEST(tensor, pack_increment) {
+  // Components inserted into packed tensors are merged with the packed ones
+  for (auto& format : {CSR, DCSC, COO(2), Format({Sparse,Dense})}) {
+    SCOPED_TRACE(util::toString(format));
+    Tensor<double> a({5,6}, format);
+    a.insert({4,1}, 1.0);
+    a.insert({0,5}, 2.0);
+    a.insert({2,3}, 3.0);
+    a.pack();
+
+    std::atomic<int> compiledModules(0);
+    ir::setTierTransitionHook([&](const ir::TierTransition&) {
+      compiledModules++;
+    });
+    a.insert({2,3}, 10.0);
+    a.insert({2,0}, 20.0);
+    a.insert({4,5}, 30.0);
+    a.insert({2,0}, 40.0);
+    a.pack();
+    ir::setTierTransitionHook(nullptr);
+    ASSERT_EQ(0, compiledModules);
+
+    map<vector<int>,double> vals = {{{0,5}, 2.0}, {{2,0}, 60.0},
+                                    {{2,3}, 13.0}, {{4,1}, 1.0},
+                                    {{4,5}, 30.0}};
+    size_t numNonZeros = 0;
+    for (auto val = a.beginTyped<int>(); val != a.endTyped<int>(); ++val) {
+      if (val->second != 0.0) {
+        ASSERT_TRUE(util::contains(vals, val->first.toVector()));
+        ASSERT_EQ(vals.at(val->first.toVector()), val->second);
+        numNonZeros++;
+      }
+    }
+    ASSERT_EQ(vals.size(), numNonZeros);
+  }
+
+  Tensor<int> b;
+  b.insert({}, 1);
+  b.pack();
+  b.insert({}, 2);
+  b.pack();
+  ASSERT_EQ(3, b.begin()->second);
+}
+
+TEST(tensor, insert_columns) {
+  // Components inserted as coordinate columns, both in storage order and out
+  // of order, pack to the same tensor as components inserted one at a time
+  const vector<int> rows = {0, 1, 1, 3, 3, 4};
+  const vector<int> cols = {2, 0, 4, 1, 1, 3};
+  const vector<float> vals = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+  for (auto& format : {CSR, CSC, Format({Sparse,Sparse,Dense})}) {
+    SCOPED_TRACE(util::toString(format));
+    vector<int> dims = {5, 5};
+    if (format.getOrder() == 3) {
+      dims.push_back(1);
+    }
+    Tensor<float> expected(dims, format);
+    for (size_t i = 0; i < vals.size(); ++i) {
+      vector<int> coord = {rows[i], cols[i]};
+      coord.resize(dims.size(), 0);
+      expected.insert(coord, vals[i]);
+    }
+    expected.pack();
+
+    const vector<int> zeros(vals.size(), 0);
+    vector<const int*> columns = {rows.data(), cols.data()};
+    if (dims.size() == 3) {
+      columns.push_back(zeros.data());
+    }
+    Tensor<float> a(dims, format);
+    a.reserve(vals.size());
+    a.insert(columns, vals.data(), 3);
+    a.insert(columns, vals.data(), 0);
+    for (auto& column : columns) {
+      column += 3;
+    }
+    a.insert(columns, vals.data() + 3, 3);
+    a.pack();
+    ASSERT_TRUE(equals(expected, a));
+  }
+}
+
+TEST(tensor, helper_functions_shape_agnostic) {
+  // Iterating tensors compiles one helper module per format and component
+  // type, whatever the tensor shapes are
+  std::mutex mutex;
+  std::set<const ir::Module*> compiledModules;
+  ir::setTierTransitionHook([&](const ir::TierTransition& transition) {
+    std::lock_guard<std::mutex> lock(mutex);
+    compiledModules.insert(transition.module);
+  });
+  const Format format({Sparse,Dense}, {1,0});
+  for (int n = 1; n <= 8; n++) {
+    Tensor<int8_t> a({n, 2*n + 1}, format);
+    a.insert({n - 1, 2*n}, (int8_t)n);
+    a.insert({0, 0}, (int8_t)1);
+    a.pack();
+    int sum = 0;
+    for (auto val = a.beginTyped<int>(); val != a.endTyped<int>(); ++val) {
+      sum += val->second;
+    }
+    ASSERT_EQ(n + 1, sum);
+  }
+  ir::setTierTransitionHook(nullptr);
+  ASSERT_EQ(1u, compiledModules.size());
+}
+
+TEST(tensor, radix_sort_permutation) {
+  const size_t n = 300000;
+  vector<int> keys(2 * n);
+  uint64_t seed = 7;
+  for (size_t i = 0; i < n; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    keys[2*i] = (int)((seed >> 33) % 1000);
+    keys[2*i+1] = (int)((seed >> 43) % 3);
+  }
+  vector<uint32_t> expected(n);
+  for (size_t i = 0; i < n; i++) {
+    expected[i] = i;
+  }
+  std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) {
+    return std::make_pair(keys[2*a+1], keys[2*a]) <
+           std::make_pair(keys[2*b+1], keys[2*b]);
+  });
+  for (size_t threads : {1, 4}) {
+    ASSERT_EQ(expected, util::radixSortPermutation({&keys[1], &keys[0]},
+                                                   2 * sizeof(int), n,
+                                                   threads));
+  }
+}
+
 TEST(tensor, duplicates_scalar) {
   Tensor<double> a;
   a.insert({}, 1.0);
@@ -519,3 +743,205 @@ TEST(tensor, cache) {
   // ability to answer a request for the first query.
   c(i, j) = a(i, j); c.evaluate();
 }
+
+TEST(tensor, disk_cache) {
+  const std::string cachedir = util::getTmpdir() + "kernel_cache/";
+  setenv("TACO_CACHE_DIR", cachedir.c_str(), 1);
+
+  IndexVar i("i");
+  TensorVar a("a", Type(Float64, {3}), Format({Dense}));
+  TensorVar b("b", Type(Float64, {3}), Format({Dense}));
+  ir::Stmt func = lower(makeConcreteNotation(b(i) = a(i)), "compute",
+                        false, true);
+
+  // The first module misses in the cache and is compiled from scratch, while
+  // the second one loads the library that the first one published.
+  const Target target(Target::C99, Target::Linux);
+  ir::Module first(target);
+  first.addFunction(func);
+  const std::string firstPath = first.compile();
+  first.waitForOptimization();
+  ir::Module second(target);
+  second.addFunction(func);
+  const std::string secondPath = second.compile();
+  unsetenv("TACO_CACHE_DIR");
+
+  ASSERT_NE(0u, firstPath.find(cachedir));
+  ASSERT_EQ(0u, secondPath.find(cachedir));
+  ASSERT_NE(nullptr, second.getFuncPtr("compute"));
+}
+
+TEST(tensor, llvm_backend) {
+  IndexVar i("i"), j("j");
+  TensorVar A("A", Type(Float64, {3,3}), Format({Dense, Sparse}));
+  TensorVar x("x", Type(Float64, {3}), Format({Dense}));
+  TensorVar y("y", Type(Float64, {3}), Format({Dense}));
+  IndexStmt stmt = makeReductionNotation(y(i) = A(i,j) * x(j));
+  ir::Stmt func = lower(makeConcreteNotation(stmt), "compute", true, true);
+
+  ir::Module module(Target(Target::X86, Target::Linux));
+  module.addFunction(func);
+  const std::string path = module.compile();
+  if (LLVM_BUILT) {
+    ASSERT_TRUE(path.empty());
+  }
+  ASSERT_NE(nullptr, module.getFuncPtr("compute"));
+  ASSERT_NE(nullptr, module.getFuncPtr("_shim_compute"));
+  ASSERT_NE(std::string::npos, module.getSource().find("compute"));
+
+  // Kernels that taco compiles on its own go through the same backend. The
+  // formats are chosen so that no kernel compiled earlier is reused.
+  setenv("TACO_TARGET", "x86-linux", 1);
+  Tensor<double> B("B", {3,3}, Format({Sparse, Sparse}, {1,0}));
+  Tensor<double> C("C", {3,3}, Format({Sparse, Sparse}, {1,0}));
+  Tensor<double> u("u", {3}, Sparse);
+  Tensor<int> v("v", {3}, Sparse);
+  B.insert({0,0}, 1.0);
+  B.insert({2,1}, 2.0);
+  B.insert({1,2}, 3.0);
+  C.insert({2,1}, 4.0);
+  C.insert({0,2}, 5.0);
+  u.insert({1}, 4.0);
+  u.insert({2}, 5.0);
+  v.insert({1}, 7);
+  v.insert({2}, -2);
+  B.pack();
+  C.pack();
+  u.pack();
+  v.pack();
+
+  Tensor<double> D("D", {3,3}, Format({Sparse, Sparse}, {1,0}));
+  D(i,j) = B(i,j) + 2.0 * C(i,j);
+  Tensor<double> w("w", {3}, Dense);
+  w(i) = B(i,j) * u(j);
+  Tensor<int> s("s", {3}, Sparse);
+  s(i) = abs(v(i)) * v(i);
+  D.evaluate();
+  w.evaluate();
+  s.evaluate();
+  unsetenv("TACO_TARGET");
+
+  Tensor<double> expectedD("expectedD", {3,3}, Format({Dense, Dense}, {1,0}));
+  expectedD.insert({0,0}, 1.0);
+  expectedD.insert({2,1}, 10.0);
+  expectedD.insert({1,2}, 3.0);
+  expectedD.insert({0,2}, 10.0);
+  expectedD.pack();
+  ASSERT_TENSOR_EQ(expectedD, D);
+
+  Tensor<double> expectedw("expectedw", {3}, Dense);
+  expectedw.insert({1}, 15.0);
+  expectedw.insert({2}, 8.0);
+  expectedw.pack();
+  ASSERT_TENSOR_EQ(expectedw, w);
+
+  Tensor<int> expecteds("expecteds", {3}, Dense);
+  expecteds.insert({1}, 49);
+  expecteds.insert({2}, -4);
+  expecteds.pack();
+  ASSERT_TENSOR_EQ(expecteds, s);
+}
+
+TEST(tensor, tiered_compilation) {
+  // Other modules may still be recompiling in the background, so transitions
+  // are recorded per module
+  std::mutex mutex;
+  std::map<const ir::Module*, std::vector<ir::CompilationTier>> tiers;
+  ir::setTierTransitionHook([&](const ir::TierTransition& transition) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tiers[transition.module].push_back(transition.tier);
+  });
+  setenv("TACO_TIERED_COMPILATION", "1", 1);
+
+  IndexVar i("i");
+  TensorVar a("a", Type(Float64, {3}), Format({Dense}));
+  TensorVar b("b", Type(Float64, {3}), Format({Dense}));
+  ir::Stmt func = lower(makeConcreteNotation(b(i) = a(i) * a(i)), "compute",
+                        false, true);
+  for (auto arch : {Target::C99, Target::X86}) {
+    ir::Module module(Target(arch, Target::Linux));
+    module.addFunction(func);
+    module.compile();
+    ASSERT_NE(nullptr, module.getFuncPtr("compute"));
+    module.waitForOptimization();
+    ASSERT_EQ(ir::CompilationTier::Optimized, module.getTier());
+    ASSERT_NE(nullptr, module.getFuncPtr("compute"));
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(2u, tiers[&module].size());
+    ASSERT_EQ(ir::CompilationTier::Baseline, tiers[&module][0]);
+    ASSERT_EQ(ir::CompilationTier::Optimized, tiers[&module][1]);
+    tiers.clear();
+  }
+
+  // Kernels keep computing the same results across the tier transition
+  Tensor<double> c("c", {4}, Format({Sparse}));
+  c.insert({1}, 2.0);
+  c.insert({3}, 3.0);
+  c.pack();
+  Tensor<double> d("d", {4}, Format({Sparse}));
+  d(i) = c(i) * c(i) + c(i);
+  d.evaluate();
+  unsetenv("TACO_TIERED_COMPILATION");
+  ir::setTierTransitionHook(nullptr);
+
+  Tensor<double> expected("expected", {4}, Format({Sparse}));
+  expected.insert({1}, 6.0);
+  expected.insert({3}, 12.0);
+  expected.pack();
+  ASSERT_TENSOR_EQ(expected, d);
+}
+
+TEST(tensor, batch_compile) {
+  IndexVar i("i"), j("j");
+  Tensor<double> B("B", {3,3}, Format({Dense, Sparse}));
+  Tensor<double> c("c", {3}, Format({Sparse}));
+  B.insert({0,1}, 1.0);
+  B.insert({1,1}, 2.0);
+  B.insert({2,0}, 3.0);
+  c.insert({1}, 4.0);
+  c.insert({2}, 5.0);
+  B.pack();
+  c.pack();
+
+  Tensor<double> y1("y1", {3}, Format({Dense}));
+  Tensor<double> y2("y2", {3}, Format({Dense}));
+  Tensor<double> C("C", {3,3}, Format({Dense, Sparse}));
+  Tensor<double> d("d", {3}, Format({Sparse}));
+  y1(i) = B(i,j) * c(j);
+  y2(i) = B(i,j) * c(j);
+  C(i,j) = B(i,j) * B(i,j);
+  d(i) = c(i) + c(i);
+  TensorBase::compile({y1, y2, C, d});
+  ASSERT_FALSE(y1.needsCompile());
+  ASSERT_FALSE(C.needsCompile());
+  ASSERT_NE(std::string::npos, C.getSource().find("compute"));
+
+  y1.assemble();
+  y1.compute();
+  y2.assemble();
+  y2.compute();
+  C.assemble();
+  C.compute();
+  d.assemble();
+  d.compute();
+
+  Tensor<double> expectedy("expectedy", {3}, Format({Dense}));
+  expectedy.insert({0}, 4.0);
+  expectedy.insert({1}, 8.0);
+  expectedy.pack();
+  ASSERT_TENSOR_EQ(expectedy, y1);
+  ASSERT_TENSOR_EQ(expectedy, y2);
+
+  Tensor<double> expectedC("expectedC", {3,3}, Format({Dense, Sparse}));
+  expectedC.insert({0,1}, 1.0);
+  expectedC.insert({1,1}, 4.0);
+  expectedC.insert({2,0}, 9.0);
+  expectedC.pack();
+  ASSERT_TENSOR_EQ(expectedC, C);
+
+  Tensor<double> expectedd("expectedd", {3}, Format({Sparse}));
+  expectedd.insert({1}, 8.0);
+  expectedd.insert({2}, 10.0);
+  expectedd.pack();
+  ASSERT_TENSOR_EQ(expectedd, d);
+}
@@ -81,7 +81,7 @@ static void printFlag(string flag, string text) {
   cout << endl;
 }
 
-static const string fileFormats = "(.tns .ttx .mtx .rb)";
+static const string fileFormats = "(.tns .ttx .mtx .rb .taco)";
 
 static void printUsageInfo() {
   cout << "Usage: taco <index expression> [options]" << endl;
@@ -103,7 +103,9 @@ static void printUsageInfo() {
             "Specify the format of a tensor in the expression. Formats are "
             "specified per dimension using d (dense), s (sparse), "
             "u (sparse, not unique), q (singleton), c (singleton, not unique), "
-            "or p (singleton, padded). All formats default to dense. "
+            "p (singleton, padded), b (sparse, bit-packed coordinates), "
+            "h (hashed), or m (bitmap). "
+            "All formats default to dense. "
             "The ordering of modes can also be optionally specified as a "
             "comma-delimited list of modes in the order they should be stored. "
             "Examples: A:ds (i.e., CSR), B:ds:1,0 (i.e., CSC), c:d (i.e., "
@@ -194,6 +196,10 @@ static void printUsageInfo() {
   cout << endl;
   printFlag("nthreads", "Specify number of threads for parallel execution");
   cout << endl;
+  printFlag("merge-threshold", "Specify the ratio between the lengths of the "
+            "merged segments above which mergeby(i, Adaptive) merges the "
+            "segments by galloping");
+  cout << endl;
   printFlag("prefix", "Specify a prefix for generated function names");
   cout << endl;
   printFlag("help", "Print this usage information.");
@@ -262,7 +268,9 @@ static void printSchedulingHelp() {
               "an output race strategy `strat`. Since the other transformations "
               "expect serial code, parallelize must come last in a series of "
               "transformations.  Possible parallel hardware units are: "
-              "NotParallel, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector. "
+              "NotParallel, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, "
+              "CPUMergePath (which splits the rows and nonzeros of a CSR matrix "
+              "evenly across threads). "
               "Possible output race strategies are: "
               "IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction.");
 }
@@ -279,6 +287,8 @@ static void printVersionInfo() {
     cout << "Built with Python support." << endl;
   if(TACO_FEATURE_CUDA)
     cout << "Built with CUDA support." << endl;
+  if(TACO_FEATURE_LLVM)
+    cout << "Built with LLVM support." << endl;
   cout << endl;
   cout << "Built on: " << TACO_BUILD_DATE << endl;
   cout << "CMake build type: " << TACO_BUILD_TYPE << endl;
@@ -506,6 +516,10 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
         strategy = MergeStrategy::TwoFinger;
       } else if (strat == "Gallop") {
         strategy = MergeStrategy::Gallop;
+      } else if (strat == "SIMDBlock") {
+        strategy = MergeStrategy::SIMDBlock;
+      } else if (strat == "Adaptive") {
+        strategy = MergeStrategy::Adaptive;
       } else {
         taco_uerror << "Merge strategy not defined.";
         goto end;
@@ -571,6 +585,8 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
         parallel_unit = ParallelUnit::CPUThread;
       } else if (unit == "CPUVector") {
         parallel_unit = ParallelUnit::CPUVector;
+      } else if (unit == "CPUMergePath") {
+        parallel_unit = ParallelUnit::CPUMergePath;
       } else {
         taco_uerror << "Parallel hardware not defined.";
         goto end;
@@ -770,6 +786,15 @@ int main(int argc, char* argv[]) {
           case 'p':
             modeTypes.push_back(ModeFormat::Singleton(ModeFormat::PADDED));
             break;
+          case 'b':
+            modeTypes.push_back(ModeFormat::BitPacked);
+            break;
+          case 'h':
+            modeTypes.push_back(ModeFormat::Hashed);
+            break;
+          case 'm':
+            modeTypes.push_back(ModeFormat::Bitmap);
+            break;
           default:
             return reportError("Incorrect format descriptor", 3);
             break;
@@ -1016,6 +1041,14 @@ int main(int argc, char* argv[]) {
         return reportError("Incorrect -nthreads usage", 3);
       }
     }
+    else if ("-merge-threshold" == argName) {
+      try {
+        taco_set_adaptive_merge_threshold(stoi(argValue));
+      }
+      catch (...) {
+        return reportError("Incorrect -merge-threshold usage", 3);
+      }
+    }
     else if ("-print-kernels" == argName) {
       printKernels = true;
     }